@@ -0,0 +1,192 @@
+/*
+ * convert-classifier.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifdef WIN32
+	#include <SDKDDKVer.h>
+#endif
+
+#include "classification/BinaryModelFile.hpp"
+#include "classification/SvmClassifier.hpp"
+#include "classification/ProbabilisticSvmClassifier.hpp"
+#include "classification/WvmClassifier.hpp"
+#include "classification/ProbabilisticWvmClassifier.hpp"
+#include "classification/RvmClassifier.hpp"
+#include "classification/ProbabilisticRvmClassifier.hpp"
+
+#include "logging/LoggerFactory.hpp"
+
+#include "opencv2/core/core.hpp"
+
+#ifdef WIN32
+	#define BOOST_ALL_DYN_LINK	// Link against the dynamic boost lib. Seems to be necessary because we use /MD, i.e. link to the dynamic CRT.
+	#define BOOST_ALL_NO_LIB	// Don't use the automatic library linking by boost with VS2010 (#pragma ...). Instead, we specify everything in cmake.
+#endif
+#include "boost/program_options.hpp"
+#include "boost/property_tree/ptree.hpp"
+#include "boost/algorithm/string.hpp"
+#include "boost/filesystem.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <limits>
+
+namespace po = boost::program_options;
+using logging::Logger;
+using logging::LoggerFactory;
+using logging::LogLevel;
+using boost::filesystem::path;
+using cv::Mat;
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+using std::make_shared;
+
+/**
+ * Reads static negative training examples from a text file with one example per line, the same way
+ * LibSvmClassifier::loadStaticNegatives() does.
+ *
+ * @param[in] negativesFilename The name of the text file.
+ * @param[in] maxNegatives The maximum amount of examples to read.
+ * @return The examples (one example per row, CV_64F).
+ */
+Mat readStaticNegativesFromText(const path& negativesFilename, int maxNegatives)
+{
+	std::ifstream file(negativesFilename.string().c_str());
+	if (!file.is_open())
+		throw std::runtime_error("Could not open the static negatives file " + negativesFilename.string());
+	Mat negatives;
+	vector<double> values;
+	double value;
+	char separator;
+	string line;
+	while (negatives.rows < maxNegatives && std::getline(file, line)) {
+		values.clear();
+		std::istringstream lineStream(line);
+		while (lineStream.good() && !lineStream.fail()) {
+			lineStream >> value >> separator;
+			values.push_back(value);
+		}
+		if (!negatives.empty() && static_cast<int>(values.size()) != negatives.cols)
+			throw std::runtime_error("All static negatives must have the same dimension, but line " + std::to_string(negatives.rows + 1) + " differs");
+		negatives.push_back(Mat(values).reshape(1, 1));
+	}
+	return negatives;
+}
+
+/**
+ * Converts classifiers (SVM, WVM, RVM, text or Matlab files) and static negative training examples (text files)
+ * into the binary classifier model format (.bcm) that can be loaded with a few bulk reads.
+ */
+int main(int argc, char *argv[])
+{
+	string verboseLevelConsole;
+	string type;
+	bool probabilistic;
+	path inputFilename, thresholdsFilename, outputFilename;
+	int maxNegatives;
+
+	try {
+		po::options_description desc("Allowed options");
+		desc.add_options()
+			("help,h",
+				"produce help message")
+			("verbose,v", po::value<string>(&verboseLevelConsole)->implicit_value("DEBUG")->default_value("INFO", "show messages with INFO loglevel or below."),
+				"specify the verbosity of the console output: PANIC, ERROR, WARN, INFO, DEBUG or TRACE")
+			("type,t", po::value<string>(&type)->required(),
+				"the type of the input: svm, wvm, rvm or negatives")
+			("probabilistic,p", po::value<bool>(&probabilistic)->implicit_value(true)->default_value(false, "false"),
+				"convert a probabilistic classifier including the parameters of the logistic function")
+			("input,i", po::value<path>(&inputFilename)->required(),
+				"the classifier (.mat or the SVM text format) or the text file with the static negatives")
+			("thresholds", po::value<path>(&thresholdsFilename)->default_value(""),
+				"the Matlab file with the thresholds and logistic parameters (WVM, RVM and probabilistic Matlab SVM)")
+			("max-negatives", po::value<int>(&maxNegatives)->default_value(std::numeric_limits<int>::max(), "all"),
+				"the maximum amount of static negatives to convert")
+			("output,o", po::value<path>(&outputFilename)->required(),
+				"the binary model file to write, usually with extension .bcm")
+			;
+
+		po::variables_map vm;
+		po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+		if (vm.count("help")) {
+			cout << "Usage: convert-classifier [options]\n";
+			cout << desc;
+			return EXIT_SUCCESS;
+		}
+		po::notify(vm);
+
+	}
+	catch (po::error& e) {
+		cout << "Error while parsing command-line arguments: " << e.what() << endl;
+		cout << "Use --help to display a list of options." << endl;
+		return EXIT_SUCCESS;
+	}
+
+	LogLevel logLevel;
+	if (boost::iequals(verboseLevelConsole, "PANIC")) logLevel = LogLevel::Panic;
+	else if (boost::iequals(verboseLevelConsole, "ERROR")) logLevel = LogLevel::Error;
+	else if (boost::iequals(verboseLevelConsole, "WARN")) logLevel = LogLevel::Warn;
+	else if (boost::iequals(verboseLevelConsole, "INFO")) logLevel = LogLevel::Info;
+	else if (boost::iequals(verboseLevelConsole, "DEBUG")) logLevel = LogLevel::Debug;
+	else if (boost::iequals(verboseLevelConsole, "TRACE")) logLevel = LogLevel::Trace;
+	else {
+		cout << "Error: Invalid LogLevel." << endl;
+		return EXIT_FAILURE;
+	}
+
+	Loggers->getLogger("classification").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
+	Loggers->getLogger("convert-classifier").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
+	Logger appLogger = Loggers->getLogger("convert-classifier");
+
+	appLogger.debug("Verbose level for console output: " + logging::logLevelToString(logLevel));
+
+	// Use the same config-tree layout as the apps, so the probabilistic classifiers go through their load():
+	boost::property_tree::ptree classifierConfig;
+	classifierConfig.put("classifierFile", inputFilename.string());
+	classifierConfig.put("thresholdsFile", thresholdsFilename.string());
+
+	try {
+		if (boost::iequals(type, "svm")) {
+			if (probabilistic)
+				classification::ProbabilisticSvmClassifier::load(classifierConfig)->writeBinary(outputFilename.string());
+			else if (inputFilename.extension() == ".mat")
+				classification::SvmClassifier::loadFromMatlab(inputFilename.string())->writeBinary(outputFilename.string());
+			else
+				classification::SvmClassifier::loadFromText(inputFilename.string())->writeBinary(outputFilename.string());
+		} else if (boost::iequals(type, "wvm")) {
+			if (probabilistic)
+				classification::ProbabilisticWvmClassifier::loadFromMatlab(inputFilename.string(), thresholdsFilename.string())->writeBinary(outputFilename.string());
+			else
+				classification::WvmClassifier::loadFromMatlab(inputFilename.string(), thresholdsFilename.string())->writeBinary(outputFilename.string());
+		} else if (boost::iequals(type, "rvm")) {
+			if (probabilistic)
+				classification::ProbabilisticRvmClassifier::load(classifierConfig)->writeBinary(outputFilename.string());
+			else
+				classification::RvmClassifier::loadFromMatlab(inputFilename.string(), thresholdsFilename.string())->writeBinary(outputFilename.string());
+		} else if (boost::iequals(type, "negatives")) {
+			Mat negatives = readStaticNegativesFromText(inputFilename, maxNegatives);
+			appLogger.info("Read " + std::to_string(negatives.rows) + " static negatives with " + std::to_string(negatives.cols) + " dimensions");
+			classification::writeStaticNegatives(outputFilename.string(), negatives);
+		} else {
+			appLogger.error("Unknown type '" + type + "', expected svm, wvm, rvm or negatives.");
+			return EXIT_FAILURE;
+		}
+	}
+	catch (const std::exception& error) {
+		appLogger.error(error.what());
+		return EXIT_FAILURE;
+	}
+	appLogger.info("Finished writing " + outputFilename.string());
+
+	return EXIT_SUCCESS;
+}
@@ -192,10 +192,17 @@ int main(int argc, char *argv[])
 		boost::filesystem::create_directory(outputLandmarks);
 	}
 
+	// The files of a dataset usually all have the same landmarks in the same order, so the mapping is
+	// compiled once against them and only re-compiled if a file has a different scheme.
+	CompiledLandmarkMapping compiledMapping;
+	LandmarkCollection convertedLandmarks;
 	while(landmarkSource->next()) {
 		appLogger.info("Converting " + landmarkSource->getName().string());
 		LandmarkCollection originalLandmarks = landmarkSource->getLandmarks();
-		LandmarkCollection convertedLandmarks = landmarkMapper.convert(originalLandmarks);
+		if (!compiledMapping.hasSourceScheme(originalLandmarks)) {
+			compiledMapping = landmarkMapper.compile(originalLandmarks);
+		}
+		compiledMapping.convert(originalLandmarks, convertedLandmarks);
 		
 		path outputFilename = outputLandmarks / landmarkSource->getName().stem(); // Todo: Add file-extension
 		landmarkSink->add(convertedLandmarks, outputFilename);
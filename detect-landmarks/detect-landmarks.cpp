@@ -49,6 +49,7 @@
 #include "imageio/ModelLandmark.hpp"
 
 #include "logging/LoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 
 using namespace imageio;
 using namespace superviseddescent;
@@ -92,6 +93,7 @@ int main(int argc, char *argv[])
 	path faceBoxesDirectory;
 	path outputDirectory;
 	string landmarkType;
+	path instrumentationFile;
 
 	try {
 		po::options_description desc("Allowed options");
@@ -112,6 +114,8 @@ int main(int argc, char *argv[])
 				"specify the type of landmarks to load: rect-face-box, PaSC-still-PittPatt-eyes, PaSC-video-PittPatt-detections, SimpleModelLandmark")
 			("output,o", po::value<path>(&outputDirectory)->required(),
 				"Output directory for the result images and landmarks.")
+			("instrumentation", po::value<path>(&instrumentationFile),
+				"a JSON file for storing the per-image stage timings and counters (needs WITH_INSTRUMENTATION)")
 		;
 
 		po::positional_options_description p;
@@ -382,7 +386,11 @@ int main(int argc, char *argv[])
 		end = std::chrono::system_clock::now();
 		int elapsed_mseconds = std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count();
 		appLogger.info("Finished processing. Elapsed time: " + lexical_cast<string>(elapsed_mseconds) + "ms.");
+		INSTRUMENT_END_FRAME();
 	}
 
+	if (!instrumentationFile.empty()) {
+		logging::Instrumentation::Instance()->writeJson(instrumentationFile.string());
+	}
 	return 0;
 }
@@ -6,7 +6,9 @@
  *
  * Example:
  * extract-frames -i ...
- *   
+ *
+ * Several videos, directories of videos or text files with one video per
+ * line can be given with -i, they are processed concurrently.
  */
 
 // For memory leak debugging: http://msdn.microsoft.com/en-us/library/x98tx3cf(v=VS.100).aspx
@@ -34,9 +36,13 @@
 
 #include <memory>
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <random>
 #include <iomanip>
+#include <algorithm>
+#include <thread>
+#include <atomic>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
@@ -77,6 +83,181 @@ std::ostream& operator<<(std::ostream& os, const std::vector<T>& v)
 	return os;
 }
 
+/**
+ * Returns whether the file looks like a video, judging from its extension.
+ */
+bool isVideoFile(const path& file)
+{
+	static const vector<string> videoExtensions{ ".mp4", ".avi", ".mov", ".mpg", ".mpeg", ".mkv", ".wmv" };
+	string extension = file.extension().string();
+	return std::any_of(begin(videoExtensions), end(videoExtensions), [&extension](const string& videoExtension) { return boost::iequals(extension, videoExtension); });
+}
+
+/**
+ * Collects the videos to process. Each input is either a video, a directory
+ * (all videos directly inside it are used) or a .txt file with one video per line.
+ */
+vector<path> gatherVideos(const vector<path>& inputs)
+{
+	vector<path> videos;
+	for (const auto& input : inputs) {
+		if (boost::filesystem::is_directory(input)) {
+			vector<path> directoryVideos;
+			for (boost::filesystem::directory_iterator it(input); it != boost::filesystem::directory_iterator(); ++it) {
+				if (boost::filesystem::is_regular_file(it->status()) && isVideoFile(it->path())) {
+					directoryVideos.push_back(it->path());
+				}
+			}
+			std::sort(begin(directoryVideos), end(directoryVideos));
+			videos.insert(end(videos), begin(directoryVideos), end(directoryVideos));
+		}
+		else if (boost::iequals(input.extension().string(), ".txt")) {
+			std::ifstream listFile(input.string());
+			if (!listFile.is_open()) {
+				throw std::runtime_error("Could not open the video list " + input.string());
+			}
+			string line;
+			while (std::getline(listFile, line)) {
+				boost::trim(line);
+				if (!line.empty()) {
+					videos.push_back(path(line));
+				}
+			}
+		}
+		else {
+			videos.push_back(input);
+		}
+	}
+	return videos;
+}
+
+/**
+ * Returns the name the PaSC landmarks of a frame are stored under. The
+ * frame numbers start with 1.
+ */
+string getFrameName(const path& video, int frameNumber)
+{
+	std::ostringstream ss;
+	ss << std::setw(3) << std::setfill('0') << frameNumber;
+	return video.stem().string() + "/" + video.stem().string() + "-" + ss.str() + ".jpg";
+}
+
+/**
+ * Returns the number of frames of the video. It is taken from the container
+ * if possible, otherwise the frames are counted by grabbing them, without
+ * retrieving the images. In the latter case, the capture is re-opened.
+ */
+int getFrameCount(cv::VideoCapture& cap, const path& video)
+{
+	int frameCount = static_cast<int>(cap.get(CV_CAP_PROP_FRAME_COUNT));
+	if (frameCount > 0) {
+		return frameCount;
+	}
+	frameCount = 0;
+	while (cap.grab()) {
+		++frameCount;
+	}
+	cap.open(video.string());
+	return frameCount;
+}
+
+/**
+ * Chooses the frame to extract (starting at 0) without decoding any frame.
+ * For maxFaceWidth, only the landmarks of each frame are looked up.
+ * Returns -1 if there is no frame to extract. Throws a std::runtime_error
+ * if the number of frames can't be determined.
+ */
+int chooseFrame(cv::VideoCapture& cap, const path& video, const string& extractionMethod, imageio::NamedLandmarkSource& landmarkSource, Logger& logger)
+{
+	int frameCount = getFrameCount(cap, video);
+	if (frameCount == 0) {
+		throw std::runtime_error("Could not determine the number of frames.");
+	}
+	if (extractionMethod == "first") {
+		return 0;
+	}
+	if (extractionMethod == "middle") {
+		return frameCount / 2; // rounding down on odd numbers
+	}
+	if (extractionMethod == "random") {
+		std::uniform_int_distribution<> rndInt(0, frameCount - 1);
+		std::mt19937 engine{};
+		return rndInt(engine);
+	}
+	// maxFaceWidth:
+	int frameToExtract = -1;
+	double maxInterEyeDistance = 0.0;
+	for (int frame = 0; frame < frameCount; ++frame) {
+		imageio::LandmarkCollection landmarks = landmarkSource.get(getFrameName(video, frame + 1)); // frame numbering in the CSV starts with 1
+		if (landmarks.hasLandmark("le") && landmarks.hasLandmark("re")) {
+			double interEyeDistance = cv::norm(landmarks.getLandmark("le")->getPosition2D(), landmarks.getLandmark("re")->getPosition2D(), cv::NORM_L2);
+			if (interEyeDistance > maxInterEyeDistance) {
+				maxInterEyeDistance = interEyeDistance;
+				frameToExtract = frame;
+			}
+		}
+	}
+	if (frameToExtract < 0) {
+		// We don't have any landmarks at all for this video.
+		logger.info(video.string() + ": No landmarks found for this video - doing nothing.");
+	}
+	return frameToExtract;
+}
+
+/**
+ * Extracts one frame of the video and writes it, together with its eye
+ * landmarks, to the output path. The frames before it are skipped with
+ * grab(), so only the extracted frame is retrieved. The landmark source
+ * is only read from, so one instance can be used by several threads.
+ *
+ * @return True if a frame was written, false if there was nothing to extract.
+ * @throws std::runtime_error if the video can't be opened or read.
+ */
+bool extractFrame(const path& video, const string& extractionMethod, imageio::NamedLandmarkSource& landmarkSource, const path& outputPath, Logger& logger)
+{
+	cv::VideoCapture cap(video.string());
+	if (!cap.isOpened()) {
+		throw std::runtime_error("Could not open the video.");
+	}
+
+	int frameToExtract = chooseFrame(cap, video, extractionMethod, landmarkSource, logger);
+	if (frameToExtract < 0) {
+		return false;
+	}
+
+	// Skip to the frame and get the frame image:
+	for (int frame = 0; frame < frameToExtract; ++frame) {
+		if (!cap.grab()) {
+			throw std::runtime_error("The video ended before frame " + std::to_string(frameToExtract + 1) + ".");
+		}
+	}
+	Mat img;
+	if (!cap.read(img) || img.empty()) {
+		throw std::runtime_error("Could not read frame " + std::to_string(frameToExtract + 1) + ".");
+	}
+	path fn = outputPath / video.filename();
+	frameToExtract++; // PaSC starts naming them from 1
+	fn.replace_extension(std::to_string(frameToExtract) + ".png"); // Note/Todo: We should add zeros here if we want to pad the filename
+	cv::imwrite(fn.string(), img);
+
+	// Get and write the frames landmarks:
+	imageio::LandmarkCollection frameLandmarks = landmarkSource.get(getFrameName(video, frameToExtract));
+	if (frameLandmarks.hasLandmark("le") && frameLandmarks.hasLandmark("re")) {
+		imageio::LandmarkCollection landmarks;
+		// we only want the eyes, not the face (not a ModelLandmark):
+		landmarks.insert(frameLandmarks.getLandmark("le"));
+		landmarks.insert(frameLandmarks.getLandmark("re"));
+		fn.replace_extension(".txt");
+		imageio::SimpleModelLandmarkSink landmarkSink;
+		landmarkSink.add(landmarks, fn);
+	}
+	else {
+		logger.warn(video.string() + ": There are no eye landmarks for frame " + std::to_string(frameToExtract) + ", only the image was written.");
+	}
+	logger.debug(video.string() + ": Extracted frame " + std::to_string(frameToExtract) + ".");
+	return true;
+}
+
 int main(int argc, char *argv[])
 {
 	#ifdef WIN32
@@ -85,12 +266,13 @@ int main(int argc, char *argv[])
 	#endif
 	
 	string verboseLevelConsole;
-	path inputFilename;
-	//path inputLandmarks;
+	vector<path> inputPaths;
+	path inputLandmarks;
 	//string landmarkType;
 	//path landmarkMappings;
 	path outputPath;
 	string extractionMethod;
+	unsigned int numThreads;
 
 	try {
 		po::options_description desc("Allowed options");
@@ -99,10 +281,10 @@ int main(int argc, char *argv[])
 				"produce help message")
 			("verbose,v", po::value<string>(&verboseLevelConsole)->implicit_value("DEBUG")->default_value("INFO","show messages with INFO loglevel or below."),
 				  "specify the verbosity of the console output: PANIC, ERROR, WARN, INFO, DEBUG or TRACE")
-			("input,i", po::value<path>(&inputFilename)->required(),
-				"input video")
-			//("landmarks,l", po::value<path>(&inputLandmarks)->required(),
-			//	"input landmarks")
+			("input,i", po::value<vector<path>>(&inputPaths)->multitoken()->required(),
+				"input video(s), directories containing videos, or .txt files with one video per line")
+			("landmarks,l", po::value<path>(&inputLandmarks)->default_value(path(R"(C:\Users\Patrik\Documents\GitHub\data\PaSC\pasc_video_pittpatt_detections_debug2.csv)")),
+				"the PaSC video landmarks (PittPatt detections) as .csv file")
 			//("landmark-type,t", po::value<string>(&landmarkType)->required(),
 			//	"specify the type of landmarks: ibug")
 			//("landmark-mappings,m", po::value<path>(&landmarkMappings),
@@ -111,6 +293,8 @@ int main(int argc, char *argv[])
 				"how to extract the frame(s): first, middle, random, maxFaceWidth")
 			("output,o", po::value<path>(&outputPath)->default_value("."),
 				"path to an output folder")
+			("threads,j", po::value<unsigned int>(&numThreads)->default_value(0),
+				"the number of videos to process concurrently, 0 uses one per hardware thread")
 		;
 
 		po::variables_map vm;
@@ -141,15 +325,34 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 	
+	// All loggers are created here, before the worker threads start:
 	Loggers->getLogger("imageio").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
 	Loggers->getLogger("extract-frames").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
 	Logger appLogger = Loggers->getLogger("extract-frames");
 
 	appLogger.debug("Verbose level for console output: " + logging::logLevelToString(logLevel));
 
+	if (extractionMethod != "first" && extractionMethod != "middle" && extractionMethod != "random" && extractionMethod != "maxFaceWidth") {
+		appLogger.error("Invalid extraction method: " + extractionMethod);
+		return EXIT_FAILURE;
+	}
+
+	vector<path> videos;
+	try {
+		videos = gatherVideos(inputPaths);
+	}
+	catch (const std::exception& e) {
+		appLogger.error(e.what());
+		return EXIT_FAILURE;
+	}
+	if (videos.empty()) {
+		appLogger.error("No input videos found.");
+		return EXIT_FAILURE;
+	}
+
 	// Read the PaSC video landmarks:
 	shared_ptr<imageio::NamedLandmarkSource> landmarkSource;
-	vector<path> groundtruthDirs{ path(R"(C:\Users\Patrik\Documents\GitHub\data\PaSC\pasc_video_pittpatt_detections_debug2.csv)") };
+	vector<path> groundtruthDirs{ inputLandmarks };
 	shared_ptr<imageio::LandmarkFormatParser> landmarkFormatParser;
 	string groundtruthType = "PaSC-video-PittPatt-detections";
 	if (boost::iequals(groundtruthType, "PaSC-video-PittPatt-detections")) { // Todo/Note: Not sure this is working?
@@ -161,90 +364,44 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	// Output landmarks for the extracted frame:
-	imageio::SimpleModelLandmarkSink landmarkSink;
-
 	// Create the output directory if it doesn't exist yet
 	if (!boost::filesystem::exists(outputPath)) {
 		boost::filesystem::create_directory(outputPath);
 	}
 
-	cv::VideoCapture cap(inputFilename.string());
-	if (!cap.isOpened())
-		return EXIT_FAILURE;
-
-	appLogger.info("Extracting frame using method: " + extractionMethod);
-
-	int frameToExtract;
-	if (extractionMethod == "first" || extractionMethod == "middle" || extractionMethod == "random") {
-		int frameCount = static_cast<int>(cap.get(CV_CAP_PROP_FRAME_COUNT));
-		if (frameCount == 0) {
-			// error, property not supported.
-			return EXIT_FAILURE;
-		}
-		if (extractionMethod == "first") {
-			frameToExtract = 0;
-		}
-		else if (extractionMethod == "middle") {
-			frameToExtract = frameCount / 2; // rounding down on odd numbers
-		}
-		else if (extractionMethod == "random") {
-			std::uniform_int_distribution<> rndInt(0, frameCount - 1);
-			std::mt19937 engine{};
-			frameToExtract = rndInt(engine);
-		}
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
 	}
-	
-	if (extractionMethod == "maxFaceWidth") {
-		Mat img;
-		int currentFrame = 0;
-		vector<double> interEyeDistances;
-		while (cap.read(img)) {
-			currentFrame++; // frame numbering in the CSV starts with 1
-			std::ostringstream ss;
-			ss << std::setw(3) << std::setfill('0') << currentFrame;
-			string frameName = inputFilename.stem().string() + "/" + inputFilename.stem().string() + "-" + ss.str() + ".jpg";
-			imageio::LandmarkCollection landmarks = landmarkSource->get(frameName);
-			if (landmarks.isEmpty()) {
-				interEyeDistances.emplace_back(0.0);
+	numThreads = std::min(numThreads, static_cast<unsigned int>(videos.size()));
+	appLogger.info("Extracting frames from " + std::to_string(videos.size()) + " video(s) with " + std::to_string(numThreads) + " thread(s) using method: " + extractionMethod);
+
+	// Each thread takes the next video until all are processed:
+	std::atomic<size_t> nextVideo(0);
+	std::atomic<int> numExtracted(0);
+	std::atomic<int> numFailed(0);
+	auto worker = [&]() {
+		for (size_t i = nextVideo++; i < videos.size(); i = nextVideo++) {
+			try {
+				if (extractFrame(videos[i], extractionMethod, *landmarkSource, outputPath, appLogger)) {
+					++numExtracted;
+				}
 			}
-			else {
-				auto le = landmarks.getLandmark("le");
-				auto re = landmarks.getLandmark("re");
-				interEyeDistances.emplace_back(cv::norm(le->getPosition2D(), re->getPosition2D(), cv::NORM_L2));
+			catch (const std::exception& e) {
+				appLogger.error(videos[i].string() + ": " + e.what());
+				++numFailed;
 			}
 		}
-		auto result = std::max_element(begin(interEyeDistances), end(interEyeDistances));
-		if (*result == 0.0) {
-			// The only maximum we could find is 0.0. It means we don't have any landmarks at all for this video.
-			appLogger.info("No landmarks found for this video - doing nothing.");
-			return EXIT_SUCCESS;
-
-		}
-		frameToExtract = std::distance(begin(interEyeDistances), result);
+	};
+	vector<std::thread> threads;
+	for (unsigned int t = 1; t < numThreads; ++t) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
 	}
 
-	// Get and write the frame image:
-	Mat img;
-	cap.set(CV_CAP_PROP_POS_FRAMES, frameToExtract); // starts at 0
-	cap >> img;
-	path fn = outputPath / inputFilename.filename();
-	frameToExtract++; // PaSC starts naming them from 1
-	fn.replace_extension(std::to_string(frameToExtract) + ".png"); // Note/Todo: We should add zeros here if we want to pad the filename
-	cv::imwrite(fn.string(), img);
+	appLogger.info("Finished extracting frame(s) from " + std::to_string(numExtracted.load()) + " of " + std::to_string(videos.size()) + " video(s), " + std::to_string(numFailed.load()) + " failed.");
 
-	// Get and write the frames landmarks:
-	std::ostringstream ss;
-	ss << std::setw(3) << std::setfill('0') << frameToExtract;
-	string frameName = inputFilename.stem().string() + "/" + inputFilename.stem().string() + "-" + ss.str() + ".jpg";
-	imageio::LandmarkCollection landmarks;
-	// we only want the eyes, not the face (not a ModelLandmark):
-	landmarks.insert(landmarkSource->get(frameName).getLandmark("le"));
-	landmarks.insert(landmarkSource->get(frameName).getLandmark("re"));
-	fn.replace_extension(".txt");
-	landmarkSink.add(landmarks, fn);
-
-	appLogger.info("Finished extracting frame(s).");
-
-	return EXIT_SUCCESS;
+	return numFailed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
 }
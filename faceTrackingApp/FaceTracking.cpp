@@ -33,6 +33,7 @@
 #include "classification/ProbabilisticRvmClassifier.hpp"
 #include "condensation/ResamplingSampler.hpp"
 #include "condensation/GridSampler.hpp"
+#include "condensation/HierarchicalGridSampler.hpp"
 #include "condensation/LowVarianceSampling.hpp"
 #include "condensation/SimpleTransitionModel.hpp"
 #include "condensation/WvmSvmModel.hpp"
@@ -61,16 +62,16 @@ namespace po = boost::program_options;
 const string FaceTracking::videoWindowName = "Image";
 const string FaceTracking::controlWindowName = "Controls";
 
-FaceTracking::FaceTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink) :
+FaceTracking::FaceTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink, size_t maxGridEvaluations) :
 				imageSource(move(imageSource)),
 				imageSink(move(imageSink)) {
-	initTracking();
+	initTracking(maxGridEvaluations);
 	initGui();
 }
 
 FaceTracking::~FaceTracking() {}
 
-void FaceTracking::initTracking() {
+void FaceTracking::initTracking(size_t maxGridEvaluations) {
 	// create measurement model
 	shared_ptr<DirectPyramidFeatureExtractor> featureExtractor = make_shared<DirectPyramidFeatureExtractor>(20, 20, 80, 480, 5);
 	featureExtractor->addImageFilter(make_shared<GrayscaleFilter>());
@@ -123,7 +124,11 @@ void FaceTracking::initTracking() {
 	transitionModel = make_shared<SimpleTransitionModel>(10.0, 0.1);
 	resamplingSampler = make_shared<ResamplingSampler>(count, randomRate, make_shared<LowVarianceSampling>(),
 			transitionModel, 80, 480);
-	gridSampler = make_shared<GridSampler>(80, 480, 1 / featureExtractor->getPyramid()->getIncrementalScaleFactor(), 0.1);
+	if (maxGridEvaluations > 0)
+		gridSampler = make_shared<HierarchicalGridSampler>(measurementModel, 80, 480,
+				1 / featureExtractor->getPyramid()->getIncrementalScaleFactor(), 0.1, 3, 10, maxGridEvaluations);
+	else
+		gridSampler = make_shared<GridSampler>(80, 480, 1 / featureExtractor->getPyramid()->getIncrementalScaleFactor(), 0.1);
 	tracker = unique_ptr<CondensationTracker>(new CondensationTracker(
 			resamplingSampler, measurementModel, make_shared<FilteringStateExtractor>(make_shared<WeightedMeanStateExtractor>())));
 }
@@ -272,6 +277,7 @@ int main(int argc, char *argv[]) {
 	bool useCamera = false, useKinect = false, useFile = false, useDirectory = false;
 	string outputFile;
 	int outputFps = -1;
+	size_t maxGridEvaluations;
 
 	try {
 		po::options_description desc("Allowed options");
@@ -284,6 +290,7 @@ int main(int argc, char *argv[]) {
 			("kinect,k", po::value<int>(&kinectId)->implicit_value(0), "Windows only: Use a Kinect as camera. Optionally specify a device ID.")
 			("output,o", po::value< string >(&outputFile)->default_value("","none"), "Filename to a video file for storing the image data.")
 			("output-fps,r", po::value<int>(&outputFps)->default_value(-1), "The framerate of the output video.")
+			("grid-evaluations,g", po::value<size_t>(&maxGridEvaluations)->default_value(0, "full grid"), "Search the grid hierarchically with at most this many evaluations per frame.")
 			;
 
 		po::variables_map vm;
@@ -344,7 +351,7 @@ int main(int argc, char *argv[]) {
 		imageSink.reset(new VideoImageSink(outputFile, outputFps));
 	}
 
-	unique_ptr<FaceTracking> tracker(new FaceTracking(move(imageSource), move(imageSink)));
+	unique_ptr<FaceTracking> tracker(new FaceTracking(move(imageSource), move(imageSink), maxGridEvaluations));
 	tracker->run();
 	return 0;
 }
@@ -14,7 +14,7 @@
 #include "condensation/MeasurementModel.hpp"
 #include "condensation/SimpleTransitionModel.hpp"
 #include "condensation/ResamplingSampler.hpp"
-#include "condensation/GridSampler.hpp"
+#include "condensation/Sampler.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include <memory>
 #include <string>
@@ -30,7 +30,7 @@ using std::make_shared;
 class FaceTracking {
 public:
 
-	FaceTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink);
+	FaceTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink, size_t maxGridEvaluations = 0);
 	virtual ~FaceTracking();
 
 	void run();
@@ -45,7 +45,7 @@ private:
 	static void sizeDeviationChanged(int state, void* userdata);
 	static void drawSamplesChanged(int state, void* userdata);
 
-	void initTracking();
+	void initTracking(size_t maxGridEvaluations);
 	void initGui();
 	void drawDebug(Mat& image);
 
@@ -63,7 +63,7 @@ private:
 	shared_ptr<MeasurementModel> measurementModel;
 	shared_ptr<SimpleTransitionModel> transitionModel;
 	shared_ptr<ResamplingSampler> resamplingSampler;
-	shared_ptr<GridSampler> gridSampler;
+	shared_ptr<Sampler> gridSampler;
 };
 
 #endif /* FACETRACKING_HPP_ */
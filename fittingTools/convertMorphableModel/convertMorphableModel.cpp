@@ -0,0 +1,120 @@
+/*
+ * convertMorphableModel.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifdef WIN32
+	#include <SDKDDKVer.h>
+#endif
+
+#include "morphablemodel/MorphableModel.hpp"
+
+#include "logging/LoggerFactory.hpp"
+
+#ifdef WIN32
+	#define BOOST_ALL_DYN_LINK	// Link against the dynamic boost lib. Seems to be necessary because we use /MD, i.e. link to the dynamic CRT.
+	#define BOOST_ALL_NO_LIB	// Don't use the automatic library linking by boost with VS2010 (#pragma ...). Instead, we specify everything in cmake.
+#endif
+#include "boost/program_options.hpp"
+#include "boost/property_tree/ptree.hpp"
+#include "boost/algorithm/string.hpp"
+#include "boost/filesystem.hpp"
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <exception>
+
+namespace po = boost::program_options;
+using logging::Logger;
+using logging::LoggerFactory;
+using logging::LogLevel;
+using boost::filesystem::path;
+using std::cout;
+using std::endl;
+using std::string;
+using std::make_shared;
+
+/**
+ * Converts a Morphable Model in any of the formats supported by
+ * MorphableModel::load() (.scm or .h5) into the binary format (.bmm)
+ * that can be memory-mapped by MorphableModel::loadBinaryModel().
+ */
+int main(int argc, char *argv[])
+{
+	string verboseLevelConsole;
+	path inputFilename, vertexMappingFilename, isomapFilename, outputFilename;
+
+	try {
+		po::options_description desc("Allowed options");
+		desc.add_options()
+			("help,h",
+				"produce help message")
+			("verbose,v", po::value<string>(&verboseLevelConsole)->implicit_value("DEBUG")->default_value("INFO", "show messages with INFO loglevel or below."),
+				"specify the verbosity of the console output: PANIC, ERROR, WARN, INFO, DEBUG or TRACE")
+			("input,i", po::value<path>(&inputFilename)->required(),
+				"a Morphable Model, either .scm or .h5")
+			("vertex-mapping,m", po::value<path>(&vertexMappingFilename)->default_value(""),
+				"the landmarks to vertex-id mapping file (only for .scm models)")
+			("isomap", po::value<path>(&isomapFilename)->default_value(""),
+				"an optional isomap file with texture coordinates (only for .scm models)")
+			("output,o", po::value<path>(&outputFilename)->required(),
+				"the binary model file to write, usually with extension .bmm")
+			;
+
+		po::variables_map vm;
+		po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+		if (vm.count("help")) {
+			cout << "Usage: convertMorphableModel [options]\n";
+			cout << desc;
+			return EXIT_SUCCESS;
+		}
+		po::notify(vm);
+
+	}
+	catch (po::error& e) {
+		cout << "Error while parsing command-line arguments: " << e.what() << endl;
+		cout << "Use --help to display a list of options." << endl;
+		return EXIT_SUCCESS;
+	}
+
+	LogLevel logLevel;
+	if (boost::iequals(verboseLevelConsole, "PANIC")) logLevel = LogLevel::Panic;
+	else if (boost::iequals(verboseLevelConsole, "ERROR")) logLevel = LogLevel::Error;
+	else if (boost::iequals(verboseLevelConsole, "WARN")) logLevel = LogLevel::Warn;
+	else if (boost::iequals(verboseLevelConsole, "INFO")) logLevel = LogLevel::Info;
+	else if (boost::iequals(verboseLevelConsole, "DEBUG")) logLevel = LogLevel::Debug;
+	else if (boost::iequals(verboseLevelConsole, "TRACE")) logLevel = LogLevel::Trace;
+	else {
+		cout << "Error: Invalid LogLevel." << endl;
+		return EXIT_FAILURE;
+	}
+
+	Loggers->getLogger("morphablemodel").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
+	Loggers->getLogger("convertMorphableModel").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
+	Logger appLogger = Loggers->getLogger("convertMorphableModel");
+
+	appLogger.debug("Verbose level for console output: " + logging::logLevelToString(logLevel));
+
+	// Use the same config-tree layout as the apps, so we go through MorphableModel::load():
+	boost::property_tree::ptree modelConfig;
+	modelConfig.put("filename", inputFilename.string());
+	modelConfig.put("vertexMapping", vertexMappingFilename.string());
+	modelConfig.put("isomap", isomapFilename.string());
+
+	morphablemodel::MorphableModel morphableModel;
+	try {
+		morphableModel = morphablemodel::MorphableModel::load(modelConfig);
+		appLogger.info("Loaded " + inputFilename.string() + ", writing " + outputFilename.string());
+		morphableModel.writeBinaryModel(outputFilename);
+	}
+	catch (const std::runtime_error& error) {
+		appLogger.error(error.what());
+		return EXIT_FAILURE;
+	}
+	appLogger.info("Finished writing the binary model.");
+
+	return EXIT_SUCCESS;
+}
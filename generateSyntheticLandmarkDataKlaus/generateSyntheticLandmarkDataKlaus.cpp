@@ -19,6 +19,7 @@
 #include "render/MeshUtils.hpp"
 #include "render/MatrixUtils.hpp"
 #include "render/SoftwareRenderer.hpp"
+#include "render/BatchRenderer.hpp"
 #include "render/Camera.hpp"
 
 #include "morphablemodel/MorphableModel.hpp"
@@ -182,6 +183,7 @@ int main(int argc, char *argv[])
 	Mat moveCameraBack = render::utils::MatrixUtils::createTranslationMatrix(0.0f, 0.0f, -3.0f);
 	Mat projection = render::utils::MatrixUtils::createOrthogonalProjectionMatrix(-1.0f*aspect, 1.0f*aspect, -1.0f, 1.0f, zNear, zFar);
 	SoftwareRenderer r(screenWidth, screenHeight);
+	render::BatchRenderer batchRenderer(screenWidth, screenHeight);
 
 	//namedWindow(windowName, WINDOW_AUTOSIZE);
 	//setMouseCallback(windowName, winOnMouse);
@@ -246,98 +248,124 @@ int main(int argc, char *argv[])
 	int generatedSamples = 0;
 	int samplesToGenerate = 600000; //600000;
 	int cnt = 0;
+	const int renderBatchSize = 32; // Render the views of this many samples in one call. Every view has its own framebuffers, so this bounds the memory.
+	vector<render::MeshInstance> renderBatch(renderBatchSize); // The samples are drawn into these instances, so they are allocated only once
+	struct SampleToRender {
+		int randomVertex;
+		int yaw;
+		int pitch;
+		int roll;
+	};
+	Mat modelScaling = render::utils::MatrixUtils::createScalingMatrix(1.0f/140.0f, 1.0f/140.0f, 1.0f/140.0f);
+	// The position of a vertex of an instance, in homogeneous coordinates:
+	auto vertexPosition = [](const render::MeshInstance& instance, int vertexId) {
+		const float* position = instance.positions.ptr<float>(3 * vertexId);
+		return Vec4f(position[0], position[1], position[2], 1.0f);
+	};
 	while (generatedSamples < samplesToGenerate) {
-		++cnt;
-		//r.resetBuffers();
-		std::cout << generatedSamples << std::endl;
-
-		render::Mesh newSampleMesh = morphableModel.drawSample(0.7f); // Note: it would suffice to only draw a shape model, but then we can't render it
-		render::Mesh::writeObj(newSampleMesh, "C:\\Users\\Patrik\\Documents\\GitHub\\test3.obj");
-		
-		int randomVertex = randIntVtx();
-		int yaw = randIntYaw();
-		int pitch = randIntPitch();
-		int roll = randIntRoll();
-
-		vector<shared_ptr<Landmark>> pointsToWrite;
-		//Mat testImg = r.getImage().clone();
-
-		// 1) Render the randomVertex frontal
-		Mat modelScaling = render::utils::MatrixUtils::createScalingMatrix(1.0f/140.0f, 1.0f/140.0f, 1.0f/140.0f);
-		Mat rotPitchX = Mat::eye(4, 4, CV_32FC1);
-		Mat rotYawY = Mat::eye(4, 4, CV_32FC1);
-		Mat rotRollZ = Mat::eye(4, 4, CV_32FC1);
-		Mat modelMatrix = projection * rotYawY * moveCameraBack * rotPitchX * rotRollZ * modelScaling;
-		Vec3f res = r.projectVertex(newSampleMesh.vertex[randomVertex].position, modelMatrix);
-		auto framebuffers = r.render(newSampleMesh, modelMatrix);
-		string name = "randomVertexFrontal";
-		pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
-		cv::circle(framebuffers.first, cv::Point(res[0], res[1]), 3, cv::Scalar(0, 0, 255));
-
-		// 2) Render all LMs in frontal pose
-		for (const auto& vid : vertexIds) {
-			modelMatrix = projection * moveCameraBack * rotYawY * rotPitchX * rotRollZ * modelScaling; // same as before in 1)
-			res = r.projectVertex(newSampleMesh.vertex[vid].position, modelMatrix);
-			//r.renderLM(newSampleMesh.vertex[vid].position, Scalar(255.0f, 0.0f, 0.0f));
-			name = DidLandmarkFormatParser::didToTlmsName(vid);
-			pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
-			cv::circle(framebuffers.first, cv::Point(res[0], res[1]), 3, cv::Scalar(255, 0, 128));
+		// Draw the next samples, choose their random vertex and pose and render all their frontal and posed views in one batch:
+		vector<SampleToRender> samplesToRender;
+		vector<vector<Mat>> mvps;
+		morphableModel.drawSamples(renderBatch, 0.7f); // Note: it would suffice to only draw a shape model, but then we can't render it
+		for (int i = 0; i < renderBatchSize; ++i) {
+			SampleToRender sample;
+			sample.randomVertex = randIntVtx();
+			sample.yaw = randIntYaw();
+			sample.pitch = randIntPitch();
+			sample.roll = randIntRoll();
+			samplesToRender.push_back(sample);
+			Mat modelMatrix = projection * moveCameraBack * modelScaling;
+			Mat rotPitchXPose = render::utils::MatrixUtils::createRotationMatrixX(sample.pitch * (CV_PI / 180.0f));
+			Mat rotYawYPose = render::utils::MatrixUtils::createRotationMatrixY(sample.yaw * (CV_PI / 180.0f));
+			Mat rotRollZPose = render::utils::MatrixUtils::createRotationMatrixZ(sample.roll * (CV_PI / 180.0f));
+			Mat modelMatrixPose = projection * moveCameraBack * rotYawYPose * rotPitchXPose * rotRollZPose * modelScaling;
+			mvps.push_back({ modelMatrix, modelMatrixPose });
 		}
-		imwrite("out/" + lexical_cast<string>(cnt) + "_front.png", framebuffers.first);
-
-		// 3) Render the randomVertex in pose angle
-		rotPitchX = render::utils::MatrixUtils::createRotationMatrixX(pitch * (CV_PI/180.0f));
-		rotYawY = render::utils::MatrixUtils::createRotationMatrixY(yaw * (CV_PI/180.0f));
-		rotRollZ = render::utils::MatrixUtils::createRotationMatrixZ(roll * (CV_PI/180.0f));
-		modelMatrix = projection * moveCameraBack * rotYawY * rotPitchX * rotRollZ * modelScaling;
-		auto framebuffersPose = r.render(newSampleMesh, modelMatrix);
-
-		res = r.projectVertex(newSampleMesh.vertex[randomVertex].position, modelMatrix);
-		double zBufferValue = framebuffersPose.second.at<double>(static_cast<int>(cvRound(res[1])), static_cast<int>(cvRound(res[0])));
-		Point2i centerPixel(floor(res[0]), floor(res[1]));
-		int minzx = std::max(0, centerPixel.x - 1);
-		int maxzx = std::min(centerPixel.x + 1, framebuffersPose.second.cols - 1);
-		int minzy = std::max(0, centerPixel.y - 1);
-		int maxzy = std::min(centerPixel.y + 1, framebuffersPose.second.rows - 1);
-		bool isVisible = false;
-		for (int x = minzx; x < maxzx; ++x) {
-			for (int y = minzy; y < maxzy; ++y) {
-				double zBufferValue = framebuffersPose.second.at<double>(y, x);
-				if (res[2] <= zBufferValue) {
-					isVisible = true;
+		auto renderedViews = batchRenderer.render(renderBatch, mvps);
+
+		for (size_t sampleIndex = 0; sampleIndex < renderBatch.size() && generatedSamples < samplesToGenerate; ++sampleIndex) {
+			++cnt;
+			std::cout << generatedSamples << std::endl;
+
+			const render::MeshInstance& newSampleMesh = renderBatch[sampleIndex];
+
+			int randomVertex = samplesToRender[sampleIndex].randomVertex;
+			int yaw = samplesToRender[sampleIndex].yaw;
+			int pitch = samplesToRender[sampleIndex].pitch;
+			int roll = samplesToRender[sampleIndex].roll;
+
+			vector<shared_ptr<Landmark>> pointsToWrite;
+			//Mat testImg = r.getImage().clone();
+
+			// 1) Render the randomVertex frontal
+			Mat modelMatrix = mvps[sampleIndex][0];
+			Mat modelMatrixPose = mvps[sampleIndex][1];
+			auto& framebuffers = renderedViews[sampleIndex][0];
+			auto& framebuffersPose = renderedViews[sampleIndex][1];
+			Vec3f res = r.projectVertex(vertexPosition(newSampleMesh, randomVertex), modelMatrix);
+			string name = "randomVertexFrontal";
+			pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
+			cv::circle(framebuffers.first, cv::Point(res[0], res[1]), 3, cv::Scalar(0, 0, 255));
+
+			// 2) Render all LMs in frontal pose
+			for (const auto& vid : vertexIds) {
+				res = r.projectVertex(vertexPosition(newSampleMesh, vid), modelMatrix); // same as before in 1)
+				//r.renderLM(newSampleMesh.vertex[vid].position, Scalar(255.0f, 0.0f, 0.0f));
+				name = DidLandmarkFormatParser::didToTlmsName(vid);
+				pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
+				cv::circle(framebuffers.first, cv::Point(res[0], res[1]), 3, cv::Scalar(255, 0, 128));
+			}
+			imwrite("out/" + lexical_cast<string>(cnt) + "_front.png", framebuffers.first);
+
+			// 3) Render the randomVertex in pose angle
+			modelMatrix = modelMatrixPose;
+
+			res = r.projectVertex(vertexPosition(newSampleMesh, randomVertex), modelMatrix);
+			double zBufferValue = framebuffersPose.second.at<double>(static_cast<int>(cvRound(res[1])), static_cast<int>(cvRound(res[0])));
+			Point2i centerPixel(floor(res[0]), floor(res[1]));
+			int minzx = std::max(0, centerPixel.x - 1);
+			int maxzx = std::min(centerPixel.x + 1, framebuffersPose.second.cols - 1);
+			int minzy = std::max(0, centerPixel.y - 1);
+			int maxzy = std::min(centerPixel.y + 1, framebuffersPose.second.rows - 1);
+			bool isVisible = false;
+			for (int x = minzx; x < maxzx; ++x) {
+				for (int y = minzy; y < maxzy; ++y) {
+					double zBufferValue = framebuffersPose.second.at<double>(y, x);
+					if (res[2] <= zBufferValue) {
+						isVisible = true;
+					}
 				}
 			}
-		}
-		if (isVisible == false) {
-		//if (res[2] > zBufferValue + 0.00004) { // we apply a threshold because our projectVertex is somehow a little bit off, probably because rasterTriangle() works a bit different? (offset, rounding, ...).
-			// But caution, this hack depends on the resolution of the z-buffer?
-			// not visible
+			if (isVisible == false) {
+			//if (res[2] > zBufferValue + 0.00004) { // we apply a threshold because our projectVertex is somehow a little bit off, probably because rasterTriangle() works a bit different? (offset, rounding, ...).
+				// But caution, this hack depends on the resolution of the z-buffer?
+				// not visible
+				cv::circle(framebuffersPose.first, cv::Point(res[0], res[1]), 3, cv::Scalar(255, 0, 128));
+				imwrite("out/" + lexical_cast<string>(cnt)+"_pose_invis.png", framebuffersPose.first);
+				continue;
+			}
 			cv::circle(framebuffersPose.first, cv::Point(res[0], res[1]), 3, cv::Scalar(255, 0, 128));
-			imwrite("out/" + lexical_cast<string>(cnt)+"_pose_invis.png", framebuffersPose.first);
-			continue;
-		}
-		cv::circle(framebuffersPose.first, cv::Point(res[0], res[1]), 3, cv::Scalar(255, 0, 128));
-		name = "randomVertexPose";
-		pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
-
-		// 4) Render all LMs in pose angle
-		for (const auto& vid : vertexIds) {
-			modelMatrix = projection * moveCameraBack * rotYawY * rotPitchX * rotRollZ * modelScaling; // same as before in 3)
-			res = r.projectVertex(newSampleMesh.vertex[vid].position, modelMatrix);
-			name = DidLandmarkFormatParser::didToTlmsName(vid);
+			name = "randomVertexPose";
 			pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
-			cv::circle(framebuffersPose.first, cv::Point(res[0], res[1]), 3, cv::Scalar(128, 0, 255));
-		}
-		imwrite("out/" + lexical_cast<string>(cnt)+"_pose_vis.png", framebuffersPose.first);
+
+			// 4) Render all LMs in pose angle
+			for (const auto& vid : vertexIds) {
+				res = r.projectVertex(vertexPosition(newSampleMesh, vid), modelMatrix); // same as before in 3)
+				name = DidLandmarkFormatParser::didToTlmsName(vid);
+				pointsToWrite.push_back(make_shared<ModelLandmark>(name, res));
+				cv::circle(framebuffersPose.first, cv::Point(res[0], res[1]), 3, cv::Scalar(128, 0, 255));
+			}
+			imwrite("out/" + lexical_cast<string>(cnt)+"_pose_vis.png", framebuffersPose.first);
 					
-		// 4) Write one row to the file
-		for (const auto& lm : pointsToWrite) {
-			//lm->draw(screen);
-			outputFile << lm->getX() << " " << lm->getY() << " ";
-		}
+			// 4) Write one row to the file
+			for (const auto& lm : pointsToWrite) {
+				//lm->draw(screen);
+				outputFile << lm->getX() << " " << lm->getY() << " ";
+			}
 
-		outputFile << yaw << " " << pitch << " " << roll << " " << randomVertex << std::endl;
-		++generatedSamples;
+			outputFile << yaw << " " << pitch << " " << roll << " " << randomVertex << std::endl;
+			++generatedSamples;
+		}
 	}
 
 	outputFile.close();
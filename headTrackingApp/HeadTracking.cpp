@@ -9,6 +9,7 @@
 #include "logging/LoggerFactory.hpp"
 #include "logging/Logger.hpp"
 #include "logging/ConsoleAppender.hpp"
+#include "logging/Instrumentation.hpp"
 #include "imageio/LandmarkSource.hpp"
 #include "imageio/BobotLandmarkSource.hpp"
 #include "imageio/SingleLandmarkSource.hpp"
@@ -20,6 +21,8 @@
 #include "imageio/OrderedLabeledImageSource.hpp"
 #include "imageio/RepeatingFileImageSource.hpp"
 #include "imageio/VideoImageSink.hpp"
+#include "imageio/SingleLandmarkSink.hpp"
+#include "imageio/RectLandmark.hpp"
 #include "imageio/Landmark.hpp"
 #include "imageprocessing/GrayscaleFilter.hpp"
 #include "imageprocessing/HistEq64Filter.hpp"
@@ -64,6 +67,7 @@
 #endif
 #include "condensation/ResamplingSampler.hpp"
 #include "condensation/GridSampler.hpp"
+#include "condensation/HierarchicalGridSampler.hpp"
 #include "condensation/LowVarianceSampling.hpp"
 #include "condensation/SimpleTransitionModel.hpp"
 #include "condensation/OpticalFlowTransitionModel.hpp"
@@ -88,6 +92,7 @@
 #include <chrono>
 #include <sstream>
 #include <algorithm>
+#include <thread>
 
 using namespace logging;
 using namespace classification;
@@ -107,13 +112,24 @@ namespace po = boost::program_options;
 const string HeadTracking::videoWindowName = "Image";
 const string HeadTracking::controlWindowName = "Controls";
 
-HeadTracking::HeadTracking(unique_ptr<LabeledImageSource> imageSource, unique_ptr<ImageSink> imageSink, ptree& config) :
-		imageSource(move(imageSource)), imageSink(move(imageSink)) {
+HeadTracking::HeadTracking(unique_ptr<LabeledImageSource> imageSource, unique_ptr<ImageSink> imageSink,
+		unique_ptr<OrderedLandmarkSink> resultSink, ptree& config, bool headless) :
+				imageSource(move(imageSource)), imageSink(move(imageSink)), resultSink(move(resultSink)), headless(headless) {
 	initTracking(config);
-	initGui();
+	drawSamples = false;
+	drawFlow = 0;
+	if (headless) {
+		if (initialization == Initialization::MANUAL)
+			throw invalid_argument("HeadTracking: manual initialization is not possible without a display");
+	} else {
+		// all windows and trackbars are created on the display thread, which also runs their callbacks
+		display.reset(new WindowImageSink(videoWindowName, 5, [this]() { initGui(); }));
+	}
 }
 
-HeadTracking::~HeadTracking() {}
+HeadTracking::~HeadTracking() {
+	display.reset(); // the GUI callbacks must not run while the trackers are destructed
+}
 
 shared_ptr<DirectPyramidFeatureExtractor> HeadTracking::createPyramidExtractor(
 		ptree& config, shared_ptr<ImagePyramid> pyramid, bool needsLayerFilters) {
@@ -557,8 +573,8 @@ void HeadTracking::initTracking(ptree& config) {
 			config.get<unsigned int>("adaptive.resampling.particleCount"), config.get<double>("adaptive.resampling.randomRate"),
 			make_shared<LowVarianceSampling>(), transitionModel,
 			config.get<double>("adaptive.resampling.minSize"), config.get<double>("adaptive.resampling.maxSize"));
-	gridSampler = make_shared<GridSampler>(config.get<int>("pyramid.patch.minWidth"), config.get<int>("pyramid.patch.maxWidth"),
-			1 / pyramid->getIncrementalScaleFactor(), 0.1);
+	gridSampler = HierarchicalGridSampler::createGridSampler(config, adaptiveMeasurementModel,
+			config.get<int>("pyramid.patch.minWidth"), config.get<int>("pyramid.patch.maxWidth"), 1 / pyramid->getIncrementalScaleFactor());
 	shared_ptr<StateExtractor> stateExtractor = make_shared<FilteringStateExtractor>(make_shared<WeightedMeanStateExtractor>());
 	adaptiveTracker = unique_ptr<AdaptiveCondensationTracker>(new AdaptiveCondensationTracker(
 			adaptiveResamplingSampler, adaptiveMeasurementModel, stateExtractor,
@@ -586,11 +602,10 @@ void HeadTracking::initTracking(ptree& config) {
 }
 
 void HeadTracking::initGui() {
-	drawSamples = false;
-	drawFlow = 0;
-
 	cvNamedWindow(videoWindowName.c_str(), CV_WINDOW_AUTOSIZE);
 	cvMoveWindow(videoWindowName.c_str(), 50, 50);
+	if (initialization == Initialization::MANUAL)
+		cv::setMouseCallback(videoWindowName, onMouse, this);
 
 	cvNamedWindow(controlWindowName.c_str(), CV_WINDOW_NORMAL);
 	cvMoveWindow(controlWindowName.c_str(), 900, 50);
@@ -650,6 +665,7 @@ void HeadTracking::initGui() {
 
 void HeadTracking::adaptiveChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->useAdaptive = (state == 1);
 	if (state == 0)
 		tracking->adaptiveUsable = false;
@@ -657,6 +673,7 @@ void HeadTracking::adaptiveChanged(int state, void* userdata) {
 
 void HeadTracking::positionDeviationChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	if (tracking->opticalFlowTransitionModel)
 		tracking->opticalFlowTransitionModel->setPositionDeviation(0.1 * state);
 	else
@@ -665,6 +682,7 @@ void HeadTracking::positionDeviationChanged(int state, void* userdata) {
 
 void HeadTracking::sizeDeviationChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	if (tracking->opticalFlowTransitionModel)
 		tracking->opticalFlowTransitionModel->setSizeDeviation(0.01 * state);
 	else
@@ -673,6 +691,7 @@ void HeadTracking::sizeDeviationChanged(int state, void* userdata) {
 
 void HeadTracking::initialSamplerChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	if (state == 0)
 		tracking->initialTracker->setSampler(tracking->gridSampler);
 	else
@@ -681,16 +700,19 @@ void HeadTracking::initialSamplerChanged(int state, void* userdata) {
 
 void HeadTracking::initialSampleCountChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->initialResamplingSampler->setCount(state);
 }
 
 void HeadTracking::initialRandomRateChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->initialResamplingSampler->setRandomRate(0.01 * state);
 }
 
 void HeadTracking::adaptiveSamplerChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	if (state == 0)
 		tracking->adaptiveTracker->setSampler(tracking->gridSampler);
 	else
@@ -699,50 +721,124 @@ void HeadTracking::adaptiveSamplerChanged(int state, void* userdata) {
 
 void HeadTracking::adaptiveSampleCountChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->adaptiveResamplingSampler->setCount(state);
 }
 
 void HeadTracking::adaptiveRandomRateChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->adaptiveResamplingSampler->setRandomRate(0.01 * state);
 }
 
 void HeadTracking::numFiltersChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->filter->setNumFiltersToUse(state);
 }
 
 void HeadTracking::drawSamplesChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->drawSamples = (state == 1);
 }
 
 void HeadTracking::drawFlowChanged(int state, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->drawFlow = state;
 }
 
-void HeadTracking::drawDebug(Mat& image, bool usedAdaptive) {
-	cv::Scalar black(0, 0, 0); // blue, green, red
-	cv::Scalar red(0, 0, 255); // blue, green, red
-	cv::Scalar green(0, 255, 0); // blue, green, red
+bool HeadTracking::needsVisualization() const {
+	// frames that the display thread would drop anyway are not prepared at all
+	return imageSink || (display && display->isReady());
+}
+
+HeadTracking::Visualization HeadTracking::createVisualization(optional<Rect> target, bool usedAdaptive, bool adapted) {
+	Visualization visualization;
+	if (drawFlow > 0) { // the flow is only known to the transition model, so it has to be drawn right away
+		frame.copyTo(visualization.image);
+		cv::Scalar red(0, 0, 255); // blue, green, red
+		cv::Scalar green(0, 255, 0); // blue, green, red
+		if (drawFlow == 1)
+			opticalFlowTransitionModel->drawFlow(visualization.image, -drawFlow, green, red);
+		else
+			opticalFlowTransitionModel->drawFlow(visualization.image, drawFlow - 1, green, red);
+	} else {
+		visualization.image = frame;
+	}
 	if (drawSamples) {
 		const std::vector<shared_ptr<Sample>>& samples = usedAdaptive ? adaptiveTracker->getSamples() : initialTracker->getSamples();
-		for (const shared_ptr<Sample>& sample : samples) {
-			if (!sample->isTarget())
-				cv::circle(image, Point(sample->getX(), sample->getY()), 3, black);
-		}
-		for (const shared_ptr<Sample>& sample : samples) {
-			if (sample->isTarget()) {
-				cv::Scalar color(0, sample->getWeight() * 255, sample->getWeight() * 255);
-				cv::circle(image, Point(sample->getX(), sample->getY()), 3, color);
-			}
+		visualization.samples.reserve(samples.size());
+		for (const shared_ptr<Sample>& sample : samples)
+			visualization.samples.push_back(*sample);
+	}
+	visualization.groundTruth = imageSource->getLandmarks();
+	visualization.target = target;
+	visualization.usedAdaptive = usedAdaptive;
+	visualization.adapted = adapted;
+	return visualization;
+}
+
+void HeadTracking::show(const Visualization& visualization) {
+	if (display && display->isReady()) {
+		display->add(visualization.image, [visualization](Mat& image) {
+			draw(image, visualization);
+		});
+	}
+	if (imageSink) {
+		Mat image;
+		visualization.image.copyTo(image);
+		draw(image, visualization);
+		imageSink->add(image);
+	}
+}
+
+void HeadTracking::addResult(optional<Rect> target) {
+	if (resultSink) {
+		LandmarkCollection collection;
+		if (target)
+			collection.insert(make_shared<RectLandmark>("target", *target));
+		else
+			collection.insert(make_shared<RectLandmark>("target"));
+		resultSink->add(collection);
+	}
+}
+
+void HeadTracking::handleKey(int key) {
+	char c = (char)key;
+	if (c == 'p')
+		paused = !paused;
+	else if (c == 'q')
+		stop();
+}
+
+void HeadTracking::waitForQuit(const string& message) {
+	if (display) {
+		std::cerr << message << " - press 'q' to quit program" << std::endl;
+		while ('q' != (char)display->getKey())
+			std::this_thread::sleep_for(milliseconds(10));
+	}
+}
+
+void HeadTracking::draw(Mat& image, const Visualization& visualization) {
+	drawDebug(image, visualization.samples);
+	drawGroundTruth(image, visualization.groundTruth);
+	drawTarget(image, visualization.target, visualization.usedAdaptive, visualization.adapted);
+}
+
+void HeadTracking::drawDebug(Mat& image, const std::vector<Sample>& samples) {
+	cv::Scalar black(0, 0, 0); // blue, green, red
+	for (const Sample& sample : samples) {
+		if (!sample.isTarget())
+			cv::circle(image, Point(sample.getX(), sample.getY()), 3, black);
+	}
+	for (const Sample& sample : samples) {
+		if (sample.isTarget()) {
+			cv::Scalar color(0, sample.getWeight() * 255, sample.getWeight() * 255);
+			cv::circle(image, Point(sample.getX(), sample.getY()), 3, color);
 		}
 	}
-	if (drawFlow == 1)
-		opticalFlowTransitionModel->drawFlow(image, -drawFlow, green, red);
-	else if (drawFlow > 1)
-		opticalFlowTransitionModel->drawFlow(image, drawFlow - 1, green, red);
 }
 
 void HeadTracking::drawCrosshair(Mat& image) {
@@ -780,99 +876,110 @@ void HeadTracking::drawTarget(Mat& image, optional<Rect> target, bool usedAdapti
 void HeadTracking::onMouse(int event, int x, int y, int, void* userdata) {
 	HeadTracking *tracking = (HeadTracking*)userdata;
 	if (tracking->running && !tracking->adaptiveUsable) {
+		std::lock_guard<std::mutex> lock(tracking->selectionMutex);
 		if (event == cv::EVENT_MOUSEMOVE) {
 			tracking->currentX = x;
 			tracking->currentY = y;
-			Mat& image = tracking->image;
-			tracking->frame.copyTo(image);
-			tracking->drawBox(image);
-			tracking->drawCrosshair(image);
-			imshow(videoWindowName, image);
 		} else if (event == cv::EVENT_LBUTTONDOWN) {
 			if (tracking->storedX < 0 || tracking->storedY < 0) {
 				tracking->storedX = x;
 				tracking->storedY = y;
 			}
 		} else if (event == cv::EVENT_LBUTTONUP) {
-			Logger& log = Loggers->getLogger("app");
 			int size = abs(tracking->currentY - tracking->storedY);
 			Rect position(tracking->storedX - size / 2, std::min(tracking->storedY, tracking->currentY), size, size);
-
-			if (position.width != 0 && position.height != 0) {
-				int tries = 0;
-				while (tries < 10 && !tracking->adaptiveUsable) {
-					tries++;
-					tracking->adaptiveUsable = tracking->adaptiveTracker->initialize(tracking->frame, position);
-				}
-				if (tracking->adaptiveUsable) {
-					log.info("Initialized adaptive tracking after " + std::to_string(tries) + " tries");
-					tracking->storedX = -1;
-					tracking->storedY = -1;
-					tracking->currentX = -1;
-					tracking->currentY = -1;
-					Mat& image = tracking->image;
-					tracking->frame.copyTo(image);
-					tracking->drawTarget(image, optional<Rect>(position), true, true);
-					imshow(videoWindowName, image);
-				} else {
-					log.warn("Could not initialize tracker after " + std::to_string(tries) + " tries (patch too small/big?)");
-					std::cerr << "Could not initialize tracker - press 'q' to quit program" << std::endl;
-					tracking->stop();
-					while ('q' != (char)cv::waitKey(10));
-				}
-			}
+			if (position.width != 0 && position.height != 0)
+				tracking->selection = position;
 		}
 	}
 }
 
+optional<Rect> HeadTracking::takeSelection() {
+	std::lock_guard<std::mutex> lock(selectionMutex);
+	optional<Rect> position = selection;
+	selection = boost::none;
+	return position;
+}
+
 void HeadTracking::run() {
 	Logger& log = Loggers->getLogger("app");
 	running = true;
 	paused = false;
 	adaptiveUsable = false;
 
-	// manual initialization
+	// manual initialization, the mouse events are handled on the display thread
 	if (initialization == Initialization::MANUAL) {
-		storedX = -1;
-		storedY = -1;
-		currentX = -1;
-		currentY = -1;
-		cv::setMouseCallback(videoWindowName, onMouse, this);
+		{
+			std::lock_guard<std::mutex> lock(selectionMutex);
+			storedX = -1;
+			storedY = -1;
+			currentX = -1;
+			currentY = -1;
+			selection = boost::none;
+		}
 		while (running && !adaptiveUsable) {
-			if (!imageSource->next()) {
-				std::cerr << "Could not capture frame - press 'q' to quit program" << std::endl;
-				stop();
-				while ('q' != (char)cv::waitKey(10));
-			} else {
+			bool newFrame = false;
+			if (!paused || frame.empty()) {
+				if (!imageSource->next()) {
+					stop();
+					waitForQuit("Could not capture frame");
+					break;
+				}
 				frame = imageSource->getImage();
+				newFrame = true;
+			}
+			optional<Rect> position = takeSelection();
+			if (position) {
+				int tries = 0;
+				{
+					std::lock_guard<std::mutex> lock(trackingMutex);
+					while (tries < 10 && !adaptiveUsable) {
+						tries++;
+						adaptiveUsable = static_cast<bool>(adaptiveTracker->initialize(frame, *position));
+					}
+				}
+				if (adaptiveUsable) {
+					log.info("Initialized adaptive tracking after " + std::to_string(tries) + " tries");
+				} else {
+					log.warn("Could not initialize tracker after " + std::to_string(tries) + " tries (patch too small/big?)");
+					stop();
+					waitForQuit("Could not initialize tracker");
+					break;
+				}
+			}
+			if (newFrame)
+				addResult(adaptiveUsable ? position : optional<Rect>());
+			if (display->isReady() || (imageSink && newFrame)) {
+				Mat image;
 				frame.copyTo(image);
-				drawBox(image);
-				drawCrosshair(image);
-				imshow(videoWindowName, image);
-				if (imageSink.get() != 0)
+				if (adaptiveUsable) {
+					drawTarget(image, position, true, true);
+				} else {
+					std::lock_guard<std::mutex> lock(selectionMutex);
+					drawBox(image);
+					drawCrosshair(image);
+				}
+				if (display->isReady())
+					display->add(image);
+				if (imageSink && newFrame)
 					imageSink->add(image);
-
-				int delay = paused ? 0 : 5;
-				char c = (char)cv::waitKey(delay);
-				if (c == 'p')
-					paused = !paused;
-				else if (c == 'q')
-					stop();
 			}
+			handleKey(display->getKey());
+			std::this_thread::sleep_for(milliseconds(paused ? 10 : 5));
 		}
-	} else if (initialization == Initialization::GROUND_TRUTH) {
-		Logger& log = Loggers->getLogger("app");
+	}
+
+	// initialization using the ground truth
+	if (initialization == Initialization::GROUND_TRUTH) {
 		int tries = 0;
-		int frameIndex = 0;
 		while (running && !adaptiveUsable) {
 			if (!imageSource->next()) {
-				std::cerr << "Could not capture frame - press 'q' to quit program" << std::endl;
+				log.warn("Could not initialize tracker before the end of the images");
 				stop();
-				while ('q' != (char)cv::waitKey(10));
+				waitForQuit("Could not capture frame");
 			} else {
 				frame = imageSource->getImage();
-				frame.copyTo(image);
-				drawGroundTruth(image, imageSource->getLandmarks());
+				optional<Rect> position;
 				if (!imageSource->getLandmarks().isEmpty()) {
 					shared_ptr<Landmark> landmark = imageSource->getLandmarks().getLandmark();
 					cv::Rect_<float> floatBounds = landmark->getRect();
@@ -888,31 +995,38 @@ void HeadTracking::run() {
 					Rect bounds(
 							Point(cvRound(floatBounds.tl().x), cvRound(floatBounds.tl().y)),
 							Point(cvRound(floatBounds.br().x), cvRound(floatBounds.br().y)));
-					if (landmark->isVisible() && bounds.x >= 0 && bounds.y >= 0 && bounds.br().x < image.cols && bounds.br().y < image.rows) {
+					if (landmark->isVisible() && bounds.x >= 0 && bounds.y >= 0 && bounds.br().x < frame.cols && bounds.br().y < frame.rows) {
 						tries++;
-						adaptiveUsable = adaptiveTracker->initialize(frame, bounds);
-						drawTarget(image, optional<Rect>(bounds), true, true);
+						{
+							std::lock_guard<std::mutex> lock(trackingMutex);
+							adaptiveUsable = static_cast<bool>(adaptiveTracker->initialize(frame, bounds));
+						}
+						position = bounds;
 						if (adaptiveUsable) {
 							log.info("Initialized adaptive tracking after " + std::to_string(tries) + " tries");
 						} else if (tries == 10) {
 							log.warn("Could not initialize tracker after " + std::to_string(tries) + " tries (patch too small/big?)");
-							std::cerr << "Could not initialize tracker - press 'q' to quit program" << std::endl;
 							stop();
-							while ('q' != (char)cv::waitKey(10));
+							waitForQuit("Could not initialize tracker");
 						}
 					}
 				}
-				imshow(videoWindowName, image);
-				if (imageSink.get() != 0)
-					imageSink->add(image);
-
-				int delay = paused ? 0 : 5;
-				char c = (char)cv::waitKey(delay);
-				if (c == 'p')
-					paused = !paused;
-				else if (c == 'q')
-					stop();
-				frameIndex++;
+				addResult(adaptiveUsable ? position : optional<Rect>());
+				if (needsVisualization()) {
+					Visualization visualization;
+					visualization.image = frame;
+					visualization.groundTruth = imageSource->getLandmarks();
+					visualization.target = position;
+					visualization.usedAdaptive = true;
+					visualization.adapted = true;
+					show(visualization);
+				}
+				if (display)
+					handleKey(display->getKey());
+				while (running && paused) {
+					std::this_thread::sleep_for(milliseconds(10));
+					handleKey(display->getKey());
+				}
 			}
 		}
 	}
@@ -926,30 +1040,31 @@ void HeadTracking::run() {
 		steady_clock::time_point frameStart = steady_clock::now();
 
 		if (!imageSource->next()) {
-			std::cerr << "Could not capture frame - press 'q' to quit program" << std::endl;
 			stop();
-			while ('q' != (char)cv::waitKey(10));
+			waitForQuit("Could not capture frame");
 		} else {
 			frames++;
 			frame = imageSource->getImage();
 			steady_clock::time_point condensationStart = steady_clock::now();
 			bool usedAdaptive = false;
 			bool adapted = false;
-			optional<Rect> position = adaptiveTracker->process(frame);
-			usedAdaptive = true;
-			adapted = adaptiveTracker->hasAdapted();
-			steady_clock::time_point condensationEnd = steady_clock::now();
-			frame.copyTo(image);
-			drawDebug(image, usedAdaptive);
-			drawGroundTruth(image, imageSource->getLandmarks());
-			drawTarget(image, position, usedAdaptive, adapted);
-			imshow(videoWindowName, image);
-			if (imageSink.get() != 0)
-				imageSink->add(image);
+			optional<Rect> position;
+			milliseconds condensationTime;
+			{
+				std::lock_guard<std::mutex> lock(trackingMutex);
+				position = adaptiveTracker->process(frame);
+				usedAdaptive = true;
+				adapted = adaptiveTracker->hasAdapted();
+				steady_clock::time_point condensationEnd = steady_clock::now();
+				condensationTime = duration_cast<milliseconds>(condensationEnd - condensationStart);
+				addResult(position);
+				if (needsVisualization())
+					show(createVisualization(position, usedAdaptive, adapted));
+			}
 			steady_clock::time_point frameEnd = steady_clock::now();
+			INSTRUMENT_END_FRAME();
 
 			milliseconds iterationTime = duration_cast<milliseconds>(frameEnd - frameStart);
-			milliseconds condensationTime = duration_cast<milliseconds>(condensationEnd - condensationStart);
 			allIterationTime += iterationTime;
 			allCondensationTime += condensationTime;
 			float iterationFps = frames / allIterationTime.count();
@@ -961,14 +1076,25 @@ void HeadTracking::run() {
 					<< " condensation: " << condensationTime.count() << " ms (" << condensationFps << " fps)";
 			log.info(text.str());
 
-			int delay = paused ? 0 : 5;
-			char c = (char)cv::waitKey(delay);
-			if (c == 'p')
-				paused = !paused;
-			else if (c == 'q')
-				stop();
+			if (display)
+				handleKey(display->getKey());
+			while (running && paused) {
+				std::this_thread::sleep_for(milliseconds(10));
+				handleKey(display->getKey());
+			}
 		}
 	}
+
+	if (frames > 0) {
+		ostringstream text;
+		text.precision(3);
+		text << "Tracked " << frames << " frames with " << (frames / allIterationTime.count()) << " fps"
+				<< " (condensation: " << (frames / allCondensationTime.count()) << " fps)";
+		if (display)
+			text << ", " << display->getDroppedCount() << " frames were not displayed";
+		log.info(text.str());
+	}
+	display.reset();
 }
 
 void HeadTracking::stop() {
@@ -984,6 +1110,9 @@ int main(int argc, char *argv[]) {
 	string configFile;
 	string outputFile;
 	int outputFps = -1;
+	string resultFile;
+	bool headless = false;
+	string instrumentationFile;
 
 	try {
 		po::options_description desc("Allowed options");
@@ -1000,6 +1129,9 @@ int main(int argc, char *argv[]) {
 			("config,c", po::value< string >(&configFile)->default_value("default.cfg","default.cfg"), "The filename to the config file.")
 			("output,o", po::value< string >(&outputFile)->default_value("","none"), "Filename to a video file for storing the image data.")
 			("output-fps,r", po::value<int>(&outputFps)->default_value(-1), "The framerate of the output video.")
+			("result,R", po::value< string >(&resultFile)->default_value("","none"), "Filename to a text file for storing the estimated target position of each frame.")
+			("headless", "Run the tracking without any window, e.g. for measuring the throughput. Needs a ground truth for initialization.")
+			("instrumentation", po::value< string >(&instrumentationFile)->default_value("","none"), "Filename to a JSON file for storing the per-frame stage timings and counters (needs WITH_INSTRUMENTATION).")
 			;
 
 		po::variables_map vm;
@@ -1023,6 +1155,8 @@ int main(int argc, char *argv[]) {
 			useGroundTruth = true;
 		if (vm.count("bobot"))
 			bobot = true;
+		if (vm.count("headless"))
+			headless = true;
 	}
 	catch (std::exception& e) {
 		std::cout << e.what() << std::endl;
@@ -1072,13 +1206,19 @@ int main(int argc, char *argv[]) {
 		imageSink.reset(new VideoImageSink(outputFile, outputFps));
 	}
 
+	unique_ptr<OrderedLandmarkSink> resultSink;
+	if (resultFile != "")
+		resultSink.reset(new SingleLandmarkSink(resultFile));
+
 	ptree config;
 	read_info(configFile, config);
 	if (useGroundTruth)
 		config.put("tracking.initial", "groundtruth");
 	try {
-		unique_ptr<HeadTracking> tracker(new HeadTracking(move(labeledImageSource), move(imageSink), config.get_child("tracking")));
+		unique_ptr<HeadTracking> tracker(new HeadTracking(move(labeledImageSource), move(imageSink), move(resultSink), config.get_child("tracking"), headless));
 		tracker->run();
+		if (instrumentationFile != "")
+			Instrumentation::Instance()->writeJson(instrumentationFile);
 	} catch (std::exception& exc) {
 		Loggers->getLogger("app").error(string("A wild exception appeared: ") + exc.what());
 		throw;
@@ -10,6 +10,8 @@
 
 #include "imageio/LabeledImageSource.hpp"
 #include "imageio/ImageSink.hpp"
+#include "imageio/WindowImageSink.hpp"
+#include "imageio/OrderedLandmarkSink.hpp"
 #include "imageio/LandmarkCollection.hpp"
 #include "imageprocessing/FeatureExtractor.hpp"
 #include "imageprocessing/DirectPyramidFeatureExtractor.hpp"
@@ -25,13 +27,15 @@
 #include "condensation/SimpleTransitionModel.hpp"
 #include "condensation/OpticalFlowTransitionModel.hpp"
 #include "condensation/ResamplingSampler.hpp"
-#include "condensation/GridSampler.hpp"
+#include "condensation/Sampler.hpp"
+#include "condensation/Sample.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "boost/property_tree/ptree.hpp"
 #include <memory>
 #include <string>
-#include <memory>
-#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
 
 using namespace imageio;
 using namespace imageprocessing;
@@ -49,7 +53,17 @@ using std::make_shared;
 class HeadTracking {
 public:
 
-	HeadTracking(unique_ptr<LabeledImageSource> imageSource, unique_ptr<ImageSink> imageSink, ptree& config);
+	/**
+	 * Constructs a new head tracking.
+	 *
+	 * @param[in] imageSource Source of the images and ground truth.
+	 * @param[in] imageSink Sink for the visualized images (may be null). Is written to on the tracking thread.
+	 * @param[in] resultSink Sink for the estimated target positions, one per frame (may be null).
+	 * @param[in] config The configuration of the tracking.
+	 * @param[in] headless Flag that indicates whether to run without any window. Does not work with manual initialization.
+	 */
+	HeadTracking(unique_ptr<LabeledImageSource> imageSource, unique_ptr<ImageSink> imageSink,
+			unique_ptr<OrderedLandmarkSink> resultSink, ptree& config, bool headless);
 	~HeadTracking();
 
 	void run();
@@ -59,6 +73,19 @@ private:
 
 	enum class Initialization { AUTOMATIC, MANUAL, GROUND_TRUTH };
 
+	/**
+	 * Copy of everything that is drawn onto a frame, so the drawing can happen on the display thread
+	 * while the tracker already processes the next frame.
+	 */
+	struct Visualization {
+		Mat image; ///< The frame (a copy with the optical flow drawn onto it, if that is enabled).
+		std::vector<Sample> samples; ///< Copies of the samples, empty if they should not be drawn.
+		LandmarkCollection groundTruth; ///< The ground truth of the frame.
+		optional<Rect> target; ///< The estimated position of the target.
+		bool usedAdaptive; ///< Flag that indicates whether the adaptive tracker was used.
+		bool adapted; ///< Flag that indicates whether the adaptive tracker adapted to the frame.
+	};
+
 	static void adaptiveChanged(int state, void* userdata);
 	static void positionDeviationChanged(int state, void* userdata);
 	static void sizeDeviationChanged(int state, void* userdata);
@@ -90,27 +117,40 @@ private:
 			shared_ptr<TrainableSvmClassifier> trainableSvm, ptree& config);
 	void initTracking(ptree& config);
 	void initGui();
-	void drawDebug(Mat& image, bool usedAdaptive);
+	bool needsVisualization() const;
+	Visualization createVisualization(optional<Rect> target, bool usedAdaptive, bool adapted);
+	void show(const Visualization& visualization);
+	void addResult(optional<Rect> target);
+	optional<Rect> takeSelection();
+	void handleKey(int key);
+	void waitForQuit(const string& message);
+	static void draw(Mat& image, const Visualization& visualization);
+	static void drawDebug(Mat& image, const std::vector<Sample>& samples);
 	void drawCrosshair(Mat& image);
 	void drawBox(Mat& image);
-	void drawGroundTruth(Mat& image, const LandmarkCollection& target);
-	void drawTarget(Mat& image, optional<Rect> target, bool usedAdaptive, bool adapted);
+	static void drawGroundTruth(Mat& image, const LandmarkCollection& target);
+	static void drawTarget(Mat& image, optional<Rect> target, bool usedAdaptive, bool adapted);
 
 	static const string videoWindowName;
 	static const string controlWindowName;
 
 	Mat frame;
-	Mat image;
 	unique_ptr<LabeledImageSource> imageSource;
 	unique_ptr<ImageSink> imageSink;
+	unique_ptr<OrderedLandmarkSink> resultSink;
+	unique_ptr<WindowImageSink> display; ///< Shows the images and runs the GUI callbacks on a thread of its own, null if headless.
+	std::mutex trackingMutex; ///< Guards the trackers against changes by the GUI callbacks, which run on the display thread.
+	std::mutex selectionMutex; ///< Guards the mouse positions and the selection, which are written by the mouse callback.
 
 	int currentX, currentY;
 	int storedX, storedY;
+	optional<Rect> selection; ///< Position of the target that was selected with the mouse, but not used for initialization yet.
 
-	bool running;
+	std::atomic<bool> running;
 	bool paused;
+	bool headless;
 	bool useAdaptive;
-	bool adaptiveUsable;
+	std::atomic<bool> adaptiveUsable;
 	bool drawSamples;
 	int drawFlow;
 
@@ -122,7 +162,7 @@ private:
 	shared_ptr<OpticalFlowTransitionModel> opticalFlowTransitionModel;
 	shared_ptr<ResamplingSampler> initialResamplingSampler;
 	shared_ptr<ResamplingSampler> adaptiveResamplingSampler;
-	shared_ptr<GridSampler> gridSampler;
+	shared_ptr<Sampler> gridSampler;
 };
 
 #endif /* HEADTRACKING_HPP_ */
@@ -8,7 +8,7 @@
 #ifndef AGEBASEDEXAMPLEMANAGEMENT_HPP_
 #define AGEBASEDEXAMPLEMANAGEMENT_HPP_
 
-#include "classification/VectorBasedExampleManagement.hpp"
+#include "classification/MatrixBasedExampleManagement.hpp"
 
 namespace classification {
 
@@ -16,7 +16,7 @@ namespace classification {
  * Example storage that, when reaching maximum size, replaces the oldest training examples with
  * new ones.
  */
-class AgeBasedExampleManagement : public VectorBasedExampleManagement {
+class AgeBasedExampleManagement : public MatrixBasedExampleManagement {
 public:
 
 	/**
@@ -29,6 +29,8 @@ public:
 
 	void add(const std::vector<cv::Mat>& newExamples);
 
+	void clear();
+
 private:
 
 	size_t insertPosition; ///< The insertion index of new examples.
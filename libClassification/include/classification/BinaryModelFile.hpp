@@ -0,0 +1,396 @@
+/*
+ * BinaryModelFile.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+#pragma once
+
+#ifndef BINARYMODELFILE_HPP_
+#define BINARYMODELFILE_HPP_
+
+#include "opencv2/core/core.hpp"
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+
+namespace boost {
+	namespace interprocess {
+		class mapped_region;
+	}
+}
+
+namespace classification {
+
+class Kernel;
+
+/**
+ * The kind of model that is stored in a binary model file.
+ */
+enum class BinaryModelType : std::uint32_t {
+	Svm = 1, ///< SvmClassifier, see SvmClassifier::writeBinary().
+	Wvm = 2, ///< WvmClassifier, see WvmClassifier::writeBinary().
+	Rvm = 3, ///< RvmClassifier, see RvmClassifier::writeBinary().
+	StaticNegatives = 4, ///< A matrix of static negative training examples (one example per row, CV_64F).
+	PatchSet = 5 ///< A set of patches of the same size and type, see BinaryPatchSetWriter.
+};
+
+/**
+ * Writes the binary classifier model format (usually with the extension .bcm). A file starts with a header
+ * containing a magic number, the format version, the model type and (optionally) the parameters of the logistic
+ * function of a probabilistic classifier. The header is followed by the values and blocks written by the classifier.
+ * Blocks (e.g. all support vectors or filters) are aligned to binaryAlignment bytes inside the file, so they can be
+ * read in one go directly into the memory used by the classifier. The values are stored with the byte order of the
+ * machine that wrote the file.
+ */
+class BinaryModelWriter {
+public:
+
+	/**
+	 * Creates the file and writes the header of a non-probabilistic classifier.
+	 *
+	 * @param[in] filename The name of the file to write.
+	 * @param[in] type The model type.
+	 */
+	BinaryModelWriter(const std::string& filename, BinaryModelType type);
+
+	/**
+	 * Creates the file and writes the header of a probabilistic classifier.
+	 *
+	 * @param[in] filename The name of the file to write.
+	 * @param[in] type The model type.
+	 * @param[in] logisticA Parameter a of the logistic function p(x) = 1 / (1 + exp(a + b * x)).
+	 * @param[in] logisticB Parameter b of the logistic function p(x) = 1 / (1 + exp(a + b * x)).
+	 */
+	BinaryModelWriter(const std::string& filename, BinaryModelType type, double logisticA, double logisticB);
+
+	/**
+	 * Writes a single value.
+	 *
+	 * @param[in] value The value (of a fundamental type).
+	 */
+	template<class T>
+	void write(T value) {
+		file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	/**
+	 * Writes a block of data that starts at an aligned position inside the file.
+	 *
+	 * @param[in] data The data.
+	 * @param[in] size The size of the data in bytes.
+	 */
+	void writeBlock(const void* data, std::size_t size);
+
+	/**
+	 * Starts a block that is written in several parts using writeData(), by padding the file to an aligned position.
+	 */
+	void beginBlock();
+
+	/**
+	 * Writes data without padding, e.g. the next part of a block started with beginBlock().
+	 *
+	 * @param[in] data The data.
+	 * @param[in] size The size of the data in bytes.
+	 */
+	void writeData(const void* data, std::size_t size);
+
+	/**
+	 * @return The current position inside the file.
+	 */
+	std::streamoff getPosition() {
+		return file.tellp();
+	}
+
+	/**
+	 * Overwrites a single value that was written before (e.g. a count that is only known at the end), and
+	 * continues writing at the end of the file afterwards.
+	 *
+	 * @param[in] position The position of the value inside the file, see getPosition().
+	 * @param[in] value The value (of a fundamental type).
+	 */
+	template<class T>
+	void writeAt(std::streamoff position, T value) {
+		std::streamoff end = file.tellp();
+		file.seekp(position);
+		write(value);
+		file.seekp(end);
+	}
+
+	/**
+	 * Flushes the data and closes the file.
+	 */
+	void close() {
+		file.close();
+	}
+
+	/**
+	 * Writes the type and parameters of a kernel.
+	 *
+	 * @param[in] kernel The kernel.
+	 */
+	void writeKernel(const Kernel& kernel);
+
+	/**
+	 * Writes the size, type and data of vectors (e.g. support vectors). The data of all vectors is written as a single block.
+	 * Throws a std::runtime_error if the vectors differ in size or type.
+	 *
+	 * @param[in] vectors The vectors.
+	 */
+	void writeVectors(const std::vector<cv::Mat>& vectors);
+
+	static const std::size_t binaryAlignment = 64; ///< The alignment of the blocks inside the file, in bytes.
+
+private:
+
+	/**
+	 * Creates the file and writes the header.
+	 */
+	void writeHeader(const std::string& filename, BinaryModelType type, bool probabilistic, double logisticA, double logisticB);
+
+	std::ofstream file; ///< The file that is written.
+};
+
+/**
+ * Reads the binary classifier model format, see BinaryModelWriter. The file is memory-mapped, so the blocks are
+ * copied straight from the mapping into the memory of the classifier without going through a stream buffer.
+ */
+class BinaryModelReader {
+public:
+
+	/**
+	 * Maps the file and reads the header. Throws a std::runtime_error if the file cannot be mapped, is not a binary
+	 * model file, has an unsupported version or does not contain a model of the expected type.
+	 *
+	 * @param[in] filename The name of the file to read.
+	 * @param[in] expectedType The model type that the file has to contain.
+	 */
+	BinaryModelReader(const std::string& filename, BinaryModelType expectedType);
+
+	/**
+	 * Determines whether a file is a binary model file by looking at its first bytes.
+	 *
+	 * @param[in] filename The name of the file.
+	 * @return True if the file exists and starts with the magic number of binary model files, false otherwise.
+	 */
+	static bool isBinaryModelFile(const std::string& filename);
+
+	/**
+	 * Determines the type of model that a binary model file contains.
+	 * Throws a std::runtime_error if the file cannot be opened or is not a binary model file.
+	 *
+	 * @param[in] filename The name of the file.
+	 * @return The model type.
+	 */
+	static BinaryModelType getModelType(const std::string& filename);
+
+	/**
+	 * Reads a single value.
+	 *
+	 * @return The value (of a fundamental type).
+	 */
+	template<class T>
+	T read() {
+		T value;
+		readData(&value, sizeof(T));
+		return value;
+	}
+
+	/**
+	 * Reads a block of data that was written with BinaryModelWriter::writeBlock() using a single copy from the mapping.
+	 *
+	 * @param[out] data The memory to read the data into.
+	 * @param[in] size The size of the data in bytes.
+	 */
+	void readBlock(void* data, std::size_t size);
+
+	/**
+	 * Skips to the beginning of a block that is read in several parts using readData().
+	 */
+	void beginBlock();
+
+	/**
+	 * Reads data without skipping padding, e.g. the next part of a block started with beginBlock().
+	 *
+	 * @param[out] data The memory to read the data into.
+	 * @param[in] size The size of the data in bytes.
+	 */
+	void readData(void* data, std::size_t size);
+
+	/**
+	 * Reads a kernel that was written with BinaryModelWriter::writeKernel().
+	 *
+	 * @return The kernel.
+	 */
+	std::shared_ptr<Kernel> readKernel();
+
+	/**
+	 * Reads vectors that were written with BinaryModelWriter::writeVectors(). The data of all vectors is read into one
+	 * matrix (one row per vector), the returned vectors refer to the rows of that matrix.
+	 *
+	 * @param[out] data The matrix that receives the data of all vectors.
+	 * @return The vectors.
+	 */
+	std::vector<cv::Mat> readVectors(cv::Mat& data);
+
+	/**
+	 * @return True if the file contains a probabilistic classifier, false otherwise.
+	 */
+	bool isProbabilistic() const {
+		return probabilistic;
+	}
+
+	/**
+	 * @return Parameter a of the logistic function (only valid if the classifier is probabilistic).
+	 */
+	double getLogisticA() const {
+		return logisticA;
+	}
+
+	/**
+	 * @return Parameter b of the logistic function (only valid if the classifier is probabilistic).
+	 */
+	double getLogisticB() const {
+		return logisticB;
+	}
+
+private:
+
+	std::string filename; ///< The name of the file that is read.
+	std::shared_ptr<boost::interprocess::mapped_region> mappedRegion; ///< The mapping of the file that is read.
+	std::size_t offset; ///< The current position inside the file.
+	bool probabilistic; ///< Flag that indicates whether the file contains a probabilistic classifier.
+	double logisticA; ///< Parameter a of the logistic function.
+	double logisticB; ///< Parameter b of the logistic function.
+};
+
+/**
+ * Writes static negative training examples to a binary model file. The examples are written as one block.
+ *
+ * @param[in] filename The name of the file to write.
+ * @param[in] negatives The examples (one example per row, CV_64F).
+ */
+void writeStaticNegatives(const std::string& filename, const cv::Mat& negatives);
+
+/**
+ * Reads static negative training examples from a binary model file that was written by writeStaticNegatives() or
+ * by BinaryPatchSetWriter. In the latter case, each patch becomes one row.
+ *
+ * @param[in] filename The name of the file to read.
+ * @param[in] maxNegatives The maximum amount of examples to read.
+ * @return The examples (one example per row, CV_64F).
+ */
+cv::Mat readStaticNegatives(const std::string& filename, int maxNegatives);
+
+/**
+ * Writes patches of the same size and type (e.g. training examples) to a binary model file, one patch after another,
+ * so the patches do not have to be kept in memory. After the header, the file contains the number of patches, their
+ * height, width and type, followed by the data of all patches as one block. The number of patches is written when
+ * the file is closed.
+ */
+class BinaryPatchSetWriter {
+public:
+
+	/**
+	 * Creates the file and writes the header.
+	 *
+	 * @param[in] filename The name of the file to write.
+	 * @param[in] height The height of each patch.
+	 * @param[in] width The width of each patch.
+	 * @param[in] type The type of each patch.
+	 */
+	BinaryPatchSetWriter(const std::string& filename, int height, int width, int type);
+
+	/**
+	 * Closes the file if that was not done before.
+	 */
+	~BinaryPatchSetWriter();
+
+	/**
+	 * Appends patches to the file. Throws a std::runtime_error if a patch differs in size or type.
+	 *
+	 * @param[in] patches The patches.
+	 */
+	void write(const std::vector<cv::Mat>& patches);
+
+	/**
+	 * Writes the number of patches and closes the file.
+	 */
+	void close();
+
+private:
+
+	BinaryModelWriter writer; ///< The writer of the binary model file.
+	std::streamoff countPosition; ///< The position of the number of patches inside the file.
+	int count; ///< The number of patches written so far.
+	int height; ///< The height of each patch.
+	int width; ///< The width of each patch.
+	int type; ///< The type of each patch.
+	bool closed; ///< Flag that indicates whether the file was closed already.
+};
+
+/**
+ * Reads patches from a binary model file that was written by BinaryPatchSetWriter, a few at a time.
+ */
+class BinaryPatchSetReader {
+public:
+
+	/**
+	 * Opens the file and reads the header. Throws a std::runtime_error if the file cannot be opened or does not
+	 * contain a patch set.
+	 *
+	 * @param[in] filename The name of the file to read.
+	 */
+	explicit BinaryPatchSetReader(const std::string& filename);
+
+	/**
+	 * Reads the next patches. Each patch is allocated separately.
+	 *
+	 * @param[out] patches The patches that were read, empty if there are no patches left.
+	 * @param[in] maxCount The maximum number of patches to read.
+	 */
+	void read(std::vector<cv::Mat>& patches, std::size_t maxCount);
+
+	/**
+	 * @return The number of patches inside the file.
+	 */
+	int getCount() const {
+		return count;
+	}
+
+	/**
+	 * @return The height of each patch.
+	 */
+	int getHeight() const {
+		return height;
+	}
+
+	/**
+	 * @return The width of each patch.
+	 */
+	int getWidth() const {
+		return width;
+	}
+
+	/**
+	 * @return The type of each patch.
+	 */
+	int getType() const {
+		return type;
+	}
+
+private:
+
+	BinaryModelReader reader; ///< The reader of the binary model file.
+	int count; ///< The number of patches inside the file.
+	int height; ///< The height of each patch.
+	int width; ///< The width of each patch.
+	int type; ///< The type of each patch.
+	int remaining; ///< The number of patches that were not read yet.
+};
+
+} /* namespace classification */
+#endif /* BINARYMODELFILE_HPP_ */
@@ -8,7 +8,8 @@
 #ifndef CONFIDENCEBASEDEXAMPLEMANAGEMENT_HPP_
 #define CONFIDENCEBASEDEXAMPLEMANAGEMENT_HPP_
 
-#include "classification/VectorBasedExampleManagement.hpp"
+#include "classification/MatrixBasedExampleManagement.hpp"
+#include <utility>
 
 namespace classification {
 
@@ -17,8 +18,12 @@ class BinaryClassifier;
 /**
  * Example storage that, when reaching maximum size, replaces training examples that have the highest
  * confidence when evaluated by the classifier. The first training example will not be replaced.
+ *
+ * The confidences of the stored training examples are cached and only re-computed after the classifier
+ * changed (see classifierChanged()). The replaceable examples are kept in a heap with the highest confidence
+ * on top, so adding an example costs O(log n) as long as the classifier does not change.
  */
-class ConfidenceBasedExampleManagement : public VectorBasedExampleManagement {
+class ConfidenceBasedExampleManagement : public MatrixBasedExampleManagement {
 public:
 
 	/**
@@ -33,10 +38,30 @@ public:
 
 	void add(const std::vector<cv::Mat>& newExamples);
 
+	void clear();
+
+	void classifierChanged();
+
 private:
 
+	/**
+	 * Computes the confidence of a training example, which is negative if it is classified wrongly.
+	 *
+	 * @param[in] example The training example.
+	 * @return The confidence of the classifier that the example belongs to the class of this set.
+	 */
+	double computeConfidence(const cv::Mat& example) const;
+
+	/**
+	 * Re-computes the confidences of all stored training examples and rebuilds the heap.
+	 */
+	void updateConfidences();
+
 	const std::shared_ptr<BinaryClassifier> classifier; ///< Classifier for computing the confidences of the training examples.
 	bool positive; ///< Flag that indicates whether this set contains positive training examples.
+	bool confidencesValid; ///< Flag that indicates whether the cached confidences belong to the current classifier.
+	std::vector<double> confidences; ///< Cached confidences of the stored training examples.
+	std::vector<std::pair<double, size_t>> heap; ///< Max-heap of the confidences and indices of the replaceable training examples.
 };
 
 } /* namespace classification */
@@ -56,6 +56,12 @@ public:
 	 */
 	virtual void clear() = 0;
 
+	/**
+	 * Notifies this example management that the classifier was changed (e.g. re-trained), so any classification
+	 * results of the stored training examples that were cached are outdated.
+	 */
+	virtual void classifierChanged() {}
+
 	/**
 	 * @return Amount of training examples.
 	 */
@@ -0,0 +1,109 @@
+/*
+ * MatrixBasedExampleManagement.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef MATRIXBASEDEXAMPLEMANAGEMENT_HPP_
+#define MATRIXBASEDEXAMPLEMANAGEMENT_HPP_
+
+#include "classification/ExampleManagement.hpp"
+
+namespace classification {
+
+/**
+ * Example management with a fixed capacity that stores the training examples in the rows of a single contiguous
+ * matrix, which is allocated once when the first example arrives. Replacing an example copies its data into the
+ * row of the replaced one, so no memory is allocated per example. All examples must have the same size and type.
+ */
+class MatrixBasedExampleManagement : public ExampleManagement {
+public:
+
+	/**
+	 * Constructs a new matrix based example management.
+	 *
+	 * @param[in] capacity Maximum amount of stored training examples.
+	 * @param[in] requiredSize Minimum amount of training examples required for training.
+	 */
+	explicit MatrixBasedExampleManagement(size_t capacity, size_t requiredSize = 1);
+
+	virtual ~MatrixBasedExampleManagement();
+
+	void clear();
+
+	size_t size() const;
+
+	bool hasRequiredSize() const;
+
+	std::unique_ptr<ExampleManagement::ExampleIterator> iterator() const;
+
+protected:
+
+	/**
+	 * @return Maximum amount of stored training examples.
+	 */
+	size_t capacity() const;
+
+	/**
+	 * Appends a training example, there must be space left.
+	 *
+	 * @param[in] example The new training example.
+	 * @return The index of the new training example.
+	 */
+	size_t append(const cv::Mat& example);
+
+	/**
+	 * Replaces a stored training example.
+	 *
+	 * @param[in] index The index of the training example that is replaced.
+	 * @param[in] example The new training example.
+	 */
+	void replace(size_t index, const cv::Mat& example);
+
+	/**
+	 * @param[in] index The index of a stored training example.
+	 * @return The training example, which refers to the data inside the example matrix.
+	 */
+	const cv::Mat& get(size_t index) const;
+
+private:
+
+	/**
+	 * Checks a new training example and allocates the example matrix if it does not exist yet.
+	 *
+	 * @param[in] example The new training example.
+	 */
+	void prepare(const cv::Mat& example);
+
+	/**
+	 * Example iterator that iterates over the rows of the example matrix.
+	 */
+	class MatrixIterator : public ExampleIterator {
+	public:
+
+		/**
+		 * Constructs a new matrix based example iterator.
+		 *
+		 * @param[in] examples Training examples to iterate over.
+		 */
+		MatrixIterator(const std::vector<cv::Mat>& examples);
+
+		bool hasNext() const;
+
+		const cv::Mat& next();
+
+	private:
+
+		std::vector<cv::Mat>::const_iterator current; ///< Iterator that points to the current training example.
+		std::vector<cv::Mat>::const_iterator end;     ///< Iterator that points behind the last training example.
+	};
+
+	size_t maxSize; ///< Maximum amount of stored training examples.
+	size_t requiredSize; ///< Minimum amount of training examples required for training.
+	cv::Mat matrix; ///< Matrix with one training example per row.
+	std::vector<cv::Mat> examples; ///< Headers of the stored training examples (with their original shape) that refer to the rows of the matrix.
+};
+
+} /* namespace classification */
+#endif /* MATRIXBASEDEXAMPLEMANAGEMENT_HPP_ */
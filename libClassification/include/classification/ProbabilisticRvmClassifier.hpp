@@ -82,6 +82,22 @@ public:
 	 */
 	static std::shared_ptr<ProbabilisticRvmClassifier> load(const boost::property_tree::ptree& subtree);
 
+	/**
+	 * Creates a new probabilistic RVM classifier from a binary model file (see writeBinary()). The file
+	 * has to contain the logistic parameters.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 * @return The newly created probabilistic RVM classifier.
+	 */
+	static std::shared_ptr<ProbabilisticRvmClassifier> loadFromBinary(const std::string& classifierFilename);
+
+	/**
+	 * Writes the RVM and the logistic parameters to a binary model file.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 */
+	void writeBinary(const std::string& classifierFilename) const;
+
 	/**
 	 * @return The actual RVM.
 	 */
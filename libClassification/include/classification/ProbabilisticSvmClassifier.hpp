@@ -99,6 +99,22 @@ public:
 	 */
 	static std::shared_ptr<ProbabilisticSvmClassifier> load(const boost::property_tree::ptree& subtree);
 
+	/**
+	 * Creates a new probabilistic SVM classifier from a binary model file (see writeBinary()). If the file contains
+	 * a non-probabilistic SVM, the default logistic parameters are used.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 * @return The newly created probabilistic SVM classifier.
+	 */
+	static std::shared_ptr<ProbabilisticSvmClassifier> loadFromBinary(const std::string& classifierFilename);
+
+	/**
+	 * Writes the SVM and the logistic parameters to a binary model file.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 */
+	void writeBinary(const std::string& classifierFilename) const;
+
 	/**
 	 * @return The actual SVM.
 	 */
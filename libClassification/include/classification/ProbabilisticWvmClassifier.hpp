@@ -82,6 +82,22 @@ public:
 	 */
 	static std::shared_ptr<ProbabilisticWvmClassifier> load(const boost::property_tree::ptree& subtree);
 
+	/**
+	 * Creates a new probabilistic WVM classifier from a binary model file (see writeBinary()). The file
+	 * has to contain the logistic parameters.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 * @return The newly created probabilistic WVM classifier.
+	 */
+	static std::shared_ptr<ProbabilisticWvmClassifier> loadFromBinary(const std::string& classifierFilename);
+
+	/**
+	 * Writes the WVM and the logistic parameters to a binary model file.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 */
+	void writeBinary(const std::string& classifierFilename) const;
+
 	/**
 	 * @return The actual WVM.
 	 */
@@ -17,6 +17,9 @@
 
 namespace classification {
 
+class BinaryModelReader;
+class BinaryModelWriter;
+
 /**
  * Classifier based on a Reduced Vector Machine.
  * An RVM differs from an SVM in certain points:
@@ -108,9 +111,39 @@ public:
 	 */
 	static std::shared_ptr<RvmClassifier> loadFromMatlab(const std::string& classifierFilename, const std::string& thresholdsFilename);
 
+	/**
+	 * Creates a new RVM classifier from a binary model file (see writeBinary()).
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 * @return The newly created RVM classifier.
+	 */
+	static std::shared_ptr<RvmClassifier> loadFromBinary(const std::string& classifierFilename);
+
+	/**
+	 * Creates a new RVM classifier from the remaining content of a binary model file.
+	 *
+	 * @param[in] reader The reader of the binary model file, whose header was already read.
+	 * @return The newly created RVM classifier.
+	 */
+	static std::shared_ptr<RvmClassifier> readBinary(BinaryModelReader& reader);
+
+	/**
+	 * Writes this RVM including its thresholds to a binary model file. All reduced vectors must have the same size and type.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 */
+	void writeBinary(const std::string& classifierFilename) const;
+
+	/**
+	 * Writes the parameters of this RVM to a binary model file whose header was already written.
+	 *
+	 * @param[in] writer The writer of the binary model file.
+	 */
+	void writeBinary(BinaryModelWriter& writer) const;
+
 	/**
 	 * Creates a new RVM classifier from the parameters given in the ptree sub-tree. Passes the
-	 * loading to the respective loading routine (at the moment, only Matlab files are supported).
+	 * loading to the respective loading routine (Matlab files or binary model files).
 	 *
 	 * @param[in] subtree The subtree containing the config information for this classifier.
 	 * @return The newly created RVM classifier.
@@ -123,6 +156,7 @@ private:
 	std::vector<std::vector<float>> coefficients;	///< The coefficients of the support vectors. Each step in the cascade has its own set of coefficients.
 	int numFiltersToUse; ///< The number of filters to use out of the total number.
 	std::vector<float> hierarchicalThresholds; ///< A classification threshold for each filter.
+	cv::Mat supportVectorData; ///< Contiguous memory of the support vectors if they were loaded from a binary model file.
 };
 
 } /* namespace classification */
@@ -16,6 +16,9 @@
 
 namespace classification {
 
+class BinaryModelReader;
+class BinaryModelWriter;
+
 /**
  * Classifier based on a Support Vector Machine.
  */
@@ -53,6 +56,10 @@ public:
 	 * Computes the distance of a feature vector to the decision hyperplane. This is the real distance without
 	 * any influence by the offset for configuring the operating point of the SVM.
 	 *
+	 * With a linear kernel, the support vectors are combined into a single dense weight vector (when the
+	 * parameters are set), which is then scored directly against the feature vector if it is continuous and
+	 * has the same depth (CV_32F or CV_64F).
+	 *
 	 * @param[in] featureVector The feature vector.
 	 * @return The distance of the feature vector to the decision hyperplane.
 	 */
@@ -83,6 +90,37 @@ public:
 	 */
 	static std::shared_ptr<SvmClassifier> loadFromText(const std::string& classifierFilename);
 
+	/**
+	 * Creates a new SVM classifier from a binary model file (see writeBinary()). All support vectors are
+	 * read at once into one contiguous block of memory.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 * @return The newly created SVM classifier.
+	 */
+	static std::shared_ptr<SvmClassifier> loadFromBinary(const std::string& classifierFilename);
+
+	/**
+	 * Creates a new SVM classifier from the remaining content of a binary model file.
+	 *
+	 * @param[in] reader The reader of the binary model file, whose header was already read.
+	 * @return The newly created SVM classifier.
+	 */
+	static std::shared_ptr<SvmClassifier> readBinary(BinaryModelReader& reader);
+
+	/**
+	 * Writes this SVM to a binary model file. All support vectors must have the same size and type.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 */
+	void writeBinary(const std::string& classifierFilename) const;
+
+	/**
+	 * Writes the parameters of this SVM to a binary model file whose header was already written.
+	 *
+	 * @param[in] writer The writer of the binary model file.
+	 */
+	void writeBinary(BinaryModelWriter& writer) const;
+
 	/**
 	 * @return The support vectors.
 	 */
@@ -99,8 +137,16 @@ public:
 
 private:
 
+	/**
+	 * Combines the support vectors into linearWeights if the kernel is linear and the support vectors are
+	 * continuous floating point vectors of the same size and depth. Clears linearWeights otherwise.
+	 */
+	void computeLinearWeights();
+
 	std::vector<cv::Mat> supportVectors; ///< The support vectors.
 	std::vector<float> coefficients; ///< The coefficients of the support vectors.
+	cv::Mat supportVectorData; ///< Contiguous memory of the support vectors if they were loaded from a binary model file.
+	cv::Mat linearWeights; ///< Sum of the support vectors scaled by their coefficients (single row), empty if the kernel is not linear.
 };
 
 } /* namespace classification */
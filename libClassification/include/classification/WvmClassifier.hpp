@@ -17,6 +17,8 @@
 namespace classification {
 
 class IImg;
+class BinaryModelReader;
+class BinaryModelWriter;
 
 /**
  * Classifier based on a Wavelet Reduced Vector Machine.
@@ -69,6 +71,44 @@ public:
 	 */
 	static std::shared_ptr<WvmClassifier> loadFromMatlab(const std::string& classifierFilename, const std::string& thresholdsFilename);
 
+	/**
+	 * Creates a new WVM classifier from a binary model file (see writeBinary()). The filters and
+	 * their weights are read at once into one contiguous block of memory each.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 * @return The newly created WVM classifier.
+	 */
+	static std::shared_ptr<WvmClassifier> loadFromBinary(const std::string& classifierFilename);
+
+	/**
+	 * Creates a new WVM classifier from the remaining content of a binary model file.
+	 *
+	 * @param[in] reader The reader of the binary model file, whose header was already read.
+	 * @return The newly created WVM classifier.
+	 */
+	static std::shared_ptr<WvmClassifier> readBinary(BinaryModelReader& reader);
+
+	/**
+	 * Writes this WVM (including the hierarchical thresholds) to a binary model file.
+	 *
+	 * @param[in] classifierFilename The name of the binary model file.
+	 */
+	void writeBinary(const std::string& classifierFilename) const;
+
+	/**
+	 * Writes the parameters of this WVM to a binary model file whose header was already written.
+	 *
+	 * @param[in] writer The writer of the binary model file.
+	 */
+	void writeBinary(BinaryModelWriter& writer) const;
+
+	/**
+	 * @return The size of the patches this WVM expects (width and height of the filters).
+	 */
+	cv::Size getFilterSize() const {
+		return cv::Size(filter_size_x, filter_size_y);
+	}
+
 	int getNumUsedFilters(void);
 	void setNumUsedFilters(int);			 ///< Change the number of currently used wavelet-vectors
 	float getLimitReliabilityFilter(void);
@@ -78,6 +118,14 @@ protected:
 
 	float linEvalWvmHisteq64(int, int, float*, float*, const IImg*, const IImg*) const;
 
+	/**
+	 * Allocates the filters and the weights of the hierarchical kernels, numLinFilters must be set. Each of them
+	 * is one contiguous block of memory, linFilters[i] and hkWeights[i] point into that block.
+	 *
+	 * @param[in] filterSize The number of values of one filter (filter_size_x * filter_size_y).
+	 */
+	void allocateFilters(int filterSize);
+
 	int filter_size_x;	///< We need this for the integral image. Better solution maybe later...
 	int filter_size_y;	///< We need this for the integral image. Better solution maybe later...
 	float basisParam;	///< The Rbf-Kernel parameter. Maybe better solution later to encapsulate it, like in the SVM.
@@ -118,7 +166,8 @@ protected:
 		void dump(char*);
 		int		cntval;
 		double	*val;
-		TRec	**rec;
+		TRec	**rec;		///< rec[v] points into allrec
+		TRec	*allrec;	///< the rectangles of all gray values in one block
 		int		*cntrec;
 		int		cntallrec;
 	};
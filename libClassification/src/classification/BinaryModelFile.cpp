@@ -0,0 +1,343 @@
+/*
+ * BinaryModelFile.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "classification/BinaryModelFile.hpp"
+#include "classification/KernelVisitor.hpp"
+#include "classification/LinearKernel.hpp"
+#include "classification/PolynomialKernel.hpp"
+#include "classification/RbfKernel.hpp"
+#include "classification/HistogramIntersectionKernel.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+using cv::Mat;
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::make_shared;
+using std::int32_t;
+using std::uint32_t;
+using std::runtime_error;
+
+namespace classification {
+
+namespace {
+
+const char magic[8] = { 'B', 'C', 'M', 'O', 'D', 'E', 'L', '\0' }; ///< The first bytes of each binary model file.
+const uint32_t formatVersion = 1; ///< The version of the format that is written.
+
+/**
+ * Kernel types inside the binary format. The values must not change, as they are written to the files.
+ */
+enum class KernelType : uint32_t {
+	Linear = 1,
+	Polynomial = 2,
+	Rbf = 3,
+	HistogramIntersection = 4
+};
+
+/**
+ * Kernel visitor that writes the type and parameters of a kernel.
+ */
+class KernelWriter : public KernelVisitor {
+public:
+
+	explicit KernelWriter(BinaryModelWriter& writer) : writer(writer) {}
+
+	void visit(const LinearKernel& kernel) {
+		writeKernel(KernelType::Linear, 0, 0, 0);
+	}
+
+	void visit(const PolynomialKernel& kernel) {
+		writeKernel(KernelType::Polynomial, kernel.getAlpha(), kernel.getConstant(), kernel.getDegree());
+	}
+
+	void visit(const RbfKernel& kernel) {
+		writeKernel(KernelType::Rbf, kernel.getGamma(), 0, 0);
+	}
+
+	void visit(const HistogramIntersectionKernel& kernel) {
+		writeKernel(KernelType::HistogramIntersection, 0, 0, 0);
+	}
+
+private:
+
+	void writeKernel(KernelType type, double parameter1, double parameter2, double parameter3) {
+		writer.write(static_cast<uint32_t>(type));
+		writer.write(parameter1);
+		writer.write(parameter2);
+		writer.write(parameter3);
+	}
+
+	BinaryModelWriter& writer; ///< The writer of the binary model file.
+};
+
+/**
+ * Computes the amount of padding bytes that are necessary to reach an aligned position.
+ *
+ * @param[in] position The current position inside the file.
+ * @return The amount of padding bytes.
+ */
+std::streamoff computePadding(std::streamoff position) {
+	std::streamoff alignment = static_cast<std::streamoff>(BinaryModelWriter::binaryAlignment);
+	return (alignment - position % alignment) % alignment;
+}
+
+} /* unnamed namespace */
+
+BinaryModelWriter::BinaryModelWriter(const string& filename, BinaryModelType type) {
+	writeHeader(filename, type, false, 0, 0);
+}
+
+BinaryModelWriter::BinaryModelWriter(const string& filename, BinaryModelType type, double logisticA, double logisticB) {
+	writeHeader(filename, type, true, logisticA, logisticB);
+}
+
+void BinaryModelWriter::writeHeader(const string& filename, BinaryModelType type, bool probabilistic, double logisticA, double logisticB) {
+	file.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+		throw runtime_error("BinaryModelWriter: Could not create the file " + filename);
+	file.exceptions(std::ios::failbit | std::ios::badbit);
+	file.write(magic, sizeof(magic));
+	write(formatVersion);
+	write(static_cast<uint32_t>(type));
+	write(static_cast<uint32_t>(probabilistic ? 1 : 0));
+	write(static_cast<uint32_t>(0)); // reserved
+	write(logisticA);
+	write(logisticB);
+}
+
+void BinaryModelWriter::writeBlock(const void* data, std::size_t size) {
+	beginBlock();
+	writeData(data, size);
+}
+
+void BinaryModelWriter::beginBlock() {
+	std::streamoff padding = computePadding(file.tellp());
+	const char zeros[binaryAlignment] = {};
+	file.write(zeros, padding);
+}
+
+void BinaryModelWriter::writeData(const void* data, std::size_t size) {
+	file.write(static_cast<const char*>(data), size);
+}
+
+void BinaryModelWriter::writeKernel(const Kernel& kernel) {
+	KernelWriter kernelWriter(*this);
+	kernel.accept(kernelWriter);
+}
+
+void BinaryModelWriter::writeVectors(const vector<Mat>& vectors) {
+	int rows = vectors.empty() ? 0 : vectors.front().rows;
+	int cols = vectors.empty() ? 0 : vectors.front().cols;
+	int type = vectors.empty() ? CV_32F : vectors.front().type();
+	Mat data(static_cast<int>(vectors.size()), rows * cols * CV_MAT_CN(type), CV_MAT_DEPTH(type));
+	for (size_t i = 0; i < vectors.size(); ++i) {
+		if (vectors[i].rows != rows || vectors[i].cols != cols || vectors[i].type() != type)
+			throw runtime_error("BinaryModelWriter: All vectors must have the same size and type to be written");
+		vectors[i].reshape(1, 1).copyTo(data.row(static_cast<int>(i)));
+	}
+	write(static_cast<int32_t>(vectors.size()));
+	write(static_cast<int32_t>(rows));
+	write(static_cast<int32_t>(cols));
+	write(static_cast<int32_t>(type));
+	writeBlock(data.data, data.total() * data.elemSize());
+}
+
+BinaryModelReader::BinaryModelReader(const string& filename, BinaryModelType expectedType) :
+		filename(filename), offset(0), probabilistic(false), logisticA(0), logisticB(0) {
+	namespace bip = boost::interprocess;
+	try {
+		bip::file_mapping file(filename.c_str(), bip::read_only);
+		mappedRegion = make_shared<bip::mapped_region>(file, bip::read_only); // the mapping stays valid after the file_mapping is destroyed
+	} catch (const bip::interprocess_exception& e) {
+		throw runtime_error("BinaryModelReader: Could not map the file " + filename + ": " + e.what());
+	}
+	if (mappedRegion->get_size() < sizeof(magic) || std::memcmp(mappedRegion->get_address(), magic, sizeof(magic)) != 0)
+		throw runtime_error("BinaryModelReader: Not a binary model file: " + filename);
+	offset = sizeof(magic);
+	if (read<uint32_t>() != formatVersion)
+		throw runtime_error("BinaryModelReader: Unsupported version of the binary model file " + filename);
+	if (read<uint32_t>() != static_cast<uint32_t>(expectedType))
+		throw runtime_error("BinaryModelReader: The file " + filename + " does not contain the expected type of model");
+	probabilistic = read<uint32_t>() != 0;
+	read<uint32_t>(); // reserved
+	logisticA = read<double>();
+	logisticB = read<double>();
+}
+
+bool BinaryModelReader::isBinaryModelFile(const string& filename) {
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	char fileMagic[sizeof(magic)];
+	return file.read(fileMagic, sizeof(fileMagic)) && std::memcmp(fileMagic, magic, sizeof(magic)) == 0;
+}
+
+BinaryModelType BinaryModelReader::getModelType(const string& filename) {
+	std::ifstream file(filename.c_str(), std::ios::binary);
+	if (!file.is_open())
+		throw runtime_error("BinaryModelReader: Could not open the file " + filename);
+	char fileMagic[sizeof(magic)];
+	if (!file.read(fileMagic, sizeof(fileMagic)) || std::memcmp(fileMagic, magic, sizeof(magic)) != 0)
+		throw runtime_error("BinaryModelReader: Not a binary model file: " + filename);
+	uint32_t values[2]; // version and type
+	if (!file.read(reinterpret_cast<char*>(values), sizeof(values)))
+		throw runtime_error("BinaryModelReader: Unexpected end of file " + filename);
+	if (values[0] != formatVersion)
+		throw runtime_error("BinaryModelReader: Unsupported version of the binary model file " + filename);
+	return static_cast<BinaryModelType>(values[1]);
+}
+
+void BinaryModelReader::readBlock(void* data, std::size_t size) {
+	beginBlock();
+	readData(data, size);
+}
+
+void BinaryModelReader::beginBlock() {
+	offset += static_cast<std::size_t>(computePadding(static_cast<std::streamoff>(offset)));
+}
+
+void BinaryModelReader::readData(void* data, std::size_t size) {
+	if (offset > mappedRegion->get_size() || size > mappedRegion->get_size() - offset)
+		throw runtime_error("BinaryModelReader: Unexpected end of file " + filename);
+	std::memcpy(data, static_cast<const char*>(mappedRegion->get_address()) + offset, size);
+	offset += size;
+}
+
+shared_ptr<Kernel> BinaryModelReader::readKernel() {
+	uint32_t type = read<uint32_t>();
+	double parameter1 = read<double>();
+	double parameter2 = read<double>();
+	double parameter3 = read<double>();
+	switch (static_cast<KernelType>(type)) {
+	case KernelType::Linear:
+		return make_shared<LinearKernel>();
+	case KernelType::Polynomial:
+		return make_shared<PolynomialKernel>(parameter1, parameter2, static_cast<int>(parameter3));
+	case KernelType::Rbf:
+		return make_shared<RbfKernel>(parameter1);
+	case KernelType::HistogramIntersection:
+		return make_shared<HistogramIntersectionKernel>();
+	default:
+		throw runtime_error("BinaryModelReader: Unknown kernel type in the file " + filename);
+	}
+}
+
+vector<Mat> BinaryModelReader::readVectors(Mat& data) {
+	int count = read<int32_t>();
+	int rows = read<int32_t>();
+	int cols = read<int32_t>();
+	int type = read<int32_t>();
+	if (count < 0 || rows < 0 || cols < 0)
+		throw runtime_error("BinaryModelReader: Invalid vectors in the file " + filename);
+	data.create(count, rows * cols * CV_MAT_CN(type), CV_MAT_DEPTH(type));
+	readBlock(data.data, data.total() * data.elemSize());
+	vector<Mat> vectors;
+	vectors.reserve(count);
+	for (int i = 0; i < count; ++i) {
+		Mat vector = data.row(i).reshape(CV_MAT_CN(type), rows);
+		vector.flags &= ~Mat::SUBMATRIX_FLAG; // must look like any other vector, as some kernels compare the flags
+		vectors.push_back(vector);
+	}
+	return vectors;
+}
+
+void writeStaticNegatives(const string& filename, const Mat& negatives) {
+	if (negatives.type() != CV_64FC1)
+		throw runtime_error("writeStaticNegatives: The examples must be of type CV_64FC1");
+	Mat data = negatives.isContinuous() ? negatives : negatives.clone();
+	BinaryModelWriter writer(filename, BinaryModelType::StaticNegatives);
+	writer.write(static_cast<int32_t>(data.rows));
+	writer.write(static_cast<int32_t>(data.cols));
+	writer.writeBlock(data.data, data.total() * data.elemSize());
+}
+
+Mat readStaticNegatives(const string& filename, int maxNegatives) {
+	if (BinaryModelReader::getModelType(filename) == BinaryModelType::PatchSet) {
+		BinaryPatchSetReader patchReader(filename);
+		vector<Mat> patches;
+		patchReader.read(patches, static_cast<std::size_t>(std::max(maxNegatives, 0)));
+		int dimensions = patchReader.getHeight() * patchReader.getWidth() * CV_MAT_CN(patchReader.getType());
+		Mat negatives(static_cast<int>(patches.size()), dimensions, CV_64FC1);
+		for (size_t i = 0; i < patches.size(); ++i) {
+			Mat row = negatives.row(static_cast<int>(i));
+			patches[i].reshape(1, 1).convertTo(row, CV_64F);
+		}
+		return negatives;
+	}
+	BinaryModelReader reader(filename, BinaryModelType::StaticNegatives);
+	int count = reader.read<int32_t>();
+	int dimensions = reader.read<int32_t>();
+	if (count < 0 || dimensions < 0)
+		throw runtime_error("readStaticNegatives: Invalid examples in the file " + filename);
+	Mat negatives(std::min(count, std::max(maxNegatives, 0)), dimensions, CV_64FC1);
+	reader.readBlock(negatives.data, negatives.total() * negatives.elemSize()); // the remaining examples are not read
+	return negatives;
+}
+
+BinaryPatchSetWriter::BinaryPatchSetWriter(const string& filename, int height, int width, int type) :
+		writer(filename, BinaryModelType::PatchSet), countPosition(0), count(0), height(height), width(width), type(type), closed(false) {
+	countPosition = writer.getPosition();
+	writer.write(static_cast<int32_t>(0)); // the number of patches is written on closing
+	writer.write(static_cast<int32_t>(height));
+	writer.write(static_cast<int32_t>(width));
+	writer.write(static_cast<int32_t>(type));
+	writer.beginBlock();
+}
+
+BinaryPatchSetWriter::~BinaryPatchSetWriter() {
+	try {
+		close();
+	} catch (...) {} // must not throw, call close() explicitly to get notified about errors
+}
+
+void BinaryPatchSetWriter::write(const vector<Mat>& patches) {
+	for (const Mat& patch : patches) {
+		if (patch.rows != height || patch.cols != width || patch.type() != type)
+			throw runtime_error("BinaryPatchSetWriter: All patches must have the same size and type to be written");
+		if (patch.isContinuous()) {
+			writer.writeData(patch.data, patch.total() * patch.elemSize());
+		} else {
+			for (int row = 0; row < patch.rows; ++row)
+				writer.writeData(patch.ptr(row), patch.cols * patch.elemSize());
+		}
+		++count;
+	}
+}
+
+void BinaryPatchSetWriter::close() {
+	if (closed)
+		return;
+	closed = true;
+	writer.writeAt(countPosition, static_cast<int32_t>(count));
+	writer.close();
+}
+
+BinaryPatchSetReader::BinaryPatchSetReader(const string& filename) : reader(filename, BinaryModelType::PatchSet) {
+	count = reader.read<int32_t>();
+	height = reader.read<int32_t>();
+	width = reader.read<int32_t>();
+	type = reader.read<int32_t>();
+	if (count < 0 || height < 0 || width < 0)
+		throw runtime_error("BinaryPatchSetReader: Invalid patches in the file " + filename);
+	remaining = count;
+	reader.beginBlock();
+}
+
+void BinaryPatchSetReader::read(vector<Mat>& patches, std::size_t maxCount) {
+	std::size_t patchCount = std::min(maxCount, static_cast<std::size_t>(remaining));
+	patches.resize(patchCount);
+	for (Mat& patch : patches) {
+		patch = Mat(height, width, type);
+		reader.readData(patch.data, patch.total() * patch.elemSize());
+	}
+	remaining -= static_cast<int>(patchCount);
+}
+
+} /* namespace classification */
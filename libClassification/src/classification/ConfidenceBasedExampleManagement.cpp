@@ -7,6 +7,7 @@
 
 #include "classification/ConfidenceBasedExampleManagement.hpp"
 #include "classification/BinaryClassifier.hpp"
+#include <algorithm>
 #include <utility>
 
 using cv::Mat;
@@ -19,48 +20,79 @@ namespace classification {
 
 ConfidenceBasedExampleManagement::ConfidenceBasedExampleManagement(
 		const shared_ptr<BinaryClassifier>& classifier, bool positive, size_t capacity, size_t requiredSize) :
-				VectorBasedExampleManagement(capacity, requiredSize), classifier(classifier), positive(positive) {}
+				MatrixBasedExampleManagement(capacity, requiredSize), classifier(classifier), positive(positive),
+				confidencesValid(true), confidences(), heap() {
+	confidences.reserve(capacity);
+	heap.reserve(capacity);
+}
 
 void ConfidenceBasedExampleManagement::add(const vector<Mat>& newExamples) {
-	// compute confidences of existing and new training examples and sort
-	vector<pair<size_t, double>> existingConfidences;
-	existingConfidences.reserve(examples.size());
-	for (size_t i = 1; i < examples.size(); ++i) {
-		pair<bool, double> result = classifier->getConfidence(examples[i]);
-		double score = result.second;
-		if (positive ^ result.first)
-			score = -score;
-		existingConfidences.push_back(make_pair(i, score));
-	}
+	if (!confidencesValid)
+		updateConfidences();
+	// compute confidences of new training examples and sort
 	vector<pair<size_t, double>> newConfidences;
 	newConfidences.reserve(newExamples.size());
-	for (size_t i = 0; i < newExamples.size(); ++i) {
-		pair<bool, double> result = classifier->getConfidence(newExamples[i]);
-		double score = result.second;
-		if (positive ^ result.first)
-			score = -score;
-		newConfidences.push_back(make_pair(i, score));
-	}
-	sort(existingConfidences.begin(), existingConfidences.end(), [](pair<size_t, double> a, pair<size_t, double> b) {
-		return a.second > b.second; // descending order (high confidence first)
-	});
+	for (size_t i = 0; i < newExamples.size(); ++i)
+		newConfidences.push_back(make_pair(i, computeConfidence(newExamples[i])));
 	sort(newConfidences.begin(), newConfidences.end(), [](pair<size_t, double> a, pair<size_t, double> b) {
 		return a.second < b.second; // ascending order (low confidence first)
 	});
 	// add new examples until there is no more space, then replace existing examples that have higher confidence than new examples
+	// (the new examples may not replace each other, so they are put into the heap afterwards)
+	vector<pair<double, size_t>> added;
 	auto newConfidence = newConfidences.cbegin();
-	while (examples.size() < examples.capacity() && newConfidence != newConfidences.cend()) {
-		examples.push_back(newExamples[newConfidence->first]);
+	while (size() < capacity() && newConfidence != newConfidences.cend()) {
+		size_t index = append(newExamples[newConfidence->first]);
+		confidences.push_back(newConfidence->second);
+		if (index > 0) // the first training example will not be replaced
+			added.push_back(make_pair(newConfidence->second, index));
 		++newConfidence;
 	}
-	auto existingConfidence = existingConfidences.cbegin();
-	while (existingConfidence != existingConfidences.cend()
+	while (!heap.empty()
 			&& newConfidence != newConfidences.cend()
-			&& newConfidence->second < existingConfidence->second) {
-		examples[existingConfidence->first] = newExamples[newConfidence->first];
-		++existingConfidence;
+			&& newConfidence->second < heap.front().first) {
+		std::pop_heap(heap.begin(), heap.end());
+		size_t index = heap.back().second;
+		heap.pop_back();
+		replace(index, newExamples[newConfidence->first]);
+		confidences[index] = newConfidence->second;
+		added.push_back(make_pair(newConfidence->second, index));
 		++newConfidence;
 	}
+	for (const pair<double, size_t>& entry : added) {
+		heap.push_back(entry);
+		std::push_heap(heap.begin(), heap.end());
+	}
+}
+
+void ConfidenceBasedExampleManagement::clear() {
+	MatrixBasedExampleManagement::clear();
+	confidences.clear();
+	heap.clear();
+	confidencesValid = true;
+}
+
+void ConfidenceBasedExampleManagement::classifierChanged() {
+	confidencesValid = false;
+}
+
+double ConfidenceBasedExampleManagement::computeConfidence(const Mat& example) const {
+	pair<bool, double> result = classifier->getConfidence(example);
+	double score = result.second;
+	if (positive ^ result.first)
+		score = -score;
+	return score;
+}
+
+void ConfidenceBasedExampleManagement::updateConfidences() {
+	heap.clear();
+	for (size_t i = 0; i < size(); ++i) {
+		confidences[i] = computeConfidence(get(i));
+		if (i > 0) // the first training example will not be replaced
+			heap.push_back(make_pair(confidences[i], i));
+	}
+	std::make_heap(heap.begin(), heap.end());
+	confidencesValid = true;
 }
 
 } /* namespace classification */
@@ -0,0 +1,90 @@
+/*
+ * MatrixBasedExampleManagement.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "classification/MatrixBasedExampleManagement.hpp"
+#include <stdexcept>
+
+using cv::Mat;
+using std::vector;
+using std::unique_ptr;
+using std::invalid_argument;
+using std::logic_error;
+
+namespace classification {
+
+MatrixBasedExampleManagement::MatrixBasedExampleManagement(size_t capacity, size_t requiredSize) :
+		maxSize(capacity), requiredSize(requiredSize), matrix(), examples() {
+	examples.reserve(capacity);
+}
+
+MatrixBasedExampleManagement::~MatrixBasedExampleManagement() {}
+
+void MatrixBasedExampleManagement::clear() {
+	examples.clear();
+}
+
+size_t MatrixBasedExampleManagement::size() const {
+	return examples.size();
+}
+
+bool MatrixBasedExampleManagement::hasRequiredSize() const {
+	return examples.size() >= requiredSize;
+}
+
+unique_ptr<ExampleManagement::ExampleIterator> MatrixBasedExampleManagement::iterator() const {
+	return unique_ptr<MatrixIterator>(new MatrixIterator(examples));
+}
+
+size_t MatrixBasedExampleManagement::capacity() const {
+	return maxSize;
+}
+
+size_t MatrixBasedExampleManagement::append(const Mat& example) {
+	if (examples.size() >= maxSize)
+		throw logic_error("MatrixBasedExampleManagement: there is no space left for another example");
+	prepare(example);
+	size_t index = examples.size();
+	// the header has the shape of the example and shares (and counts references to) the data of the matrix
+	Mat header = matrix.row(static_cast<int>(index)).reshape(example.channels(), example.rows);
+	header.flags &= ~Mat::SUBMATRIX_FLAG; // must look like any other example, as some kernels compare the flags
+	examples.push_back(header);
+	example.copyTo(examples.back());
+	return index;
+}
+
+void MatrixBasedExampleManagement::replace(size_t index, const Mat& example) {
+	prepare(example);
+	example.copyTo(examples[index]);
+}
+
+const Mat& MatrixBasedExampleManagement::get(size_t index) const {
+	return examples[index];
+}
+
+void MatrixBasedExampleManagement::prepare(const Mat& example) {
+	int dimensions = static_cast<int>(example.total() * example.channels());
+	if (examples.empty()) {
+		if (matrix.cols != dimensions || matrix.depth() != example.depth())
+			matrix.create(static_cast<int>(maxSize), dimensions, example.depth());
+	} else if (examples.front().rows != example.rows || examples.front().cols != example.cols || examples.front().type() != example.type()) {
+		throw invalid_argument("MatrixBasedExampleManagement: all examples must have the same size and type");
+	}
+}
+
+MatrixBasedExampleManagement::MatrixIterator::MatrixIterator(const vector<Mat>& examples) : current(examples.cbegin()), end(examples.cend()) {}
+
+bool MatrixBasedExampleManagement::MatrixIterator::hasNext() const {
+	return current != end;
+}
+
+const Mat& MatrixBasedExampleManagement::MatrixIterator::next() {
+	const Mat& example = *current;
+	++current;
+	return example;
+}
+
+} /* namespace classification */
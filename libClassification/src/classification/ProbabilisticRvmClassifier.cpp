@@ -7,6 +7,7 @@
 
 #include "classification/ProbabilisticRvmClassifier.hpp"
 #include "classification/RvmClassifier.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "logging/LoggerFactory.hpp"
 #ifdef WITH_MATLAB_CLASSIFIER
 	#include "mat.h"
@@ -80,11 +81,30 @@ shared_ptr<ProbabilisticRvmClassifier> ProbabilisticRvmClassifier::load(const pt
 		// Option 1: Make a pair<float sigmA, float sigmB> loadSigmFromML(...); <- changed to this now
 		//        2: Here, first call rvm = RvmClassifier::loadConfig(subtree), loads everything.
 		//			 Then, here, call prvm = ProbRvmClass::loadMatlab/ProbabilisticStuff(rvm, thresholdsFile);
+	} else if (classifierFile.extension() == ".bcm") {
+		return loadFromBinary(classifierFile.string());
 	} else {
-		throw logic_error("ProbabilisticRvmClassifier: Only loading of .mat RVMs is supported. If you want to load a non-cascaded RVM, use an SvmClassifier.");
+		throw logic_error("ProbabilisticRvmClassifier: Only loading of .mat and .bcm RVMs is supported. If you want to load a non-cascaded RVM, use an SvmClassifier.");
 	}
 }
 
+shared_ptr<ProbabilisticRvmClassifier> ProbabilisticRvmClassifier::loadFromBinary(const string& classifierFilename)
+{
+	Logger logger = Loggers->getLogger("classification");
+	logger.info("Loading probabilistic RVM classifier from binary file: " + classifierFilename);
+	BinaryModelReader reader(classifierFilename, BinaryModelType::Rvm);
+	if (!reader.isProbabilistic())
+		throw runtime_error("ProbabilisticRvmClassifier: The binary file does not contain the logistic parameters: " + classifierFilename);
+	shared_ptr<RvmClassifier> rvm = RvmClassifier::readBinary(reader);
+	return make_shared<ProbabilisticRvmClassifier>(rvm, reader.getLogisticA(), reader.getLogisticB());
+}
+
+void ProbabilisticRvmClassifier::writeBinary(const string& classifierFilename) const
+{
+	BinaryModelWriter writer(classifierFilename, BinaryModelType::Rvm, logisticA, logisticB);
+	rvm->writeBinary(writer);
+}
+
 pair<double, double> ProbabilisticRvmClassifier::loadSigmoidParamsFromMatlab(const string& logisticFilename)
 {
 	Logger logger = Loggers->getLogger("classification");
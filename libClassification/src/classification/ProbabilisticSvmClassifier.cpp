@@ -7,6 +7,7 @@
 
 #include "classification/ProbabilisticSvmClassifier.hpp"
 #include "classification/SvmClassifier.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "logging/LoggerFactory.hpp"
 #ifdef WITH_MATLAB_CLASSIFIER
 	#include "mat.h"
@@ -68,6 +69,8 @@ shared_ptr<ProbabilisticSvmClassifier> ProbabilisticSvmClassifier::load(const pt
 	shared_ptr<ProbabilisticSvmClassifier> psvm;
 	if (classifierFile.extension() == ".mat") {
 		psvm = loadFromMatlab(classifierFile.string(), subtree.get<string>("thresholdsFile"));
+	} else if (classifierFile.extension() == ".bcm") {
+		psvm = loadFromBinary(classifierFile.string());
 	} else {
 		shared_ptr<SvmClassifier> svm = SvmClassifier::loadFromText(classifierFile.string()); // Todo: Make a ProbabilisticSvmClassifier::loadFromText(...)
 		if (subtree.get("logisticA", 0.0) == 0.0 || subtree.get("logisticB", 0.0) == 0.0) {
@@ -88,6 +91,25 @@ shared_ptr<ProbabilisticSvmClassifier> ProbabilisticSvmClassifier::load(const pt
 	return psvm;
 }
 
+shared_ptr<ProbabilisticSvmClassifier> ProbabilisticSvmClassifier::loadFromBinary(const string& classifierFilename)
+{
+	Logger logger = Loggers->getLogger("classification");
+	logger.info("Loading probabilistic SVM classifier from binary file: " + classifierFilename);
+	BinaryModelReader reader(classifierFilename, BinaryModelType::Svm);
+	shared_ptr<SvmClassifier> svm = SvmClassifier::readBinary(reader);
+	if (!reader.isProbabilistic()) {
+		logger.warn("The binary file does not contain logistic parameters, using default sigmoid parameters.");
+		return make_shared<ProbabilisticSvmClassifier>(svm);
+	}
+	return make_shared<ProbabilisticSvmClassifier>(svm, reader.getLogisticA(), reader.getLogisticB());
+}
+
+void ProbabilisticSvmClassifier::writeBinary(const string& classifierFilename) const
+{
+	BinaryModelWriter writer(classifierFilename, BinaryModelType::Svm, logisticA, logisticB);
+	svm->writeBinary(writer);
+}
+
 shared_ptr<ProbabilisticSvmClassifier> ProbabilisticSvmClassifier::loadFromMatlab(const string& classifierFilename, const string& logisticFilename)
 {
 	pair<double, double> sigmoidParams = loadSigmoidParamsFromMatlab(logisticFilename);
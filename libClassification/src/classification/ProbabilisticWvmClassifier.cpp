@@ -7,10 +7,12 @@
 
 #include "classification/ProbabilisticWvmClassifier.hpp"
 #include "classification/WvmClassifier.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "logging/LoggerFactory.hpp"
 #ifdef WITH_MATLAB_CLASSIFIER
 	#include "mat.h"
 #endif
+#include "boost/filesystem/path.hpp"
 #include <iostream>
 #include <stdexcept>
 
@@ -18,6 +20,7 @@ using logging::Logger;
 using logging::LoggerFactory;
 using cv::Mat;
 using boost::property_tree::ptree;
+using boost::filesystem::path;
 using std::pair;
 using std::string;
 using std::make_pair;
@@ -74,16 +77,39 @@ pair<bool, double> ProbabilisticWvmClassifier::getProbability(pair<int, double>
 
 shared_ptr<ProbabilisticWvmClassifier> ProbabilisticWvmClassifier::load(const ptree& subtree)
 {
-	pair<double, double> sigmoidParams = loadSigmoidParamsFromMatlab(subtree.get<string>("thresholdsFile"));
-	// Load the detector and thresholds:
-	shared_ptr<WvmClassifier> wvm = WvmClassifier::loadFromMatlab(subtree.get<string>("classifierFile"), subtree.get<string>("thresholdsFile"));
-	shared_ptr<ProbabilisticWvmClassifier> pwvm = make_shared<ProbabilisticWvmClassifier>(wvm, sigmoidParams.first, sigmoidParams.second);
+	shared_ptr<ProbabilisticWvmClassifier> pwvm;
+	path classifierFile = subtree.get<path>("classifierFile");
+	if (classifierFile.extension() == ".bcm") {
+		pwvm = loadFromBinary(classifierFile.string());
+	} else {
+		pair<double, double> sigmoidParams = loadSigmoidParamsFromMatlab(subtree.get<string>("thresholdsFile"));
+		// Load the detector and thresholds:
+		shared_ptr<WvmClassifier> wvm = WvmClassifier::loadFromMatlab(classifierFile.string(), subtree.get<string>("thresholdsFile"));
+		pwvm = make_shared<ProbabilisticWvmClassifier>(wvm, sigmoidParams.first, sigmoidParams.second);
+	}
 
 	pwvm->getWvm()->setLimitReliabilityFilter(subtree.get("threshold", 0.0f));
 
 	return pwvm;
 }
 
+shared_ptr<ProbabilisticWvmClassifier> ProbabilisticWvmClassifier::loadFromBinary(const string& classifierFilename)
+{
+	Logger logger = Loggers->getLogger("classification");
+	logger.info("Loading probabilistic WVM classifier from binary file: " + classifierFilename);
+	BinaryModelReader reader(classifierFilename, BinaryModelType::Wvm);
+	if (!reader.isProbabilistic())
+		throw runtime_error("ProbabilisticWvmClassifier: The binary file does not contain the logistic parameters: " + classifierFilename);
+	shared_ptr<WvmClassifier> wvm = WvmClassifier::readBinary(reader);
+	return make_shared<ProbabilisticWvmClassifier>(wvm, reader.getLogisticA(), reader.getLogisticB());
+}
+
+void ProbabilisticWvmClassifier::writeBinary(const string& classifierFilename) const
+{
+	BinaryModelWriter writer(classifierFilename, BinaryModelType::Wvm, logisticA, logisticB);
+	wvm->writeBinary(writer);
+}
+
 shared_ptr<ProbabilisticWvmClassifier> ProbabilisticWvmClassifier::loadFromMatlab(const string& classifierFilename, const string& thresholdsFilename)
 {
 	pair<double, double> sigmoidParams = loadSigmoidParamsFromMatlab(thresholdsFilename);
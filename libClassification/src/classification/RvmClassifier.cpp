@@ -8,6 +8,7 @@
 #include "classification/RvmClassifier.hpp"
 #include "classification/PolynomialKernel.hpp"
 #include "classification/RbfKernel.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "logging/LoggerFactory.hpp"
 #ifdef WITH_MATLAB_CLASSIFIER
 	#include "mat.h"
@@ -20,6 +21,7 @@
 #include "boost/lexical_cast.hpp"
 #include <stdexcept>
 #include <fstream>
+#include <algorithm>
 
 using boost::filesystem::path;
 using logging::Logger;
@@ -137,9 +139,68 @@ shared_ptr<RvmClassifier> RvmClassifier::load(const ptree& subtree)
 		//wvm->numUsedFilters=280;	// Todo make dynamic (from script)
 		return rvm;
 	}
+	else if (classifierFile.extension() == ".bcm") {
+		return loadFromBinary(classifierFile.string());
+	}
 	else {
-		throw logic_error("ProbabilisticRvmClassifier: Only loading of .mat RVMs is supported. If you want to load a non-cascaded RVM, use an SvmClassifier.");
+		throw logic_error("RvmClassifier: Only loading of .mat and .bcm RVMs is supported. If you want to load a non-cascaded RVM, use an SvmClassifier.");
+	}
+}
+
+shared_ptr<RvmClassifier> RvmClassifier::loadFromBinary(const string& classifierFilename)
+{
+	Logger logger = Loggers->getLogger("classification");
+	logger.info("Loading RVM classifier from binary file: " + classifierFilename);
+	BinaryModelReader reader(classifierFilename, BinaryModelType::Rvm);
+	shared_ptr<RvmClassifier> rvm = readBinary(reader);
+	logger.info("RVM successfully read.");
+	return rvm;
+}
+
+shared_ptr<RvmClassifier> RvmClassifier::readBinary(BinaryModelReader& reader)
+{
+	shared_ptr<RvmClassifier> rvm = make_shared<RvmClassifier>(reader.readKernel());
+	rvm->bias = reader.read<float>();
+	int numFiltersToUse = reader.read<int32_t>();
+	rvm->supportVectors = reader.readVectors(rvm->supportVectorData);
+	size_t numFilters = rvm->supportVectors.size();
+	// the coefficients of filter level i are the first i + 1 values of row i of a lower triangular matrix
+	vector<float> coefficients(numFilters * numFilters);
+	reader.readBlock(coefficients.data(), coefficients.size() * sizeof(float));
+	rvm->coefficients.resize(numFilters);
+	for (size_t i = 0; i < numFilters; ++i)
+		rvm->coefficients[i].assign(coefficients.begin() + i * numFilters, coefficients.begin() + i * numFilters + i + 1);
+	rvm->hierarchicalThresholds.resize(numFilters);
+	reader.readBlock(rvm->hierarchicalThresholds.data(), numFilters * sizeof(float));
+	rvm->setNumFiltersToUse(numFiltersToUse);
+	return rvm;
+}
+
+void RvmClassifier::writeBinary(const string& classifierFilename) const
+{
+	BinaryModelWriter writer(classifierFilename, BinaryModelType::Rvm);
+	writeBinary(writer);
+}
+
+void RvmClassifier::writeBinary(BinaryModelWriter& writer) const
+{
+	if (!kernel)
+		throw runtime_error("RvmClassifier: Cannot write an RVM without a kernel");
+	size_t numFilters = supportVectors.size();
+	if (coefficients.size() != numFilters || hierarchicalThresholds.size() != numFilters)
+		throw runtime_error("RvmClassifier: Cannot write an RVM whose number of coefficients or thresholds differs from the number of vectors");
+	vector<float> coefficients(numFilters * numFilters, 0.0f);
+	for (size_t i = 0; i < numFilters; ++i) {
+		if (this->coefficients[i].size() < i + 1)
+			throw runtime_error("RvmClassifier: Cannot write an RVM with missing coefficients at filter level " + lexical_cast<string>(i));
+		std::copy(this->coefficients[i].begin(), this->coefficients[i].begin() + i + 1, coefficients.begin() + i * numFilters);
 	}
+	writer.writeKernel(*kernel);
+	writer.write(bias);
+	writer.write(static_cast<int32_t>(numFiltersToUse));
+	writer.writeVectors(supportVectors);
+	writer.writeBlock(coefficients.data(), coefficients.size() * sizeof(float));
+	writer.writeBlock(hierarchicalThresholds.data(), numFilters * sizeof(float));
 }
 
 shared_ptr<RvmClassifier> RvmClassifier::loadFromMatlab(const string& classifierFilename, const string& thresholdsFilename)
@@ -8,12 +8,16 @@
 #include "classification/SvmClassifier.hpp"
 #include "classification/PolynomialKernel.hpp"
 #include "classification/RbfKernel.hpp"
+#include "classification/LinearKernel.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "logging/LoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 #ifdef WITH_MATLAB_CLASSIFIER
 	#include "mat.h"
 #endif
 #include <stdexcept>
 #include <fstream>
+#include <sstream>
 
 using logging::Logger;
 using logging::LoggerFactory;
@@ -29,6 +33,18 @@ using std::runtime_error;
 
 namespace classification {
 
+namespace {
+
+template<class T>
+double dot(const T* lhs, const T* rhs, size_t count) {
+	double sum = 0;
+	for (size_t i = 0; i < count; ++i)
+		sum += static_cast<double>(lhs[i]) * rhs[i];
+	return sum;
+}
+
+} /* unnamed namespace */
+
 SvmClassifier::SvmClassifier(shared_ptr<Kernel> kernel) :
 		VectorMachineClassifier(kernel), supportVectors(), coefficients() {}
 
@@ -52,6 +68,15 @@ pair<bool, double> SvmClassifier::getConfidence(double hyperplaneDistance) const
 }
 
 double SvmClassifier::computeHyperplaneDistance(const Mat& featureVector) const {
+	if (!linearWeights.empty() && featureVector.isContinuous() && featureVector.depth() == linearWeights.depth()
+			&& featureVector.total() * featureVector.channels() == linearWeights.total()) {
+		INSTRUMENT_COUNT("SvmClassifier.kernelEvaluations", 1);
+		if (linearWeights.depth() == CV_32F)
+			return dot(featureVector.ptr<float>(), linearWeights.ptr<float>(), linearWeights.total()) - bias;
+		else
+			return dot(featureVector.ptr<double>(), linearWeights.ptr<double>(), linearWeights.total()) - bias;
+	}
+	INSTRUMENT_COUNT("SvmClassifier.kernelEvaluations", supportVectors.size());
 	double distance = -bias;
 	for (size_t i = 0; i < supportVectors.size(); ++i)
 		distance += coefficients[i] * kernel->compute(featureVector, supportVectors[i]);
@@ -62,6 +87,66 @@ void SvmClassifier::setSvmParameters(vector<Mat> supportVectors, vector<float> c
 	this->supportVectors = supportVectors;
 	this->coefficients = coefficients;
 	this->bias = bias;
+	supportVectorData.release();
+	computeLinearWeights();
+}
+
+void SvmClassifier::computeLinearWeights() {
+	linearWeights.release();
+	if (supportVectors.empty() || !dynamic_cast<const LinearKernel*>(kernel.get()))
+		return;
+	const Mat& first = supportVectors.front();
+	int depth = first.depth();
+	size_t dimensions = first.total() * first.channels();
+	if (depth != CV_32F && depth != CV_64F)
+		return;
+	Mat weights = Mat::zeros(1, static_cast<int>(dimensions), CV_64F);
+	Mat vector;
+	for (size_t i = 0; i < supportVectors.size(); ++i) {
+		const Mat& supportVector = supportVectors[i];
+		if (!supportVector.isContinuous() || supportVector.depth() != depth || supportVector.total() * supportVector.channels() != dimensions)
+			return;
+		supportVector.reshape(1, 1).convertTo(vector, CV_64F);
+		cv::scaleAdd(vector, coefficients[i], weights, weights);
+	}
+	weights.convertTo(linearWeights, depth);
+}
+
+shared_ptr<SvmClassifier> SvmClassifier::loadFromBinary(const string& classifierFilename)
+{
+	Logger logger = Loggers->getLogger("classification");
+	logger.info("Loading SVM classifier from binary file: " + classifierFilename);
+	BinaryModelReader reader(classifierFilename, BinaryModelType::Svm);
+	shared_ptr<SvmClassifier> svm = readBinary(reader);
+	logger.info("SVM successfully read.");
+	return svm;
+}
+
+shared_ptr<SvmClassifier> SvmClassifier::readBinary(BinaryModelReader& reader)
+{
+	shared_ptr<SvmClassifier> svm = make_shared<SvmClassifier>(reader.readKernel());
+	svm->bias = reader.read<float>();
+	svm->supportVectors = reader.readVectors(svm->supportVectorData);
+	svm->coefficients.resize(svm->supportVectors.size());
+	reader.readBlock(svm->coefficients.data(), svm->coefficients.size() * sizeof(float));
+	svm->computeLinearWeights();
+	return svm;
+}
+
+void SvmClassifier::writeBinary(const string& classifierFilename) const
+{
+	BinaryModelWriter writer(classifierFilename, BinaryModelType::Svm);
+	writeBinary(writer);
+}
+
+void SvmClassifier::writeBinary(BinaryModelWriter& writer) const
+{
+	if (!kernel)
+		throw runtime_error("SvmClassifier: Cannot write an SVM without a kernel");
+	writer.writeKernel(*kernel);
+	writer.write(bias);
+	writer.writeVectors(supportVectors);
+	writer.writeBlock(coefficients.data(), coefficients.size() * sizeof(float));
 }
 
 shared_ptr<SvmClassifier> SvmClassifier::loadFromText(const string& classifierFilename)
@@ -7,12 +7,16 @@
 
 #include "classification/WvmClassifier.hpp"
 #include "classification/IImg.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "logging/LoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 #ifdef WITH_MATLAB_CLASSIFIER
 	#include "mat.h"
 #endif
 #include "boost/lexical_cast.hpp"
 #include <stdexcept>
+#include <algorithm>
+#include <vector>
 
 using logging::Logger;
 using logging::LoggerFactory;
@@ -50,13 +54,11 @@ WvmClassifier::WvmClassifier() : VectorMachineClassifier(nullptr)
 
 WvmClassifier::~WvmClassifier()
 {
-	if (linFilters != NULL) {
-		for (int i = 0; i < numLinFilters; ++i)
-			delete [] linFilters[i];
-	}
+	if (linFilters != NULL && numLinFilters > 0)
+		delete [] linFilters[0]; // all filters are in one block
 	delete [] linFilters;
-	if (hkWeights != NULL)
-		for (int i = 0; i < numLinFilters; ++i) delete [] hkWeights[i];
+	if (hkWeights != NULL && numLinFilters > 0)
+		delete [] hkWeights[0];
 	delete [] hkWeights;
 	delete [] lin_thresholds;
 	//delete [] hierarchicalThresholds;
@@ -136,6 +138,7 @@ pair<int, double> WvmClassifier::computeHyperplaneDistance(const Mat& featureVec
 		fout = this->linEvalWvmHisteq64(filter_level, (filter_level%this->numFiltersPerLevel), filter_output, u_kernel_eval, iimg_x, iimg_xx);
 		//} while (fout >= this->hierarchicalThresholds[filter_level] && filter_level+1 < this->numLinFilters); //280
 	} while (fout >= this->hierarchicalThresholds[filter_level] && filter_level+1 < this->numUsedFilters); //280
+	INSTRUMENT_COUNT("WvmClassifier.filterEvaluations", filter_level + 1);
 
 	// fout = final result now!
 	delete iimg_x;
@@ -493,14 +496,7 @@ shared_ptr<WvmClassifier> WvmClassifier::loadFromMatlab(const string& classifier
 		wvm->filter_size_y = h;
 
 		wvm->numLinFilters = nfilter;
-		wvm->linFilters = new float*[wvm->numLinFilters];
-		for (int i = 0; i < wvm->numLinFilters; ++i)
-			wvm->linFilters[i] = new float[w*h];
-
-		//hierarchicalThresholds = new float [numLinFilters];
-		wvm->hkWeights = new float*[wvm->numLinFilters];
-		for (int i = 0; i < wvm->numLinFilters; ++i)
-			wvm->hkWeights[i] = new float[wvm->numLinFilters];
+		wvm->allocateFilters(w*h);
 
 		if (pmxarray == 0) {
 			throw runtime_error("WvmClassifier: Unable to find the matrix 'support_hk1' in the classifier file.");
@@ -770,11 +766,146 @@ shared_ptr<WvmClassifier> WvmClassifier::loadFromMatlab(const string& classifier
 }
 
 
+void WvmClassifier::allocateFilters(int filterSize)
+{
+	linFilters = new float*[numLinFilters];
+	hkWeights = new float*[numLinFilters];
+	if (numLinFilters > 0) {
+		linFilters[0] = new float[numLinFilters*filterSize];
+		hkWeights[0] = new float[numLinFilters*numLinFilters](); // only the weights 0...i of hkWeights[i] are used, the others are zero
+	}
+	for (int i = 1; i < numLinFilters; ++i) {
+		linFilters[i] = linFilters[0] + i*filterSize;
+		hkWeights[i] = hkWeights[0] + i*numLinFilters;
+	}
+}
+
+shared_ptr<WvmClassifier> WvmClassifier::loadFromBinary(const string& classifierFilename)
+{
+	Logger logger = Loggers->getLogger("classification");
+	logger.info("Loading WVM classifier from binary file: " + classifierFilename);
+	BinaryModelReader reader(classifierFilename, BinaryModelType::Wvm);
+	shared_ptr<WvmClassifier> wvm = readBinary(reader);
+	logger.info("WVM successfully read.");
+	return wvm;
+}
+
+shared_ptr<WvmClassifier> WvmClassifier::readBinary(BinaryModelReader& reader)
+{
+	shared_ptr<WvmClassifier> wvm = make_shared<WvmClassifier>();
+	wvm->filter_size_x = reader.read<int32_t>();
+	wvm->filter_size_y = reader.read<int32_t>();
+	wvm->bias = reader.read<float>();
+	wvm->basisParam = reader.read<float>();
+	wvm->numLinFilters = reader.read<int32_t>();
+	wvm->numFiltersPerLevel = reader.read<int32_t>();
+	wvm->numLevels = reader.read<int32_t>();
+	wvm->numUsedFilters = reader.read<int32_t>();
+	wvm->limitReliabilityFilter = reader.read<float>();
+	int numFilters = wvm->numLinFilters;
+	int filterSize = wvm->filter_size_x * wvm->filter_size_y;
+	if (numFilters < 0 || filterSize < 0)
+		throw runtime_error("WvmClassifier: Invalid binary classifier file.");
+
+	wvm->allocateFilters(filterSize);
+	if (numFilters > 0) {
+		reader.readBlock(wvm->linFilters[0], numFilters * filterSize * sizeof(float));
+		reader.readBlock(wvm->hkWeights[0], numFilters * numFilters * sizeof(float));
+	}
+	wvm->app_rsv_convol = new double[numFilters];
+	reader.readBlock(wvm->app_rsv_convol, numFilters * sizeof(double));
+	wvm->hierarchicalThresholdsFromFile.resize(numFilters);
+	reader.readBlock(wvm->hierarchicalThresholdsFromFile.data(), numFilters * sizeof(float));
+
+	// the areas: number of gray values of each area, number of rectangles of each gray value, gray values, rectangles
+	std::vector<int32_t> cntvals(numFilters);
+	reader.readBlock(cntvals.data(), numFilters * sizeof(int32_t));
+	int totalCntval = 0;
+	for (int cntval : cntvals)
+		totalCntval += cntval;
+	std::vector<int32_t> cntrecs(totalCntval);
+	reader.readBlock(cntrecs.data(), totalCntval * sizeof(int32_t));
+	std::vector<double> vals(totalCntval);
+	reader.readBlock(vals.data(), totalCntval * sizeof(double));
+	int totalCntrec = 0;
+	for (int cntrec : cntrecs)
+		totalCntrec += cntrec;
+	std::vector<TRec> recs(totalCntrec);
+	reader.readBlock(recs.data(), totalCntrec * sizeof(TRec));
+	wvm->area = new Area*[numFilters];
+	for (int hrsv = 0; hrsv < numFilters; ++hrsv)
+		wvm->area[hrsv] = NULL;
+	int valOffset = 0, recOffset = 0;
+	for (int hrsv = 0; hrsv < numFilters; ++hrsv) {
+		Area* area = new Area(cntvals[hrsv], cntrecs.data() + valOffset);
+		wvm->area[hrsv] = area;
+		std::copy(vals.begin() + valOffset, vals.begin() + valOffset + area->cntval, area->val);
+		std::copy(recs.begin() + recOffset, recs.begin() + recOffset + area->cntallrec, area->allrec);
+		valOffset += area->cntval;
+		recOffset += area->cntallrec;
+	}
+
+	wvm->lin_thresholds = new float[numFilters];
+	for (int i = 0; i < numFilters; ++i)
+		wvm->lin_thresholds[i] = wvm->bias;
+	wvm->filter_output = new float[numFilters];
+	wvm->u_kernel_eval = new float[numFilters];
+	wvm->setLimitReliabilityFilter(wvm->limitReliabilityFilter); // This initializes the vector hierarchicalThresholds
+	wvm->setNumUsedFilters(wvm->numUsedFilters);
+	return wvm;
+}
+
+void WvmClassifier::writeBinary(const string& classifierFilename) const
+{
+	BinaryModelWriter writer(classifierFilename, BinaryModelType::Wvm);
+	writeBinary(writer);
+}
+
+void WvmClassifier::writeBinary(BinaryModelWriter& writer) const
+{
+	if (area == NULL || app_rsv_convol == NULL || static_cast<int>(hierarchicalThresholdsFromFile.size()) != numLinFilters)
+		throw runtime_error("WvmClassifier: Cannot write a WVM that was not loaded completely.");
+	int filterSize = filter_size_x * filter_size_y;
+	writer.write(static_cast<int32_t>(filter_size_x));
+	writer.write(static_cast<int32_t>(filter_size_y));
+	writer.write(bias);
+	writer.write(basisParam);
+	writer.write(static_cast<int32_t>(numLinFilters));
+	writer.write(static_cast<int32_t>(numFiltersPerLevel));
+	writer.write(static_cast<int32_t>(numLevels));
+	writer.write(static_cast<int32_t>(numUsedFilters));
+	writer.write(limitReliabilityFilter);
+	if (numLinFilters > 0) {
+		writer.writeBlock(linFilters[0], numLinFilters * filterSize * sizeof(float));
+		writer.writeBlock(hkWeights[0], numLinFilters * numLinFilters * sizeof(float));
+	}
+	writer.writeBlock(app_rsv_convol, numLinFilters * sizeof(double));
+	writer.writeBlock(hierarchicalThresholdsFromFile.data(), numLinFilters * sizeof(float));
+
+	std::vector<int32_t> cntvals, cntrecs;
+	std::vector<double> vals;
+	std::vector<TRec> recs;
+	for (int hrsv = 0; hrsv < numLinFilters; ++hrsv) {
+		const Area* area = this->area[hrsv];
+		cntvals.push_back(area->cntval);
+		for (int v = 0; v < area->cntval; ++v) {
+			cntrecs.push_back(area->cntrec[v]);
+			vals.push_back(area->val[v]);
+			recs.insert(recs.end(), area->rec[v], area->rec[v] + area->cntrec[v]);
+		}
+	}
+	writer.writeBlock(cntvals.data(), cntvals.size() * sizeof(int32_t));
+	writer.writeBlock(cntrecs.data(), cntrecs.size() * sizeof(int32_t));
+	writer.writeBlock(vals.data(), vals.size() * sizeof(double));
+	writer.writeBlock(recs.data(), recs.size() * sizeof(TRec));
+}
+
 WvmClassifier::Area::Area(void)
 {
 	cntval=0;
 	val=NULL;
 	rec=NULL;
+	allrec=NULL;
 	cntrec=NULL;
 	cntallrec=0;
 }
@@ -791,15 +922,17 @@ WvmClassifier::Area::Area(int cv, int *cr) : cntval(cv)
 		cntallrec+=cr[v];
 	}
 	rec = new TRec*[cntval];
-	for (v=0;v<cntval;v++) {
-		rec[v] = new TRec[cntrec[v]];
-		for (r=0;r<cntrec[v];r++) { rec[v][r].x1=rec[v][r].y1=rec[v][r].x2=rec[v][r].y2=0; }
+	allrec = new TRec[cntallrec];
+	for (v=0,r=0;v<cntval;v++) {
+		rec[v] = allrec + r;
+		r += cntrec[v];
 	}
+	for (r=0;r<cntallrec;r++) { allrec[r].x1=allrec[r].y1=allrec[r].x2=allrec[r].y2=0; }
 }
 
 WvmClassifier::Area::~Area(void)
 {
-	if (rec!=NULL) for (int v=0;v<cntval;v++) delete [] rec[v];
+	if (allrec!=NULL) delete [] allrec;
 	if (rec!=NULL) delete [] rec;
 	if (cntrec!=NULL) delete [] cntrec;
 	if (val!=NULL) delete [] val;
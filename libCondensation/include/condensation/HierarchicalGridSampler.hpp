@@ -0,0 +1,131 @@
+/*
+ * HierarchicalGridSampler.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef HIERARCHICALGRIDSAMPLER_HPP_
+#define HIERARCHICALGRIDSAMPLER_HPP_
+
+#include "condensation/Sampler.hpp"
+#include "boost/property_tree/ptree.hpp"
+
+namespace condensation {
+
+class MeasurementModel;
+
+/**
+ * Creates new samples by searching a grid (like GridSampler) from coarse to fine. The samples of a coarse grid are
+ * evaluated first, then the grid is refined around the best samples only, halving the step of position and size on
+ * each level. The finest level has the same resolution as the grid of GridSampler. The samples of the finest level
+ * (and the candidates they were refined from) are the new samples.
+ *
+ * The number of evaluations per call is limited. If the coarsest grid would need more than half of the evaluations,
+ * its step is increased accordingly, the remaining evaluations are used for the refinement. Thus the time needed for
+ * (re-)initialization is bounded independently of the image size. Note that the tracker evaluates the new samples
+ * again, which is not included in the limit.
+ */
+class HierarchicalGridSampler : public Sampler {
+public:
+
+	/**
+	 * Constructs a new hierarchical grid sampler.
+	 *
+	 * @param[in] measurementModel The measurement model that is used for evaluating the samples of the coarse levels.
+	 * @param[in] minSize The minimum size of a sample.
+	 * @param[in] maxSize The maximum size of a sample.
+	 * @param[in] sizeScale The scale factor of the size on the finest level (beginning from the minimum size). Has to be greater than one.
+	 * @param[in] stepSize The step size relative to the sample size on the finest level.
+	 * @param[in] levelCount The number of levels (one is a plain grid with limited evaluations).
+	 * @param[in] candidateCount The number of best samples that are refined on the next level.
+	 * @param[in] maxEvaluations The maximum number of evaluations per call.
+	 */
+	HierarchicalGridSampler(std::shared_ptr<MeasurementModel> measurementModel, int minSize, int maxSize, float sizeScale, float stepSize,
+			int levelCount = 3, size_t candidateCount = 10, size_t maxEvaluations = 2000);
+
+	/**
+	 * Creates a grid sampler from the given configuration. The value of the node "grid" is the type, "simple" (the
+	 * default, a GridSampler) or "hierarchical" (a HierarchicalGridSampler). Its children are the step size and, for
+	 * the hierarchical grid, the level count, candidate count and maximum number of evaluations.
+	 *
+	 * @param[in] config The configuration containing the (optional) node "grid".
+	 * @param[in] measurementModel The measurement model that is used for evaluating the samples of the coarse levels.
+	 * @param[in] minSize The minimum size of a sample.
+	 * @param[in] maxSize The maximum size of a sample.
+	 * @param[in] sizeScale The scale factor of the size (beginning from the minimum size).
+	 * @return The newly created grid sampler.
+	 * @throws std::invalid_argument if the type of the grid is unknown.
+	 */
+	static std::shared_ptr<Sampler> createGridSampler(const boost::property_tree::ptree& config,
+			std::shared_ptr<MeasurementModel> measurementModel, int minSize, int maxSize, float sizeScale);
+
+	void init(const cv::Mat& image);
+
+	void sample(const std::vector<std::shared_ptr<Sample>>& samples, std::vector<std::shared_ptr<Sample>>& newSamples,
+			const cv::Mat& image, const std::shared_ptr<Sample> target);
+
+	void sample(const std::vector<std::shared_ptr<Sample>>& samples, std::vector<std::shared_ptr<Sample>>& newSamples,
+			const std::shared_ptr<imageprocessing::VersionedImage>& image, const std::shared_ptr<Sample> target);
+
+private:
+
+	/**
+	 * Sample together with the index of its size (size = minSize * sizeScale^sizeIndex).
+	 */
+	struct GridSample {
+		std::shared_ptr<Sample> sample; ///< The sample.
+		int sizeIndex; ///< The index of the size.
+	};
+
+	/**
+	 * Computes the size of samples.
+	 *
+	 * @param[in] sizeIndex The index of the size.
+	 * @return The size of the samples.
+	 */
+	int getSize(int sizeIndex) const;
+
+	/**
+	 * Computes the step between the positions of neighboring samples.
+	 *
+	 * @param[in] size The size of the samples.
+	 * @param[in] relativeStep The step size relative to the sample size.
+	 * @return The step in pixels.
+	 */
+	int getStep(int size, float relativeStep) const;
+
+	/**
+	 * Creates the samples of the coarsest grid.
+	 *
+	 * @param[out] gridSamples The samples.
+	 * @param[in] image The image.
+	 * @param[in] sizeIndexStep The step of the size index.
+	 * @param[in] relativeStep The step size relative to the sample size.
+	 */
+	void createGrid(std::vector<GridSample>& gridSamples, const cv::Mat& image, int sizeIndexStep, float relativeStep) const;
+
+	/**
+	 * Counts the samples of a grid.
+	 *
+	 * @param[in] image The image.
+	 * @param[in] sizeIndexStep The step of the size index.
+	 * @param[in] relativeStep The step size relative to the sample size.
+	 * @return The number of samples.
+	 */
+	size_t countGrid(const cv::Mat& image, int sizeIndexStep, float relativeStep) const;
+
+	std::shared_ptr<MeasurementModel> measurementModel; ///< The measurement model that is used for evaluating the samples of the coarse levels.
+	int minSize;     ///< The minimum size of a sample.
+	int maxSize;     ///< The maximum size of a sample.
+	float sizeScale; ///< The scale factor of the size on the finest level.
+	float stepSize;  ///< The step size relative to the sample size on the finest level.
+	int maxSizeIndex;      ///< The maximum index of the size.
+	int levelCount;        ///< The number of levels.
+	size_t candidateCount; ///< The number of best samples that are refined on the next level.
+	size_t maxEvaluations; ///< The maximum number of evaluations per call.
+	std::shared_ptr<imageprocessing::VersionedImage> image; ///< Versioned image used when only the image data is given.
+};
+
+} /* namespace condensation */
+#endif /* HIERARCHICALGRIDSAMPLER_HPP_ */
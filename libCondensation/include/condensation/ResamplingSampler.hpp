@@ -41,6 +41,8 @@ public:
 
 	void init(const cv::Mat& image);
 
+	using Sampler::sample;
+
 	void sample(const std::vector<std::shared_ptr<Sample>>& samples, std::vector<std::shared_ptr<Sample>>& newSamples,
 			const cv::Mat& image, const std::shared_ptr<Sample> target);
 
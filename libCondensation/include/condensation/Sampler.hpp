@@ -8,6 +8,7 @@
 #ifndef SAMPLER_HPP_
 #define SAMPLER_HPP_
 
+#include "imageprocessing/VersionedImage.hpp"
 #include "opencv2/core/core.hpp"
 #include <vector>
 #include <memory>
@@ -41,6 +42,21 @@ public:
 	 */
 	virtual void sample(const std::vector<std::shared_ptr<Sample>>& samples, std::vector<std::shared_ptr<Sample>>& newSamples,
 			const cv::Mat& image, const std::shared_ptr<Sample> target) = 0;
+
+	/**
+	 * Creates new samples. Samplers that evaluate samples on their own should override this function to share the
+	 * versioned image (and thereby data derived from it, e.g. image pyramids) with the measurement model. The default
+	 * implementation just uses the image data.
+	 *
+	 * @param[in] samples The vector containing the samples of the previous time step.
+	 * @param[in,out] newSamples The vector to insert the new samples into.
+	 * @param[in] image The new image.
+	 * @param[in] target The previous target state.
+	 */
+	virtual void sample(const std::vector<std::shared_ptr<Sample>>& samples, std::vector<std::shared_ptr<Sample>>& newSamples,
+			const std::shared_ptr<imageprocessing::VersionedImage>& image, const std::shared_ptr<Sample> target) {
+		sample(samples, newSamples, image->getData(), target);
+	}
 };
 
 } /* namespace condensation */
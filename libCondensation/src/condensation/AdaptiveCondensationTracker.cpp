@@ -13,6 +13,7 @@
 #include "condensation/StateExtractor.hpp"
 #include "condensation/StateValidator.hpp"
 #include "imageprocessing/VersionedImage.hpp"
+#include "logging/Instrumentation.hpp"
 #include <stdexcept>
 
 using imageprocessing::VersionedImage;
@@ -67,12 +68,20 @@ optional<Rect> AdaptiveCondensationTracker::initialize(const Mat& imageData, con
 optional<Rect> AdaptiveCondensationTracker::process(const Mat& imageData) {
 	if (!measurementModel->isUsable())
 		throw runtime_error("AdaptiveCondensationTracker: Is not usable (was not initialized or was resetted)");
+	INSTRUMENT_SCOPE("AdaptiveCondensationTracker::process");
 	image->setData(imageData);
 	samples.swap(oldSamples);
 	samples.clear();
-	sampler->sample(oldSamples, samples, image->getData(), state);
+	{
+		INSTRUMENT_SCOPE("AdaptiveCondensationTracker.sampling");
+		sampler->sample(oldSamples, samples, image, state);
+	}
+	INSTRUMENT_COUNT("AdaptiveCondensationTracker.samples", samples.size());
 	// evaluate samples and extract state
-	measurementModel->evaluate(image, samples);
+	{
+		INSTRUMENT_SCOPE("AdaptiveCondensationTracker.evaluation");
+		measurementModel->evaluate(image, samples);
+	}
 	state = extractor->extract(samples);
 	// validate target state
 	if (state) {
@@ -84,10 +93,13 @@ optional<Rect> AdaptiveCondensationTracker::process(const Mat& imageData) {
 		}
 	}
 	// update model
-	if (state)
-		adapted = measurementModel->adapt(image, samples, *state);
-	else
-		adapted = measurementModel->adapt(image, samples);
+	{
+		INSTRUMENT_SCOPE("AdaptiveCondensationTracker.adaptation");
+		if (state)
+			adapted = measurementModel->adapt(image, samples, *state);
+		else
+			adapted = measurementModel->adapt(image, samples);
+	}
 	// return position
 	if (state)
 		return optional<Rect>(state->getBounds());
@@ -11,6 +11,7 @@
 #include "condensation/MeasurementModel.hpp"
 #include "condensation/StateExtractor.hpp"
 #include "imageprocessing/VersionedImage.hpp"
+#include "logging/Instrumentation.hpp"
 
 using imageprocessing::VersionedImage;
 using cv::Mat;
@@ -33,12 +34,20 @@ CondensationTracker::CondensationTracker(shared_ptr<Sampler> sampler,
 				extractor(extractor) {}
 
 optional<Rect> CondensationTracker::process(const Mat& imageData) {
+	INSTRUMENT_SCOPE("CondensationTracker::process");
 	image->setData(imageData);
 	samples.swap(oldSamples);
 	samples.clear();
-	sampler->sample(oldSamples, samples, image->getData(), state);
+	{
+		INSTRUMENT_SCOPE("CondensationTracker.sampling");
+		sampler->sample(oldSamples, samples, image, state);
+	}
+	INSTRUMENT_COUNT("CondensationTracker.samples", samples.size());
 	// evaluate samples and extract position
-	measurementModel->evaluate(image, samples);
+	{
+		INSTRUMENT_SCOPE("CondensationTracker.evaluation");
+		measurementModel->evaluate(image, samples);
+	}
 	state = extractor->extract(samples);
 	// return position
 	if (state)
@@ -0,0 +1,208 @@
+/*
+ * HierarchicalGridSampler.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "condensation/HierarchicalGridSampler.hpp"
+#include "condensation/GridSampler.hpp"
+#include "condensation/MeasurementModel.hpp"
+#include "condensation/Sample.hpp"
+#include "imageprocessing/VersionedImage.hpp"
+#include "logging/Instrumentation.hpp"
+#include <algorithm>
+#include <unordered_set>
+#include <stdexcept>
+#include <cmath>
+
+using imageprocessing::VersionedImage;
+using boost::property_tree::ptree;
+using cv::Mat;
+using std::min;
+using std::max;
+using std::vector;
+using std::string;
+using std::unordered_set;
+using std::shared_ptr;
+using std::make_shared;
+using std::invalid_argument;
+
+namespace condensation {
+
+HierarchicalGridSampler::HierarchicalGridSampler(shared_ptr<MeasurementModel> measurementModel, int minSize, int maxSize,
+		float sizeScale, float stepSize, int levelCount, size_t candidateCount, size_t maxEvaluations) :
+				measurementModel(measurementModel), minSize(minSize), maxSize(maxSize), sizeScale(sizeScale), stepSize(stepSize),
+				maxSizeIndex(0), levelCount(levelCount), candidateCount(candidateCount), maxEvaluations(maxEvaluations),
+				image(make_shared<VersionedImage>()) {
+	if (!measurementModel)
+		throw invalid_argument("HierarchicalGridSampler: the measurement model must not be null");
+	if (minSize < 1)
+		throw invalid_argument("HierarchicalGridSampler: the minimum size must be greater than zero");
+	if (maxSize < minSize)
+		throw invalid_argument("HierarchicalGridSampler: the maximum size must not be smaller than the minimum size");
+	if (sizeScale <= 1)
+		throw invalid_argument("HierarchicalGridSampler: the scale factor of the size must be greater than one");
+	if (stepSize <= 0)
+		throw invalid_argument("HierarchicalGridSampler: the step size must be greater than zero");
+	if (levelCount < 1)
+		throw invalid_argument("HierarchicalGridSampler: there must be at least one level");
+	if (candidateCount < 1)
+		throw invalid_argument("HierarchicalGridSampler: the candidate count must be greater than zero");
+	if (maxEvaluations < 1)
+		throw invalid_argument("HierarchicalGridSampler: the maximum number of evaluations must be greater than zero");
+	while (getSize(maxSizeIndex + 1) <= maxSize)
+		++maxSizeIndex;
+}
+
+shared_ptr<Sampler> HierarchicalGridSampler::createGridSampler(const ptree& config,
+		shared_ptr<MeasurementModel> measurementModel, int minSize, int maxSize, float sizeScale) {
+	string type = config.get<string>("grid", "simple");
+	float stepSize = config.get<float>("grid.stepSize", 0.1f);
+	if (type == "simple") {
+		return make_shared<GridSampler>(minSize, maxSize, sizeScale, stepSize);
+	} else if (type == "hierarchical") {
+		return make_shared<HierarchicalGridSampler>(measurementModel, minSize, maxSize, sizeScale, stepSize,
+				config.get<int>("grid.levelCount", 3), config.get<size_t>("grid.candidateCount", 10), config.get<size_t>("grid.maxEvaluations", 2000));
+	} else {
+		throw invalid_argument("HierarchicalGridSampler: invalid grid sampler type: " + type);
+	}
+}
+
+void HierarchicalGridSampler::init(const Mat& image) {}
+
+void HierarchicalGridSampler::sample(const vector<shared_ptr<Sample>>& samples, vector<shared_ptr<Sample>>& newSamples,
+		const Mat& image, const shared_ptr<Sample> target) {
+	this->image->setData(image);
+	sample(samples, newSamples, this->image, target);
+}
+
+void HierarchicalGridSampler::sample(const vector<shared_ptr<Sample>>& samples, vector<shared_ptr<Sample>>& newSamples,
+		const shared_ptr<VersionedImage>& image, const shared_ptr<Sample> target) {
+	newSamples.clear();
+	const Mat& imageData = image->getData();
+	measurementModel->update(image);
+
+	// coarsest grid, its step is increased if it would need too many evaluations
+	int level = levelCount - 1;
+	float relativeStep = stepSize * (1 << level);
+	size_t coarseEvaluations = levelCount > 1 ? max(maxEvaluations / 2, static_cast<size_t>(1)) : maxEvaluations;
+	size_t count = countGrid(imageData, 1 << level, relativeStep);
+	while (count > coarseEvaluations) {
+		relativeStep *= max(1.1f, std::sqrt(static_cast<float>(count) / static_cast<float>(coarseEvaluations)));
+		size_t newCount = countGrid(imageData, 1 << level, relativeStep);
+		if (newCount == count) // only one sample per size left
+			break;
+		count = newCount;
+	}
+	vector<GridSample> candidates;
+	createGrid(candidates, imageData, 1 << level, relativeStep);
+	if (candidates.size() > coarseEvaluations) { // the step could not be increased any further
+		// the samples are ordered by size, so an evenly spaced subset keeps all sizes instead of dropping the largest ones
+		vector<GridSample> subset;
+		subset.reserve(coarseEvaluations);
+		for (size_t i = 0; i < coarseEvaluations; ++i)
+			subset.push_back(candidates[i * candidates.size() / coarseEvaluations]);
+		candidates.swap(subset);
+	}
+	for (GridSample& candidate : candidates)
+		measurementModel->evaluate(*candidate.sample);
+	size_t evaluations = candidates.size();
+
+	// refinement around the best samples of the previous level
+	vector<GridSample> refined;
+	unordered_set<long long> positions;
+	for (--level; level >= 0 && evaluations < maxEvaluations; --level) {
+		size_t bestCount = min(candidateCount, candidates.size());
+		std::partial_sort(candidates.begin(), candidates.begin() + bestCount, candidates.end(), [](const GridSample& lhs, const GridSample& rhs) {
+			return lhs.sample->getWeight() > rhs.sample->getWeight();
+		});
+		candidates.resize(bestCount);
+		relativeStep = max(stepSize * (1 << level), 0.5f * relativeStep);
+		int sizeIndexStep = 1 << level;
+
+		refined.clear();
+		positions.clear();
+		for (const GridSample& candidate : candidates) {
+			refined.push_back(candidate);
+			positions.insert((static_cast<long long>(candidate.sizeIndex) << 42) | (static_cast<long long>(candidate.sample->getX()) << 21) | candidate.sample->getY());
+		}
+		for (size_t i = 0; i < candidates.size() && evaluations < maxEvaluations; ++i) {
+			const GridSample& candidate = candidates[i];
+			for (int sizeIndex = candidate.sizeIndex - sizeIndexStep; sizeIndex <= candidate.sizeIndex + sizeIndexStep && evaluations < maxEvaluations; sizeIndex += sizeIndexStep) {
+				if (sizeIndex < 0 || sizeIndex > maxSizeIndex)
+					continue;
+				int size = getSize(sizeIndex);
+				int halfSize = size / 2;
+				int step = getStep(size, relativeStep);
+				for (int dy = -1; dy <= 1 && evaluations < maxEvaluations; ++dy) {
+					int y = candidate.sample->getY() + dy * step;
+					if (y < halfSize || y >= imageData.rows - size + halfSize)
+						continue;
+					for (int dx = -1; dx <= 1 && evaluations < maxEvaluations; ++dx) {
+						int x = candidate.sample->getX() + dx * step;
+						if (x < halfSize || x >= imageData.cols - size + halfSize)
+							continue;
+						if (!positions.insert((static_cast<long long>(sizeIndex) << 42) | (static_cast<long long>(x) << 21) | y).second)
+							continue;
+						GridSample neighbor;
+						neighbor.sample = make_shared<Sample>(x, y, size);
+						neighbor.sizeIndex = sizeIndex;
+						measurementModel->evaluate(*neighbor.sample);
+						++evaluations;
+						refined.push_back(neighbor);
+					}
+				}
+			}
+		}
+		candidates.swap(refined);
+	}
+	INSTRUMENT_COUNT("HierarchicalGridSampler.evaluations", evaluations);
+
+	newSamples.reserve(candidates.size());
+	for (const GridSample& candidate : candidates)
+		newSamples.push_back(candidate.sample);
+}
+
+int HierarchicalGridSampler::getSize(int sizeIndex) const {
+	return cvRound(minSize * std::pow(sizeScale, sizeIndex));
+}
+
+int HierarchicalGridSampler::getStep(int size, float relativeStep) const {
+	return max(1, static_cast<int>(relativeStep * size + 0.5f));
+}
+
+void HierarchicalGridSampler::createGrid(vector<GridSample>& gridSamples, const Mat& image, int sizeIndexStep, float relativeStep) const {
+	gridSamples.clear();
+	for (int sizeIndex = 0; sizeIndex <= maxSizeIndex; sizeIndex += sizeIndexStep) {
+		int size = getSize(sizeIndex);
+		int halfSize = size / 2;
+		int maxX = image.cols - size + halfSize;
+		int maxY = image.rows - size + halfSize;
+		int step = getStep(size, relativeStep);
+		GridSample gridSample;
+		gridSample.sizeIndex = sizeIndex;
+		for (int x = halfSize; x < maxX; x += step) {
+			for (int y = halfSize; y < maxY; y += step) {
+				gridSample.sample = make_shared<Sample>(x, y, size);
+				gridSamples.push_back(gridSample);
+			}
+		}
+	}
+}
+
+size_t HierarchicalGridSampler::countGrid(const Mat& image, int sizeIndexStep, float relativeStep) const {
+	size_t count = 0;
+	for (int sizeIndex = 0; sizeIndex <= maxSizeIndex; sizeIndex += sizeIndexStep) {
+		int size = getSize(sizeIndex);
+		int width = image.cols - size;
+		int height = image.rows - size;
+		if (width <= 0 || height <= 0)
+			continue;
+		int step = getStep(size, relativeStep);
+		count += static_cast<size_t>((width + step - 1) / step) * static_cast<size_t>((height + step - 1) / step);
+	}
+	return count;
+}
+
+} /* namespace condensation */
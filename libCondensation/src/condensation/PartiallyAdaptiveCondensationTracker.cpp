@@ -41,7 +41,7 @@ optional<Rect> PartiallyAdaptiveCondensationTracker::process(const Mat& imageDat
 	image->setData(imageData);
 	samples.swap(oldSamples);
 	samples.clear();
-	sampler->sample(oldSamples, samples, image->getData(), state);
+	sampler->sample(oldSamples, samples, image, state);
 	// evaluate samples and extract position
 	if (useAdaptiveModel && measurementModel->isUsable()) {
 		measurementModel->evaluate(image, samples);
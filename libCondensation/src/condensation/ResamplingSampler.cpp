@@ -9,6 +9,7 @@
 #include "condensation/Sample.hpp"
 #include "condensation/ResamplingAlgorithm.hpp"
 #include "condensation/TransitionModel.hpp"
+#include "logging/Instrumentation.hpp"
 #include <algorithm>
 #include <ctime>
 #include <stdexcept>
@@ -50,6 +51,7 @@ void ResamplingSampler::init(const Mat& image) {
 void ResamplingSampler::sample(const vector<shared_ptr<Sample>>& samples, vector<shared_ptr<Sample>>& newSamples,
 		const Mat& image, const shared_ptr<Sample> target) {
 	resamplingAlgorithm->resample(samples, (int)((1 - randomRate) * count), newSamples);
+	INSTRUMENT_COUNT("ResamplingSampler.resampled", newSamples.size());
 	transitionModel->predict(newSamples, image, target);
 	while (newSamples.size() < count) {
 		shared_ptr<Sample> newSample = make_shared<Sample>();
@@ -8,6 +8,7 @@
 #include "detection/FiveStageSlidingWindowDetector.hpp"
 #include "detection/ClassifiedPatch.hpp"
 #include "logging/LoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 #include "imagelogging/ImageLoggerFactory.hpp"
 
 #include "opencv2/imgproc/imgproc.hpp"
@@ -186,6 +187,7 @@ void nonMaximaSuppression(const Mat& src, const int sz, Mat& dst, const Mat mask
 
 vector<shared_ptr<ClassifiedPatch>> FiveStageSlidingWindowDetector::detect(const Mat& image)
 {
+	INSTRUMENT_SCOPE("FiveStageSlidingWindowDetector::detect");
 	vector<shared_ptr<ClassifiedPatch>> classifiedPatches;
 
 	Logger logger = Loggers->getLogger("detection");
@@ -256,9 +258,13 @@ vector<shared_ptr<ClassifiedPatch>> FiveStageSlidingWindowDetector::detect(const
 
 	// SVM stage
 	vector<shared_ptr<ClassifiedPatch>> svmPatches;
-	for(const auto &patch : classifiedPatches) {
-		svmPatches.push_back(make_shared<ClassifiedPatch>(patch->getPatch(), strongClassifier->classify(patch->getPatch()->getData())));
+	{
+		INSTRUMENT_SCOPE("FiveStageSlidingWindowDetector.svmStage");
+		for(const auto &patch : classifiedPatches) {
+			svmPatches.push_back(make_shared<ClassifiedPatch>(patch->getPatch(), strongClassifier->classify(patch->getPatch()->getData())));
+		}
 	}
+	INSTRUMENT_COUNT("FiveStageSlidingWindowDetector.svmWindows", svmPatches.size());
 	Mat imgSvmAll = image.clone();
 	imageLogger.intermediate(imgSvmAll, bind(drawBoxes, imgSvmAll, svmPatches), "03svmall");
 
@@ -297,10 +303,20 @@ vector<shared_ptr<ClassifiedPatch>> FiveStageSlidingWindowDetector::detect(const
 	cv::findNonZero(maxima, maximaCoords);
 	vector<shared_ptr<ClassifiedPatch>> classifiedPatchesNewNMS;
 	sort(begin(svmPatchesPositive), end(svmPatchesPositive), [](shared_ptr<ClassifiedPatch> a, shared_ptr<ClassifiedPatch> b) { return *a > *b; });
+	// index of the best patch at each position, so we don't have to search all patches for each maximum
+	cv::Mat_<int> patchIndices(probabilityMap.size(), -1);
+	for (size_t i = 0; i < svmPatchesPositive.size(); ++i) {
+		int& index = patchIndices(svmPatchesPositive[i]->getPatch()->getY(), svmPatchesPositive[i]->getPatch()->getX());
+		if (index < 0)
+			index = static_cast<int>(i);
+	}
 	for (const auto& p : maximaCoords) {
-		const auto& foundPatchIt = std::find_if(begin(svmPatchesPositive), end(svmPatchesPositive), [p](shared_ptr<ClassifiedPatch> a) { 
-			return (a->getPatch()->getX() == p.x && a->getPatch()->getY() == p.y); }); // should never fail but we should handle an error anyway
-		classifiedPatchesNewNMS.push_back(*foundPatchIt);
+		int index = patchIndices(p.y, p.x);
+		if (index < 0) { // should never happen, as each maximum of the map is at the position of a patch
+			logger.warn("FiveStageSlidingWindowDetector: Found a maximum in the probability map without a corresponding patch.");
+			continue;
+		}
+		classifiedPatchesNewNMS.push_back(svmPatchesPositive[index]);
 	}
 	svmPatchesPositive = classifiedPatchesNewNMS; 
 	// end new nms
@@ -330,6 +346,7 @@ vector<shared_ptr<ClassifiedPatch>> FiveStageSlidingWindowDetector::detect(share
 
 vector<shared_ptr<ClassifiedPatch>> FiveStageSlidingWindowDetector::detect(const Mat& image, const Rect& roi)
 {
+	INSTRUMENT_SCOPE("FiveStageSlidingWindowDetector::detect");
 	vector<shared_ptr<ClassifiedPatch>> classifiedPatches;
 
 	Logger logger = Loggers->getLogger("detection");
@@ -349,9 +366,13 @@ vector<shared_ptr<ClassifiedPatch>> FiveStageSlidingWindowDetector::detect(const
 
 	// SVM stage
 	vector<shared_ptr<ClassifiedPatch>> svmPatches;
-	for(const auto &patch : classifiedPatches) {
-		svmPatches.push_back(make_shared<ClassifiedPatch>(patch->getPatch(), strongClassifier->classify(patch->getPatch()->getData())));
+	{
+		INSTRUMENT_SCOPE("FiveStageSlidingWindowDetector.svmStage");
+		for(const auto &patch : classifiedPatches) {
+			svmPatches.push_back(make_shared<ClassifiedPatch>(patch->getPatch(), strongClassifier->classify(patch->getPatch()->getData())));
+		}
 	}
+	INSTRUMENT_COUNT("FiveStageSlidingWindowDetector.svmWindows", svmPatches.size());
 	Mat imgSvmAll = image.clone();
 	imageLogger.intermediate(imgSvmAll, bind(drawBoxes, imgSvmAll, svmPatches), "03svmall");
 
@@ -8,12 +8,16 @@
 #include "detection/OverlapElimination.hpp"
 #include "detection/ClassifiedPatch.hpp"
 #include "logging/LoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 
 #include "boost/iterator/indirect_iterator.hpp"
 #include "boost/lexical_cast.hpp"
 #include <iostream>	// TODO remove the cout's here and replace with logger/exceptions.
 #include <string>
 #include <functional>
+#include <unordered_map>
+#include <cstdint>
+#include <cmath>
 
 using logging::Logger;
 using logging::LoggerFactory;
@@ -25,6 +29,8 @@ using std::greater;
 using std::min;
 using std::max;
 using std::abs;
+using std::unordered_map;
+using imageprocessing::Patch;
 
 namespace detection {
 
@@ -43,6 +49,7 @@ OverlapElimination::OverlapElimination(float dist, float ratio) : dist(dist), ra
 //	 The distance is measured in pixel if thresholds[0]>1 else rel. to patch width.
 vector<shared_ptr<ClassifiedPatch>> OverlapElimination::eliminate(vector<shared_ptr<ClassifiedPatch>> &classifiedPatches)
 {
+	INSTRUMENT_SCOPE("OverlapElimination::eliminate");
 
 	vector<shared_ptr<ClassifiedPatch>> candidates = classifiedPatches;
 	if (candidates.size() == 0)
@@ -61,44 +68,58 @@ vector<shared_ptr<ClassifiedPatch>> OverlapElimination::eliminate(vector<shared_
 	
 	sort(make_indirect_iterator(candidates.begin()), make_indirect_iterator(candidates.end()), greater<ClassifiedPatch>());
 	 
-	// Commented-out is the code from Andreas. It might be a nice extension in the future.
-	//int K = 9999; // how many to keep, 1-X
-	//int L = 1; // (level_span>0) ? level_span : 1;
-	//float R = 1; // (radius>0) ? radius*radius : 25.f;
-
-     //for (int acc=0; acc<candidates.size() && acc < K; ++acc)
-     for (vector<shared_ptr<ClassifiedPatch>>::iterator accepted = candidates.begin(); accepted != candidates.end(); accepted++)
-     {
-         //for (int pro=acc+1; pro<candidates.size(); )
-         for (vector<shared_ptr<ClassifiedPatch>>::iterator proband = accepted+1; proband!= candidates.end(); )
-         {
-			 if (dist <= 1.0) {
-				 d = dist*max((*accepted)->getPatch()->getWidth(), (*proband)->getPatch()->getWidth());
-			 } else {
-				 d = dist;
-			 }
-             //if ( abs(candidates[acc].s-candidates[pro].s)<L && sq_dist(candidates[acc],candidates[pro])<R )
-             if ( (abs((*accepted)->getPatch()->getX() - (*proband)->getPatch()->getX()) < d)
-			   && (abs((*accepted)->getPatch()->getY() - (*proband)->getPatch()->getY()) < d)
-			   && ( ((float)min((*accepted)->getPatch()->getWidth(), (*proband)->getPatch()->getWidth()) / (float)max((*accepted)->getPatch()->getWidth(), (*proband)->getPatch()->getWidth()) ) > ratio) )
-             {
-                 //candidates.erase((candidates.begin()+pro));
-                 proband = candidates.erase(proband);
-             } else {
-                 //++pro;
-                 proband++;
-             }
-         }
-         //if (!(--K>0))
-         //{
-         //    candidates.erase(++accepted,candidates.end());
-         //    break;
-         //}
-     }
-     //if (K<candidates.size())
-     //{
-     //    candidates.erase((candidates.begin()+K),candidates.end());
-     //}
+	// The candidates are processed in order of decreasing probability, and a candidate is kept if it does
+	// not overlap with any of the already kept ones (this is what the nested loops with erase() of Andreas
+	// did). To not compare each candidate with all kept ones, the kept candidates are put into a grid whose
+	// cells are as big as the largest possible distance d, so overlapping candidates are in neighbouring cells.
+	float maxD = dist;
+	if (dist <= 1.0) {
+		int maxWidth = 0;
+		for (const auto& candidate : candidates)
+			maxWidth = max(maxWidth, candidate->getPatch()->getWidth());
+		maxD = dist * maxWidth;
+	}
+	if (maxD <= 0) { // nothing can overlap
+		log.debug("OverlapElimination did not remove any of the " + lexical_cast<string>(classifiedPatches.size()) + " candidate patches.");
+		return candidates;
+	}
+	auto getCell = [maxD](int coordinate) { return static_cast<int>(std::floor(coordinate / maxD)); };
+	auto getKey = [](int cellX, int cellY) { return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellY); };
+	unordered_map<uint64_t, vector<size_t>> grid; // cell -> indices of the kept candidates
+	vector<shared_ptr<ClassifiedPatch>> accepted;
+	accepted.reserve(candidates.size());
+	for (const shared_ptr<ClassifiedPatch>& proband : candidates) {
+		const Patch& probandPatch = *proband->getPatch();
+		int cellX = getCell(probandPatch.getX());
+		int cellY = getCell(probandPatch.getY());
+		bool overlaps = false;
+		for (int y = cellY - 1; y <= cellY + 1 && !overlaps; ++y) {
+			for (int x = cellX - 1; x <= cellX + 1 && !overlaps; ++x) {
+				auto cell = grid.find(getKey(x, y));
+				if (cell == grid.end())
+					continue;
+				for (size_t index : cell->second) {
+					const Patch& acceptedPatch = *accepted[index]->getPatch();
+					if (dist <= 1.0) {
+						d = dist*max(acceptedPatch.getWidth(), probandPatch.getWidth());
+					} else {
+						d = dist;
+					}
+					if ( (abs(acceptedPatch.getX() - probandPatch.getX()) < d)
+					  && (abs(acceptedPatch.getY() - probandPatch.getY()) < d)
+					  && ( ((float)min(acceptedPatch.getWidth(), probandPatch.getWidth()) / (float)max(acceptedPatch.getWidth(), probandPatch.getWidth()) ) > ratio) ) {
+						overlaps = true;
+						break;
+					}
+				}
+			}
+		}
+		if (!overlaps) {
+			grid[getKey(cellX, cellY)].push_back(accepted.size());
+			accepted.push_back(proband);
+		}
+	}
+	candidates.swap(accepted);
 
 	 log.debug("OverlapElimination reduced the candidate patches from " + lexical_cast<string>(classifiedPatches.size()) + " to " + lexical_cast<string>(candidates.size()) + ".");
 
@@ -12,6 +12,7 @@
 #include "classification/ProbabilisticClassifier.hpp"
 #include "detection/ClassifiedPatch.hpp"
 #include "imagelogging/ImageLoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
@@ -86,6 +87,7 @@ vector<shared_ptr<ClassifiedPatch>> SlidingWindowDetector::detect(shared_ptr<Ver
 
 vector<shared_ptr<ClassifiedPatch>> SlidingWindowDetector::detect() const
 {
+	INSTRUMENT_SCOPE("SlidingWindowDetector::detect");
 	vector<shared_ptr<ClassifiedPatch>> classifiedPatches;
 	vector<shared_ptr<Patch>> pyramidPatches = featureExtractor->extract(stepSizeX, stepSizeY);
 
@@ -94,6 +96,8 @@ vector<shared_ptr<ClassifiedPatch>> SlidingWindowDetector::detect() const
 		if(res.first==true)
 			classifiedPatches.push_back(make_shared<ClassifiedPatch>(pyramidPatches[i], res));
 	}
+	INSTRUMENT_COUNT("SlidingWindowDetector.windows", pyramidPatches.size());
+	INSTRUMENT_COUNT("SlidingWindowDetector.positives", classifiedPatches.size());
 	return classifiedPatches;
 }
 
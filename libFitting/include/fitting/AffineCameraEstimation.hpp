@@ -16,9 +16,105 @@
 #include "opencv2/core/core.hpp"
 
 #include <vector>
+#include <random>
 
 namespace fitting {
 
+/**
+ * Estimates affine camera matrices from 2D-3D correspondences,
+ * like estimateAffineCamera(), but is meant to be kept around and
+ * re-used, e.g. over the frames of a video: It keeps its point
+ * buffers between calls, can optionally ignore or down-weight
+ * badly localised landmarks (RANSAC or a Huber loss) and can
+ * start from the camera of the previous call.
+ *
+ * Each estimate solves the normalised linear system of the Gold
+ * Standard Algorithm. The two rows of the camera are decoupled and
+ * share one 4x4 system of normal equations, which is solved with a
+ * Cholesky decomposition.
+ *
+ * One instance should not be shared between threads.
+ */
+class AffineCameraEstimator
+{
+public:
+	/**
+	 * How to deal with outliers, i.e. badly localised landmarks.
+	 */
+	enum class Mode {
+		LeastSquares, ///< Least squares over all correspondences, the same as estimateAffineCamera()
+		Ransac, ///< RANSAC with minimal sets of 4 correspondences, followed by a least squares fit to the inliers
+		Huber ///< Iteratively re-weighted least squares with a Huber loss
+	};
+
+	/**
+	 * Constructs an estimator that looks up the 3D points in the
+	 * mean of the given model. The model is borrowed and has to
+	 * outlive the estimator.
+	 *
+	 * @param[in] morphableModel The 3D model whose correspondences are used to estimate the camera.
+	 */
+	explicit AffineCameraEstimator(const morphablemodel::MorphableModel& morphableModel);
+
+	/**
+	 * Estimates the camera from the given landmarks. Landmarks that
+	 * don't exist in the model are skipped.
+	 *
+	 * @param[in] imagePoints A list of 2D image points.
+	 * @return A 3x4 affine camera matrix (the third row is [0, 0, 0, 1]).
+	 * @throws std::runtime_error if there are less than 4 correspondences, or if they are degenerate and there is no previous camera.
+	 */
+	cv::Mat estimate(const std::vector<imageio::ModelLandmark>& imagePoints);
+
+	/**
+	 * Estimates the camera from the given correspondences, for callers
+	 * that keep their own point buffers. If the correspondences are
+	 * degenerate (e.g. all points coincide), the camera of the previous
+	 * call is returned.
+	 *
+	 * @param[in] imagePoints An n x 2 matrix of 2D image points, CV_32FC1.
+	 * @param[in] modelPoints An n x 3 matrix of the corresponding 3D points, CV_32FC1.
+	 * @return A 3x4 affine camera matrix (the third row is [0, 0, 0, 1]).
+	 * @throws std::runtime_error if there are less than 4 correspondences, the sizes don't match, or the correspondences are degenerate and there is no previous camera.
+	 */
+	cv::Mat estimate(cv::Mat imagePoints, cv::Mat modelPoints);
+
+	/**
+	 * Returns for every correspondence of the last estimate whether
+	 * its reprojection error is within the outlierThreshold.
+	 *
+	 * @return The inlier flags of the last estimate.
+	 */
+	const std::vector<bool>& getInliers() const;
+
+	/**
+	 * Forgets the camera of the previous call, e.g. after a shot change
+	 * in a video.
+	 */
+	void reset();
+
+	Mode mode = Mode::LeastSquares; ///< How to deal with outliers.
+	bool warmStart = false; ///< Start from the camera of the previous call: It's the first RANSAC hypothesis and the initial estimate of the Huber iterations. Use on videos.
+	float outlierThreshold = 0.02f; ///< The reprojection error above which a correspondence is an outlier (RANSAC) or gets down-weighted (Huber), in the units of the image points (usually clip-space).
+	int ransacIterations = 100; ///< Number of random minimal sets that RANSAC tries.
+	int huberIterations = 5; ///< Number of re-weighting iterations with a Huber loss.
+
+private:
+	// Solves the weighted, normalised least squares problem. Correspondences with weight 0 are ignored. Returns an empty Mat if all weights are 0 or all weighted points coincide.
+	cv::Mat solve(const cv::Mat& imagePoints, const cv::Mat& modelPoints, const std::vector<float>& weights) const;
+	// Calculates the reprojection error of every correspondence.
+	void computeResiduals(const cv::Mat& camera, const cv::Mat& imagePoints, const cv::Mat& modelPoints);
+
+	const morphablemodel::MorphableModel& morphableModel;
+	cv::Mat imagePointsBuffer; ///< n x 2, re-used between calls
+	cv::Mat modelPointsBuffer; ///< n x 3, re-used between calls
+	std::vector<float> weights;
+	std::vector<float> residuals;
+	std::vector<bool> inliers;
+	cv::Mat previousCamera; ///< The result of the previous call, for warm-starting. Empty if there is none.
+	std::mt19937 engine; ///< For drawing the RANSAC samples. Default-seeded, so the results are reproducible.
+};
+
 /**
  * The Gold Standard Algorithm for estimating an affine
  * camera matrix from world to image correspondences.
@@ -31,8 +127,10 @@ namespace fitting {
  * @param[in] morphableModel The 3D model whose correspondences are used to estimate the camera
  * @param[in] vertexIds An optional list of vertex ids if not all given imagePoints have a corresponding point in the model. TODO: Should this better be a map that is used in addition to the standard lookup?
  * @return A 3x4 affine camera matrix (the third row is [0, 0, 0, 1]).
+ *
+ * To estimate the camera of many frames, or with outliers, use an AffineCameraEstimator.
  */
-cv::Mat estimateAffineCamera(std::vector<imageio::ModelLandmark> imagePoints, morphablemodel::MorphableModel morphableModel, std::vector<int> vertexIds=std::vector<int>());
+cv::Mat estimateAffineCamera(const std::vector<imageio::ModelLandmark>& imagePoints, const morphablemodel::MorphableModel& morphableModel, std::vector<int> vertexIds=std::vector<int>());
 
 /**
  * Takes a 3x4 affine camera matrix, calculates the
@@ -18,9 +18,73 @@
 //#include "boost/optional.hpp" // Weird: Why does it compile without this header? (Win64)
 
 #include <vector>
+#include <string>
+#include <array>
+#include <list>
+#include <utility>
 
 namespace fitting {
 
+/**
+ * A fitting context for the linear shape fitting of fitShapeToLandmarksLinear()
+ * that can be re-used over many images, e.g. the frames of a video.
+ *
+ * For each set of landmarks (identified by the ordered list of their names),
+ * it caches the rows of the normalized PCA basis and the mean that belong to the
+ * landmarks, together with their Gram products. Fitting an image then only
+ * involves the 3x3 part of the camera matrix and m x m matrices (m being the
+ * number of principal components), independent of the number of landmarks,
+ * and the regularised normal equations are solved with a Cholesky decomposition.
+ * Only the most recently used landmark sets are kept, so that a landmark
+ * detector whose set of landmarks changes from frame to frame (e.g. due to
+ * occlusions) doesn't make the cache grow without bound.
+ *
+ * The cache is modified by fit(), so one instance should not be shared between threads.
+ * Multiple fitters in different threads can borrow the same model.
+ */
+class LinearShapeFitter
+{
+public:
+	/**
+	 * Constructs a fitter for the shape model of the given Morphable Model.
+	 * The model is borrowed, not copied, and has to outlive the fitter.
+	 *
+	 * @param[in] morphableModel The Morphable Model whose shape (coefficients) are fitted.
+	 * @param[in] maxCachedSubspaces The maximum number of landmark sets whose subspace is cached.
+	 */
+	explicit LinearShapeFitter(const morphablemodel::MorphableModel& morphableModel, std::size_t maxCachedSubspaces = 8);
+
+	/**
+	 * Fits the shape coefficients to the given landmarks. Produces the same
+	 * result as fitShapeToLandmarksLinear(), see there for the parameters.
+	 * The landmark subspace is computed on the first call with a given set
+	 * of landmarks, subsequent calls with the same set re-use it.
+	 *
+	 * @return The fitted shape-coefficients (alphas).
+	 */
+	std::vector<float> fit(cv::Mat affineCameraMatrix, const std::vector<imageio::ModelLandmark>& landmarks, float lambda=20.0f, boost::optional<float> detectorStandardDeviation=boost::optional<float>(), boost::optional<float> modelStandardDeviation=boost::optional<float>());
+
+private:
+	/**
+	 * The part of the shape model that belongs to one set of N landmarks.
+	 * With V_j being the N x m matrix of the basis rows of coordinate j (x, y or z)
+	 * of each landmark, and v_j the corresponding N x 1 mean values, it stores
+	 * the products V_j^t * V_k and V_j^t * v_k for all j, k in {0, 1, 2}.
+	 */
+	struct LandmarkSubspace
+	{
+		std::array<cv::Mat, 3> basisRows; ///< V_j, N x m, CV_64FC1
+		std::array<cv::Mat, 9> basisGram; ///< V_j^t * V_k at index 3 * j + k, m x m, CV_64FC1
+		std::array<cv::Mat, 9> basisTimesMean; ///< V_j^t * v_k at index 3 * j + k, m x 1, CV_64FC1
+	};
+
+	const LandmarkSubspace& getLandmarkSubspace(const std::vector<imageio::ModelLandmark>& landmarks);
+
+	const morphablemodel::PcaModel& shapeModel;
+	std::size_t maxCachedSubspaces; ///< The maximum number of entries of landmarkSubspaces.
+	std::list<std::pair<std::vector<std::string>, LandmarkSubspace>> landmarkSubspaces; ///< Cache, keyed by the ordered landmark names, most recently used first
+};
+
 /**
  * Fits the shape of a Morphable Model to .. (i.e. estimates the ML sol of the coeffs...) as in [1].
  * linear, closed-form solution fitting of the shape, with regul. (prior to mean)
@@ -28,6 +92,8 @@ namespace fitting {
  *
  * [1] O. Aldrian & W. Smith, Inverse Rendering of Faces with a 3D Morphable Model, PAMI 2013.
  *
+ * When fitting many images with the same set of landmarks, use a LinearShapeFitter instead.
+ *
  * @param[in] morphableModel The Morphable Model whose shape (coefficients) are fitted.
  * @param[in] affineCameraMatrix A 3x4 affine camera matrix from world to clip-space (should probably be of type CV_32FC1 as all our calculations are done with float).
  * @param[in] landmarks 2D landmarks from an image, given in clip-coordinates.
@@ -37,7 +103,7 @@ namespace fitting {
  * @param[in] modelStandardDeviation The 3D standard deviation of each corresponding point (vertex) in the 3D model. Should be a vector with one value for every landmark point in the model? TODO: Also mention what unit.
  * @return The fitted shape-coefficients (alphas).
  */
-std::vector<float> fitShapeToLandmarksLinear(morphablemodel::MorphableModel morphableModel, cv::Mat affineCameraMatrix, std::vector<imageio::ModelLandmark> landmarks, float lambda=20.0f, boost::optional<int> numCoefficientsToFit=boost::optional<int>(), boost::optional<float> detectorStandardDeviation=boost::optional<float>(), boost::optional<float> modelStandardDeviation=boost::optional<float>());
+std::vector<float> fitShapeToLandmarksLinear(const morphablemodel::MorphableModel& morphableModel, cv::Mat affineCameraMatrix, const std::vector<imageio::ModelLandmark>& landmarks, float lambda=20.0f, boost::optional<int> numCoefficientsToFit=boost::optional<int>(), boost::optional<float> detectorStandardDeviation=boost::optional<float>(), boost::optional<float> modelStandardDeviation=boost::optional<float>());
 
 /**
  * Convert the landmarks to clip-space, and only convert the ones that exist in the model
@@ -45,7 +111,7 @@ std::vector<float> fitShapeToLandmarksLinear(morphablemodel::MorphableModel morp
  * @param[in] morphableModel The Morphable Model ...
  * @return The fitted shape-coefficients (alphas).
  */
-std::vector<imageio::ModelLandmark> convertAvailableLandmarksToClipSpace(std::vector<imageio::ModelLandmark> landmarks, morphablemodel::MorphableModel morphableModel, int screenWidth, int screenHeight);
+std::vector<imageio::ModelLandmark> convertAvailableLandmarksToClipSpace(const std::vector<imageio::ModelLandmark>& landmarks, const morphablemodel::MorphableModel& morphableModel, int screenWidth, int screenHeight);
 
 } /* namespace fitting */
 #endif /* LINEARSHAPEFITTING_HPP_ */
@@ -26,6 +26,10 @@ namespace fitting {
  * parameters (a rotation and translation).
  * The wrapper takes landmarks in 2D coordinates and finds the
  * corresponding points in a 3DMM using the metadata in the model.
+ *
+ * On videos, warmStart refines the pose of the previous frame
+ * instead of solving from scratch, and useRansac makes the
+ * estimation robust against badly localised landmarks.
  */
 class OpenCVCameraEstimation  {
 public:
@@ -35,8 +39,9 @@ public:
 	 *
 	 * @param[in] MorphableModel The Morphable Model whose shape-model
 	 *                           is used to estimate the camera pose.
+	 *                           It is borrowed and has to outlive this object.
 	 */
-	OpenCVCameraEstimation(/* const? shared_ptr? */morphablemodel::MorphableModel morphableModel);
+	OpenCVCameraEstimation(const morphablemodel::MorphableModel& morphableModel);
 
 	/**
 	 * Takes 2D landmarks, finds the corresponding landmarks in the
@@ -50,12 +55,27 @@ public:
 	 * @param[in] vertexIds Bla
 	 * @return Bla R, t
 	 */
-	cv::Mat estimate(std::vector<imageio::ModelLandmark> imagePoints, cv::Mat intrinsicCameraMatrix, std::vector<int> vertexIds = std::vector<int>());
+	cv::Mat estimate(const std::vector<imageio::ModelLandmark>& imagePoints, cv::Mat intrinsicCameraMatrix, std::vector<int> vertexIds = std::vector<int>());
 
 	static cv::Mat createIntrinsicCameraMatrix(float f, int w, int h);
 
+	/**
+	 * Forgets the pose of the previous call, e.g. after a shot change
+	 * in a video.
+	 */
+	void reset();
+
+	bool warmStart = false; ///< Start the (iterative) estimation from the pose of the previous call. Use on videos.
+	bool useRansac = false; ///< Use solvePnPRansac to be robust against outlier landmarks.
+	int ransacIterations = 100; ///< Number of RANSAC iterations.
+	float ransacReprojectionError = 8.0f; ///< Inlier threshold of RANSAC, in pixels.
+
 private:
-	morphablemodel::MorphableModel morphableModel;
+	const morphablemodel::MorphableModel& morphableModel;
+	std::vector<cv::Point2f> points2d; ///< Re-used between calls
+	std::vector<cv::Point3f> points3d; ///< Re-used between calls
+	cv::Mat previousRvec; ///< The rotation of the previous call, for warm-starting. Empty if there is none.
+	cv::Mat previousTvec; ///< The translation of the previous call, for warm-starting.
 };
 
 } /* namespace fitting */
@@ -10,9 +10,10 @@
 #include "render/utils.hpp"
 #include "logging/LoggerFactory.hpp"
 
-#include "opencv2/core/core_c.h" // for CV_REDUCE_AVG
-
 #include <exception>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 
 using logging::LoggerFactory;
 using morphablemodel::MorphableModel;
@@ -23,119 +24,276 @@ using std::vector;
 
 namespace fitting {
 
-Mat estimateAffineCamera(vector<imageio::ModelLandmark> imagePoints, MorphableModel morphableModel, vector<int> vertexIds/*=std::vector<int>()*/)
+AffineCameraEstimator::AffineCameraEstimator(const MorphableModel& morphableModel) : morphableModel(morphableModel)
 {
-	// Note/TODO: If this function is called with invalid imagePoints, i.e. landmark id's that are not in the 3DMM, nothing throws. Something, somewhere, should happen.
-	// Todo: Currently, the optional vertexIds are not used
+	engine.seed();
+}
 
-	Mat matImagePoints; // will be numCorrespondences x 2, CV_32FC1
-	Mat matModelPoints; // will be numCorrespondences x 3, CV_32FC1
+Mat AffineCameraEstimator::estimate(const vector<imageio::ModelLandmark>& imagePoints)
+{
+	// Note/TODO: If this function is called with invalid imagePoints, i.e. landmark id's that are not in the 3DMM, nothing throws. Something, somewhere, should happen.
+	imagePointsBuffer.create(static_cast<int>(imagePoints.size()), 2, CV_32FC1); // no reallocation if the number of landmarks stays the same
+	modelPointsBuffer.create(static_cast<int>(imagePoints.size()), 3, CV_32FC1);
+	int numCorrespondences = 0;
 	// Use the point only if it is available in the model:
 	for (const auto& landmark : imagePoints) {
-		Vec3f tmp;
+		Vec3f modelPoint;
 		try {
-			tmp = morphableModel.getShapeModel().getMeanAtPoint(landmark.getName());
+			modelPoint = morphableModel.getShapeModel().getMeanAtPoint(landmark.getName());
 		}
 		catch (std::out_of_range& e) {
 			continue;
 		}
-		Mat imgPoint(1, 2, CV_32FC1);
-		imgPoint.at<float>(0, 0) = landmark.getX();
-		imgPoint.at<float>(0, 1) = landmark.getY();
-		matImagePoints.push_back(imgPoint);
-
-		Mat mdlPoint(1, 3, CV_32FC1);
-		mdlPoint.at<float>(0, 0) = tmp[0];
-		mdlPoint.at<float>(0, 1) = tmp[1];
-		mdlPoint.at<float>(0, 2) = tmp[2];
-		matModelPoints.push_back(mdlPoint);
-	}
-	const auto numCorrespondences = matImagePoints.rows;
+		float* imagePoint = imagePointsBuffer.ptr<float>(numCorrespondences);
+		imagePoint[0] = landmark.getX();
+		imagePoint[1] = landmark.getY();
+		float* mdlPoint = modelPointsBuffer.ptr<float>(numCorrespondences);
+		mdlPoint[0] = modelPoint[0];
+		mdlPoint[1] = modelPoint[1];
+		mdlPoint[2] = modelPoint[2];
+		++numCorrespondences;
+	}
+	return estimate(imagePointsBuffer.rowRange(0, numCorrespondences), modelPointsBuffer.rowRange(0, numCorrespondences));
+}
+
+Mat AffineCameraEstimator::estimate(Mat imagePoints, Mat modelPoints)
+{
+	if (imagePoints.rows != modelPoints.rows || imagePoints.cols != 2 || modelPoints.cols != 3) {
+		throw std::runtime_error("AffineCameraEstimation: The image points have to be n x 2 and the model points n x 3.");
+	}
+	const auto numCorrespondences = imagePoints.rows;
 	if (numCorrespondences < 4) {
 		Loggers->getLogger("fitting").error("AffineCameraEstimation: Number of points given needs to be equal to or larger than 4.");
 		throw std::runtime_error("AffineCameraEstimation: Number of points given needs to be equal to or larger than 4.");
 	}
+	if (imagePoints.type() != CV_32FC1) {
+		imagePoints.convertTo(imagePoints, CV_32FC1);
+	}
+	if (modelPoints.type() != CV_32FC1) {
+		modelPoints.convertTo(modelPoints, CV_32FC1);
+	}
 
-	//Mat tmpOrigImgPoints = matImagePoints.clone(); // Temp for testing: Save the original coordinates.
-	// translate the centroid of the image points to the origin:
-	Mat imagePointsMean; // use non-homogeneous coords for the next few steps? (less submatrices etc overhead)
-	cv::reduce(matImagePoints, imagePointsMean, 0, CV_REDUCE_AVG);
-	imagePointsMean = cv::repeat(imagePointsMean, matImagePoints.rows, 1); // get T_13 and T_23 from imagePointsMean
-	matImagePoints = matImagePoints - imagePointsMean;
-	// scale the image points such that the RMS distance from the origin is sqrt(2):
-	// 1) calculate the average norm (root mean squared distance) of all vectors
-	float averageNorm = 0.0f;
-	for (int row = 0; row < matImagePoints.rows; ++row) {
-		averageNorm += cv::norm(matImagePoints.row(row), cv::NORM_L2);
-	}
-	averageNorm /= matImagePoints.rows;
-	// 2) multiply every vectors coordinate by sqrt(2)/avgnorm
-	float scaleFactor = std::sqrt(2)/averageNorm;
-	matImagePoints *= scaleFactor; // add unit homogeneous component here
-	// The points in matImagePoints now have a RMS distance from the origin of sqrt(2).
-	// The normalisation matrix so that the 2D points are mean-free and their norm is as described above.
-	Mat T = Mat::zeros(3, 3, CV_32FC1);
-	T.at<float>(0, 0) = scaleFactor; // s_x
-	T.at<float>(1, 1) = scaleFactor; // s_y
-	T.at<float>(0, 2) = -imagePointsMean.at<float>(0, 0) * scaleFactor; // t_x
-	T.at<float>(1, 2) = -imagePointsMean.at<float>(0, 1) * scaleFactor; // t_y
-	T.at<float>(2, 2) = 1;
-	
-	// center the model points to the origin:
-	Mat tmpOrigMdlPoints = matModelPoints.clone(); // Temp for testing: Save the original coordinates.
-	// translate the centroid of the model points to the origin:
-	Mat modelPointsMean; // use non-homogeneous coords for the next few steps? (less submatrices etc overhead)
-	cv::reduce(matModelPoints, modelPointsMean, 0, CV_REDUCE_AVG);
-	modelPointsMean = cv::repeat(modelPointsMean, matModelPoints.rows, 1);
-	matModelPoints = matModelPoints - modelPointsMean;
-	// scale the model points such that the RMS distance from the origin is sqrt(3):
-	// 1) calculate the average norm (root mean squared distance) of all vectors
-	averageNorm = 0.0f;
-	for (int row = 0; row < matModelPoints.rows; ++row) {
-		averageNorm += cv::norm(matModelPoints.row(row), cv::NORM_L2);
-	}
-	averageNorm /= matModelPoints.rows;
-	// 2) multiply every vectors coordinate by sqrt(3)/avgnorm
-	scaleFactor = std::sqrt(3) / averageNorm;
-	matModelPoints *= scaleFactor; // add unit homogeneous component here
-	// The points in matModelPoints now have a RMS distance from the origin of sqrt(3).
-	// The normalisation matrix so that the 3D points are mean-free and their norm is as described above.
-	Mat U = Mat::zeros(4, 4, CV_32FC1);
-	U.at<float>(0, 0) = scaleFactor; // s_x
-	U.at<float>(1, 1) = scaleFactor; // s_y
-	U.at<float>(2, 2) = scaleFactor; // s_z
-	U.at<float>(0, 3) = -modelPointsMean.at<float>(0, 0) * scaleFactor; // t_x
-	U.at<float>(1, 3) = -modelPointsMean.at<float>(0, 1) * scaleFactor; // t_y
-	U.at<float>(2, 3) = -modelPointsMean.at<float>(0, 2) * scaleFactor; // t_z
-	U.at<float>(3, 3) = 1;
-
-	// Estimate the normalized camera matrix (C tilde).
-	// We are solving the system $A_8 * p_8 = b$
-	// The solution is obtained by the pseudo-inverse of A_8:
-	// $p_8 = A_8^+ * b$
-	Mat A_8 = Mat::zeros(numCorrespondences * 2, 8, CV_32FC1);
-	//Mat p_8(); // p_8 is 8 x 1. We are solving for it.
-	Mat b(numCorrespondences * 2, 1, CV_32FC1);
+	const bool hasPreviousCamera = warmStart && !previousCamera.empty();
+	const float threshold = outlierThreshold;
+	Mat camera;
+	weights.assign(numCorrespondences, 1.0f);
+	// solve() returns an empty Mat if the points are degenerate (e.g. they all coincide). If there is
+	// no usable camera at all, we return the one of the previous call, or throw if there is none:
+	auto fallBackIfEmpty = [this](Mat& camera) {
+		if (!camera.empty()) {
+			return;
+		}
+		if (previousCamera.empty()) {
+			throw std::runtime_error("AffineCameraEstimation: The correspondences are degenerate, could not estimate a camera.");
+		}
+		Loggers->getLogger("fitting").warn("AffineCameraEstimation: The correspondences are degenerate, returning the camera of the previous call.");
+		camera = previousCamera;
+	};
+
+	if (mode == Mode::LeastSquares) {
+		camera = solve(imagePoints, modelPoints, weights);
+		fallBackIfEmpty(camera);
+	}
+	else if (mode == Mode::Ransac) {
+		// MSAC: Each hypothesis is scored by the sum of the truncated squared reprojection errors.
+		double bestScore = std::numeric_limits<double>::max();
+		auto scoreHypothesis = [&](const Mat& hypothesis) {
+			computeResiduals(hypothesis, imagePoints, modelPoints);
+			double score = 0.0;
+			for (const auto& r : residuals) {
+				score += std::min(r * r, threshold * threshold);
+			}
+			if (score < bestScore) {
+				bestScore = score;
+				camera = hypothesis;
+			}
+		};
+		if (hasPreviousCamera) {
+			scoreHypothesis(previousCamera);
+		}
+		std::uniform_int_distribution<int> distribution(0, numCorrespondences - 1);
+		vector<float> sampleWeights(numCorrespondences);
+		for (int iteration = 0; iteration < ransacIterations; ++iteration) {
+			std::fill(begin(sampleWeights), end(sampleWeights), 0.0f);
+			int numSampled = 0;
+			while (numSampled < 4) {
+				float& weight = sampleWeights[distribution(engine)];
+				if (weight == 0.0f) {
+					weight = 1.0f;
+					++numSampled;
+				}
+			}
+			Mat hypothesis = solve(imagePoints, modelPoints, sampleWeights);
+			if (!hypothesis.empty()) {
+				scoreHypothesis(hypothesis);
+			}
+		}
+		fallBackIfEmpty(camera); // all hypotheses were degenerate
+		// Re-fit to the inliers of the best hypothesis, if there are enough. Otherwise, keep the best
+		// hypothesis, as a fit to all correspondences would include the outliers again:
+		computeResiduals(camera, imagePoints, modelPoints);
+		int numInliers = 0;
+		for (int i = 0; i < numCorrespondences; ++i) {
+			weights[i] = residuals[i] <= threshold ? 1.0f : 0.0f;
+			numInliers += residuals[i] <= threshold ? 1 : 0;
+		}
+		if (numInliers >= 4) {
+			Mat refined = solve(imagePoints, modelPoints, weights);
+			if (!refined.empty()) { // otherwise, keep the best hypothesis
+				camera = refined;
+			}
+		}
+	}
+	else if (mode == Mode::Huber) {
+		camera = hasPreviousCamera ? previousCamera : solve(imagePoints, modelPoints, weights);
+		fallBackIfEmpty(camera);
+		for (int iteration = 0; iteration < huberIterations; ++iteration) {
+			computeResiduals(camera, imagePoints, modelPoints);
+			for (int i = 0; i < numCorrespondences; ++i) {
+				weights[i] = residuals[i] <= threshold ? 1.0f : threshold / residuals[i];
+			}
+			Mat refined = solve(imagePoints, modelPoints, weights);
+			if (refined.empty()) { // keep the last estimate
+				break;
+			}
+			camera = refined;
+		}
+	}
+
+	computeResiduals(camera, imagePoints, modelPoints);
+	inliers.resize(numCorrespondences);
 	for (int i = 0; i < numCorrespondences; ++i) {
-		A_8.at<float>(2*i, 0) = matModelPoints.at<float>(i, 0); // could maybe made faster by assigning the whole row/col-range if possible?
-		A_8.at<float>(2*i, 1) = matModelPoints.at<float>(i, 1);
-		A_8.at<float>(2*i, 2) = matModelPoints.at<float>(i, 2);
-		A_8.at<float>(2*i, 3) = 1;
-		A_8.at<float>((2*i)+1, 4) = matModelPoints.at<float>(i, 0);
-		A_8.at<float>((2*i)+1, 5) = matModelPoints.at<float>(i, 1);
-		A_8.at<float>((2*i)+1, 6) = matModelPoints.at<float>(i, 2);
-		A_8.at<float>((2*i)+1, 7) = 1;
-		b.at<float>(2*i, 0) = matImagePoints.at<float>(i, 0);
-		b.at<float>((2*i)+1, 0) = matImagePoints.at<float>(i, 1);
-	}
-	Mat p_8 = A_8.inv(cv::DECOMP_SVD) * b;
-	Mat C_tilde = Mat::zeros(3, 4, CV_32FC1);
-	C_tilde.row(0) = p_8.rowRange(0, 4).t(); // The first row of C_tilde consists of the first 4 entries of the col-vector p_8
-	C_tilde.row(1) = p_8.rowRange(4, 8).t(); // Second row = last 4 entries
-	C_tilde.at<float>(2, 3) = 1; // the last row is [0 0 0 1]
-
-	Mat P_Affine = T.inv() * C_tilde * U;
-	return P_Affine;
+		inliers[i] = residuals[i] <= threshold;
+	}
+	previousCamera = camera;
+	return camera;
+}
+
+const vector<bool>& AffineCameraEstimator::getInliers() const
+{
+	return inliers;
+}
+
+void AffineCameraEstimator::reset()
+{
+	previousCamera.release();
+}
+
+Mat AffineCameraEstimator::solve(const Mat& imagePoints, const Mat& modelPoints, const vector<float>& weights) const
+{
+	const int numCorrespondences = imagePoints.rows;
+	// Translate the centroid of the image and model points to the origin:
+	double sumOfWeights = 0.0;
+	cv::Vec2d imagePointsMean;
+	cv::Vec3d modelPointsMean;
+	for (int i = 0; i < numCorrespondences; ++i) {
+		const float w = weights[i];
+		if (w <= 0.0f) {
+			continue;
+		}
+		const float* imagePoint = imagePoints.ptr<float>(i);
+		const float* modelPoint = modelPoints.ptr<float>(i);
+		sumOfWeights += w;
+		imagePointsMean[0] += w * imagePoint[0];
+		imagePointsMean[1] += w * imagePoint[1];
+		modelPointsMean[0] += w * modelPoint[0];
+		modelPointsMean[1] += w * modelPoint[1];
+		modelPointsMean[2] += w * modelPoint[2];
+	}
+	if (sumOfWeights == 0.0) {
+		return Mat();
+	}
+	imagePointsMean *= 1.0 / sumOfWeights;
+	modelPointsMean *= 1.0 / sumOfWeights;
+	// Scale the points such that the average distance from the origin is sqrt(2) (image points) resp. sqrt(3) (model points):
+	double averageImageNorm = 0.0;
+	double averageModelNorm = 0.0;
+	for (int i = 0; i < numCorrespondences; ++i) {
+		const float w = weights[i];
+		if (w <= 0.0f) {
+			continue;
+		}
+		const float* imagePoint = imagePoints.ptr<float>(i);
+		const float* modelPoint = modelPoints.ptr<float>(i);
+		averageImageNorm += w * std::sqrt(std::pow(imagePoint[0] - imagePointsMean[0], 2) + std::pow(imagePoint[1] - imagePointsMean[1], 2));
+		averageModelNorm += w * std::sqrt(std::pow(modelPoint[0] - modelPointsMean[0], 2) + std::pow(modelPoint[1] - modelPointsMean[1], 2) + std::pow(modelPoint[2] - modelPointsMean[2], 2));
+	}
+	averageImageNorm /= sumOfWeights;
+	averageModelNorm /= sumOfWeights;
+	if (averageImageNorm == 0.0 || averageModelNorm == 0.0) {
+		return Mat();
+	}
+	const double imageScale = std::sqrt(2.0) / averageImageNorm;
+	const double modelScale = std::sqrt(3.0) / averageModelNorm;
+
+	// Estimate the normalized camera matrix (C tilde). Its first two rows are
+	// independent least squares problems with the same design matrix, with
+	// rows (X, Y, Z, 1) of the normalised model points. We solve both with
+	// the (weighted) normal equations, one 4x4 system with 2 right-hand sides.
+	Mat AtA = Mat::zeros(4, 4, CV_64FC1);
+	Mat Atb = Mat::zeros(4, 2, CV_64FC1);
+	for (int i = 0; i < numCorrespondences; ++i) {
+		const float w = weights[i];
+		if (w <= 0.0f) {
+			continue;
+		}
+		const float* imagePoint = imagePoints.ptr<float>(i);
+		const float* modelPoint = modelPoints.ptr<float>(i);
+		const double a[4] = { (modelPoint[0] - modelPointsMean[0]) * modelScale, (modelPoint[1] - modelPointsMean[1]) * modelScale, (modelPoint[2] - modelPointsMean[2]) * modelScale, 1.0 };
+		const double b[2] = { (imagePoint[0] - imagePointsMean[0]) * imageScale, (imagePoint[1] - imagePointsMean[1]) * imageScale };
+		for (int r = 0; r < 4; ++r) {
+			double* AtARow = AtA.ptr<double>(r);
+			for (int c = 0; c < 4; ++c) {
+				AtARow[c] += w * a[r] * a[c];
+			}
+			Atb.at<double>(r, 0) += w * a[r] * b[0];
+			Atb.at<double>(r, 1) += w * a[r] * b[1];
+		}
+	}
+	Mat p; // 4 x 2, the two first rows of C tilde as columns
+	if (!cv::solve(AtA, Atb, p, cv::DECOMP_CHOLESKY)) {
+		cv::solve(AtA, Atb, p, cv::DECOMP_SVD); // pseudo-inverse if the points are degenerate
+	}
+
+	// Undo the normalisation: P_Affine = T^-1 * C_tilde * U
+	cv::Matx34d C_tilde;
+	for (int c = 0; c < 4; ++c) {
+		C_tilde(0, c) = p.at<double>(c, 0);
+		C_tilde(1, c) = p.at<double>(c, 1);
+	}
+	C_tilde(2, 3) = 1.0; // the last row is [0 0 0 1]
+	const cv::Matx33d T_inv(1.0 / imageScale, 0.0, imagePointsMean[0],
+	                        0.0, 1.0 / imageScale, imagePointsMean[1],
+	                        0.0, 0.0, 1.0);
+	const cv::Matx44d U(modelScale, 0.0, 0.0, -modelPointsMean[0] * modelScale,
+	                    0.0, modelScale, 0.0, -modelPointsMean[1] * modelScale,
+	                    0.0, 0.0, modelScale, -modelPointsMean[2] * modelScale,
+	                    0.0, 0.0, 0.0, 1.0);
+	const cv::Matx34d P_Affine = T_inv * C_tilde * U;
+	Mat camera;
+	Mat(P_Affine).convertTo(camera, CV_32FC1);
+	return camera;
+}
+
+void AffineCameraEstimator::computeResiduals(const Mat& camera, const Mat& imagePoints, const Mat& modelPoints)
+{
+	const float* P0 = camera.ptr<float>(0);
+	const float* P1 = camera.ptr<float>(1);
+	residuals.resize(imagePoints.rows);
+	for (int i = 0; i < imagePoints.rows; ++i) {
+		const float* imagePoint = imagePoints.ptr<float>(i);
+		const float* modelPoint = modelPoints.ptr<float>(i);
+		const float dx = P0[0] * modelPoint[0] + P0[1] * modelPoint[1] + P0[2] * modelPoint[2] + P0[3] - imagePoint[0];
+		const float dy = P1[0] * modelPoint[0] + P1[1] * modelPoint[1] + P1[2] * modelPoint[2] + P1[3] - imagePoint[1];
+		residuals[i] = std::sqrt(dx * dx + dy * dy);
+	}
+}
+
+Mat estimateAffineCamera(const vector<imageio::ModelLandmark>& imagePoints, const MorphableModel& morphableModel, vector<int> vertexIds/*=std::vector<int>()*/)
+{
+	// Todo: Currently, the optional vertexIds are not used
+	AffineCameraEstimator estimator(morphableModel);
+	return estimator.estimate(imagePoints);
 }
 
 Mat calculateAffineZDirection(Mat affineCameraMatrix)
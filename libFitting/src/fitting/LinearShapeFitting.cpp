@@ -10,87 +10,141 @@
 
 #include "logging/LoggerFactory.hpp"
 
+#include <algorithm>
+
 using logging::LoggerFactory;
 using morphablemodel::MorphableModel;
 using cv::Mat;
 using std::vector;
+using std::string;
 
 namespace fitting {
 
-vector<float> fitShapeToLandmarksLinear(MorphableModel morphableModel, Mat affineCameraMatrix, vector<imageio::ModelLandmark> landmarks, float lambda/*=20.0f*/, boost::optional<int> numCoefficientsToFit/*=boost::optional<int>()*/, boost::optional<float> detectorStandardDeviation/*=boost::optional<float>()*/, boost::optional<float> modelStandardDeviation/*=boost::optional<float>()*/)
+LinearShapeFitter::LinearShapeFitter(const MorphableModel& morphableModel, std::size_t maxCachedSubspaces) : shapeModel(morphableModel.getShapeModel()), maxCachedSubspaces(std::max(maxCachedSubspaces, std::size_t(1)))
 {
-	// Not used yet
-	//int numCoeffsToFit = numCoefficientsToFit.get_value_or(morphableModel.getShapeModel().getNumberOfPrincipalComponents());
+}
+
+vector<float> LinearShapeFitter::fit(Mat affineCameraMatrix, const vector<imageio::ModelLandmark>& landmarks, float lambda/*=20.0f*/, boost::optional<float> detectorStandardDeviation/*=boost::optional<float>()*/, boost::optional<float> modelStandardDeviation/*=boost::optional<float>()*/)
+{
+	// We solve the same regularised least squares problem as fitShapeToLandmarksLinear() originally did with dense matrices:
+	// A = P * V_hat_h, b = P * v_bar - y, c_s = -(A^t * Omega * A + lambda * I)^-1 * A^t * Omega^t * b.
+	// P is block-diagonal with the camera matrix C = [C3 | t], so the rows of A belonging to landmark i are C3 * V_i,
+	// and the ones of b are C3 * v_i + t - y_i. Omega is a scalar times the identity.
+	// With G = C3^t * C3, this gives A^t * A = sum_jk G_jk * V_j^t * V_k and
+	// A^t * b = sum_jk G_jk * V_j^t * v_k + sum_j V_j^t * r_j, where r_j contains the j-th entry of C3^t * (t - y_i) of every landmark.
+	const LandmarkSubspace& subspace = getLandmarkSubspace(landmarks);
+	const int numShapePc = shapeModel.getNumberOfPrincipalComponents();
+	const int numLandmarks = static_cast<int>(landmarks.size());
+
+	cv::Mat_<double> C;
+	affineCameraMatrix.convertTo(C, CV_64FC1);
+	cv::Matx33d G;
+	for (int j = 0; j < 3; ++j) {
+		for (int k = 0; k < 3; ++k) {
+			G(j, k) = C(0, j) * C(0, k) + C(1, j) * C(1, k) + C(2, j) * C(2, k);
+		}
+	}
+
+	Mat AtA = Mat::zeros(numShapePc, numShapePc, CV_64FC1);
+	Mat Atb = Mat::zeros(numShapePc, 1, CV_64FC1);
+	for (int jk = 0; jk < 9; ++jk) {
+		cv::scaleAdd(subspace.basisGram[jk], G(jk / 3, jk % 3), AtA, AtA);
+		cv::scaleAdd(subspace.basisTimesMean[jk], G(jk / 3, jk % 3), Atb, Atb);
+	}
+	std::array<Mat, 3> r;
+	for (auto& r_j : r) {
+		r_j.create(numLandmarks, 1, CV_64FC1);
+	}
+	for (int i = 0; i < numLandmarks; ++i) {
+		// t - y_i, with y_i = (x, y, 1) being the landmark in homogeneous coordinates:
+		const cv::Vec3d d(C(0, 3) - landmarks[i].getX(), C(1, 3) - landmarks[i].getY(), C(2, 3) - 1.0);
+		for (int j = 0; j < 3; ++j) {
+			r[j].at<double>(i) = C(0, j) * d[0] + C(1, j) * d[1] + C(2, j) * d[2];
+		}
+	}
+	for (int j = 0; j < 3; ++j) {
+		cv::gemm(subspace.basisRows[j], r[j], 1.0, Atb, 1.0, Atb, cv::GEMM_1_T);
+	}
+
+	// The variances, see fitShapeToLandmarksLinear(). Omega = Sigma^t * Sigma is diagonal with 1/sigma^2 on every entry.
+	const double sigma_2D_3D = detectorStandardDeviation.get_value_or(0.003f) + modelStandardDeviation.get_value_or(0.0f);
+	const double omega = 1.0 / (sigma_2D_3D * sigma_2D_3D);
+
+	Mat AtOmegaAReg = omega * AtA + lambda * Mat::eye(numShapePc, numShapePc, CV_64FC1);
+	Mat AtOmegatb = -omega * Atb;
+	Mat c_s; // The variance-normalized shape parameter vector, $c_s = [a_1/sigma_{s,1} , ..., a_m-1/sigma_{s,m-1}]^t$
+	// AtOmegaAReg is symmetric and, for lambda > 0, positive definite. Only fall back to the pseudo-inverse if it isn't (i.e. lambda = 0 and too few landmarks).
+	if (!cv::solve(AtOmegaAReg, AtOmegatb, c_s, cv::DECOMP_CHOLESKY)) {
+		cv::solve(AtOmegaAReg, AtOmegatb, c_s, cv::DECOMP_SVD);
+	}
+	Mat c_s_float;
+	c_s.convertTo(c_s_float, CV_32FC1);
+	return vector<float>(c_s_float);
+}
 
-	// $\hat{V} \in R^{3N\times m-1}$, subselect the rows of the eigenvector matrix $V$ associated with the $N$ feature points
-	// And we insert a row of zeros after every third row, resulting in matrix $\hat{V}_h \in R^{4N\times m-1}$:
-	Mat V_hat_h = Mat::zeros(4 * landmarks.size(), morphableModel.getShapeModel().getNumberOfPrincipalComponents(), CV_32FC1);
-	int rowIndex = 0;
+const LinearShapeFitter::LandmarkSubspace& LinearShapeFitter::getLandmarkSubspace(const vector<imageio::ModelLandmark>& landmarks)
+{
+	vector<string> landmarkNames;
+	landmarkNames.reserve(landmarks.size());
 	for (const auto& lm : landmarks) {
-		Mat basisRows = morphableModel.getShapeModel().getNormalizedPcaBasis(lm.getName()); // In the paper, the not-normalized basis might be used? I'm not sure, check it. It's even a mess in the paper. PH 26.5.2014: I think the normalized basis is fine/better.
-		basisRows.copyTo(V_hat_h.rowRange(rowIndex, rowIndex + 3));
-		rowIndex += 4; // replace 3 rows and skip the 4th one, it has all zeros
+		landmarkNames.push_back(lm.getName());
+	}
+	// The cache is small, so a linear search is fine. A hit is moved to the front:
+	auto cached = std::find_if(begin(landmarkSubspaces), end(landmarkSubspaces), [&landmarkNames](const std::pair<vector<string>, LandmarkSubspace>& entry) {
+		return entry.first == landmarkNames;
+	});
+	if (cached != end(landmarkSubspaces)) {
+		landmarkSubspaces.splice(begin(landmarkSubspaces), landmarkSubspaces, cached);
+		return landmarkSubspaces.front().second;
 	}
-	// Form a block diagonal matrix $P \in R^{3N\times 4N}$ in which the camera matrix C (P_Affine, affineCam) is placed on the diagonal:
-	Mat P = Mat::zeros(3 * landmarks.size(), 4 * landmarks.size(), CV_32FC1);
-	for (int i = 0; i < landmarks.size(); ++i) {
-		Mat submatrixToReplace = P.colRange(4 * i, (4 * i) + 4).rowRange(3 * i, (3 * i) + 3);
-		affineCameraMatrix.copyTo(submatrixToReplace);
+
+	const int numShapePc = shapeModel.getNumberOfPrincipalComponents();
+	const int numLandmarks = static_cast<int>(landmarks.size());
+	LandmarkSubspace subspace;
+	std::array<Mat, 3> meanRows;
+	for (int j = 0; j < 3; ++j) {
+		subspace.basisRows[j].create(numLandmarks, numShapePc, CV_64FC1);
+		meanRows[j].create(numLandmarks, 1, CV_64FC1);
+	}
+	for (int i = 0; i < numLandmarks; ++i) {
+		Mat basisRows = shapeModel.getNormalizedPcaBasis(landmarkNames[i]); // 3 x m, see the note in fitShapeToLandmarksLinear() about the normalized basis
+		cv::Vec3f modelMean = shapeModel.getMeanAtPoint(landmarkNames[i]);
+		for (int j = 0; j < 3; ++j) {
+			Mat basisRow = subspace.basisRows[j].row(i);
+			basisRows.row(j).convertTo(basisRow, CV_64FC1);
+			meanRows[j].at<double>(i) = modelMean[j];
+		}
 	}
+	for (int j = 0; j < 3; ++j) {
+		for (int k = 0; k < 3; ++k) {
+			cv::gemm(subspace.basisRows[j], subspace.basisRows[k], 1.0, Mat(), 0.0, subspace.basisGram[3 * j + k], cv::GEMM_1_T);
+			cv::gemm(subspace.basisRows[j], meanRows[k], 1.0, Mat(), 0.0, subspace.basisTimesMean[3 * j + k], cv::GEMM_1_T);
+		}
+	}
+	if (landmarkSubspaces.size() >= maxCachedSubspaces) {
+		landmarkSubspaces.pop_back(); // the least recently used one
+	}
+	landmarkSubspaces.emplace_front(std::move(landmarkNames), std::move(subspace));
+	return landmarkSubspaces.front().second;
+}
+
+vector<float> fitShapeToLandmarksLinear(const MorphableModel& morphableModel, Mat affineCameraMatrix, const vector<imageio::ModelLandmark>& landmarks, float lambda/*=20.0f*/, boost::optional<int> numCoefficientsToFit/*=boost::optional<int>()*/, boost::optional<float> detectorStandardDeviation/*=boost::optional<float>()*/, boost::optional<float> modelStandardDeviation/*=boost::optional<float>()*/)
+{
+	// Not used yet
+	//int numCoeffsToFit = numCoefficientsToFit.get_value_or(morphableModel.getShapeModel().getNumberOfPrincipalComponents());
+
 	// The variances: Add the 2D and 3D standard deviations.
 	// If the user doesn't provide them, we choose the following:
 	// 2D (detector) variance: Assuming the detector has a standard deviation of 3 pixels, and the face size (IED) is around 80px. That's 3.75% of the IED. Assume that an image is on average 512x512px so 80/512 = 0.16 is the size the IED occupies inside an image.
 	//                         Now we're in clip-coords ([-1, 1]) and take 0.16 of the range [-1, 1], 0.16/2 = 0.08, and then the standard deviation of the detector is 3.75% of 0.08, i.e. 0.0375*0.08 = 0.003.
 	// 3D (model) variance: 0.0f. It only makes sense to set it to something when we have a different variance for different vertices.
-	float sigma_2D_3D = detectorStandardDeviation.get_value_or(0.003f) + modelStandardDeviation.get_value_or(0.0f);
 	// Note: Isn't it a bit strange to add those as they have different units/normalizations? Check the paper.
-	Mat Sigma = Mat::zeros(3 * landmarks.size(), 3 * landmarks.size(), CV_32FC1);
-	for (int i = 0; i < 3 * landmarks.size(); ++i) {
-		Sigma.at<float>(i, i) = 1.0f / sigma_2D_3D; // the higher the sigma_2D_3D, the smaller the diagonal entries of Sigma will be
-	}
-	Mat Omega = Sigma.t() * Sigma; // just squares the diagonal
-	// The landmarks in matrix notation (in homogeneous coordinates), $3N\times 1$
-	Mat y = Mat::ones(3 * landmarks.size(), 1, CV_32FC1);
-	for (int i = 0; i < landmarks.size(); ++i) {
-		y.at<float>(3 * i, 0) = landmarks[i].getX();
-		y.at<float>((3 * i) + 1, 0) = landmarks[i].getY();
-		//y.at<float>((3 * i) + 2, 0) = 1; // already 1, stays (homogeneous coordinate)
-	}
-	// The mean, with an added homogeneous coordinate (x_1, y_1, z_1, 1, x_2, ...)^t
-	Mat v_bar = Mat::ones(4 * landmarks.size(), 1, CV_32FC1);
-	for (int i = 0; i < landmarks.size(); ++i) {
-		cv::Vec3f modelMean = morphableModel.getShapeModel().getMeanAtPoint(landmarks[i].getName());
-		v_bar.at<float>(4 * i, 0) = modelMean[0];
-		v_bar.at<float>((4 * i) + 1, 0) = modelMean[1];
-		v_bar.at<float>((4 * i) + 2, 0) = modelMean[2];
-		//v_bar.at<float>((4 * i) + 3, 0) = 1; // already 1, stays (homogeneous coordinate)
-	}
-
-	// Bring into standard regularised quadratic form with diagonal distance matrix Omega
-	Mat A = P * V_hat_h; // camera matrix times the basis
-	Mat b = P * v_bar - y; // camera matrix times the mean, minus the landmarks.
-	//Mat c_s; // The x, we solve for this! (the variance-normalized shape parameter vector, $c_s = [a_1/sigma_{s,1} , ..., a_m-1/sigma_{s,m-1}]^t$
-	int numShapePc = morphableModel.getShapeModel().getNumberOfPrincipalComponents();
-	Mat AtOmegaA = A.t() * Omega * A;
-	Mat AtOmegaAReg = AtOmegaA + lambda * Mat::eye(numShapePc, numShapePc, CV_32FC1);
-	// Invert using OpenCV:
-	Mat AtOmegaARegInv = AtOmegaAReg.inv(cv::DECOMP_SVD); // DECOMP_SVD calculates the pseudo-inverse if the matrix is not invertible.
-	// Invert (and perform some sanity checks) using Eigen:
-	/*
-	Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> AtOmegaAReg_Eigen(AtOmegaAReg.ptr<float>(), AtOmegaAReg.rows, AtOmegaAReg.cols);
-	Eigen::FullPivLU<Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>> luOfAtOmegaAReg(AtOmegaAReg_Eigen); // Calculate the full-pivoting LU decomposition of the regularized AtA. Note: We could also try FullPivHouseholderQR if our system is non-minimal (i.e. there are more constraints than unknowns).
-	float rankOfAtOmegaAReg = luOfAtOmegaAReg.rank();
-	bool isAtOmegaARegInvertible = luOfAtOmegaAReg.isInvertible();
-	Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> AtARegInv_EigenFullLU = luOfAtOmegaAReg.inverse();
-	Mat AtOmegaARegInvFullLU(AtARegInv_EigenFullLU.rows(), AtARegInv_EigenFullLU.cols(), CV_32FC1, AtARegInv_EigenFullLU.data()); // create an OpenCV Mat header for the Eigen data
-	*/
-	Mat AtOmegatb = A.t() * Omega.t() * b;
-	Mat c_s = -AtOmegaARegInv * AtOmegatb; // Note/Todo: We get coefficients ~ N(0, sigma) I think. They are not multiplied with the eigenvalues.
-	
-	return vector<float>(c_s);
+	// In the paper, the not-normalized basis might be used? I'm not sure, check it. It's even a mess in the paper. PH 26.5.2014: I think the normalized basis is fine/better.
+	LinearShapeFitter fitter(morphableModel);
+	return fitter.fit(affineCameraMatrix, landmarks, lambda, detectorStandardDeviation, modelStandardDeviation);
 }
 
-std::vector<imageio::ModelLandmark> convertAvailableLandmarksToClipSpace(std::vector<imageio::ModelLandmark> landmarks, morphablemodel::MorphableModel morphableModel, int screenWidth, int screenHeight)
+std::vector<imageio::ModelLandmark> convertAvailableLandmarksToClipSpace(const std::vector<imageio::ModelLandmark>& landmarks, const morphablemodel::MorphableModel& morphableModel, int screenWidth, int screenHeight)
 {
 	vector<imageio::ModelLandmark> landmarksClipSpace;
 	for (const auto& lm : landmarks) {
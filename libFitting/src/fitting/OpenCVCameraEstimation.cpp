@@ -21,12 +21,12 @@ using std::pair;
 
 namespace fitting {
 
-OpenCVCameraEstimation::OpenCVCameraEstimation(/* const? shared_ptr? */MorphableModel morphableModel) : morphableModel(morphableModel)
+OpenCVCameraEstimation::OpenCVCameraEstimation(const MorphableModel& morphableModel) : morphableModel(morphableModel)
 {
 
 }
 
-cv::Mat OpenCVCameraEstimation::estimate(std::vector<imageio::ModelLandmark> imagePoints, cv::Mat intrinsicCameraMatrix, std::vector<int> vertexIds /*= std::vector<int>()*/)
+cv::Mat OpenCVCameraEstimation::estimate(const std::vector<imageio::ModelLandmark>& imagePoints, cv::Mat intrinsicCameraMatrix, std::vector<int> vertexIds /*= std::vector<int>()*/)
 {
 	if (imagePoints.size() < 3) {
 		Loggers->getLogger("morphablemodel").error("CameraEstimation: Number of points given is smaller than 3.");
@@ -34,17 +34,28 @@ cv::Mat OpenCVCameraEstimation::estimate(std::vector<imageio::ModelLandmark> ima
 	}
 
 	// Todo: Currently, the optional vertexIds is not used
-	vector<Point2f> points2d;
-	vector<Point3f> points3d;
+	points2d.clear(); // keeps the capacity
+	points3d.clear();
 	for (const auto& landmark : imagePoints) {
 		points2d.emplace_back(landmark.getPoint2D());
 		points3d.emplace_back(morphableModel.getShapeModel().getMeanAtPoint(landmark.getName()));
 	}
 
 	//Estimate the pose
+	const bool hasPreviousPose = warmStart && !previousRvec.empty();
 	Mat rvec(3, 1, CV_64FC1);
 	Mat tvec(3, 1, CV_64FC1);
-	if (points2d.size() == 3) {
+	if (hasPreviousPose) {
+		previousRvec.copyTo(rvec);
+		previousTvec.copyTo(tvec);
+	}
+	if (useRansac && points2d.size() >= 4) {
+		// With a previous pose, the iterative solver refines it. Without, EPNP gives the initial solution.
+		cv::solvePnPRansac(points3d, points2d, intrinsicCameraMatrix, vector<float>(), rvec, tvec, hasPreviousPose, ransacIterations, ransacReprojectionError, static_cast<int>(points2d.size()), cv::noArray(), hasPreviousPose ? CV_ITERATIVE : CV_EPNP);
+	} else if (hasPreviousPose) {
+		// Levenberg-Marquardt refinement of the previous pose, usually converges in a few iterations on videos
+		cv::solvePnP(points3d, points2d, intrinsicCameraMatrix, vector<float>(), rvec, tvec, true, CV_ITERATIVE);
+	} else if (points2d.size() == 3) {
 		cv::solvePnP(points3d, points2d, intrinsicCameraMatrix, vector<float>(), rvec, tvec, false, CV_ITERATIVE); // CV_ITERATIVE (3pts) | CV_P3P (4pts) | CV_EPNP (4pts)
 	} else {
 		cv::solvePnP(points3d, points2d, intrinsicCameraMatrix, vector<float>(), rvec, tvec, false, CV_EPNP); // CV_ITERATIVE (3pts) | CV_P3P (4pts) | CV_EPNP (4pts)
@@ -53,6 +64,9 @@ cv::Mat OpenCVCameraEstimation::estimate(std::vector<imageio::ModelLandmark> ima
 		// has an optional argument 'inliers' - might be useful
 	}
 
+	rvec.copyTo(previousRvec);
+	tvec.copyTo(previousTvec);
+
 	// Convert rvec/tvec to matrices, etc... return 4x4 extrinsic camera matrix
 	Mat rotation_matrix(3, 3, CV_64FC1);
 	cv::Rodrigues(rvec, rotation_matrix);
@@ -70,6 +84,12 @@ cv::Mat OpenCVCameraEstimation::estimate(std::vector<imageio::ModelLandmark> ima
 	return extrinsicCameraMatrix;
 }
 
+void OpenCVCameraEstimation::reset()
+{
+	previousRvec.release();
+	previousTvec.release();
+}
+
 cv::Mat OpenCVCameraEstimation::createIntrinsicCameraMatrix(float f, int w, int h)
 {
 	Mat camMatrix = (cv::Mat_<double>(3, 3) << f, 0, w / 2.0,
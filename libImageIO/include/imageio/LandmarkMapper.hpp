@@ -14,9 +14,107 @@
 	#define BOOST_ALL_NO_LIB	// Don't use the automatic library linking by boost with VS2010 (#pragma ...). Instead, we specify everything in cmake.
 #endif
 #include "boost/filesystem/path.hpp"
+#include "opencv2/core/core.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
 
 namespace imageio {
 
+/**
+ * A landmark mapping that was compiled against a source and a target
+ * landmark scheme, i.e. against ordered lists of landmark names. It
+ * consists of the index of the source landmark of each target landmark,
+ * so converting is a permutation that doesn't need any name lookups.
+ * Create it with LandmarkMapper::compile(...).
+ */
+class CompiledLandmarkMapping {
+public:
+
+	/**
+	 * Constructs an empty mapping with empty schemes.
+	 */
+	CompiledLandmarkMapping();
+
+	/**
+	 * Constructs a mapping from the index of the source landmark of each
+	 * target landmark.
+	 *
+	 * @param[in] sourceScheme The names of the source landmarks, in order.
+	 * @param[in] targetScheme The names of the target landmarks, in order.
+	 * @param[in] sourceIndices The index into the source scheme of each target landmark, -1 if it has no source.
+	 */
+	CompiledLandmarkMapping(std::vector<std::string> sourceScheme, std::vector<std::string> targetScheme, std::vector<int> sourceIndices);
+
+	/**
+	 * Determines whether the landmarks of a collection are in the order
+	 * of the source scheme, so it can be converted without name lookups.
+	 *
+	 * @param[in] landmarks A collection of landmarks.
+	 * @return True if the names of the landmarks are the source scheme.
+	 */
+	bool hasSourceScheme(const LandmarkCollection& landmarks) const;
+
+	/**
+	 * Converts a collection of landmarks into the landmarks of the target
+	 * scheme, in the order of the target scheme. Target landmarks whose
+	 * source landmark is not contained in the collection are omitted. If
+	 * the collection has the source scheme, no names are looked up at all.
+	 *
+	 * @param[in] landmarks A collection of landmarks with names of the source scheme.
+	 * @param[out] convertedLandmarks The converted landmarks. Is cleared first.
+	 */
+	void convert(const LandmarkCollection& landmarks, LandmarkCollection& convertedLandmarks) const;
+
+	/**
+	 * Converts dense landmark points, one landmark per row, from the source
+	 * scheme to the target scheme by copying the rows. Rows of target
+	 * landmarks without a source landmark are set to zero. Nothing is
+	 * allocated if the output already has the right size and type.
+	 *
+	 * @param[in] points The points of the source landmarks, one row per landmark of the source scheme.
+	 * @param[out] convertedPoints The points of the target landmarks, one row per landmark of the target scheme.
+	 */
+	void convert(const cv::Mat& points, cv::Mat& convertedPoints) const;
+
+	/**
+	 * Converts dense 2D landmark points from the source scheme to the target
+	 * scheme. Points of target landmarks without a source landmark are set to
+	 * (0, 0). Nothing is allocated if the output has enough capacity.
+	 *
+	 * @param[in] points The points of the source landmarks, one per landmark of the source scheme.
+	 * @param[out] convertedPoints The points of the target landmarks, one per landmark of the target scheme.
+	 */
+	void convert(const std::vector<cv::Point2f>& points, std::vector<cv::Point2f>& convertedPoints) const;
+
+	/**
+	 * @return The names of the source landmarks, in order.
+	 */
+	const std::vector<std::string>& getSourceScheme() const {
+		return sourceScheme;
+	}
+
+	/**
+	 * @return The names of the target landmarks, in order.
+	 */
+	const std::vector<std::string>& getTargetScheme() const {
+		return targetScheme;
+	}
+
+	/**
+	 * @return The index into the source scheme of each target landmark, -1 if it has no source.
+	 */
+	const std::vector<int>& getSourceIndices() const {
+		return sourceIndices;
+	}
+
+private:
+	std::vector<std::string> sourceScheme; ///< The names of the source landmarks, in order.
+	std::vector<std::string> targetScheme; ///< The names of the target landmarks, in order.
+	std::vector<int> sourceIndices; ///< The index into the source scheme of each target landmark, -1 if it has no source.
+};
+
 /**
  * Represents a mapping from one kind of landmarks
  * to a different format. Mappings are stored in a
@@ -56,7 +154,15 @@ public:
 	* @throws out_of_range exception if there is no mapping
 	*         for the given landmarkName.
 	*/
-	std::string convert(std::string landmarkName);
+	std::string convert(const std::string& landmarkName) const;
+
+	/**
+	* Determines whether there is a mapping for the given landmark name.
+	*
+	* @param[in] landmarkName A landmark name.
+	* @return True if the landmark name can be converted.
+	*/
+	bool hasMapping(const std::string& landmarkName) const;
 
 
 	/**
@@ -68,7 +174,7 @@ public:
 	* @throws out_of_range exception if there is no mapping
 	*         for the landmark name of the given landmark.
 	*/
-	std::shared_ptr<Landmark> convert(std::shared_ptr<Landmark> landmark);
+	std::shared_ptr<Landmark> convert(std::shared_ptr<Landmark> landmark) const;
 
 	/**
 	* Returns a new LandmarkCollection with all the landmark names
@@ -80,7 +186,37 @@ public:
 	* @return A LandmarkCollection containing all the landmarks
 	*         that were successfully converted.
 	*/
-	LandmarkCollection convert(LandmarkCollection landmarks);
+	LandmarkCollection convert(const LandmarkCollection& landmarks) const;
+
+	/**
+	* Compiles the mappings against a source scheme. The target
+	* scheme consists of the mapped names of the source landmarks
+	* that have a mapping, in the order of the source scheme.
+	*
+	* @param[in] sourceScheme The names of the source landmarks, in order.
+	* @return The compiled mapping.
+	*/
+	CompiledLandmarkMapping compile(const std::vector<std::string>& sourceScheme) const;
+
+	/**
+	* Compiles the mappings against the names of the landmarks of
+	* a collection, in their order (see compile(const std::vector<std::string>&)).
+	*
+	* @param[in] landmarks A collection of landmarks whose names make up the source scheme.
+	* @return The compiled mapping.
+	*/
+	CompiledLandmarkMapping compile(const LandmarkCollection& landmarks) const;
+
+	/**
+	* Compiles the mappings against a source and a target scheme.
+	* Target landmarks that are not mapped to from any landmark of
+	* the source scheme have no source (see CompiledLandmarkMapping).
+	*
+	* @param[in] sourceScheme The names of the source landmarks, in order.
+	* @param[in] targetScheme The names of the target landmarks, in order.
+	* @return The compiled mapping.
+	*/
+	CompiledLandmarkMapping compile(const std::vector<std::string>& sourceScheme, const std::vector<std::string>& targetScheme) const;
 
 private:
 	std::map<std::string, std::string> landmarkMappings;
@@ -0,0 +1,122 @@
+/*
+ * WindowImageSink.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef WINDOWIMAGESINK_HPP_
+#define WINDOWIMAGESINK_HPP_
+
+#include "imageio/ImageSink.hpp"
+#include "opencv2/core/core.hpp"
+#include <string>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+namespace imageio {
+
+/**
+ * Image sink that shows the images in a window, using a thread of its own.
+ *
+ * Showing an image (and polling the GUI events) is done on the display thread, so adding an image
+ * never waits for the GUI. There is only one slot for pending images: If the display thread is
+ * still busy with the previous image, the pending image is replaced by the new one, so images are
+ * dropped instead of stalling the caller. The display thread keeps polling the GUI events while no
+ * image arrives, so mouse and trackbar callbacks of the window are executed on the display thread.
+ *
+ * Keys that are pressed while the window has the focus are remembered and can be polled by other
+ * threads using getKey().
+ *
+ * Most GUI backends require all GUI calls to be made from the same thread. Therefore, other windows,
+ * trackbars and mouse callbacks should be created by the setup function, which runs on the display
+ * thread, too.
+ */
+class WindowImageSink : public ImageSink {
+public:
+
+	/**
+	 * Constructs a new window image sink and starts the display thread. Returns after the window was
+	 * created and the setup function was run on the display thread.
+	 *
+	 * @param[in] windowName The name of the window. It will be created if it does not exist yet.
+	 * @param[in] delay Time in milliseconds the GUI events are polled for after showing an image (and between polls).
+	 * @param[in] setup Function that is run on the display thread after creating the window (may be empty).
+	 * @throws Whatever the setup function throws.
+	 */
+	explicit WindowImageSink(const std::string& windowName, int delay = 5, std::function<void()> setup = nullptr);
+
+	/**
+	 * Stops the display thread after it has shown the pending image, if any.
+	 */
+	~WindowImageSink();
+
+	/**
+	 * Adds an image that should be shown. The image is copied.
+	 *
+	 * @param[in] image The image.
+	 */
+	void add(const cv::Mat& image);
+
+	/**
+	 * Adds an image that should be shown after drawing onto it. The image is copied, the drawing is done
+	 * on the display thread. Therefore, the drawing function must not refer to data that is changed by the
+	 * caller afterwards, so it should take copies of everything it draws.
+	 *
+	 * @param[in] image The image.
+	 * @param[in] draw Function that draws onto the copy of the image before it is shown.
+	 */
+	void add(const cv::Mat& image, std::function<void(cv::Mat&)> draw);
+
+	/**
+	 * Determines whether the display thread is idle, so an image that is added now is going to be
+	 * shown. Callers can use this to avoid preparing images that would be dropped anyway.
+	 *
+	 * @return True if there is no pending image, false otherwise.
+	 */
+	bool isReady() const;
+
+	/**
+	 * Returns the key that was pressed most recently and forgets about it.
+	 *
+	 * @return The code of the key (as returned by cv::waitKey) or -1 if no key was pressed since the last call.
+	 */
+	int getKey();
+
+	/**
+	 * @return The number of images that were replaced by newer ones before they could be shown.
+	 */
+	size_t getDroppedCount() const;
+
+private:
+
+	/**
+	 * Creates the window, runs the setup function, then shows the pending images and polls the GUI
+	 * events until the sink is destructed.
+	 *
+	 * @param[in] setup Function that is run after creating the window (may be empty).
+	 */
+	void run(std::function<void()> setup);
+
+	const std::string windowName; ///< The name of the window.
+	const int delay; ///< Time in milliseconds the GUI events are polled for.
+	mutable std::mutex pendingMutex; ///< Mutex that guards the pending image.
+	std::condition_variable pendingChanged; ///< Notifies the display thread about new images and stopping.
+	std::condition_variable startedChanged; ///< Notifies the constructor about the end of the setup.
+	cv::Mat pendingImage; ///< Image that was added, but not shown yet.
+	std::function<void(cv::Mat&)> pendingDraw; ///< Drawing function of the pending image (may be empty).
+	bool hasPending; ///< Flag that indicates whether there is a pending image.
+	bool stopping; ///< Flag that indicates whether the display thread should stop.
+	bool started; ///< Flag that indicates whether the window was created and the setup function was run.
+	std::atomic<int> key; ///< Code of the most recently pressed key, -1 if none.
+	std::atomic<size_t> droppedCount; ///< Number of images that were dropped.
+	std::exception_ptr error; ///< Exception that was thrown on the display thread, will be re-thrown on the next add.
+	std::thread thread; ///< The display thread.
+};
+
+} /* namespace imageio */
+#endif /* WINDOWIMAGESINK_HPP_ */
@@ -15,14 +15,112 @@
 #include "boost/property_tree/ptree.hpp"
 #include "boost/property_tree/info_parser.hpp"
 
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
 using boost::property_tree::ptree;
 using boost::lexical_cast;
+using cv::Mat;
+using cv::Point2f;
 using std::string;
+using std::vector;
+using std::unordered_map;
 using std::shared_ptr;
 using std::make_shared;
 
 namespace imageio {
 
+namespace {
+
+// Creates a copy of the landmark with a new name.
+shared_ptr<Landmark> createRenamedLandmark(const Landmark& landmark, const string& name)
+{
+	switch (landmark.getType())
+	{
+	case Landmark::LandmarkType::MODEL:
+		return make_shared<ModelLandmark>(name, landmark.getPosition3D(), landmark.isVisible());
+	case Landmark::LandmarkType::RECT:
+		return make_shared<RectLandmark>(name, landmark.getPosition2D(), landmark.getSize(), landmark.isVisible());
+	default:
+		logging::Logger logger = logging::Loggers->getLogger("imageio");
+		string errorMessage = "Encountered an unknown LandmarkType. Please update this switch-statement.";
+		logger.error(errorMessage);
+		throw std::runtime_error(errorMessage);
+	}
+}
+
+} /* unnamed namespace */
+
+CompiledLandmarkMapping::CompiledLandmarkMapping()
+{
+}
+
+CompiledLandmarkMapping::CompiledLandmarkMapping(vector<string> sourceScheme, vector<string> targetScheme, vector<int> sourceIndices) :
+		sourceScheme(std::move(sourceScheme)), targetScheme(std::move(targetScheme)), sourceIndices(std::move(sourceIndices))
+{
+	if (this->targetScheme.size() != this->sourceIndices.size())
+		throw std::invalid_argument("CompiledLandmarkMapping: there must be one source index per target landmark");
+	for (int index : this->sourceIndices) {
+		if (index >= static_cast<int>(this->sourceScheme.size()))
+			throw std::invalid_argument("CompiledLandmarkMapping: source index " + lexical_cast<string>(index) + " is out of range");
+	}
+}
+
+bool CompiledLandmarkMapping::hasSourceScheme(const LandmarkCollection& landmarks) const
+{
+	const vector<shared_ptr<Landmark>>& sourceLandmarks = landmarks.getLandmarks();
+	if (sourceLandmarks.size() != sourceScheme.size())
+		return false;
+	for (size_t i = 0; i < sourceScheme.size(); ++i) {
+		if (sourceLandmarks[i]->getName() != sourceScheme[i])
+			return false;
+	}
+	return true;
+}
+
+void CompiledLandmarkMapping::convert(const LandmarkCollection& landmarks, LandmarkCollection& convertedLandmarks) const
+{
+	convertedLandmarks.clear();
+	const vector<shared_ptr<Landmark>>& sourceLandmarks = landmarks.getLandmarks();
+	const bool inSchemeOrder = hasSourceScheme(landmarks);
+	for (size_t i = 0; i < targetScheme.size(); ++i) {
+		int sourceIndex = sourceIndices[i];
+		if (sourceIndex < 0)
+			continue;
+		if (inSchemeOrder)
+			convertedLandmarks.insert(createRenamedLandmark(*sourceLandmarks[sourceIndex], targetScheme[i]));
+		else if (landmarks.hasLandmark(sourceScheme[sourceIndex]))
+			convertedLandmarks.insert(createRenamedLandmark(*landmarks.getLandmark(sourceScheme[sourceIndex]), targetScheme[i]));
+	}
+}
+
+void CompiledLandmarkMapping::convert(const Mat& points, Mat& convertedPoints) const
+{
+	if (points.rows != static_cast<int>(sourceScheme.size()))
+		throw std::invalid_argument("CompiledLandmarkMapping: there must be one row per landmark of the source scheme");
+	convertedPoints.create(static_cast<int>(targetScheme.size()), points.cols, points.type());
+	const size_t rowSize = points.cols * points.elemSize();
+	for (size_t i = 0; i < targetScheme.size(); ++i) {
+		int sourceIndex = sourceIndices[i];
+		if (sourceIndex < 0)
+			std::memset(convertedPoints.ptr(static_cast<int>(i)), 0, rowSize);
+		else
+			std::memcpy(convertedPoints.ptr(static_cast<int>(i)), points.ptr(sourceIndex), rowSize);
+	}
+}
+
+void CompiledLandmarkMapping::convert(const vector<Point2f>& points, vector<Point2f>& convertedPoints) const
+{
+	if (points.size() != sourceScheme.size())
+		throw std::invalid_argument("CompiledLandmarkMapping: there must be one point per landmark of the source scheme");
+	convertedPoints.resize(targetScheme.size());
+	for (size_t i = 0; i < targetScheme.size(); ++i) {
+		int sourceIndex = sourceIndices[i];
+		convertedPoints[i] = sourceIndex < 0 ? Point2f(0, 0) : points[sourceIndex];
+	}
+}
+
 LandmarkMapper::LandmarkMapper()
 {
 }
@@ -65,51 +163,78 @@ LandmarkMapper LandmarkMapper::load(boost::filesystem::path filename)
 	return LandmarkMapper(filename);
 }
 
-string LandmarkMapper::convert(string landmarkName)
+string LandmarkMapper::convert(const string& landmarkName) const
 {
 	return landmarkMappings.at(landmarkName); // throws an out_of_range exception if landmarkName does not match the key of any element in the map
 }
 
-
-shared_ptr<Landmark> LandmarkMapper::convert(shared_ptr<Landmark> landmark)
+bool LandmarkMapper::hasMapping(const string& landmarkName) const
 {
-	shared_ptr<Landmark> convertedLandmark;
-	string mappedId = landmarkMappings.at(landmark->getName());
-	switch (landmark->getType())
-	{
-	case Landmark::LandmarkType::MODEL:
-		convertedLandmark = make_shared<ModelLandmark>(mappedId, landmark->getPosition3D(), landmark->isVisible());
-		break;
-	case Landmark::LandmarkType::RECT:
-		convertedLandmark = make_shared<RectLandmark>(mappedId, landmark->getPosition2D(), landmark->getSize(), landmark->isVisible());
-		break;
-	default:
-		logging::Logger logger = logging::Loggers->getLogger("imageio");
-		string errorMessage = "Encountered an unknown LandmarkType. Please update this switch-statement.";
-		logger.error(errorMessage);
-		throw std::runtime_error(errorMessage);
-		break;
-	}
-	return convertedLandmark;
+	return landmarkMappings.find(landmarkName) != landmarkMappings.end();
 }
 
-LandmarkCollection LandmarkMapper::convert(LandmarkCollection landmarks)
+shared_ptr<Landmark> LandmarkMapper::convert(shared_ptr<Landmark> landmark) const
 {
-	logging::Logger logger = logging::Loggers->getLogger("imageio");
+	return createRenamedLandmark(*landmark, landmarkMappings.at(landmark->getName()));
+}
 
+LandmarkCollection LandmarkMapper::convert(const LandmarkCollection& landmarks) const
+{
 	LandmarkCollection convertedLandmarks;
-	const auto& originalLandmarks = landmarks.getLandmarks();
-	for (const auto& lm : originalLandmarks) {
-		try {
-			shared_ptr<Landmark> convertedLandmark = convert(lm);
-			convertedLandmarks.insert(convertedLandmark);
-		}
-		catch (std::out_of_range& error) {
-			// a mapping for the current landmark is not found, we skip it
-			logger.trace("Could not find the current landmark \"" + lm->getName() + "\" in the landmarks-mapping, not converting this landmark.");
+	size_t unmapped = 0;
+	for (const auto& lm : landmarks.getLandmarks()) {
+		auto mapping = landmarkMappings.find(lm->getName());
+		if (mapping == landmarkMappings.end()) {
+			++unmapped; // a mapping for the current landmark is not found, we skip it
+			continue;
 		}
+		convertedLandmarks.insert(createRenamedLandmark(*lm, mapping->second));
+	}
+	if (unmapped > 0) {
+		logging::Logger logger = logging::Loggers->getLogger("imageio");
+		logger.trace("Could not find " + lexical_cast<string>(unmapped) + " landmarks in the landmarks-mapping, not converting them.");
 	}
 	return convertedLandmarks;
 }
 
+CompiledLandmarkMapping LandmarkMapper::compile(const vector<string>& sourceScheme) const
+{
+	vector<string> targetScheme;
+	vector<int> sourceIndices;
+	for (size_t i = 0; i < sourceScheme.size(); ++i) {
+		auto mapping = landmarkMappings.find(sourceScheme[i]);
+		if (mapping != landmarkMappings.end()) {
+			targetScheme.push_back(mapping->second);
+			sourceIndices.push_back(static_cast<int>(i));
+		}
+	}
+	return CompiledLandmarkMapping(sourceScheme, targetScheme, sourceIndices);
+}
+
+CompiledLandmarkMapping LandmarkMapper::compile(const LandmarkCollection& landmarks) const
+{
+	vector<string> sourceScheme;
+	sourceScheme.reserve(landmarks.getLandmarks().size());
+	for (const auto& lm : landmarks.getLandmarks())
+		sourceScheme.push_back(lm->getName());
+	return compile(sourceScheme);
+}
+
+CompiledLandmarkMapping LandmarkMapper::compile(const vector<string>& sourceScheme, const vector<string>& targetScheme) const
+{
+	unordered_map<string, int> targetIndices;
+	for (size_t i = 0; i < targetScheme.size(); ++i)
+		targetIndices.emplace(targetScheme[i], static_cast<int>(i));
+	vector<int> sourceIndices(targetScheme.size(), -1);
+	for (size_t i = 0; i < sourceScheme.size(); ++i) {
+		auto mapping = landmarkMappings.find(sourceScheme[i]);
+		if (mapping == landmarkMappings.end())
+			continue;
+		auto target = targetIndices.find(mapping->second);
+		if (target != targetIndices.end() && sourceIndices[target->second] < 0)
+			sourceIndices[target->second] = static_cast<int>(i);
+	}
+	return CompiledLandmarkMapping(sourceScheme, targetScheme, sourceIndices);
+}
+
 } /* namespace imageio */
@@ -0,0 +1,128 @@
+/*
+ * WindowImageSink.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "imageio/WindowImageSink.hpp"
+#include "opencv2/highgui/highgui.hpp"
+#include <chrono>
+
+using cv::Mat;
+using std::string;
+using std::function;
+using std::mutex;
+using std::unique_lock;
+using std::lock_guard;
+
+namespace imageio {
+
+WindowImageSink::WindowImageSink(const string& windowName, int delay, function<void()> setup) :
+		windowName(windowName), delay(delay), hasPending(false), stopping(false), started(false), key(-1), droppedCount(0) {
+	thread = std::thread(&WindowImageSink::run, this, std::move(setup));
+	unique_lock<mutex> lock(pendingMutex);
+	startedChanged.wait(lock, [this]() { return started; });
+	if (error) { // the setup failed, the display thread already terminated
+		lock.unlock();
+		thread.join();
+		std::rethrow_exception(error);
+	}
+}
+
+WindowImageSink::~WindowImageSink() {
+	{
+		lock_guard<mutex> lock(pendingMutex);
+		stopping = true;
+	}
+	pendingChanged.notify_one();
+	thread.join();
+}
+
+void WindowImageSink::add(const Mat& image) {
+	add(image, function<void(Mat&)>());
+}
+
+void WindowImageSink::add(const Mat& image, function<void(Mat&)> draw) {
+	Mat copy = image.clone(); // the source may re-use its buffer for the next image
+	{
+		lock_guard<mutex> lock(pendingMutex);
+		if (error) {
+			std::exception_ptr e = error;
+			error = nullptr;
+			std::rethrow_exception(e);
+		}
+		if (hasPending)
+			++droppedCount;
+		pendingImage = copy;
+		pendingDraw = std::move(draw);
+		hasPending = true;
+	}
+	pendingChanged.notify_one();
+}
+
+bool WindowImageSink::isReady() const {
+	lock_guard<mutex> lock(pendingMutex);
+	return !hasPending;
+}
+
+int WindowImageSink::getKey() {
+	return key.exchange(-1);
+}
+
+size_t WindowImageSink::getDroppedCount() const {
+	return droppedCount;
+}
+
+void WindowImageSink::run(function<void()> setup) {
+	try {
+		cv::namedWindow(windowName, cv::WINDOW_AUTOSIZE);
+		if (setup)
+			setup();
+	} catch (...) {
+		lock_guard<mutex> lock(pendingMutex);
+		error = std::current_exception();
+		started = true;
+		startedChanged.notify_one();
+		return;
+	}
+	{
+		lock_guard<mutex> lock(pendingMutex);
+		started = true;
+	}
+	startedChanged.notify_one();
+	Mat image;
+	function<void(Mat&)> draw;
+	while (true) {
+		bool show = false;
+		{
+			unique_lock<mutex> lock(pendingMutex);
+			pendingChanged.wait_for(lock, std::chrono::milliseconds(delay), [this]() { return hasPending || stopping; });
+			if (hasPending) {
+				image = pendingImage;
+				draw = std::move(pendingDraw);
+				pendingImage = Mat();
+				pendingDraw = nullptr;
+				hasPending = false;
+				show = true;
+			} else if (stopping) {
+				break;
+			}
+		}
+		if (show) {
+			try {
+				if (draw)
+					draw(image);
+				cv::imshow(windowName, image);
+			} catch (...) {
+				lock_guard<mutex> lock(pendingMutex);
+				error = std::current_exception();
+			}
+		}
+		int pressed = cv::waitKey(delay); // processes the GUI events, including mouse and trackbar callbacks
+		if (pressed >= 0)
+			key = pressed;
+	}
+}
+
+} /* namespace imageio */
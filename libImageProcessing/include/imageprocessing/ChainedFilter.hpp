@@ -57,6 +57,11 @@ public:
 	 */
 	void add(std::shared_ptr<ImageFilter> filter);
 
+	/**
+	 * @return The filters in order of application.
+	 */
+	const std::vector<std::shared_ptr<ImageFilter>>& getFilters() const;
+
 	using ImageFilter::applyTo;
 
 	cv::Mat applyTo(const cv::Mat& image, cv::Mat& filtered) const;
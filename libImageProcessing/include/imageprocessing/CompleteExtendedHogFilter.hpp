@@ -11,6 +11,7 @@
 #include "imageprocessing/ImageFilter.hpp"
 #include <vector>
 #include <array>
+#include <memory>
 
 namespace imageprocessing {
 
@@ -73,13 +74,15 @@ private:
 	};
 
 	/**
-	 * Creates the look-up-table if its size does not match the requested size.
+	 * Provides the look-up table for the given size. If the current look-up table does not match, a new one is
+	 * created and published, so threads that still use the previous table are not affected.
 	 *
-	 * @param[in,out] lut The look-up table.
+	 * @param[in] lut The current look-up table (might be empty).
 	 * @param[in] size The necessary amount of entries (row/column count).
 	 * @param[in] count The number of cells.
+	 * @return The matching look-up table.
 	 */
-	void createLut(std::vector<BinInformation>& lut, size_t size, size_t count) const;
+	std::shared_ptr<const std::vector<BinInformation>> getLut(std::shared_ptr<const std::vector<BinInformation>>& lut, size_t size, size_t count) const;
 
 	/**
 	 * Creates the initial histograms by computing the gradients over the image.
@@ -110,8 +113,8 @@ private:
 	float alpha; ///< Truncation threshold of the orientation bin values (applied after normalization).
 
 	std::array<BinInformation, 512 * 512> binLut;  ///< Look-up table for bin information given a gradient code.
-	mutable std::vector<BinInformation> rowLut;    ///< Look-up table for the linear interpolation of the row indices.
-	mutable std::vector<BinInformation> columnLut; ///< Look-up table for the linear interpolation of the column indices.
+	mutable std::shared_ptr<const std::vector<BinInformation>> rowLut;    ///< Look-up table for the linear interpolation of the row indices (only accessed atomically).
+	mutable std::shared_ptr<const std::vector<BinInformation>> columnLut; ///< Look-up table for the linear interpolation of the column indices (only accessed atomically).
 
 	static const float eps; ///< The small value being added to the norm to prevent division by zero.
 };
@@ -9,6 +9,7 @@
 #define HISTEQ64FILTER_HPP_
 
 #include "imageprocessing/ImageFilter.hpp"
+#include <vector>
 
 namespace imageprocessing {
 
@@ -36,8 +37,49 @@ public:
 
 	void applyInPlace(cv::Mat& image) const;
 
+	/**
+	 * Computes the equalization look-up tables of many overlapping windows of an image (e.g. a pyramid layer)
+	 * at once. The top-left corners of the windows are at (area.x + i * stepX, area.y + j * stepY), as long as the
+	 * windows fit into the area. Instead of building a new histogram for each window, the histogram is slid along
+	 * each row of windows by removing the columns that leave the window and adding the ones that enter it, so the
+	 * cost per window is O(height * stepX) instead of O(width * height).
+	 *
+	 * Row k = j * windowsPerRow + i of the result contains the equalized value of each of the 64 bins of window (i, j),
+	 * i.e. applyTo() on that window gives lut[bin(pixel)] for each pixel, where bin(pixel) = pixel / 4.
+	 *
+	 * @param[in] image The image, CV_8UC1.
+	 * @param[in] windowSize The size of the windows.
+	 * @param[in] area The area of the image that the windows have to lie in.
+	 * @param[in] stepX The horizontal distance between two windows.
+	 * @param[in] stepY The vertical distance between two windows.
+	 * @return A matrix of type CV_8UC1 with one row of 64 values per window, the windows ordered row by row.
+	 */
+	cv::Mat computeWindowLuts(const cv::Mat& image, cv::Size windowSize, cv::Rect area, int stepX, int stepY) const;
+
+	/**
+	 * Equalizes many overlapping windows of an image at once, see computeWindowLuts(). The result for each window
+	 * is the same as that of applyTo().
+	 *
+	 * @param[in] image The image, CV_8UC1.
+	 * @param[in] windowSize The size of the windows.
+	 * @param[in] area The area of the image that the windows have to lie in.
+	 * @param[in] stepX The horizontal distance between two windows.
+	 * @param[in] stepY The vertical distance between two windows.
+	 * @return The equalized windows (CV_8UC1), row by row.
+	 */
+	std::vector<cv::Mat> applyToWindows(const cv::Mat& image, cv::Size windowSize, cv::Rect area, int stepX, int stepY) const;
+
 private:
 
+	/**
+	 * Computes the equalized value of each of the 64 bins from the histogram of a patch.
+	 *
+	 * @param[in] histogram The number of pixels in each of the 64 bins.
+	 * @param[in] stretchFactor 255 divided by the number of pixels of the patch.
+	 * @param[out] lut The equalized value of each bin.
+	 */
+	static void computeLut(const int* histogram, float stretchFactor, uchar* lut);
+
 	unsigned char* LUTbin; ///< lookup table for the histogram equalization
 };
 
@@ -10,6 +10,7 @@
 
 #include "imageprocessing/ImageFilter.hpp"
 #include <vector>
+#include <memory>
 
 namespace imageprocessing {
 
@@ -78,13 +79,23 @@ private:
 	};
 
 	/**
-	 * Creates the cache contents if the size of the cache does not match the requested size.
+	 * Cache for the linear interpolation of the indices along one dimension.
+	 */
+	struct Cache {
+		int count; ///< The number of cells.
+		std::vector<CacheEntry> entries; ///< One entry per pixel.
+	};
+
+	/**
+	 * Provides the cache for the given size and cell count. If the current cache does not match, a new one is created
+	 * and published, so threads that still use the previous cache are not affected.
 	 *
-	 * @param[in] cache The cache.
+	 * @param[in] cache The current cache (might be empty).
 	 * @param[in] size The necessary size of the cache.
 	 * @param[in] count The number of cells.
+	 * @return The matching cache.
 	 */
-	void createCache(std::vector<CacheEntry>& cache, unsigned int size, int count) const;
+	std::shared_ptr<const Cache> getCache(std::shared_ptr<const Cache>& cache, unsigned int size, int count) const;
 
 	/**
 	 * Normalizes the given histogram according to L2-norm.
@@ -115,8 +126,8 @@ private:
 	 */
 	void normalizeL1Sqrt(cv::Mat& histogram) const;
 
-	mutable std::vector<CacheEntry> rowCache; ///< Cache for the linear interpolation of the row indices.
-	mutable std::vector<CacheEntry> colCache; ///< Cache for the linear interpolation of the column indices.
+	mutable std::shared_ptr<const Cache> rowCache; ///< Cache for the linear interpolation of the row indices (only accessed atomically).
+	mutable std::shared_ptr<const Cache> colCache; ///< Cache for the linear interpolation of the column indices (only accessed atomically).
 };
 
 } /* namespace imageprocessing */
@@ -14,6 +14,11 @@ namespace imageprocessing {
 
 /**
  * Filter of images.
+ *
+ * Applying a filter must not change its observable state, so a single (configured) filter may be used by several
+ * threads at once. Precomputed data like look-up tables is either created in the constructor or published atomically
+ * as an immutable object, per-call buffers are local to the call. Filters that would otherwise allocate large buffers
+ * on every call offer an additional applyTo overload that takes a workspace, which the caller keeps per thread.
  */
 class ImageFilter {
 public:
@@ -9,6 +9,10 @@
 #define WHITENINGFILTER_HPP_
 
 #include "imageprocessing/ImageFilter.hpp"
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
 
 namespace imageprocessing {
 
@@ -17,41 +21,124 @@ namespace imageprocessing {
  * must not have more than one channel and can be of any type. The output image has the same type
  * as the input image.
  *
+ * The frequency-domain filters are cached per transform size. Optionally, the images are padded (by reflection)
+ * to a size that can be transformed efficiently before whitening, which is mostly useful for large images like
+ * pyramid layers. Many images of the same size (e.g. patches) can be whitened in one batched transformation.
+ *
  * The algorithm was taken from http://sun360.csail.mit.edu/jxiao/SFMedu/SFMedu/lib/vlfeat/toolbox/imop/vl_imwhiten.m.
  */
 class WhiteningFilter : public ImageFilter {
 public:
 
+	/**
+	 * Buffers that are used while applying the filter. Keeping one workspace per thread avoids the re-allocation
+	 * of the buffers on every call.
+	 */
+	struct Workspace {
+		cv::Mat floatImage;      ///< Buffer for the float conversion of the image(s).
+		cv::Mat paddedImage;     ///< Buffer for the padded image.
+		cv::Mat fourierImage;    ///< Buffer for the Fourier transformation of the image(s).
+		cv::Mat transposedImage; ///< Buffer for the transposed Fourier transformation of the images (batch only).
+	};
+
 	/**
 	 * Constructs a new whitening filter.
 	 *
 	 * @param[in] alpha Decay of modulus of spectrum is assumed as 1/frequency^alpha.
 	 * @param[in] cutoffFrequency The cut-off frequency of the additional low-pass filter (only applied when greater than zero).
+	 * @param[in] padToOptimalSize Flag that indicates whether the images should be padded to a size that is fast to transform.
 	 */
-	WhiteningFilter(float alpha = 1, float cutoffFrequency = 0.390625);
+	WhiteningFilter(float alpha = 1, float cutoffFrequency = 0.390625, bool padToOptimalSize = false);
 
 	using ImageFilter::applyTo;
 
 	cv::Mat applyTo(const cv::Mat& image, cv::Mat& filtered) const;
 
+	/**
+	 * Applies this filter to an image using the buffers of the given workspace.
+	 *
+	 * @param[in] image The image that should be filtered.
+	 * @param[out] filtered The image for writing the filtered data into.
+	 * @param[in,out] workspace The buffers, must not be used by another thread at the same time.
+	 * @return The filtered image.
+	 */
+	cv::Mat applyTo(const cv::Mat& image, cv::Mat& filtered, Workspace& workspace) const;
+
+	/**
+	 * Applies this filter to several images of the same size and type using one batched Fourier transformation.
+	 * The result is the same as applying the filter to each image separately (up to rounding errors). The
+	 * images may be filtered in place by giving the same vector twice.
+	 *
+	 * @param[in] images The images that should be filtered.
+	 * @param[out] filtered The filtered images.
+	 */
+	void applyTo(const std::vector<cv::Mat>& images, std::vector<cv::Mat>& filtered) const;
+
+	/**
+	 * Applies this filter to several images of the same size and type using the buffers of the given workspace,
+	 * see applyTo(const std::vector<cv::Mat>&, std::vector<cv::Mat>&).
+	 *
+	 * @param[in] images The images that should be filtered.
+	 * @param[out] filtered The filtered images.
+	 * @param[in,out] workspace The buffers, must not be used by another thread at the same time.
+	 */
+	void applyTo(const std::vector<cv::Mat>& images, std::vector<cv::Mat>& filtered, Workspace& workspace) const;
+
 	void applyInPlace(cv::Mat& image) const;
 
 private:
 
 	/**
-	 * Provides the whitening filter for the image in the frequency domain.
+	 * Whitening filter of a certain size in the frequency domain.
+	 */
+	struct Spectrum {
+		cv::Mat filter;           ///< The filter (height x width).
+		cv::Mat transposedFilter; ///< The transposed filter (width x height), scaled by 1 / (width * height) for the batched transformation.
+	};
+
+	typedef std::map<std::pair<int, int>, std::shared_ptr<const Spectrum>> SpectrumCache; ///< Filters by width and height.
+
+	/**
+	 * Computes the size of the Fourier transformation for images of the given size.
+	 *
+	 * @param[in] size The size of the images.
+	 * @return The size of the (padded) images that are transformed.
+	 */
+	cv::Size getTransformSize(cv::Size size) const;
+
+	/**
+	 * Provides the whitening filter for the image in the frequency domain. If there is no cached filter for the
+	 * size, a new one is created and added to a copy of the cache, so threads that still use the previous cache
+	 * are not affected.
 	 *
 	 * @param[in] width The width of the image (and filter).
 	 * @param[in] height The height of the image (and filter).
 	 * @return The filter of the given size.
 	 */
-	const cv::Mat& getFilter(int width, int height) const;
+	std::shared_ptr<const Spectrum> getFilter(int width, int height) const;
+
+	/**
+	 * Creates the whitening filter of a certain size.
+	 *
+	 * @param[in] width The width of the image (and filter).
+	 * @param[in] height The height of the image (and filter).
+	 * @return The filter of the given size.
+	 */
+	std::shared_ptr<const Spectrum> createFilter(int width, int height) const;
+
+	/**
+	 * Converts the whitened float image back to the type of the input image.
+	 *
+	 * @param[in] floatImage The whitened float image.
+	 * @param[out] filtered The image for writing the converted data into.
+	 * @param[in] type The type of the input image.
+	 */
+	static void convertBack(const cv::Mat& floatImage, cv::Mat& filtered, int type);
 
 	float alpha;           ///< Decay of modulus of spectrum is assumed as 1/frequency^alpha.
 	float cutoffFrequency; ///< The cut-off frequency of the additional low-pass filter (only applied when greater than zero).
-	mutable cv::Mat filter;       ///< The current filter.
-	mutable cv::Mat floatImage;   ///< Temporal buffer for the float conversion of the image.
-	mutable cv::Mat fourierImage; ///< Temporal buffer for the Fourier transformation of the image.
+	bool padToOptimalSize; ///< Flag that indicates whether the images should be padded to a size that is fast to transform.
+	mutable std::shared_ptr<const SpectrumCache> filters; ///< The cached filters (only accessed atomically).
 };
 
 } /* namespace imageprocessing */
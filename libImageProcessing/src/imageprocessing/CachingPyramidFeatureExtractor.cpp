@@ -8,6 +8,7 @@
 #include "imageprocessing/CachingPyramidFeatureExtractor.hpp"
 #include "imageprocessing/VersionedImage.hpp"
 #include "imageprocessing/Patch.hpp"
+#include "logging/Instrumentation.hpp"
 #include <stdexcept>
 
 using cv::Mat;
@@ -80,6 +81,7 @@ vector<shared_ptr<Patch>> CachingPyramidFeatureExtractor::extract(int stepX, int
 		throw invalid_argument("CachingPyramidFeatureExtractor: stepY has to be greater than zero");
 	if (stepLayer < 1)
 		throw invalid_argument("CachingPyramidFeatureExtractor: stepLayer has to be greater than zero");
+	INSTRUMENT_SCOPE("CachingPyramidFeatureExtractor::extract");
 	Size imageSize = getImageSize();
 	if (roi.x == 0 && roi.y == 0 && roi.width == 0 && roi.height == 0) {
 		roi.width = imageSize.width;
@@ -153,10 +155,12 @@ shared_ptr<Patch> CachingPyramidFeatureExtractor::extractSharing(CacheLayer& lay
 	unordered_map<CacheKey, shared_ptr<Patch>, CacheKey::hash>& layerCache = layer.getCache();
 	auto iterator = layerCache.find(key);
 	if (iterator == layerCache.end()) {
+		INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheMisses", 1);
 		shared_ptr<Patch> patch = extractor->extract(layer.getIndex(), x, y);
 		layerCache.emplace(key, patch);
 		return patch;
 	}
+	INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheHits", 1);
 	return iterator->second;
 }
 
@@ -165,11 +169,13 @@ shared_ptr<Patch> CachingPyramidFeatureExtractor::extractCopying(CacheLayer& lay
 	unordered_map<CacheKey, shared_ptr<Patch>, CacheKey::hash>& layerCache = layer.getCache();
 	auto iterator = layerCache.find(key);
 	if (iterator == layerCache.end()) {
+		INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheMisses", 1);
 		shared_ptr<Patch> patch = extractor->extract(layer.getIndex(), x, y);
 		if (patch) // store a copy of the patch only if it exists
 			layerCache.emplace(key, make_shared<Patch>(*patch));
 		return patch;
 	}
+	INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheHits", 1);
 	return make_shared<Patch>(*(iterator->second));
 }
 
@@ -178,11 +184,13 @@ shared_ptr<Patch> CachingPyramidFeatureExtractor::extractInputCopying(CacheLayer
 	unordered_map<CacheKey, shared_ptr<Patch>, CacheKey::hash>& layerCache = layer.getCache();
 	auto iterator = layerCache.find(key);
 	if (iterator == layerCache.end()) {
+		INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheMisses", 1);
 		shared_ptr<Patch> patch = extractor->extract(layer.getIndex(), x, y);
 		if (patch) // store a copy of the patch only if it exists
 			layerCache.emplace(key, make_shared<Patch>(*patch));
 		return patch;
 	}
+	INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheHits", 1);
 	return iterator->second;
 }
 
@@ -191,10 +199,12 @@ shared_ptr<Patch> CachingPyramidFeatureExtractor::extractOutputCopying(CacheLaye
 	unordered_map<CacheKey, shared_ptr<Patch>, CacheKey::hash>& layerCache = layer.getCache();
 	auto iterator = layerCache.find(key);
 	if (iterator == layerCache.end()) {
+		INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheMisses", 1);
 		shared_ptr<Patch> patch = extractor->extract(layer.getIndex(), x, y);
 		layerCache.emplace(key, patch);
 		return patch;
 	}
+	INSTRUMENT_COUNT("CachingPyramidFeatureExtractor.cacheHits", 1);
 	return make_shared<Patch>(*(iterator->second));
 }
 
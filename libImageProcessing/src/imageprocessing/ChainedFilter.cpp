@@ -29,6 +29,10 @@ ChainedFilter::ChainedFilter(
 	filters[2] = filter3;
 }
 
+const vector<shared_ptr<ImageFilter>>& ChainedFilter::getFilters() const {
+	return filters;
+}
+
 void ChainedFilter::add(shared_ptr<ImageFilter> filter) {
 	filters.push_back(filter);
 }
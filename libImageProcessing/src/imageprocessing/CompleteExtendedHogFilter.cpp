@@ -10,6 +10,8 @@
 
 using cv::Mat;
 using std::vector;
+using std::shared_ptr;
+using std::make_shared;
 using std::invalid_argument;
 
 namespace imageprocessing {
@@ -69,59 +71,66 @@ Mat CompleteExtendedHogFilter::applyTo(const Mat& image, Mat& filtered) const {
 	return filtered;
 }
 
-void CompleteExtendedHogFilter::createLut(vector<BinInformation>& lut, size_t size, size_t count) const {
-	if (lut.size() != size) {
-		lut.clear();
-		lut.reserve(size);
-		BinInformation entry;
-		if (interpolateCells) {
-			for (size_t matIndex = 0; matIndex < size; ++matIndex) {
-				double realIndex = (static_cast<double>(matIndex) + 0.5) / static_cast<double>(cellSize) - 0.5;
-				entry.index1 = static_cast<int>(floor(realIndex));
-				entry.index2 = entry.index1 + 1;
-				entry.weight2 = realIndex - entry.index1;
-				entry.weight1 = 1.f - entry.weight2;
-				if (entry.index1 < 0) {
-					entry.index1 = entry.index2;
-					entry.weight1 = 0;
-				} else if (entry.index2 >= static_cast<int>(count)) {
-					entry.index2 = entry.index1;
-					entry.weight2 = 0;
-				}
-				lut.push_back(entry);
-			}
-		} else {
-			entry.index2 = -1;
-			entry.weight1 = 1;
-			entry.weight2 = 0;
-			for (size_t matIndex = 0; matIndex < size; ++matIndex) {
-				entry.index1 = matIndex / cellSize;
-				lut.push_back(entry);
+shared_ptr<const vector<CompleteExtendedHogFilter::BinInformation>> CompleteExtendedHogFilter::getLut(
+		shared_ptr<const vector<BinInformation>>& lut, size_t size, size_t count) const {
+	shared_ptr<const vector<BinInformation>> current = std::atomic_load(&lut);
+	if (current && current->size() == size)
+		return current;
+	shared_ptr<vector<BinInformation>> created = make_shared<vector<BinInformation>>();
+	created->reserve(size);
+	BinInformation entry;
+	if (interpolateCells) {
+		for (size_t matIndex = 0; matIndex < size; ++matIndex) {
+			double realIndex = (static_cast<double>(matIndex) + 0.5) / static_cast<double>(cellSize) - 0.5;
+			entry.index1 = static_cast<int>(floor(realIndex));
+			entry.index2 = entry.index1 + 1;
+			entry.weight2 = realIndex - entry.index1;
+			entry.weight1 = 1.f - entry.weight2;
+			if (entry.index1 < 0) {
+				entry.index1 = entry.index2;
+				entry.weight1 = 0;
+			} else if (entry.index2 >= static_cast<int>(count)) {
+				entry.index2 = entry.index1;
+				entry.weight2 = 0;
 			}
+			created->push_back(entry);
+		}
+	} else {
+		entry.index2 = -1;
+		entry.weight1 = 1;
+		entry.weight2 = 0;
+		for (size_t matIndex = 0; matIndex < size; ++matIndex) {
+			entry.index1 = matIndex / cellSize;
+			created->push_back(entry);
 		}
 	}
+	current = created;
+	std::atomic_store(&lut, current);
+	return current;
 }
 
 void CompleteExtendedHogFilter::buildInitialHistograms(Mat& histograms, const Mat& image, size_t cellRowCount, size_t cellColumnCount) const {
 	if (image.type() != CV_8UC1)
 		throw invalid_argument("CompleteExtendedHogFilter: image must be of type CV_8UC1");
 
-	createLut(rowLut, image.rows, cellRowCount);
-	createLut(columnLut, image.cols, cellColumnCount);
+	shared_ptr<const vector<BinInformation>> currentRowLut = getLut(rowLut, image.rows, cellRowCount);
+	shared_ptr<const vector<BinInformation>> currentColumnLut = getLut(columnLut, image.cols, cellColumnCount);
+	const vector<BinInformation>& rowEntries = *currentRowLut;
+	const vector<BinInformation>& columnEntries = *currentColumnLut;
 	size_t height = cellRowCount * cellSize;
 	size_t width = cellColumnCount * cellSize;
 
 	for (size_t y = 0; y < height; ++y) {
-		int rowIndex1 = rowLut[y].index1;
-		int rowIndex2 = rowLut[y].index2;
-		float rowWeight1 = rowLut[y].weight1;
-		float rowWeight2 = rowLut[y].weight2;
+		int rowIndex1 = rowEntries[y].index1;
+		int rowIndex2 = rowEntries[y].index2;
+		float rowWeight1 = rowEntries[y].weight1;
+		float rowWeight2 = rowEntries[y].weight2;
 
 		for (size_t x = 0; x < width; ++x) {
-			int colIndex1 = columnLut[x].index1;
-			int colIndex2 = columnLut[x].index2;
-			float colWeight1 = columnLut[x].weight1;
-			float colWeight2 = columnLut[x].weight2;
+			int colIndex1 = columnEntries[x].index1;
+			int colIndex2 = columnEntries[x].index2;
+			float colWeight1 = columnEntries[x].weight1;
+			float colWeight2 = columnEntries[x].weight2;
 
 			int dx = image.at<uchar>(y, std::min(width - 1, x + 1)) - image.at<uchar>(y, std::max(0, static_cast<int>(x) - 1)) + 256;
 			int dy = image.at<uchar>(std::min(height - 1, y + 1), x) - image.at<uchar>(std::max(0, static_cast<int>(y) - 1), x) + 256;
@@ -10,6 +10,8 @@
 #include "imageprocessing/ImagePyramidLayer.hpp"
 #include "imageprocessing/Patch.hpp"
 #include "imageprocessing/ChainedFilter.hpp"
+#include "imageprocessing/HistEq64Filter.hpp"
+#include "logging/Instrumentation.hpp"
 #include <stdexcept>
 
 using cv::Mat;
@@ -20,6 +22,7 @@ using std::pair;
 using std::vector;
 using std::shared_ptr;
 using std::make_shared;
+using std::dynamic_pointer_cast;
 using std::invalid_argument;
 
 namespace imageprocessing {
@@ -84,6 +87,7 @@ vector<shared_ptr<Patch>> DirectPyramidFeatureExtractor::extract(int stepX, int
 		throw invalid_argument("DirectPyramidFeatureExtractor: stepY has to be greater than zero");
 	if (stepLayer < 1)
 		throw invalid_argument("DirectPyramidFeatureExtractor: stepLayer has to be greater than zero");
+	INSTRUMENT_SCOPE("DirectPyramidFeatureExtractor::extract");
 	Size imageSize = getImageSize();
 	if (roi.x == 0 && roi.y == 0 && roi.width == 0 && roi.height == 0) {
 		roi.width = imageSize.width;
@@ -95,6 +99,9 @@ vector<shared_ptr<Patch>> DirectPyramidFeatureExtractor::extract(int stepX, int
 		roi.height = std::min(imageSize.height, roi.height + roi.y) - roi.y;
 	}
 	vector<shared_ptr<Patch>> patches;
+	// if the patches are histogram equalized first, all windows of a layer are equalized at once using a sliding histogram
+	const vector<shared_ptr<ImageFilter>>& filters = patchFilter->getFilters();
+	shared_ptr<HistEq64Filter> histEqFilter = filters.empty() ? shared_ptr<HistEq64Filter>() : dynamic_pointer_cast<HistEq64Filter>(filters.front());
 	const vector<shared_ptr<ImagePyramidLayer>>& layers = pyramid->getLayers();
 	if (firstLayer < 0)
 		firstLayer = layers.front()->getIndex();
@@ -113,6 +120,23 @@ vector<shared_ptr<Patch>> DirectPyramidFeatureExtractor::extract(int stepX, int
 
 		Point roiBegin(getScaled(*layer, roi.x), getScaled(*layer, roi.y));
 		Point roiEnd(getScaled(*layer, roi.x + roi.width), getScaled(*layer, roi.y + roi.height));
+		if (histEqFilter && image.type() == CV_8U) {
+			// the windows have to end strictly before roiEnd, same as in the loops below
+			Rect area(roiBegin.x, roiBegin.y, roiEnd.x - 1 - roiBegin.x, roiEnd.y - 1 - roiBegin.y);
+			vector<Mat> windows = histEqFilter->applyToWindows(image, Size(patchWidth, patchHeight), area, stepX, stepY);
+			int windowsPerRow = area.width >= patchWidth ? (area.width - patchWidth) / stepX + 1 : 0;
+			for (size_t i = 0; i < windows.size(); ++i) {
+				int x = area.x + static_cast<int>(i % windowsPerRow) * stepX;
+				int y = area.y + static_cast<int>(i / windowsPerRow) * stepY;
+				int originalX = getOriginal(*layer, x) + originalWidth / 2;
+				int originalY = getOriginal(*layer, y) + originalHeight / 2;
+				Mat& data = windows[i];
+				for (auto filter = filters.begin() + 1; filter != filters.end(); ++filter)
+					(*filter)->applyInPlace(data);
+				patches.push_back(make_shared<Patch>(originalX, originalY, originalWidth, originalHeight, data));
+			}
+			continue;
+		}
 		Rect patchBounds(roiBegin.x, roiBegin.y, patchWidth, patchHeight);
 		for (patchBounds.y = roiBegin.y; patchBounds.y + patchBounds.height < roiEnd.y; patchBounds.y += stepY) {
 			for (patchBounds.x = roiBegin.x; patchBounds.x + patchBounds.width < roiEnd.x; patchBounds.x += stepX) {
@@ -123,6 +147,7 @@ vector<shared_ptr<Patch>> DirectPyramidFeatureExtractor::extract(int stepX, int
 			}
 		}
 	}
+	INSTRUMENT_COUNT("DirectPyramidFeatureExtractor.patches", patches.size());
 	return patches;
 }
 
@@ -10,6 +10,7 @@
 #include "imageprocessing/ImagePyramid.hpp"
 #include "imageprocessing/ImagePyramidLayer.hpp"
 #include "imageprocessing/ImageFilter.hpp"
+#include "logging/Instrumentation.hpp"
 #include "imageprocessing/GrayscaleFilter.hpp"
 #include "imageprocessing/GradientFilter.hpp"
 #include "imageprocessing/GradientBinningFilter.hpp"
@@ -124,6 +125,7 @@ shared_ptr<Patch> ExtendedHogFeatureExtractor::extract(int x, int y, int width,
 		else
 			throw runtime_error("ExtendedHogFeatureExtractor: the type of the pyramid layer images has to be CV_8UC1, CV_8UC2 or CV_8UC4");
 	}
+	INSTRUMENT_COUNT("ExtendedHogFeatureExtractor.patches", 1);
 	Mat tmp = ehogFilter->applyTo(patchData);
 	Mat data = Mat(tmp, Rect(1, 1, tmp.cols - 2, tmp.rows - 2)).clone();
 	int originalWidth = layer->getOriginal(bounds.width - 2 * cellSize);
@@ -8,6 +8,9 @@
 #include "imageprocessing/HistEq64Filter.hpp"
 
 using cv::Mat;
+using cv::Size;
+using cv::Rect;
+using std::vector;
 
 namespace imageprocessing {
 
@@ -42,48 +45,27 @@ Mat HistEq64Filter::applyTo(const Mat& image, Mat& filtered) const {
 	//fp->data = new unsigned char[filter_size_x*filter_size_y];
 	// DO THIS ONCE PER PATCH: //
 
-	float pdf_bins[64]; // can contain up to value '400', so uchar is not enough (255).
-							// need float anyway because we multiply by stretch_fac later.
-	// pdf_bins initialized with zeros.
+	int histogram[64]; // can contain up to value '400', so uchar is not enough (255).
+	// histogram initialized with zeros.
 	for(int i=0; i<64; i++) {
-		pdf_bins[i]=0.0f;
+		histogram[i]=0;
 	}
 	
 	// fill our histogram with the values from the IMAGE PYRAMID
-										// patch-height/2                         patch-width/2
-	//int start_orig = (patch_cy_py-(10))*this_pyramid->w + (patch_cx_py-(10)); // w=rowsize // 10 would be logical (or 9), but I only get the same results as matthias when I use 11 ???? (some image-errors then, but quite logical, considering 10-11=-1)
-	//int start_orig = (fp->c.y_py-(filter_size_y/2))*pyr->w + (fp->c.x_py-(filter_size_x/2));
-	//int start_orig = 0;
-	//int startcoord = start_orig;
-	//int index=0;    // patch-height, det_filtersize_y
 	for (int z=0; z<rows; z++) {		// could be made with modulo and 1 for loop 0-399 but this is supposed to be faster
 					 // patch-width, det_filtersize_x
 		const uchar* originalValues = image.ptr<uchar>(z);
 		for(int i=0; i<cols; i++) {
-			pdf_bins[LUTbin[originalValues[i]]]=pdf_bins[LUTbin[originalValues[i]]]+1;	// TODO I should not use image.data here! Use .at<>(i,j) !
-			//startcoord++;
+			++histogram[LUTbin[originalValues[i]]];
 		}									// patch-width
-		//startcoord=startcoord+(pyr->w-filter_size_x);
-	}
-
-	// stretch the probability density function (PDF)
-	for(int i=0; i<64; i++) {
-		if(pdf_bins[i]!=0) {
-			pdf_bins[i]=pdf_bins[i]*stretchFactor;
-		}
-	}
-	// TODO: maybe round pdf_bins to 4 decimals here to prevent multiplying of the inaccuracy
-	// cdf_BINS=cumsum(pdf_bins):
-	float cdf_BINS[64];
-	cdf_BINS[0]=pdf_bins[0];
-	for(unsigned int i=1; i<64; i++) {
-		cdf_BINS[i]=cdf_BINS[i-1]+pdf_bins[i];
 	}
 
+	uchar LUTbins[64];
+	computeLut(histogram, stretchFactor, LUTbins);
 	// fill the equalized look-up table
-	float LUTeq[256];
+	uchar LUTeq[256];
 	for(int i=0; i<256; i++) {
-		LUTeq[i]=cdf_BINS[LUTbin[i]];
+		LUTeq[i]=LUTbins[LUTbin[i]];
 	}
 	//printf("HistEq64 - Fill the patch with data.\n");
 	// equalize the patch with the help of the LUT:
@@ -94,7 +76,7 @@ Mat HistEq64Filter::applyTo(const Mat& image, Mat& filtered) const {
 		uchar* filteredValues = filtered.ptr<uchar>(z);
 		for(int i=0; i<cols; i++) {
 			//patch_to_equalize[index] = this_pyramid->data[startcoord]; // original
-			filteredValues[i] = (uchar)floor(LUTeq[originalValues[i]]+0.5);
+			filteredValues[i] = LUTeq[originalValues[i]];
 			/*if(LUTeq[this_pyramid->data[start_orig]] > 255) {
 				printf("hq error 1...\n");
 			}*/
@@ -128,4 +110,74 @@ void HistEq64Filter::applyInPlace(Mat& image) const {
 	applyTo(image, image);
 }
 
+void HistEq64Filter::computeLut(const int* histogram, float stretchFactor, uchar* lut) {
+	// stretch the probability density function (PDF) and accumulate it to the cumulative distribution (CDF)
+	// TODO: maybe round pdf_bins to 4 decimals here to prevent multiplying of the inaccuracy
+	float cdf = 0.0f;
+	for(int i=0; i<64; i++) {
+		float pdf = histogram[i] != 0 ? histogram[i]*stretchFactor : 0.0f;
+		cdf = i == 0 ? pdf : cdf + pdf;
+		lut[i] = (uchar)floor(cdf+0.5);
+	}
+	// The result is equal to the result from the matlab algorithm.
+	// (double checked. A few values are off by 1 but this is supposed to be a small rounding/precision issue that does not really make a difference)
+}
+
+Mat HistEq64Filter::computeWindowLuts(const Mat& image, Size windowSize, Rect area, int stepX, int stepY) const {
+	const int windowsPerRow = area.width >= windowSize.width ? (area.width - windowSize.width) / stepX + 1 : 0;
+	const int windowRows = area.height >= windowSize.height ? (area.height - windowSize.height) / stepY + 1 : 0;
+	Mat luts(windowsPerRow * windowRows, 64, CV_8U);
+	const float stretchFactor = 255.0f/(float)(windowSize.width*windowSize.height);
+	int histogram[64];
+	for (int row = 0; row < windowRows; ++row) {
+		const int top = area.y + row * stepY;
+		const int bottom = top + windowSize.height;
+		int left = area.x; // left border of the window whose pixels are currently in the histogram
+		for (int col = 0; col < windowsPerRow; ++col) {
+			const int newLeft = area.x + col * stepX;
+			if (col == 0 || newLeft - left >= windowSize.width) { // no overlap with the previous window, build the histogram from scratch
+				for (int i = 0; i < 64; ++i)
+					histogram[i] = 0;
+				for (int y = top; y < bottom; ++y) {
+					const uchar* values = image.ptr<uchar>(y);
+					for (int x = newLeft; x < newLeft + windowSize.width; ++x)
+						++histogram[LUTbin[values[x]]];
+				}
+			} else { // slide: remove the columns that leave the window, add the ones that enter it
+				for (int y = top; y < bottom; ++y) {
+					const uchar* values = image.ptr<uchar>(y);
+					for (int x = left; x < newLeft; ++x)
+						--histogram[LUTbin[values[x]]];
+					for (int x = left + windowSize.width; x < newLeft + windowSize.width; ++x)
+						++histogram[LUTbin[values[x]]];
+				}
+			}
+			left = newLeft;
+			computeLut(histogram, stretchFactor, luts.ptr<uchar>(row * windowsPerRow + col));
+		}
+	}
+	return luts;
+}
+
+vector<Mat> HistEq64Filter::applyToWindows(const Mat& image, Size windowSize, Rect area, int stepX, int stepY) const {
+	const int windowsPerRow = area.width >= windowSize.width ? (area.width - windowSize.width) / stepX + 1 : 0;
+	Mat luts = computeWindowLuts(image, windowSize, area, stepX, stepY);
+	vector<Mat> windows;
+	windows.reserve(luts.rows);
+	for (int k = 0; k < luts.rows; ++k) {
+		const uchar* lut = luts.ptr<uchar>(k);
+		const int left = area.x + (k % windowsPerRow) * stepX;
+		const int top = area.y + (k / windowsPerRow) * stepY;
+		Mat window(windowSize, CV_8U);
+		for (int y = 0; y < windowSize.height; ++y) {
+			const uchar* originalValues = image.ptr<uchar>(top + y) + left;
+			uchar* filteredValues = window.ptr<uchar>(y);
+			for (int x = 0; x < windowSize.width; ++x)
+				filteredValues[x] = lut[LUTbin[originalValues[x]]];
+		}
+		windows.push_back(window);
+	}
+	return windows;
+}
+
 } /* namespace imageprocessing */
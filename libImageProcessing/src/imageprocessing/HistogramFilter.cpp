@@ -12,6 +12,8 @@ using cv::Mat;
 using cv::Vec2b;
 using cv::Vec4b;
 using std::vector;
+using std::shared_ptr;
+using std::make_shared;
 using std::runtime_error;
 
 namespace imageprocessing {
@@ -29,22 +31,24 @@ void HistogramFilter::createCellHistograms(const Mat& image, Mat& histograms, in
 	histograms = Mat::zeros(rowCount, columnCount, CV_32FC(binCount));
 	float factor = 1.f / 255.f;
 	if (interpolate) { // bilinear interpolation between cells
-		createCache(rowCache, image.rows, rowCount);
-		createCache(colCache, image.cols, columnCount);
+		shared_ptr<const Cache> currentRowCache = getCache(rowCache, image.rows, rowCount);
+		shared_ptr<const Cache> currentColCache = getCache(colCache, image.cols, columnCount);
+		const vector<CacheEntry>& rowEntries = currentRowCache->entries;
+		const vector<CacheEntry>& colEntries = currentColCache->entries;
 		if (image.channels() == 1) { // bin information only, no weights
 			for (int imageRow = 0; imageRow < image.rows; ++imageRow) {
 				const uchar* rowValues = image.ptr<uchar>(imageRow);
-				int rowIndex0 = rowCache[imageRow].index1;
-				int rowIndex1 = rowCache[imageRow].index2;
-				float rowWeight1 = rowCache[imageRow].weight2;
-				float rowWeight0 = rowCache[imageRow].weight1;
+				int rowIndex0 = rowEntries[imageRow].index1;
+				int rowIndex1 = rowEntries[imageRow].index2;
+				float rowWeight1 = rowEntries[imageRow].weight2;
+				float rowWeight0 = rowEntries[imageRow].weight1;
 				for (int imageCol = 0; imageCol < image.cols; ++imageCol) {
 					uchar bin = rowValues[imageCol];
 
-					int colIndex0 = colCache[imageCol].index1;
-					int colIndex1 = colCache[imageCol].index2;
-					float colWeight1 = colCache[imageCol].weight2;
-					float colWeight0 = colCache[imageCol].weight1;
+					int colIndex0 = colEntries[imageCol].index1;
+					int colIndex1 = colEntries[imageCol].index2;
+					float colWeight1 = colEntries[imageCol].weight2;
+					float colWeight0 = colEntries[imageCol].weight1;
 					if (rowIndex0 >= 0 && colIndex0 >= 0) {
 						float* histogramValues = histograms.ptr<float>(rowIndex0, colIndex0);
 						histogramValues[bin] += rowWeight0 * colWeight0;
@@ -66,18 +70,18 @@ void HistogramFilter::createCellHistograms(const Mat& image, Mat& histograms, in
 		} else if (image.channels() == 2) { // bin index and weight available
 			for (int imageRow = 0; imageRow < image.rows; ++imageRow) {
 				const Vec2b* rowValues = image.ptr<Vec2b>(imageRow);
-				int rowIndex0 = rowCache[imageRow].index1;
-				int rowIndex1 = rowCache[imageRow].index2;
-				float rowWeight1 = rowCache[imageRow].weight2;
-				float rowWeight0 = rowCache[imageRow].weight1;
+				int rowIndex0 = rowEntries[imageRow].index1;
+				int rowIndex1 = rowEntries[imageRow].index2;
+				float rowWeight1 = rowEntries[imageRow].weight2;
+				float rowWeight0 = rowEntries[imageRow].weight1;
 				for (int imageCol = 0; imageCol < image.cols; ++imageCol) {
 					uchar bin = rowValues[imageCol][0];
 					float weight = factor * rowValues[imageCol][1];
 
-					int colIndex0 = colCache[imageCol].index1;
-					int colIndex1 = colCache[imageCol].index2;
-					float colWeight1 = colCache[imageCol].weight2;
-					float colWeight0 = colCache[imageCol].weight1;
+					int colIndex0 = colEntries[imageCol].index1;
+					int colIndex1 = colEntries[imageCol].index2;
+					float colWeight1 = colEntries[imageCol].weight2;
+					float colWeight0 = colEntries[imageCol].weight1;
 					if (rowIndex0 >= 0 && colIndex0 >= 0) {
 						float* histogramValues = histograms.ptr<float>(rowIndex0, colIndex0);
 						histogramValues[bin] += weight * rowWeight0 * colWeight0;
@@ -99,20 +103,20 @@ void HistogramFilter::createCellHistograms(const Mat& image, Mat& histograms, in
 		} else if (image.channels() == 4) { // two bin indices and weights available
 			for (int imageRow = 0; imageRow < image.rows; ++imageRow) {
 				const Vec4b* rowValues = image.ptr<Vec4b>(imageRow);
-				int rowIndex0 = rowCache[imageRow].index1;
-				int rowIndex1 = rowCache[imageRow].index2;
-				float rowWeight1 = rowCache[imageRow].weight2;
-				float rowWeight0 = rowCache[imageRow].weight1;
+				int rowIndex0 = rowEntries[imageRow].index1;
+				int rowIndex1 = rowEntries[imageRow].index2;
+				float rowWeight1 = rowEntries[imageRow].weight2;
+				float rowWeight0 = rowEntries[imageRow].weight1;
 				for (int imageCol = 0; imageCol < image.cols; ++imageCol) {
 					uchar bin1 = rowValues[imageCol][0];
 					float weight1 = factor * rowValues[imageCol][1];
 					uchar bin2 = rowValues[imageCol][2];
 					float weight2 = factor * rowValues[imageCol][3];
 
-					int colIndex0 = colCache[imageCol].index1;
-					int colIndex1 = colCache[imageCol].index2;
-					float colWeight1 = colCache[imageCol].weight2;
-					float colWeight0 = colCache[imageCol].weight1;
+					int colIndex0 = colEntries[imageCol].index1;
+					int colIndex1 = colEntries[imageCol].index2;
+					float colWeight1 = colEntries[imageCol].weight2;
+					float colWeight0 = colEntries[imageCol].weight1;
 					if (rowIndex0 >= 0 && colIndex0 >= 0) {
 						float* histogramValues = histograms.ptr<float>(rowIndex0, colIndex0);
 						histogramValues[bin1] += weight1 * rowWeight0 * colWeight0;
@@ -196,27 +200,32 @@ void HistogramFilter::createCellHistograms(const Mat& image, Mat& histograms, in
 	}
 }
 
-void HistogramFilter::createCache(vector<CacheEntry>& cache, unsigned int size, int count) const {
-	if (cache.size() != size) {
-		cache.clear();
-		cache.reserve(size);
-		CacheEntry entry;
-		for (unsigned int matIndex = 0; matIndex < size; ++matIndex) {
-			double realIndex = static_cast<double>(count) * (static_cast<double>(matIndex) + 0.5) / static_cast<double>(size) - 0.5;
-			entry.index1 = static_cast<int>(floor(realIndex));
-			entry.index2 = entry.index1 + 1;
-			entry.weight2 = realIndex - entry.index1;
-			entry.weight1 = 1.f - entry.weight2;
-			if (entry.index1 < 0) {
-				entry.index1 = entry.index2;
-				entry.weight1 = 0;
-			} else if (entry.index2 >= static_cast<int>(count)) {
-				entry.index2 = entry.index1;
-				entry.weight2 = 0;
-			}
-			cache.push_back(entry);
+shared_ptr<const HistogramFilter::Cache> HistogramFilter::getCache(shared_ptr<const Cache>& cache, unsigned int size, int count) const {
+	shared_ptr<const Cache> current = std::atomic_load(&cache);
+	if (current && current->entries.size() == size && current->count == count)
+		return current;
+	shared_ptr<Cache> created = make_shared<Cache>();
+	created->count = count;
+	created->entries.reserve(size);
+	CacheEntry entry;
+	for (unsigned int matIndex = 0; matIndex < size; ++matIndex) {
+		double realIndex = static_cast<double>(count) * (static_cast<double>(matIndex) + 0.5) / static_cast<double>(size) - 0.5;
+		entry.index1 = static_cast<int>(floor(realIndex));
+		entry.index2 = entry.index1 + 1;
+		entry.weight2 = realIndex - entry.index1;
+		entry.weight1 = 1.f - entry.weight2;
+		if (entry.index1 < 0) {
+			entry.index1 = entry.index2;
+			entry.weight1 = 0;
+		} else if (entry.index2 >= static_cast<int>(count)) {
+			entry.index2 = entry.index1;
+			entry.weight2 = 0;
 		}
+		created->entries.push_back(entry);
 	}
+	current = created;
+	std::atomic_store(&cache, current);
+	return current;
 }
 
 void HistogramFilter::normalize(Mat& histogram) const {
@@ -10,6 +10,7 @@
 #include "imageprocessing/VersionedImage.hpp"
 #include "imageprocessing/ChainedFilter.hpp"
 #include "logging/LoggerFactory.hpp"
+#include "logging/Instrumentation.hpp"
 #include "logging/Logger.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 #include <iostream>
@@ -100,6 +101,7 @@ void ImagePyramid::setSource(const shared_ptr<ImagePyramid>& pyramid) {
 void ImagePyramid::update() {
 	if (sourceImage) {
 		if (version != sourceImage->getVersion()) {
+			INSTRUMENT_SCOPE("ImagePyramid::update");
 			layers.clear();
 			Mat filteredImage = imageFilter->applyTo(sourceImage->getData());
 			// TODO wenn maxscale <= 0.5 -> erstmal pyrdown auf bild (etc pp)
@@ -126,9 +128,11 @@ void ImagePyramid::update() {
 			if (!layers.empty())
 				firstLayer = layers.front()->getIndex();
 			version = sourceImage->getVersion();
+			INSTRUMENT_COUNT("ImagePyramid.layers", layers.size());
 		}
 	} else if (sourcePyramid) {
 		if (version != sourcePyramid->getVersion()) {
+			INSTRUMENT_SCOPE("ImagePyramid::update");
 			incrementalScaleFactor = sourcePyramid->incrementalScaleFactor;
 			layers.clear();
 			for (const shared_ptr<ImagePyramidLayer>& layer : sourcePyramid->layers) {
@@ -10,33 +10,58 @@
 
 using cv::Mat;
 using cv::Vec2f;
+using cv::Rect;
+using cv::Size;
+using std::vector;
+using std::pair;
+using std::make_pair;
+using std::shared_ptr;
+using std::make_shared;
 using std::invalid_argument;
 
 namespace imageprocessing {
 
-WhiteningFilter::WhiteningFilter(float alpha, float cutoffFrequency) :
-		alpha(alpha), cutoffFrequency(cutoffFrequency), filter(Mat()), floatImage(Mat()), fourierImage(Mat()) {}
+WhiteningFilter::WhiteningFilter(float alpha, float cutoffFrequency, bool padToOptimalSize) :
+		alpha(alpha), cutoffFrequency(cutoffFrequency), padToOptimalSize(padToOptimalSize), filters() {}
 
 Mat WhiteningFilter::applyTo(const Mat& image, Mat& filtered) const {
+	Workspace workspace;
+	return applyTo(image, filtered, workspace);
+}
+
+Mat WhiteningFilter::applyTo(const Mat& image, Mat& filtered, Workspace& workspace) const {
 	if (image.channels() > 1)
 		throw invalid_argument("WhiteningFilter: the image must have exactly one channel");
 
+	int type = image.type();
+	Size size = image.size();
+	Size transformSize = getTransformSize(size);
+	Mat& floatImage = workspace.floatImage;
+	Mat& fourierImage = workspace.fourierImage;
+
 	// Fourier transformation
 	image.convertTo(floatImage, CV_32F);
-	dft(floatImage, fourierImage, cv::DFT_SCALE | cv::DFT_COMPLEX_OUTPUT);
+	if (transformSize != size) {
+		copyMakeBorder(floatImage, workspace.paddedImage, 0, transformSize.height - size.height,
+				0, transformSize.width - size.width, cv::BORDER_REFLECT_101);
+		dft(workspace.paddedImage, fourierImage, cv::DFT_SCALE | cv::DFT_COMPLEX_OUTPUT);
+	} else {
+		dft(floatImage, fourierImage, cv::DFT_SCALE | cv::DFT_COMPLEX_OUTPUT);
+	}
 
 	// whitening filter
+	shared_ptr<const Spectrum> spectrum = getFilter(fourierImage.cols, fourierImage.rows);
+	const Mat& filter = spectrum->filter;
 	int cols = fourierImage.cols;
 	int rows = fourierImage.rows;
-	const Mat& filter = getFilter(cols, rows);
 	if (fourierImage.isContinuous() && filter.isContinuous()) {
 		cols *= rows;
 		rows = 1;
 	}
-	for (int row = 0; row < fourierImage.rows; ++row) {
+	for (int row = 0; row < rows; ++row) {
 		Vec2f *fourierRow = fourierImage.ptr<Vec2f>(row);
 		const float *filterRow = filter.ptr<float>(row);
-		for (int col = 0; col < fourierImage.cols; ++col) {
+		for (int col = 0; col < cols; ++col) {
 			fourierRow[col][0] *= filterRow[col];
 			fourierRow[col][1] *= filterRow[col];
 		}
@@ -44,40 +69,141 @@ Mat WhiteningFilter::applyTo(const Mat& image, Mat& filtered) const {
 
 	// inverse Fourier transformation
 	dft(fourierImage, floatImage, cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT);
-	switch (image.type()) {
-	case CV_8U:
-		floatImage.convertTo(filtered, CV_8U, 1, 127); break;
-	case CV_16U:
-		floatImage.convertTo(filtered, CV_16U, 1, (1 << 15) - 1); break;
-	default: // supported: CV_8S, CV_16S, CV_32S, CV_32F, CV_64F
-		floatImage.convertTo(filtered, image.type()); break;
-	}
+	convertBack(transformSize != size ? floatImage(Rect(0, 0, size.width, size.height)) : floatImage, filtered, type);
 	return filtered;
 }
 
+void WhiteningFilter::applyTo(const vector<Mat>& images, vector<Mat>& filtered) const {
+	Workspace workspace;
+	applyTo(images, filtered, workspace);
+}
+
+void WhiteningFilter::applyTo(const vector<Mat>& images, vector<Mat>& filtered, Workspace& workspace) const {
+	if (images.empty()) {
+		filtered.clear();
+		return;
+	}
+	int type = images.front().type();
+	Size size = images.front().size();
+	for (const Mat& image : images) {
+		if (image.channels() > 1)
+			throw invalid_argument("WhiteningFilter: the images must have exactly one channel");
+		if (image.type() != type || image.size() != size)
+			throw invalid_argument("WhiteningFilter: the images must have the same size and type");
+	}
+	Size transformSize = getTransformSize(size);
+	int count = static_cast<int>(images.size());
+	int width = transformSize.width;
+	int height = transformSize.height;
+
+	// stack the (padded) images vertically
+	Mat& stack = workspace.floatImage;
+	stack.create(count * height, width, CV_32F);
+	for (int i = 0; i < count; ++i) {
+		Mat block = stack.rowRange(i * height, (i + 1) * height);
+		if (transformSize != size) {
+			images[i].convertTo(workspace.paddedImage, CV_32F);
+			copyMakeBorder(workspace.paddedImage, block, 0, height - size.height, 0, width - size.width, cv::BORDER_REFLECT_101);
+		} else {
+			images[i].convertTo(block, CV_32F);
+		}
+	}
+
+	// the two-dimensional transformation is separated into the transformation of the rows and of the columns,
+	// each done for all images at once: after transposing the stack, each column of an image is one contiguous
+	// run of values, so the transposed data can be viewed as one row per image column
+	dft(stack, workspace.fourierImage, cv::DFT_ROWS | cv::DFT_COMPLEX_OUTPUT);
+	transpose(workspace.fourierImage, workspace.transposedImage);
+	Mat columns = workspace.transposedImage.reshape(2, width * count);
+	dft(columns, columns, cv::DFT_ROWS);
+
+	// whitening filter (row r of the column view belongs to column frequency r / count)
+	shared_ptr<const Spectrum> spectrum = getFilter(width, height);
+	const Mat& transposedFilter = spectrum->transposedFilter;
+	for (int row = 0; row < columns.rows; ++row) {
+		Vec2f *fourierRow = columns.ptr<Vec2f>(row);
+		const float *filterRow = transposedFilter.ptr<float>(row / count);
+		for (int col = 0; col < height; ++col) {
+			fourierRow[col][0] *= filterRow[col];
+			fourierRow[col][1] *= filterRow[col];
+		}
+	}
+
+	// inverse transformation of the columns and rows
+	dft(columns, columns, cv::DFT_ROWS | cv::DFT_INVERSE);
+	transpose(workspace.transposedImage, workspace.fourierImage);
+	dft(workspace.fourierImage, stack, cv::DFT_ROWS | cv::DFT_INVERSE | cv::DFT_REAL_OUTPUT);
+
+	filtered.resize(images.size());
+	for (int i = 0; i < count; ++i)
+		convertBack(stack(Rect(0, i * height, size.width, size.height)), filtered[i], type);
+}
+
 void WhiteningFilter::applyInPlace(Mat& image) const {
 	applyTo(image, image);
 }
 
-const Mat& WhiteningFilter::getFilter(int width, int height) const {
-	if (filter.cols != width || filter.rows != height) {
-		filter.create(height, width, CV_32F);
-		float nyquistFrequency = 0.5;
-		for (int row = 0; row < filter.rows; ++row) {
-			float *filterRow = filter.ptr<float>(row);
-			for (int col = 0; col < filter.cols; ++col) {
-				int shiftedRow = (row + filter.rows / 2) % filter.rows;
-				int shiftedCol = (col + filter.cols / 2) % filter.cols;
-				float fx = -nyquistFrequency + shiftedCol * (2 * nyquistFrequency) / (filter.cols - 1);
-				float fy = -nyquistFrequency + shiftedRow * (2 * nyquistFrequency) / (filter.rows - 1);
-				float rho = sqrt(fx * fx + fy * fy);
-				filterRow[col] = pow(rho, alpha);
-				if (cutoffFrequency > 0)
-					filterRow[col] *= exp(-pow(rho / cutoffFrequency, 4));
-			}
+Size WhiteningFilter::getTransformSize(Size size) const {
+	if (!padToOptimalSize)
+		return size;
+	return Size(cv::getOptimalDFTSize(size.width), cv::getOptimalDFTSize(size.height));
+}
+
+shared_ptr<const WhiteningFilter::Spectrum> WhiteningFilter::getFilter(int width, int height) const {
+	pair<int, int> key = make_pair(width, height);
+	shared_ptr<const SpectrumCache> cache = std::atomic_load(&filters);
+	if (cache) {
+		auto it = cache->find(key);
+		if (it != cache->end())
+			return it->second;
+	}
+	shared_ptr<const Spectrum> spectrum = createFilter(width, height);
+	while (true) {
+		shared_ptr<SpectrumCache> updatedCache = cache ? make_shared<SpectrumCache>(*cache) : make_shared<SpectrumCache>();
+		(*updatedCache)[key] = spectrum;
+		shared_ptr<const SpectrumCache> newCache = updatedCache;
+		if (std::atomic_compare_exchange_weak(&filters, &cache, newCache))
+			return spectrum;
+		// another thread changed the cache in the meantime, which might already contain the filter
+		auto it = cache->find(key);
+		if (it != cache->end())
+			return it->second;
+	}
+}
+
+shared_ptr<const WhiteningFilter::Spectrum> WhiteningFilter::createFilter(int width, int height) const {
+	shared_ptr<Spectrum> spectrum = make_shared<Spectrum>();
+	Mat& filter = spectrum->filter;
+	filter.create(height, width, CV_32F);
+	float nyquistFrequency = 0.5;
+	for (int row = 0; row < filter.rows; ++row) {
+		float *filterRow = filter.ptr<float>(row);
+		for (int col = 0; col < filter.cols; ++col) {
+			int shiftedRow = (row + filter.rows / 2) % filter.rows;
+			int shiftedCol = (col + filter.cols / 2) % filter.cols;
+			float fx = -nyquistFrequency + shiftedCol * (2 * nyquistFrequency) / (filter.cols - 1);
+			float fy = -nyquistFrequency + shiftedRow * (2 * nyquistFrequency) / (filter.rows - 1);
+			float rho = sqrt(fx * fx + fy * fy);
+			filterRow[col] = pow(rho, alpha);
+			if (cutoffFrequency > 0)
+				filterRow[col] *= exp(-pow(rho / cutoffFrequency, 4));
 		}
 	}
-	return filter;
+	Mat transposedFilter;
+	transpose(filter, transposedFilter);
+	spectrum->transposedFilter = transposedFilter * (1.0 / (width * height));
+	return spectrum;
+}
+
+void WhiteningFilter::convertBack(const Mat& floatImage, Mat& filtered, int type) {
+	switch (type) {
+	case CV_8U:
+		floatImage.convertTo(filtered, CV_8U, 1, 127); break;
+	case CV_16U:
+		floatImage.convertTo(filtered, CV_16U, 1, (1 << 15) - 1); break;
+	default: // supported: CV_8S, CV_16S, CV_32S, CV_32F, CV_64F
+		floatImage.convertTo(filtered, type); break;
+	}
 }
 
 } /* namespace imageprocessing */
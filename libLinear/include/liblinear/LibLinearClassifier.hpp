@@ -12,6 +12,7 @@
 #include "liblinear/LibLinearUtils.hpp"
 #include "linear.h"
 #include <string>
+#include <vector>
 
 namespace classification {
 class ExampleManagement;
@@ -21,6 +22,10 @@ namespace liblinear {
 
 /**
  * Trainable SVM classifier that uses libLinear for training.
+ *
+ * The libLinear nodes of the training examples are kept in arenas that are re-used between trainings, so
+ * re-training does not allocate memory once the arenas are big enough. The trained weight vector is scored
+ * directly against dense feature vectors (see classification::SvmClassifier).
  */
 class LibLinearClassifier : public classification::TrainableSvmClassifier {
 public:
@@ -34,7 +39,8 @@ public:
 	explicit LibLinearClassifier(double c = 1, bool bias = false);
 
 	/**
-	 * Loads static negative training examples from a file.
+	 * Loads static negative training examples from a file. The file is either a text file with one example per line
+	 * or a binary model file (see classification::writeStaticNegatives()).
 	 *
 	 * @param[in] negativesFilename The name of the file containing the static negative training examples.
 	 * @param[in] maxNegatives The amount of static negative training examples to use.
@@ -70,32 +76,38 @@ private:
 	bool train();
 
 	/**
-	 * Creates libLinear nodes from training examples.
+	 * Writes the stored training examples into the arena and updates the libLinear problem, which then contains
+	 * the positive, negative and static negative training examples (in that order).
+	 */
+	void updateProblem();
+
+	/**
+	 * Appends the libLinear nodes of training examples to the arena.
 	 *
 	 * @param[in] examples Training examples.
-	 * @return Vector of libLinear nodes.
+	 * @return The amount of appended training examples.
 	 */
-	std::vector<std::unique_ptr<struct feature_node[]>> createNodes(classification::ExampleManagement* examples);
+	size_t appendExamples(const classification::ExampleManagement& examples);
 
 	/**
-	 * Creates the libLinear problem containing the training data.
+	 * Appends the libLinear nodes of a static negative training example to its arena.
 	 *
-	 * @param[in] positiveExamples Positive training examples.
-	 * @param[in] negativeExamples Negative training examples.
-	 * @param[in] staticNegativeExamples Static negative training examples.
-	 * @param[in] dimensions The amount of dimensions of the feature vectors (without the bias).
-	 * @return The libLinear problem.
+	 * @param[in] values The values of the feature vector.
+	 * @param[in] count The amount of values.
+	 * @param[in] scale The factor for scaling the values.
 	 */
-	std::unique_ptr<struct problem, ProblemDeleter> createProblem(
-			const std::vector<std::unique_ptr<struct feature_node[]>>& positiveExamples,
-			const std::vector<std::unique_ptr<struct feature_node[]>>& negativeExamples,
-			const std::vector<std::unique_ptr<struct feature_node[]>>& staticNegativeExamples,
-			size_t dimensions);
+	void appendStaticNegative(const double* values, size_t count, double scale);
 
 	LibLinearUtils utils; ///< Utils for using libLinear.
 	bool bias; ///< Flag that indicates whether there should be a bias.
 	std::unique_ptr<struct parameter, ParameterDeleter> param; ///< The libLinear parameters.
-	std::vector<std::unique_ptr<struct feature_node[]>> staticNegativeExamples; ///< The static negative training examples.
+	std::vector<struct feature_node> exampleNodes; ///< Arena of the nodes of the positive and negative training examples.
+	std::vector<size_t> exampleOffsets; ///< Offsets of the positive and negative training examples within their arena.
+	std::vector<struct feature_node> staticNegativeNodes; ///< Arena of the nodes of the static negative training examples.
+	std::vector<size_t> staticNegativeOffsets; ///< Offsets of the static negative training examples within their arena.
+	std::vector<double> labels; ///< Labels of the training examples of the libLinear problem.
+	std::vector<struct feature_node*> rows; ///< Nodes of the training examples of the libLinear problem.
+	struct problem trainingProblem; ///< The libLinear problem, refers to the labels, rows and arenas.
 	std::unique_ptr<classification::ExampleManagement> positiveExamples; ///< Storage of positive training examples.
 	std::unique_ptr<classification::ExampleManagement> negativeExamples; ///< Storage of negative training examples.
 };
@@ -64,6 +64,25 @@ public:
 	 */
 	std::unique_ptr<struct feature_node[]> createNode(const cv::Mat& vector, bool bias) const;
 
+	/**
+	 * Determines the amount of libLinear nodes that are necessary for a feature vector (including the bias and the
+	 * terminating node).
+	 *
+	 * @param[in] vector The feature vector.
+	 * @param[in] bias Flag that indicates whether there should be a bias.
+	 * @return The amount of nodes.
+	 */
+	size_t getNodeSize(const cv::Mat& vector, bool bias) const;
+
+	/**
+	 * Writes the feature vector data into existing libLinear nodes, e.g. into a buffer that is re-used.
+	 *
+	 * @param[out] node The libLinear nodes, must have room for getNodeSize(vector, bias) nodes.
+	 * @param[in] vector The feature vector.
+	 * @param[in] bias Flag that indicates whether there should be a bias.
+	 */
+	void writeNode(struct feature_node *node, const cv::Mat& vector, bool bias) const;
+
 	/**
 	 * Computes the SVM output given a libLinear node.
 	 *
@@ -11,13 +11,17 @@
 #include "classification/ExampleManagement.hpp"
 #include "classification/UnlimitedExampleManagement.hpp"
 #include "classification/EmptyExampleManagement.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
+#include <algorithm>
 
 using classification::LinearKernel;
 using classification::ExampleManagement;
 using classification::UnlimitedExampleManagement;
 using classification::EmptyExampleManagement;
+using classification::BinaryModelReader;
 using cv::Mat;
 using std::move;
 using std::string;
@@ -30,7 +34,8 @@ using std::invalid_argument;
 namespace liblinear {
 
 LibLinearClassifier::LibLinearClassifier(double c, bool bias) :
-		TrainableSvmClassifier(make_shared<LinearKernel>()), utils(), bias(bias), param(), staticNegativeExamples(),
+		TrainableSvmClassifier(make_shared<LinearKernel>()), utils(), bias(bias), param(), exampleNodes(), exampleOffsets(),
+		staticNegativeNodes(), staticNegativeOffsets(), labels(), rows(), trainingProblem(),
 		positiveExamples(new UnlimitedExampleManagement()), negativeExamples(new UnlimitedExampleManagement()) {
 	param.reset(new struct parameter);
 	param->solver_type = L2R_L2LOSS_SVC; // possible values: L2R_L2LOSS_SVC   L2R_L2LOSS_SVC_DUAL   L2R_L1LOSS_SVC_DUAL   MCSVM_CS   L1R_L2LOSS_SVC
@@ -46,7 +51,14 @@ LibLinearClassifier::LibLinearClassifier(double c, bool bias) :
 }
 
 void LibLinearClassifier::loadStaticNegatives(const string& negativesFilename, int maxNegatives, double scale) {
-	staticNegativeExamples.reserve(maxNegatives);
+	staticNegativeOffsets.reserve(staticNegativeOffsets.size() + maxNegatives);
+	if (BinaryModelReader::isBinaryModelFile(negativesFilename)) {
+		Mat negatives = classification::readStaticNegatives(negativesFilename, maxNegatives);
+		staticNegativeNodes.reserve(staticNegativeNodes.size() + negatives.rows * (negatives.cols + 2));
+		for (int row = 0; row < negatives.rows; ++row)
+			appendStaticNegative(negatives.ptr<double>(row), negatives.cols, scale);
+		return;
+	}
 	int negatives = 0;
 	vector<double> values;
 	double value;
@@ -65,43 +77,48 @@ void LibLinearClassifier::loadStaticNegatives(const string& negativesFilename, i
 				lineStream >> value >> separator;
 				values.push_back(value);
 			}
-			// create node
-			unique_ptr<struct feature_node[]> data(new struct feature_node[values.size() + 1]);
-			for (size_t i = 0; i < values.size(); ++i) {
-				data[i].index = i + 1;
-				data[i].value = scale * values[i];
-			}
-			if (bias) {
-				data[values.size()].index = values.size() + 1;
-				data[values.size()].value = 1;
-				data[values.size() + 1].index = -1;
-			} else {
-				data[values.size()].index = -1;
-			}
-			staticNegativeExamples.push_back(move(data));
+			appendStaticNegative(values.data(), values.size(), scale);
 		}
 	}
 }
 
+void LibLinearClassifier::appendStaticNegative(const double* values, size_t count, double scale) {
+	size_t offset = staticNegativeNodes.size();
+	staticNegativeNodes.resize(offset + count + (bias ? 2 : 1));
+	struct feature_node* node = &staticNegativeNodes[offset];
+	for (size_t i = 0; i < count; ++i) {
+		node[i].index = i + 1;
+		node[i].value = scale * values[i];
+	}
+	if (bias) {
+		node[count].index = count + 1;
+		node[count].value = 1;
+		node[count + 1].index = -1;
+	} else {
+		node[count].index = -1;
+	}
+	staticNegativeOffsets.push_back(offset);
+}
+
 bool LibLinearClassifier::retrain(const vector<Mat>& newPositiveExamples, const vector<Mat>& newNegativeExamples) {
 	if (newPositiveExamples.empty() && newNegativeExamples.empty()) // no new training data available -> no new training necessary
 		return usable;
 	positiveExamples->add(newPositiveExamples);
 	negativeExamples->add(newNegativeExamples);
-	if (positiveExamples->hasRequiredSize() && negativeExamples->hasRequiredSize())
+	if (positiveExamples->hasRequiredSize() && negativeExamples->hasRequiredSize()) {
 		usable = train();
+		positiveExamples->classifierChanged();
+		negativeExamples->classifierChanged();
+	}
 	return usable;
 }
 
 bool LibLinearClassifier::train() {
-	vector<unique_ptr<struct feature_node[]>> positiveExamples = move(createNodes(this->positiveExamples.get()));
-	vector<unique_ptr<struct feature_node[]>> negativeExamples = move(createNodes(this->negativeExamples.get()));
-	unique_ptr<struct problem, ProblemDeleter> problem = move(createProblem(
-			positiveExamples, negativeExamples, staticNegativeExamples, utils.getDimensions()));
-	const char* message = check_parameter(problem.get(), param.get());
+	updateProblem();
+	const char* message = check_parameter(&trainingProblem, param.get());
 	if (message != 0)
 		throw invalid_argument(string("LibLinearClassifier: invalid SVM parameters: ") + message);
-	unique_ptr<struct model, ModelDeleter> model(::train(problem.get(), param.get()));
+	unique_ptr<struct model, ModelDeleter> model(::train(&trainingProblem, param.get()));
 	svm->setSvmParameters(
 			utils.extractSupportVectors(model.get()),
 			utils.extractCoefficients(model.get()),
@@ -109,42 +126,39 @@ bool LibLinearClassifier::train() {
 	return true;
 }
 
-vector<unique_ptr<struct feature_node[]>> LibLinearClassifier::createNodes(ExampleManagement* examples) {
-	vector<unique_ptr<struct feature_node[]>> nodes;
-	nodes.reserve(examples->size());
-	for (auto iterator = examples->iterator(); iterator->hasNext();)
-		nodes.push_back(move(utils.createNode(iterator->next(), bias)));
-	return move(nodes);
+void LibLinearClassifier::updateProblem() {
+	// clear() keeps the capacity, so the arena only allocates if there are more (or bigger) examples than ever before
+	exampleNodes.clear();
+	exampleOffsets.clear();
+	size_t positiveCount = appendExamples(*positiveExamples);
+	appendExamples(*negativeExamples);
+	size_t count = exampleOffsets.size() + staticNegativeOffsets.size();
+	labels.assign(count, -1);
+	std::fill(labels.begin(), labels.begin() + positiveCount, 1);
+	// the pointers are determined after filling the arena, as it may have been re-allocated while growing
+	rows.clear();
+	for (size_t offset : exampleOffsets)
+		rows.push_back(&exampleNodes[offset]);
+	for (size_t offset : staticNegativeOffsets)
+		rows.push_back(&staticNegativeNodes[offset]);
+	size_t dimensions = utils.getDimensions();
+	trainingProblem.l = count;
+	trainingProblem.n = bias ? dimensions + 1 : dimensions;
+	trainingProblem.y = labels.data();
+	trainingProblem.x = rows.data();
+	trainingProblem.bias = bias ? 1 : -1;
 }
 
-unique_ptr<struct problem, ProblemDeleter> LibLinearClassifier::createProblem(
-		const vector<unique_ptr<struct feature_node[]>>& positiveExamples,
-		const vector<unique_ptr<struct feature_node[]>>& negativeExamples,
-		const vector<unique_ptr<struct feature_node[]>>& staticNegativeExamples,
-		size_t dimensions) {
-	unique_ptr<struct problem, ProblemDeleter> problem(new struct problem);
-	problem->l = positiveExamples.size() + negativeExamples.size() + staticNegativeExamples.size();
-	problem->n = bias ? dimensions + 1 : dimensions;
-	problem->y = new double[problem->l];
-	problem->x = new struct feature_node *[problem->l];
-	size_t i = 0;
-	for (auto& example : positiveExamples) {
-		problem->y[i] = 1;
-		problem->x[i] = example.get();
-		++i;
-	}
-	for (auto& example : negativeExamples) {
-		problem->y[i] = -1;
-		problem->x[i] = example.get();
-		++i;
-	}
-	for (auto& example : staticNegativeExamples) {
-		problem->y[i] = -1;
-		problem->x[i] = example.get();
-		++i;
+size_t LibLinearClassifier::appendExamples(const ExampleManagement& examples) {
+	size_t count = 0;
+	for (auto iterator = examples.iterator(); iterator->hasNext(); ++count) {
+		const Mat& example = iterator->next();
+		size_t offset = exampleNodes.size();
+		exampleNodes.resize(offset + utils.getNodeSize(example, bias));
+		utils.writeNode(&exampleNodes[offset], example, bias);
+		exampleOffsets.push_back(offset);
 	}
-	problem->bias = bias ? 1 : -1;
-	return move(problem);
+	return count;
 }
 
 void LibLinearClassifier::reset() {
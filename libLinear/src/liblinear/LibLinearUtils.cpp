@@ -26,16 +26,25 @@ size_t LibLinearUtils::getDimensions() const {
 }
 
 unique_ptr<struct feature_node[]> LibLinearUtils::createNode(const Mat& vector, bool bias) const {
+	unique_ptr<struct feature_node[]> node(new struct feature_node[getNodeSize(vector, bias)]);
+	writeNode(node.get(), vector, bias);
+	return move(node);
+}
+
+size_t LibLinearUtils::getNodeSize(const Mat& vector, bool bias) const {
+	return vector.total() * vector.channels() + (bias ? 2 : 1);
+}
+
+void LibLinearUtils::writeNode(struct feature_node *node, const Mat& vector, bool bias) const {
 	matRows = vector.rows;
 	matCols = vector.cols;
 	matType = vector.type();
 	matDepth = vector.depth();
 	dimensions = vector.total() * vector.channels();
-	unique_ptr<struct feature_node[]> node(new struct feature_node[dimensions + (bias ? 2 : 1)]);
 	if (matDepth == CV_32F)
-		fillNode<float>(node.get(), vector, dimensions);
+		fillNode<float>(node, vector, dimensions);
 	else if (matDepth == CV_64F)
-		fillNode<double>(node.get(), vector, dimensions);
+		fillNode<double>(node, vector, dimensions);
 	else
 		throw invalid_argument("LibLinearUtils: vector has to be of depth CV_32F or CV_64F to create a node of");
 	if (bias) {
@@ -45,7 +54,6 @@ unique_ptr<struct feature_node[]> LibLinearUtils::createNode(const Mat& vector,
 	} else {
 		node[dimensions].index = -1;
 	}
-	return move(node);
 }
 
 template<class T>
@@ -60,11 +68,14 @@ void LibLinearUtils::fillNode(struct feature_node *node, const Mat& vector, int
 }
 
 double LibLinearUtils::computeSvmOutput(struct model *model, const struct feature_node *x) const {
-	double* dec_values = new double[1];
-	predict_values(model, x, dec_values);
-	double svmOutput = dec_values[0];
-	delete[] dec_values;
-	return svmOutput;
+	if (model->nr_class == 2 && model->param.solver_type != MCSVM_CS) { // only one decision value
+		double decisionValue;
+		predict_values(model, x, &decisionValue);
+		return decisionValue;
+	}
+	vector<double> decisionValues(model->nr_class);
+	predict_values(model, x, decisionValues.data());
+	return decisionValues[0];
 }
 
 vector<Mat> LibLinearUtils::extractSupportVectors(struct model *model) const {
@@ -12,10 +12,14 @@
 #include "logging/Appender.hpp"
 #include "logging/LogLevels.hpp"
 
+#include <iostream>
+#include <mutex>
+
 namespace logging {
 
 /**
  * An appender that logs all messages equal or below its log-level to the text console.
+ * It may be used from several threads at once.
  */
 class ConsoleAppender : public Appender {
 public:
@@ -27,8 +31,9 @@ public:
 	 *			the compiler generates a ConsoleAppender() default constructor?
 	 *
 	 * param[in] loglevel The LogLevel at which to log.
+	 * param[in] stream The stream to log to, e.g. std::cerr if the standard output is used for results.
 	 */
-	ConsoleAppender(LogLevel logLevel);
+	ConsoleAppender(LogLevel logLevel, std::ostream& stream = std::cout);
 
 	/**
 	 * Logs a message to the text console.
@@ -48,6 +53,8 @@ private:
 	 */
 	std::string getCurrentTime();
 
+	std::ostream& stream; ///< The stream to log to.
+	static std::mutex streamMutex; ///< Serialises the writes of all console appenders, as they usually share std::cout or std::cerr.
 };
 
 } /* namespace logging */
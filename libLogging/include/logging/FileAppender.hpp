@@ -11,6 +11,7 @@
 
 #include "logging/Appender.hpp"
 #include <fstream>
+#include <mutex>
 
 namespace logging {
 
@@ -51,6 +52,7 @@ private:
 
 	// TODO: We should make the copy constructor (and assignment operator?) private because we have an ofstream as member variable! Read that somewhere on stackoverflow.
 	std::ofstream file;
+	std::mutex fileMutex; ///< Guards the writes to the file.
 };
 
 } /* namespace logging */
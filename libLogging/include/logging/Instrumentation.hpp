@@ -0,0 +1,199 @@
+/*
+ * Instrumentation.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+#pragma once
+
+#ifndef INSTRUMENTATION_HPP_
+#define INSTRUMENTATION_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace logging {
+
+/**
+ * Collects the time spent in named stages (e.g. pyramid building, detection) and named counters (e.g. evaluated
+ * windows) and aggregates them per frame. Use the INSTRUMENT_* macros instead of this class directly, they compile
+ * to nothing unless WITH_INSTRUMENTATION is defined (CMake option WITH_INSTRUMENTATION).
+ *
+ * Stages and counters are registered once per call site and then updated with a single atomic addition, so the
+ * instrumentation can stay enabled in production builds. The values of all threads are accumulated until
+ * endFrame() is called, which stores them as one frame and resets them.
+ */
+class Instrumentation
+{
+private:
+	/* Private constructor, destructor and copy constructor - we only want one instance. */
+	Instrumentation();
+	~Instrumentation();
+	Instrumentation(const Instrumentation &);
+	Instrumentation& operator=(const Instrumentation &);
+
+public:
+
+	/**
+	 * A counter that can be increased concurrently.
+	 */
+	class Counter {
+	public:
+
+		Counter() : value(0) {}
+
+		/**
+		 * Increases the counter.
+		 *
+		 * @param[in] amount The amount to add.
+		 */
+		void add(long long amount) {
+			value.fetch_add(amount, std::memory_order_relaxed);
+		}
+
+		/**
+		 * Resets the counter to zero.
+		 *
+		 * @return The value before the reset.
+		 */
+		long long reset() {
+			return value.exchange(0, std::memory_order_relaxed);
+		}
+
+	private:
+		std::atomic<long long> value; ///< The current value.
+	};
+
+	/**
+	 * The accumulated time and number of calls of a stage.
+	 */
+	class Stage {
+	public:
+
+		/**
+		 * Adds one call of the stage.
+		 *
+		 * @param[in] duration The duration of the call.
+		 */
+		void add(std::chrono::steady_clock::duration duration) {
+			nanoseconds.add(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+			calls.add(1);
+		}
+
+		Counter nanoseconds; ///< The accumulated time in nanoseconds.
+		Counter calls; ///< The number of calls.
+	};
+
+	static Instrumentation* Instance();
+
+	/**
+	 * Returns the stage with the given name, creating it if necessary. The reference stays valid.
+	 *
+	 * @param[in] name The name of the stage.
+	 * @return The stage.
+	 */
+	Stage& getStage(const std::string& name);
+
+	/**
+	 * Returns the counter with the given name, creating it if necessary. The reference stays valid.
+	 *
+	 * @param[in] name The name of the counter.
+	 * @return The counter.
+	 */
+	Counter& getCounter(const std::string& name);
+
+	/**
+	 * Stores the values that were accumulated since the last call as one frame and resets them.
+	 */
+	void endFrame();
+
+	/**
+	 * Removes all stored frames and resets the current values.
+	 */
+	void clear();
+
+	/**
+	 * Writes the stored frames and their totals as JSON. Times are in milliseconds.
+	 *
+	 * @param[in] out The output stream.
+	 */
+	void writeJson(std::ostream& out) const;
+
+	/**
+	 * Writes the stored frames and their totals as JSON to a file, see writeJson(std::ostream&).
+	 *
+	 * @param[in] filename The name of the file.
+	 */
+	void writeJson(const std::string& filename) const;
+
+private:
+
+	/**
+	 * The values of one frame.
+	 */
+	struct Frame {
+		std::map<std::string, std::pair<double, long long>> stages; ///< Time (in ms) and number of calls per stage.
+		std::map<std::string, long long> counters; ///< Value per counter.
+	};
+
+	mutable std::mutex registryMutex; ///< Guards the maps and frames (not the values of the stages and counters).
+	std::map<std::string, std::unique_ptr<Stage>> stages; ///< The stages by name.
+	std::map<std::string, std::unique_ptr<Counter>> counters; ///< The counters by name.
+	std::vector<Frame> frames; ///< The stored frames.
+};
+
+/**
+ * Adds the time between its construction and destruction to a stage.
+ */
+class ScopedStageTimer
+{
+public:
+
+	explicit ScopedStageTimer(Instrumentation::Stage& stage) : stage(stage), start(std::chrono::steady_clock::now()) {}
+
+	~ScopedStageTimer() {
+		stage.add(std::chrono::steady_clock::now() - start);
+	}
+
+private:
+	ScopedStageTimer(const ScopedStageTimer &);
+	ScopedStageTimer& operator=(const ScopedStageTimer &);
+
+	Instrumentation::Stage& stage; ///< The stage.
+	std::chrono::steady_clock::time_point start; ///< The time of the construction.
+};
+
+} /* namespace logging */
+
+/**
+ * INSTRUMENT_SCOPE(name) measures the time until the end of the enclosing scope and adds it to the stage name.
+ * INSTRUMENT_COUNT(name, amount) increases the counter name.
+ * INSTRUMENT_END_FRAME() stores the current values as one frame, see Instrumentation::endFrame().
+ * The name must be the same on every execution of a call site (usually a string literal), as it is only looked
+ * up once. Without WITH_INSTRUMENTATION, the macros and their arguments vanish.
+ */
+#ifdef WITH_INSTRUMENTATION
+	#define INSTRUMENTATION_CONCAT_IMPL(a, b) a##b
+	#define INSTRUMENTATION_CONCAT(a, b) INSTRUMENTATION_CONCAT_IMPL(a, b)
+	#define INSTRUMENT_SCOPE(name) \
+		static logging::Instrumentation::Stage& INSTRUMENTATION_CONCAT(instrumentationStage, __LINE__) = logging::Instrumentation::Instance()->getStage(name); \
+		logging::ScopedStageTimer INSTRUMENTATION_CONCAT(instrumentationTimer, __LINE__)(INSTRUMENTATION_CONCAT(instrumentationStage, __LINE__))
+	#define INSTRUMENT_COUNT(name, amount) \
+		do { \
+			static logging::Instrumentation::Counter& instrumentationCounter = logging::Instrumentation::Instance()->getCounter(name); \
+			instrumentationCounter.add(amount); \
+		} while (false)
+	#define INSTRUMENT_END_FRAME() logging::Instrumentation::Instance()->endFrame()
+#else
+	#define INSTRUMENT_SCOPE(name) ((void)0)
+	#define INSTRUMENT_COUNT(name, amount) ((void)0)
+	#define INSTRUMENT_END_FRAME() ((void)0)
+#endif
+
+#endif /* INSTRUMENTATION_HPP_ */
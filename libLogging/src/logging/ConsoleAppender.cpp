@@ -12,9 +12,11 @@
 #include <iomanip>
 #include <chrono>
 #include <cstdint>
+#include <ctime>
 
-using std::cout;
 using std::string;
+using std::mutex;
+using std::lock_guard;
 using std::ostringstream;
 using std::chrono::system_clock;
 using std::chrono::duration;
@@ -22,12 +24,19 @@ using std::chrono::duration_cast;
 
 namespace logging {
 
-ConsoleAppender::ConsoleAppender(LogLevel logLevel) : Appender(logLevel) {}
+mutex ConsoleAppender::streamMutex;
+
+ConsoleAppender::ConsoleAppender(LogLevel logLevel, std::ostream& stream) : Appender(logLevel), stream(stream) {}
 
 void ConsoleAppender::log(const LogLevel logLevel, const string loggerName, const string logMessage)
 {
-	if(logLevel <= this->logLevel)
-		cout << getCurrentTime() << ' ' << logLevelToString(logLevel) << ' ' << "[" << loggerName << "] " << logMessage << std::endl;
+	if (logLevel <= this->logLevel) {
+		ostringstream line;
+		line << getCurrentTime() << ' ' << logLevelToString(logLevel) << ' ' << "[" << loggerName << "] " << logMessage << '\n';
+		// Write the whole line at once, so that the lines of threads (and of other appenders) logging concurrently don't interleave:
+		lock_guard<mutex> lock(streamMutex);
+		stream << line.str() << std::flush;
+	}
 }
 
 string ConsoleAppender::getCurrentTime()
@@ -38,10 +47,15 @@ string ConsoleAppender::getCurrentTime()
 	duration<int64_t, std::milli> msec = milliseconds - seconds;
 
 	std::time_t t_now = system_clock::to_time_t(now);
-	struct tm* tm_now = std::localtime(&t_now);
+	struct tm tm_now;
+#ifdef WIN32
+	localtime_s(&tm_now, &t_now); // std::localtime() returns a pointer to a static buffer, which is not thread-safe
+#else
+	localtime_r(&t_now, &tm_now);
+#endif
 	ostringstream os;
 	os.fill('0');
-	os << std::setw(2) << tm_now->tm_hour << ':' << std::setw(2) << tm_now->tm_min << ':' << std::setw(2) << tm_now->tm_sec;
+	os << std::setw(2) << tm_now.tm_hour << ':' << std::setw(2) << tm_now.tm_min << ':' << std::setw(2) << tm_now.tm_sec;
 	os << '.' << std::setw(3) << msec.count();
 	return os.str();
 }
@@ -13,8 +13,11 @@
 #include <iomanip>
 #include <chrono>
 #include <cstdint>
+#include <ctime>
 
 using std::string;
+using std::mutex;
+using std::lock_guard;
 using std::ios_base;
 using std::ostringstream;
 using std::chrono::system_clock;
@@ -39,8 +42,12 @@ FileAppender::~FileAppender()
 
 void FileAppender::log(const LogLevel logLevel, const string loggerName, const string logMessage)
 {
-	if(logLevel <= this->logLevel)
-		file << getCurrentTime() << ' ' << logLevelToString(logLevel) << ' ' << "[" << loggerName << "] " << logMessage << std::endl;
+	if (logLevel <= this->logLevel) {
+		ostringstream line;
+		line << getCurrentTime() << ' ' << logLevelToString(logLevel) << ' ' << "[" << loggerName << "] " << logMessage << '\n';
+		lock_guard<mutex> lock(fileMutex);
+		file << line.str() << std::flush;
+	}
 }
 
 string FileAppender::getCurrentTime()
@@ -51,11 +58,16 @@ string FileAppender::getCurrentTime()
 	duration<int64_t, std::milli> msec = milliseconds - seconds;
 
 	std::time_t t_now = system_clock::to_time_t(now);
-	struct tm* tm_now = std::localtime(&t_now);
+	struct tm tm_now;
+#ifdef WIN32
+	localtime_s(&tm_now, &t_now);
+#else
+	localtime_r(&t_now, &tm_now);
+#endif
 	ostringstream os;
 	os.fill('0');
-	os << (1900 + tm_now->tm_year) << '-' << std::setw(2) << (1 + tm_now->tm_mon) << '-' << std::setw(2) << tm_now->tm_mday;
-	os << ' ' << std::setw(2) << tm_now->tm_hour << ':' << std::setw(2) << tm_now->tm_min << ':' << std::setw(2) << tm_now->tm_sec;
+	os << (1900 + tm_now.tm_year) << '-' << std::setw(2) << (1 + tm_now.tm_mon) << '-' << std::setw(2) << tm_now.tm_mday;
+	os << ' ' << std::setw(2) << tm_now.tm_hour << ':' << std::setw(2) << tm_now.tm_min << ':' << std::setw(2) << tm_now.tm_sec;
 	os << '.' << std::setw(3) << msec.count();
 	return os.str();
 }
@@ -0,0 +1,172 @@
+/*
+ * Instrumentation.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "logging/Instrumentation.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+using std::map;
+using std::pair;
+using std::string;
+using std::ostream;
+using std::unique_ptr;
+using std::lock_guard;
+using std::mutex;
+using std::make_pair;
+
+namespace logging {
+
+namespace {
+
+/**
+ * Writes a string as a JSON string literal.
+ */
+void writeJsonString(ostream& out, const string& value) {
+	out << '"';
+	for (char c : value) {
+		if (c == '"' || c == '\\')
+			out << '\\' << c;
+		else if (static_cast<unsigned char>(c) < 0x20)
+			out << ' ';
+		else
+			out << c;
+	}
+	out << '"';
+}
+
+/**
+ * Writes the stage times and counters of a frame (or of the totals) as the members of a JSON object.
+ */
+void writeJsonValues(ostream& out, const map<string, pair<double, long long>>& stages, const map<string, long long>& counters, const string& indent) {
+	out << indent << "\"stages\": {";
+	bool first = true;
+	for (const auto& stage : stages) {
+		out << (first ? "\n" : ",\n") << indent << "  ";
+		writeJsonString(out, stage.first);
+		out << ": {\"ms\": " << stage.second.first << ", \"calls\": " << stage.second.second << "}";
+		first = false;
+	}
+	out << (first ? "},\n" : "\n" + indent + "},\n");
+	out << indent << "\"counters\": {";
+	first = true;
+	for (const auto& counter : counters) {
+		out << (first ? "\n" : ",\n") << indent << "  ";
+		writeJsonString(out, counter.first);
+		out << ": " << counter.second;
+		first = false;
+	}
+	out << (first ? "}\n" : "\n" + indent + "}\n");
+}
+
+} /* unnamed namespace */
+
+Instrumentation::Instrumentation()
+{
+}
+
+Instrumentation::~Instrumentation()
+{
+}
+
+Instrumentation* Instrumentation::Instance()
+{
+	static Instrumentation instance;
+	return &instance;
+}
+
+Instrumentation::Stage& Instrumentation::getStage(const string& name)
+{
+	lock_guard<mutex> lock(registryMutex);
+	unique_ptr<Stage>& stage = stages[name];
+	if (!stage)
+		stage.reset(new Stage());
+	return *stage;
+}
+
+Instrumentation::Counter& Instrumentation::getCounter(const string& name)
+{
+	lock_guard<mutex> lock(registryMutex);
+	unique_ptr<Counter>& counter = counters[name];
+	if (!counter)
+		counter.reset(new Counter());
+	return *counter;
+}
+
+void Instrumentation::endFrame()
+{
+	lock_guard<mutex> lock(registryMutex);
+	Frame frame;
+	for (const auto& stage : stages) {
+		long long calls = stage.second->calls.reset();
+		double milliseconds = 1e-6 * stage.second->nanoseconds.reset();
+		if (calls > 0)
+			frame.stages[stage.first] = make_pair(milliseconds, calls);
+	}
+	for (const auto& counter : counters) {
+		long long value = counter.second->reset();
+		if (value != 0)
+			frame.counters[counter.first] = value;
+	}
+	frames.push_back(frame);
+}
+
+void Instrumentation::clear()
+{
+	lock_guard<mutex> lock(registryMutex);
+	for (const auto& stage : stages) {
+		stage.second->calls.reset();
+		stage.second->nanoseconds.reset();
+	}
+	for (const auto& counter : counters)
+		counter.second->reset();
+	frames.clear();
+}
+
+void Instrumentation::writeJson(ostream& stream) const
+{
+	lock_guard<mutex> lock(registryMutex);
+	map<string, pair<double, long long>> totalStages;
+	map<string, long long> totalCounters;
+	for (const Frame& frame : frames) {
+		for (const auto& stage : frame.stages) {
+			pair<double, long long>& total = totalStages[stage.first];
+			total.first += stage.second.first;
+			total.second += stage.second.second;
+		}
+		for (const auto& counter : frame.counters)
+			totalCounters[counter.first] += counter.second;
+	}
+	std::ostringstream out; // the number format is set on a local stream, so the one of the caller stays untouched
+	out << std::fixed << std::setprecision(3);
+	out << "{\n";
+	out << "  \"frameCount\": " << frames.size() << ",\n";
+	out << "  \"total\": {\n";
+	writeJsonValues(out, totalStages, totalCounters, "    ");
+	out << "  },\n";
+	out << "  \"frames\": [";
+	for (size_t i = 0; i < frames.size(); ++i) {
+		out << (i == 0 ? "\n" : ",\n") << "    {\n";
+		out << "      \"frame\": " << i << ",\n";
+		writeJsonValues(out, frames[i].stages, frames[i].counters, "      ");
+		out << "    }";
+	}
+	out << (frames.empty() ? "]\n" : "\n  ]\n");
+	out << "}\n";
+	stream << out.str();
+}
+
+void Instrumentation::writeJson(const string& filename) const
+{
+	std::ofstream file(filename.c_str());
+	if (!file.is_open())
+		throw std::runtime_error("Instrumentation: Could not open the file " + filename);
+	writeJson(file);
+}
+
+} /* namespace logging */
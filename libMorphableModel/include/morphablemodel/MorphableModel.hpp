@@ -13,6 +13,7 @@
 #include "morphablemodel/PcaModel.hpp"
 
 #include "render/Mesh.hpp"
+#include "render/MeshInstance.hpp"
 
 #ifdef WIN32
 	#define BOOST_ALL_DYN_LINK	// Link against the dynamic boost lib. Seems to be necessary because we use /MD, i.e. link to the dynamic CRT.
@@ -21,6 +22,8 @@
 #include "boost/property_tree/ptree.hpp"
 #include "boost/filesystem/path.hpp"
 
+#include <memory>
+
 namespace morphablemodel {
 
 /**
@@ -29,6 +32,11 @@ namespace morphablemodel {
  * 
  * For the general idea of 3DMMs see T. Vetter, V. Blanz,
  * 'A Morphable Model for the Synthesis of 3D Faces', SIGGRAPH 1999
+ *
+ * Like PcaModel, all const member functions only read from the model.
+ * To fit many images in parallel, load the model once and pass it by
+ * const reference to the fitting functions (e.g. fitting::LinearShapeFitter),
+ * which only borrow it. It has to outlive them.
  */
 class MorphableModel  {
 public:
@@ -62,10 +70,44 @@ public:
 
 	static MorphableModel loadStatismoModel(boost::filesystem::path h5file);
 
+	/**
+	 * Load a morphable model from a file in our own binary format (.bmm),
+	 * as written by writeBinaryModel(). The file is memory-mapped and the
+	 * PCA matrices point directly into the mapping, so loading is fast and
+	 * several processes using the same file share one physical copy of it.
+	 * See PcaModel::loadBinaryModel().
+	 *
+	 * @param[in] filename The binary model file.
+	 * @return A morphable model.
+	 * @throws std::runtime_error if the file can't be opened or has the wrong format or version.
+	 */
+	static MorphableModel loadBinaryModel(boost::filesystem::path filename);
+
+	/**
+	 * Writes the model to a file in the binary format that can be read
+	 * by loadBinaryModel(). This is meant to be done once, e.g. to convert
+	 * a .scm or .h5 model.
+	 *
+	 * @param[in] filename The file to write to. It will be overwritten.
+	 * @throws std::runtime_error if the file can't be written.
+	 */
+	void writeBinaryModel(boost::filesystem::path filename) const;
+
 	static std::vector<cv::Vec2f> loadIsomap(boost::filesystem::path isomapFile);
 	
-	PcaModel getShapeModel() const;
-	PcaModel getColorModel() const;
+	/**
+	 * Returns the shape model without copying it.
+	 *
+	 * @return A reference to the shape PCA model.
+	 */
+	const PcaModel& getShapeModel() const;
+
+	/**
+	 * Returns the color model without copying it.
+	 *
+	 * @return A reference to the color PCA model.
+	 */
+	const PcaModel& getColorModel() const;
 
 	/**
 	 * Returns the mean of the shape- and color model
@@ -112,11 +154,116 @@ public:
 	 * @param[in] colorCoefficients The PCA coefficients used to generate the shape sample.
 	 * @return A model instance with given coefficients.
 	 */
-	render::Mesh drawSample(std::vector<float> shapeCoefficients, std::vector<float> colorCoefficients);
+	render::Mesh drawSample(const std::vector<float>& shapeCoefficients, const std::vector<float>& colorCoefficients) const;
+
+	/**
+	 * Draws many random samples from the model at once. The
+	 * coefficients are drawn as in drawSample(float), and the
+	 * samples of each PCA model are computed with a single matrix
+	 * multiplication, see PcaModel::drawSamples().
+	 *
+	 * @param[in] numSamples The number of samples to draw.
+	 * @param[in] sigma The standard deviation.
+	 * @return The random samples from the model.
+	 */
+	std::vector<render::Mesh> drawSamples(int numSamples, float sigma = 1.0f);
+
+	/**
+	 * Returns many samples from the model with the given shape- and
+	 * color PCA coefficients, one sample per row of the coefficient
+	 * matrices. If a matrix is empty, the mean is used.
+	 *
+	 * @param[in] shapeCoefficients An N x k matrix of shape coefficients, see PcaModel::drawSamples().
+	 * @param[in] colorCoefficients An N x k matrix of color coefficients, see PcaModel::drawSamples().
+	 * @return N model instances.
+	 * @throws std::runtime_error if both matrices are given and their number of rows differ.
+	 */
+	std::vector<render::Mesh> drawSamples(cv::Mat shapeCoefficients, cv::Mat colorCoefficients) const;
+
+	/**
+	 * Returns the topology (triangle lists and texture coordinates)
+	 * that all instances of the model share. It is created when the
+	 * model is loaded.
+	 *
+	 * @return The topology of the model.
+	 */
+	std::shared_ptr<const render::MeshTopology> getTopology() const;
+
+	/**
+	 * Writes the mean of the shape- and color model into the given
+	 * instance. The instance gets the topology of the model, and its
+	 * vertex buffers are only allocated if they don't have the right
+	 * size yet, so an instance can be re-used without allocating.
+	 *
+	 * @param[out] instance The instance to write the mean to.
+	 */
+	void getMean(render::MeshInstance& instance) const;
+
+	/**
+	 * Draws a random sample from the model like drawSample(float),
+	 * but writes it into the given instance, see getMean(render::MeshInstance&).
+	 *
+	 * @param[out] instance The instance to write the sample to.
+	 * @param[in] sigma The standard deviation.
+	 */
+	void drawSample(render::MeshInstance& instance, float sigma = 1.0f);
+
+	/**
+	 * Computes the sample with the given shape- and color PCA
+	 * coefficients like drawSample(const std::vector<float>&, const std::vector<float>&),
+	 * but writes it into the given instance, see getMean(render::MeshInstance&).
+	 * If a vector is empty, the mean is used. If there are fewer
+	 * coefficients than principal components, the remaining
+	 * coefficients are 0.
+	 *
+	 * @param[out] instance The instance to write the sample to.
+	 * @param[in] shapeCoefficients The PCA coefficients used to generate the shape sample.
+	 * @param[in] colorCoefficients The PCA coefficients used to generate the color sample.
+	 * @throws std::runtime_error if there are more coefficients than principal components.
+	 */
+	void drawSample(render::MeshInstance& instance, const std::vector<float>& shapeCoefficients, const std::vector<float>& colorCoefficients) const;
+
+	/**
+	 * Draws one random sample into each of the given instances like
+	 * drawSamples(int, float), i.e. with a single matrix multiplication
+	 * per PCA model for all of them. The instances are prepared as in
+	 * getMean(render::MeshInstance&), so a batch of instances can be
+	 * re-used without allocating their vertex buffers again.
+	 *
+	 * @param[out] instances The instances to write the samples to.
+	 * @param[in] sigma The standard deviation.
+	 */
+	void drawSamples(std::vector<render::MeshInstance>& instances, float sigma = 1.0f);
 
 	//void setHasTextureCoordinates(bool hasTextureCoordinates);
 	
 private:
+	/**
+	 * Assembles a mesh from a shape and color sample, given as
+	 * row or column vectors (x, y, z, x, ...) resp. (r, g, b, r, ...).
+	 */
+	render::Mesh createMesh(cv::Mat shapeSample, cv::Mat colorSample) const;
+
+	/**
+	 * Creates the topology that is shared by all instances from the
+	 * shape- and color model and the texture coordinates. Has to be
+	 * called whenever one of them changed, i.e. after loading.
+	 */
+	void createTopology();
+
+	/**
+	 * Sets the topology of the instance and checks that the shape- and
+	 * color model have the same number of vertices.
+	 */
+	void prepareInstance(render::MeshInstance& instance) const;
+
+	/**
+	 * Computes mean + basis * coefficients of a PCA model into the given
+	 * (3 * numVertices) x 1 vector, without allocating it. If coefficients
+	 * is empty, the mean is copied.
+	 */
+	static void computeSample(const PcaModel& model, const cv::Mat& coefficients, cv::Mat& sample);
+
 	PcaModel shapeModel; ///< A PCA model of the shape
 	PcaModel colorModel; ///< A PCA model of vertex color information
 
@@ -124,6 +271,8 @@ private:
 
 	std::vector<cv::Vec2f> textureCoordinates; ///< 
 
+	std::shared_ptr<const render::MeshTopology> topology; ///< The topology shared by all instances of the model.
+
 };
 
 } /* namespace morphablemodel */
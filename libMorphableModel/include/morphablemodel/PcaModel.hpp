@@ -23,6 +23,14 @@
 #include <array>
 #include <map>
 #include <random>
+#include <memory>
+#include <ostream>
+
+namespace boost {
+	namespace interprocess {
+		class mapped_region;
+	}
+}
 
 namespace morphablemodel {
 
@@ -36,6 +44,11 @@ namespace morphablemodel {
  * It also contains a list of triangles to built a mesh as well as a mapping
  * from landmark points to the corresponding vertex-id in the mesh.
  * It is able to return instances of the model as meshes.
+ *
+ * All const member functions only read from the model, so one
+ * instance can be used from multiple threads at the same time.
+ * The only exception is drawSample(float), which advances the
+ * random engine of the model.
  */
 class PcaModel {
 public:
@@ -93,6 +106,35 @@ public:
 	 */
 	static PcaModel loadStatismoModel(boost::filesystem::path h5file, ModelType modelType);
 
+	/**
+	 * Reads a shape or color model from a memory-mapped file in the binary
+	 * format written by writeBinary(), starting at the given offset.
+	 * The mean, the bases and the eigenvalues are not copied, the matrices
+	 * are headers pointing into the mapping. The mapping is private
+	 * (copy-on-write), so processes that map the same file share the
+	 * physical memory as long as they don't write to it.
+	 *
+	 * Usually, this is called from MorphableModel::loadBinaryModel().
+	 *
+	 * @param[in] mappedRegion The memory-mapped file. The model keeps a reference to it.
+	 * @param[in,out] offset Byte offset of the model in the mapping. Set to the end of the model on return.
+	 * @return A shape- or color model from the given mapping.
+	 * @throws std::runtime_error if the data is truncated.
+	 */
+	static PcaModel loadBinaryModel(std::shared_ptr<boost::interprocess::mapped_region> mappedRegion, std::size_t& offset);
+
+	/**
+	 * Writes the model to a stream in the binary format that can be read
+	 * by loadBinaryModel(). The matrices are stored as raw floats,
+	 * each one aligned to binaryAlignment bytes relative to the start of
+	 * the stream, so the stream should be a file opened in binary mode.
+	 *
+	 * @param[in] stream The stream to write to.
+	 */
+	void writeBinary(std::ostream& stream) const;
+
+	static const std::size_t binaryAlignment = 64; ///< Alignment in bytes of the matrices in the binary format
+
 	/**
 	 * Returns the number of principal components in the model.
 	 *
@@ -153,7 +195,53 @@ public:
 	 * @param[in] coefficients The PCA coefficients used to generate the sample.
 	 * @return A model instance with given coefficients.
 	 */
-	cv::Mat drawSample(std::vector<float> coefficients);
+	cv::Mat drawSample(const std::vector<float>& coefficients) const;
+
+	/**
+	 * Draws a matrix of random coefficients, where each coefficient is
+	 * drawn from a normal distribution with the given standard deviation.
+	 * The result can be passed to drawSamples().
+	 *
+	 * @param[in] numSamples The number of coefficient vectors to draw.
+	 * @param[in] sigma The standard deviation.
+	 * @return A numSamples x getNumberOfPrincipalComponents() matrix of type CV_32FC1.
+	 */
+	cv::Mat drawRandomCoefficients(int numSamples, float sigma = 1.0f);
+
+	/**
+	 * Returns many samples from the model at once, computed with a
+	 * single matrix multiplication. Row i of the result is the same as
+	 * drawSample() with the coefficients in row i, transposed.
+	 * If there are fewer than getNumberOfPrincipalComponents() columns,
+	 * the remaining coefficients are 0.
+	 *
+	 * @param[in] coefficients An N x k matrix with one coefficient vector per row, k <= getNumberOfPrincipalComponents().
+	 * @return An N x getDataDimension() matrix of type CV_32FC1 with one sample per row.
+	 * @throws std::runtime_error if k is larger than the number of principal components.
+	 */
+	cv::Mat drawSamples(cv::Mat coefficients) const;
+
+	/**
+	 * Like drawSamples(cv::Mat), but only computes the values of the
+	 * given vertices, for example the landmarks. Use getVertexIndices()
+	 * to resolve landmark identifiers once and re-use the result.
+	 *
+	 * @param[in] coefficients An N x k matrix with one coefficient vector per row, k <= getNumberOfPrincipalComponents().
+	 * @param[in] vertexIndices The vertices to compute.
+	 * @return An N x (3 * vertexIndices.size()) matrix of type CV_32FC1 with one sample per row, (x, y, z) of each vertex in the given order.
+	 * @throws std::runtime_error if k is larger than the number of principal components.
+	 * @throws std::out_of_range if a vertex index is out of range.
+	 */
+	cv::Mat drawSamples(cv::Mat coefficients, const std::vector<int>& vertexIndices) const;
+
+	/**
+	 * Translates landmark identifiers into vertex indices of the model.
+	 *
+	 * @param[in] landmarkIdentifiers Landmark identifiers. At the moment, these are the vertex ids.
+	 * @return The vertex index of every landmark.
+	 * @throws std::out_of_range if a landmark does not exist in the model.
+	 */
+	std::vector<int> getVertexIndices(const std::vector<std::string>& landmarkIdentifiers) const;
 
 	/**
 	* Returns The PCA basis matrix, i.e. the eigenvectors.
@@ -166,6 +254,17 @@ public:
 	* @return Returns the normalized PCA basis matrix.
 	*/
 	cv::Mat getNormalizedPcaBasis() const;
+
+	/**
+	* Returns the normalized PCA basis matrix without copying it.
+	* The returned matrix shares its data with the model and
+	* must not be modified. Use this instead of
+	* getNormalizedPcaBasis() when only reading from the basis,
+	* e.g. in per-frame fitting.
+	*
+	* @return A reference to the normalized PCA basis matrix.
+	*/
+	const cv::Mat& getNormalizedPcaBasisView() const;
 	
 	/**
 	* Returns the PCA basis for a particular vertex. The vertex
@@ -208,6 +307,7 @@ public:
 
 private:
 	std::mt19937 engine; ///< A Mersenne twister MT19937 engine
+	std::shared_ptr<boost::interprocess::mapped_region> mappedRegion; ///< If the model was loaded from a binary file, the mapping that the matrices point into. Empty otherwise.
 	std::map<std::string, int> landmarkVertexMap; ///< Holds the translation from feature point name (e.g. "center.nose.tip") to the vertex number in the model
 	
 	cv::Mat mean; ///< A 3m x 1 col-vector (xyzxyz...)', where m is the number of model-vertices.
@@ -10,9 +10,13 @@
 #include "opencv2/core/core.hpp"
 #include "boost/lexical_cast.hpp"
 #include "boost/filesystem/path.hpp"
+#include "boost/interprocess/file_mapping.hpp"
+#include "boost/interprocess/mapped_region.hpp"
 #include <exception>
 #include <sstream>
 #include <fstream>
+#include <cstdint>
+#include <cstring>
 
 using logging::LoggerFactory;
 using cv::Mat;
@@ -26,9 +30,15 @@ using std::string;
 
 namespace morphablemodel {
 
+namespace {
+	// Header of the binary format: A magic string, followed by the version as uint32.
+	const char binaryMagic[8] = { 'B', 'M', 'M', 'O', 'D', 'E', 'L', '\0' };
+	const std::uint32_t binaryVersion = 1;
+}
+
 MorphableModel::MorphableModel()
 {
-	
+	createTopology();
 }
 
 morphablemodel::MorphableModel MorphableModel::load(const boost::property_tree::ptree configTree)
@@ -43,9 +53,12 @@ morphablemodel::MorphableModel MorphableModel::load(const boost::property_tree::
 	else if (filename.extension().string() == ".h5") {
 		morphableModel = MorphableModel::loadStatismoModel(filename.string());
 	}
+	else if (filename.extension().string() == ".bmm") {
+		morphableModel = MorphableModel::loadBinaryModel(filename);
+	}
 	else
 	{
-		throw std::runtime_error("MorphableModel: Unknown file extension. Neither .scm nor .h5.");
+		throw std::runtime_error("MorphableModel: Unknown file extension. Neither .scm, .h5 nor .bmm.");
 	}
 	return morphableModel;
 }
@@ -67,6 +80,7 @@ MorphableModel MorphableModel::loadScmModel(path h5file, path landmarkVertexMapp
 			model.hasTextureCoordinates = true;
 		}	
 	}
+	model.createTopology();
 	return model;
 }
 
@@ -75,16 +89,78 @@ MorphableModel MorphableModel::loadStatismoModel(path h5file)
 	MorphableModel model;
 	model.shapeModel = PcaModel::loadStatismoModel(h5file, PcaModel::ModelType::SHAPE);
 	model.colorModel = PcaModel::loadStatismoModel(h5file, PcaModel::ModelType::COLOR);
+	model.createTopology();
 	return model;
 }
 
+MorphableModel MorphableModel::loadBinaryModel(path filename)
+{
+	namespace bip = boost::interprocess;
+	std::shared_ptr<bip::mapped_region> mappedRegion;
+	try {
+		bip::file_mapping file(filename.string().c_str(), bip::read_only);
+		mappedRegion = std::make_shared<bip::mapped_region>(file, bip::copy_on_write); // the mapping stays valid after the file_mapping is destroyed
+	}
+	catch (const bip::interprocess_exception& e) {
+		throw std::runtime_error("MorphableModel: Could not map the binary model file " + filename.string() + ": " + e.what());
+	}
+	if (mappedRegion->get_size() < sizeof(binaryMagic) + sizeof(binaryVersion) || std::memcmp(mappedRegion->get_address(), binaryMagic, sizeof(binaryMagic)) != 0) {
+		throw std::runtime_error("MorphableModel: " + filename.string() + " is not a binary model file.");
+	}
+	std::size_t offset = sizeof(binaryMagic);
+	std::uint32_t version;
+	std::memcpy(&version, static_cast<char*>(mappedRegion->get_address()) + offset, sizeof(version));
+	offset += sizeof(version);
+	if (version != binaryVersion) {
+		throw std::runtime_error("MorphableModel: Unsupported binary model version " + lexical_cast<string>(version) + ", expected " + lexical_cast<string>(binaryVersion) + ".");
+	}
+
+	MorphableModel model;
+	model.shapeModel = PcaModel::loadBinaryModel(mappedRegion, offset);
+	model.colorModel = PcaModel::loadBinaryModel(mappedRegion, offset);
+
+	std::uint64_t numTextureCoordinates;
+	if (offset + sizeof(numTextureCoordinates) > mappedRegion->get_size()) {
+		throw std::runtime_error("MorphableModel: The binary model file is truncated.");
+	}
+	std::memcpy(&numTextureCoordinates, static_cast<char*>(mappedRegion->get_address()) + offset, sizeof(numTextureCoordinates));
+	offset += sizeof(numTextureCoordinates);
+	if (offset + numTextureCoordinates * sizeof(Vec2f) > mappedRegion->get_size()) {
+		throw std::runtime_error("MorphableModel: The binary model file is truncated.");
+	}
+	if (numTextureCoordinates > 0) {
+		model.textureCoordinates.resize(numTextureCoordinates);
+		std::memcpy(model.textureCoordinates.data(), static_cast<char*>(mappedRegion->get_address()) + offset, numTextureCoordinates * sizeof(Vec2f));
+		model.hasTextureCoordinates = true;
+	}
+	model.createTopology();
+	return model;
+}
+
+void MorphableModel::writeBinaryModel(path filename) const
+{
+	std::ofstream file(filename.string(), std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("MorphableModel: Could not open " + filename.string() + " for writing.");
+	}
+	file.write(binaryMagic, sizeof(binaryMagic));
+	file.write(reinterpret_cast<const char*>(&binaryVersion), sizeof(binaryVersion));
+	shapeModel.writeBinary(file);
+	colorModel.writeBinary(file);
+	const std::uint64_t numTextureCoordinates = hasTextureCoordinates ? textureCoordinates.size() : 0;
+	file.write(reinterpret_cast<const char*>(&numTextureCoordinates), sizeof(numTextureCoordinates));
+	file.write(reinterpret_cast<const char*>(textureCoordinates.data()), numTextureCoordinates * sizeof(Vec2f));
+	if (!file) {
+		throw std::runtime_error("MorphableModel: Error while writing " + filename.string() + ".");
+	}
+}
 
-PcaModel MorphableModel::getShapeModel() const
+const PcaModel& MorphableModel::getShapeModel() const
 {
 	return shapeModel;
 }
 
-PcaModel MorphableModel::getColorModel() const
+const PcaModel& MorphableModel::getColorModel() const
 {
 	return colorModel;
 }
@@ -93,8 +169,8 @@ render::Mesh MorphableModel::getMean() const
 {
 	render::Mesh mean;
 	
-	mean.tvi = shapeModel.getTriangleList();
-	mean.tci = colorModel.getTriangleList();
+	mean.tvi = topology->tvi;
+	mean.tci = topology->tci;
 	
 	Mat shapeMean = shapeModel.getMean();
 	Mat colorMean = colorModel.getMean();
@@ -129,8 +205,8 @@ render::Mesh MorphableModel::drawSample(float sigma /*= 1.0f*/)
 {
 	render::Mesh mean;
 
-	mean.tvi = shapeModel.getTriangleList();
-	mean.tci = colorModel.getTriangleList();
+	mean.tvi = topology->tvi;
+	mean.tci = topology->tci;
 
 	Mat shapeMean = shapeModel.drawSample(sigma);
 	Mat colorMean = colorModel.drawSample(sigma);
@@ -155,13 +231,8 @@ render::Mesh MorphableModel::drawSample(float sigma /*= 1.0f*/)
 	return mean;
 }
 
-render::Mesh MorphableModel::drawSample(vector<float> shapeCoefficients, vector<float> colorCoefficients)
+render::Mesh MorphableModel::drawSample(const vector<float>& shapeCoefficients, const vector<float>& colorCoefficients) const
 {
-	render::Mesh sample;
-
-	sample.tvi = shapeModel.getTriangleList();
-	sample.tci = colorModel.getTriangleList();
-
 	Mat shapeSample;
 	Mat colorSample;
 
@@ -176,6 +247,39 @@ render::Mesh MorphableModel::drawSample(vector<float> shapeCoefficients, vector<
 		colorSample = colorModel.drawSample(colorCoefficients);
 	}
 
+	return createMesh(shapeSample, colorSample);
+}
+
+vector<render::Mesh> MorphableModel::drawSamples(int numSamples, float sigma /*= 1.0f*/)
+{
+	return drawSamples(shapeModel.drawRandomCoefficients(numSamples, sigma), colorModel.drawRandomCoefficients(numSamples, sigma));
+}
+
+vector<render::Mesh> MorphableModel::drawSamples(Mat shapeCoefficients, Mat colorCoefficients) const
+{
+	if (!shapeCoefficients.empty() && !colorCoefficients.empty() && shapeCoefficients.rows != colorCoefficients.rows) {
+		throw std::runtime_error("MorphableModel: The shape and color coefficients must have the same number of rows.");
+	}
+	const int numSamples = shapeCoefficients.empty() ? colorCoefficients.rows : shapeCoefficients.rows;
+	// One matrix multiplication per model for all samples:
+	Mat shapeSamples = shapeCoefficients.empty() ? cv::repeat(shapeModel.getMean().t(), numSamples, 1) : shapeModel.drawSamples(shapeCoefficients);
+	Mat colorSamples = colorCoefficients.empty() ? cv::repeat(colorModel.getMean().t(), numSamples, 1) : colorModel.drawSamples(colorCoefficients);
+
+	vector<render::Mesh> samples;
+	samples.reserve(numSamples);
+	for (int i = 0; i < numSamples; ++i) {
+		samples.push_back(createMesh(shapeSamples.row(i), colorSamples.row(i)));
+	}
+	return samples;
+}
+
+render::Mesh MorphableModel::createMesh(Mat shapeSample, Mat colorSample) const
+{
+	render::Mesh sample;
+
+	sample.tvi = topology->tvi;
+	sample.tci = topology->tci;
+
 	unsigned int numVertices = shapeModel.getDataDimension() / 3;
 	unsigned int numVerticesColor = colorModel.getDataDimension() / 3;
 	if (numVertices != numVerticesColor) {
@@ -201,6 +305,91 @@ render::Mesh MorphableModel::drawSample(vector<float> shapeCoefficients, vector<
 	return sample;
 }
 
+std::shared_ptr<const render::MeshTopology> MorphableModel::getTopology() const
+{
+	return topology;
+}
+
+void MorphableModel::getMean(render::MeshInstance& instance) const
+{
+	drawSample(instance, vector<float>(), vector<float>());
+}
+
+void MorphableModel::drawSample(render::MeshInstance& instance, float sigma /*= 1.0f*/)
+{
+	prepareInstance(instance);
+	// drawRandomCoefficients() returns a continuous row, which we view as a column:
+	Mat shapeCoefficients = shapeModel.drawRandomCoefficients(1, sigma);
+	Mat colorCoefficients = colorModel.drawRandomCoefficients(1, sigma);
+	computeSample(shapeModel, shapeCoefficients.reshape(1, shapeCoefficients.cols), instance.positions);
+	computeSample(colorModel, colorCoefficients.reshape(1, colorCoefficients.cols), instance.colors);
+}
+
+void MorphableModel::drawSample(render::MeshInstance& instance, const vector<float>& shapeCoefficients, const vector<float>& colorCoefficients) const
+{
+	prepareInstance(instance);
+	// Mat(vector) doesn't copy the data:
+	computeSample(shapeModel, shapeCoefficients.empty() ? Mat() : Mat(shapeCoefficients), instance.positions);
+	computeSample(colorModel, colorCoefficients.empty() ? Mat() : Mat(colorCoefficients), instance.colors);
+}
+
+void MorphableModel::drawSamples(vector<render::MeshInstance>& instances, float sigma /*= 1.0f*/)
+{
+	if (instances.empty()) {
+		return;
+	}
+	const int numSamples = static_cast<int>(instances.size());
+	// One matrix multiplication per model for all samples:
+	Mat shapeSamples = shapeModel.drawSamples(shapeModel.drawRandomCoefficients(numSamples, sigma));
+	Mat colorSamples = colorModel.drawSamples(colorModel.drawRandomCoefficients(numSamples, sigma));
+	for (int i = 0; i < numSamples; ++i) {
+		prepareInstance(instances[i]);
+		// The rows are continuous, so they can be viewed as the columns the instance stores. copyTo() doesn't allocate, as the sizes match:
+		shapeSamples.row(i).reshape(1, shapeSamples.cols).copyTo(instances[i].positions);
+		colorSamples.row(i).reshape(1, colorSamples.cols).copyTo(instances[i].colors);
+	}
+}
+
+void MorphableModel::createTopology()
+{
+	std::shared_ptr<render::MeshTopology> newTopology = std::make_shared<render::MeshTopology>();
+	newTopology->numVertices = shapeModel.getDataDimension() / 3;
+	newTopology->tvi = shapeModel.getTriangleList();
+	newTopology->tci = colorModel.getTriangleList();
+	if (hasTextureCoordinates) {
+		newTopology->texcrd = textureCoordinates;
+	}
+	topology = newTopology;
+}
+
+void MorphableModel::prepareInstance(render::MeshInstance& instance) const
+{
+	unsigned int numVertices = shapeModel.getDataDimension() / 3;
+	unsigned int numVerticesColor = colorModel.getDataDimension() / 3;
+	if (numVertices != numVerticesColor) {
+		string msg("MorphableModel: The number of vertices of the shape and color models are not the same: " + lexical_cast<string>(numVertices) + " != " + lexical_cast<string>(numVerticesColor));
+		Loggers->getLogger("morphablemodel").debug(msg);
+		throw std::runtime_error(msg);
+	}
+	// Only allocates if the instance is new or had another topology:
+	instance.setTopology(topology);
+}
+
+void MorphableModel::computeSample(const PcaModel& model, const Mat& coefficients, Mat& sample)
+{
+	const Mat mean = model.getMean();
+	if (coefficients.empty()) {
+		mean.copyTo(sample);
+		return;
+	}
+	const Mat& basis = model.getNormalizedPcaBasisView();
+	if (coefficients.rows > basis.cols) {
+		throw std::runtime_error("MorphableModel: More coefficients given than the model has principal components.");
+	}
+	// sample already has the right size and type, so gemm() writes into it without allocating:
+	cv::gemm(basis.colRange(0, coefficients.rows), coefficients, 1.0, mean, 1.0, sample);
+}
+
 vector<Vec2f> MorphableModel::loadIsomap(path isomapFile)
 {
 	vector<float> xCoords, yCoords;
@@ -14,8 +14,11 @@
 #endif
 #include "boost/lexical_cast.hpp"
 #include "boost/algorithm/string.hpp"
+#include "boost/interprocess/mapped_region.hpp"
 
 #include <fstream>
+#include <cstdint>
+#include <cstring>
 
 using logging::LoggerFactory;
 using cv::Mat;
@@ -28,6 +31,58 @@ using std::array;
 
 namespace morphablemodel {
 
+namespace {
+	// Helpers for the binary format. Everything is stored in the native byte order.
+	template<class T>
+	void writeValue(std::ostream& stream, T value)
+	{
+		stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+
+	// Pads the stream with zeros up to the next multiple of alignment.
+	void writePadding(std::ostream& stream, std::size_t alignment)
+	{
+		const std::size_t position = static_cast<std::size_t>(stream.tellp());
+		const std::size_t padding = (alignment - position % alignment) % alignment;
+		const char zeros[PcaModel::binaryAlignment] = { 0 };
+		stream.write(zeros, padding);
+	}
+
+	// Writes a CV_32FC1 matrix as raw, aligned floats.
+	void writeMatrix(std::ostream& stream, const Mat& matrix)
+	{
+		writePadding(stream, PcaModel::binaryAlignment);
+		const Mat continuous = matrix.isContinuous() ? matrix : matrix.clone();
+		stream.write(reinterpret_cast<const char*>(continuous.ptr<float>()), continuous.total() * sizeof(float));
+	}
+
+	// Returns a pointer to numBytes bytes at offset into the mapping and advances the offset.
+	char* readBytes(const boost::interprocess::mapped_region& mappedRegion, std::size_t& offset, std::size_t numBytes)
+	{
+		if (offset + numBytes > mappedRegion.get_size()) {
+			throw std::runtime_error("PcaModel: The binary model file is truncated.");
+		}
+		char* data = static_cast<char*>(mappedRegion.get_address()) + offset;
+		offset += numBytes;
+		return data;
+	}
+
+	template<class T>
+	T readValue(const boost::interprocess::mapped_region& mappedRegion, std::size_t& offset)
+	{
+		T value;
+		std::memcpy(&value, readBytes(mappedRegion, offset, sizeof(T)), sizeof(T));
+		return value;
+	}
+
+	// Returns a CV_32FC1 matrix header pointing into the mapping, without copying.
+	Mat readMatrix(const boost::interprocess::mapped_region& mappedRegion, std::size_t& offset, int rows, int cols)
+	{
+		offset += (PcaModel::binaryAlignment - offset % PcaModel::binaryAlignment) % PcaModel::binaryAlignment;
+		return Mat(rows, cols, CV_32FC1, readBytes(mappedRegion, offset, static_cast<std::size_t>(rows) * cols * sizeof(float)));
+	}
+}
+
 PcaModel::PcaModel()
 {
 	engine.seed();
@@ -389,6 +444,52 @@ PcaModel PcaModel::loadScmModel(path modelFilename, path landmarkVertexMappingFi
 	//return model;
 }
 
+PcaModel PcaModel::loadBinaryModel(std::shared_ptr<boost::interprocess::mapped_region> mappedRegion, std::size_t& offset)
+{
+	PcaModel model;
+	const auto numDims = readValue<std::uint32_t>(*mappedRegion, offset);
+	const auto numPcaCoeffs = readValue<std::uint32_t>(*mappedRegion, offset);
+	const auto numTriangles = readValue<std::uint32_t>(*mappedRegion, offset);
+	const auto numLandmarks = readValue<std::uint32_t>(*mappedRegion, offset);
+
+	model.mean = readMatrix(*mappedRegion, offset, numDims, 1);
+	model.normalizedPcaBasis = readMatrix(*mappedRegion, offset, numDims, numPcaCoeffs);
+	model.unnormalizedPcaBasis = readMatrix(*mappedRegion, offset, numDims, numPcaCoeffs);
+	model.eigenvalues = readMatrix(*mappedRegion, offset, numPcaCoeffs, 1);
+
+	// The triangles and landmarks are small, we copy them into their containers:
+	model.triangleList.resize(numTriangles);
+	std::memcpy(model.triangleList.data(), readBytes(*mappedRegion, offset, numTriangles * sizeof(array<int, 3>)), numTriangles * sizeof(array<int, 3>));
+	for (std::uint32_t i = 0; i < numLandmarks; ++i) {
+		const auto nameLength = readValue<std::uint32_t>(*mappedRegion, offset);
+		string name(readBytes(*mappedRegion, offset, nameLength), nameLength);
+		const auto vertexId = readValue<std::int32_t>(*mappedRegion, offset);
+		model.landmarkVertexMap.insert(make_pair(name, vertexId));
+	}
+	model.mappedRegion = mappedRegion;
+	return model;
+}
+
+void PcaModel::writeBinary(std::ostream& stream) const
+{
+	writeValue<std::uint32_t>(stream, getDataDimension());
+	writeValue<std::uint32_t>(stream, getNumberOfPrincipalComponents());
+	writeValue<std::uint32_t>(stream, triangleList.size());
+	writeValue<std::uint32_t>(stream, landmarkVertexMap.size());
+
+	writeMatrix(stream, mean);
+	writeMatrix(stream, normalizedPcaBasis);
+	writeMatrix(stream, unnormalizedPcaBasis);
+	writeMatrix(stream, eigenvalues);
+
+	stream.write(reinterpret_cast<const char*>(triangleList.data()), triangleList.size() * sizeof(array<int, 3>));
+	for (const auto& landmark : landmarkVertexMap) {
+		writeValue<std::uint32_t>(stream, landmark.first.size());
+		stream.write(landmark.first.data(), landmark.first.size());
+		writeValue<std::int32_t>(stream, landmark.second);
+	}
+}
+
 unsigned int PcaModel::getNumberOfPrincipalComponents() const
 {
 	// Note: we could assert(normalizedPcaBasis.cols==unnormalizedPcaBasis.cols)
@@ -456,7 +557,7 @@ Mat PcaModel::drawSample(float sigma/*=1.0f*/)
 	*/
 }
 
-Mat PcaModel::drawSample(vector<float> coefficients)
+Mat PcaModel::drawSample(const vector<float>& coefficients) const
 {
 	Mat alphas(coefficients);
 	/*
@@ -477,11 +578,79 @@ Mat PcaModel::drawSample(vector<float> coefficients)
 	return modelSample;
 }
 
+Mat PcaModel::drawRandomCoefficients(int numSamples, float sigma/*=1.0f*/)
+{
+	std::normal_distribution<float> distribution(0.0f, sigma);
+	Mat coefficients(numSamples, getNumberOfPrincipalComponents(), CV_32FC1);
+	for (auto it = coefficients.begin<float>(); it != coefficients.end<float>(); ++it) {
+		*it = distribution(engine);
+	}
+	return coefficients;
+}
+
+Mat PcaModel::drawSamples(Mat coefficients) const
+{
+	if (coefficients.cols > normalizedPcaBasis.cols) {
+		throw std::runtime_error("PcaModel: More coefficients given than the model has principal components.");
+	}
+	if (coefficients.type() != CV_32FC1) {
+		coefficients.convertTo(coefficients, CV_32FC1);
+	}
+	// samples = coefficients * basis^t + mean^t, for all rows at once:
+	Mat samples;
+	cv::gemm(coefficients, normalizedPcaBasis.colRange(0, coefficients.cols), 1.0, cv::repeat(mean.t(), coefficients.rows, 1), 1.0, samples, cv::GEMM_2_T);
+	return samples;
+}
+
+Mat PcaModel::drawSamples(Mat coefficients, const vector<int>& vertexIndices) const
+{
+	if (coefficients.cols > normalizedPcaBasis.cols) {
+		throw std::runtime_error("PcaModel: More coefficients given than the model has principal components.");
+	}
+	if (coefficients.type() != CV_32FC1) {
+		coefficients.convertTo(coefficients, CV_32FC1);
+	}
+	// Gather the rows of the basis and mean that belong to the vertices:
+	Mat basisRows(3 * vertexIndices.size(), coefficients.cols, CV_32FC1);
+	Mat meanRows(1, 3 * vertexIndices.size(), CV_32FC1);
+	for (size_t i = 0; i < vertexIndices.size(); ++i) {
+		const int row = 3 * vertexIndices[i];
+		if (vertexIndices[i] < 0 || row + 3 > mean.rows) {
+			throw std::out_of_range("PcaModel: The given vertex index is out of range.");
+		}
+		normalizedPcaBasis.rowRange(row, row + 3).colRange(0, coefficients.cols).copyTo(basisRows.rowRange(3 * i, 3 * i + 3));
+		meanRows.at<float>(3 * i) = mean.at<float>(row);
+		meanRows.at<float>(3 * i + 1) = mean.at<float>(row + 1);
+		meanRows.at<float>(3 * i + 2) = mean.at<float>(row + 2);
+	}
+	Mat samples;
+	cv::gemm(coefficients, basisRows, 1.0, cv::repeat(meanRows, coefficients.rows, 1), 1.0, samples, cv::GEMM_2_T);
+	return samples;
+}
+
+vector<int> PcaModel::getVertexIndices(const vector<string>& landmarkIdentifiers) const
+{
+	vector<int> vertexIndices;
+	vertexIndices.reserve(landmarkIdentifiers.size());
+	for (const auto& landmarkIdentifier : landmarkIdentifiers) {
+		if (!landmarkExists(landmarkIdentifier)) {
+			throw std::out_of_range("PcaModel: The landmark " + landmarkIdentifier + " does not exist in the model.");
+		}
+		vertexIndices.push_back(lexical_cast<int>(landmarkIdentifier)); // Note: At the moment, the identifiers are the vertex ids, see getMeanAtPoint()
+	}
+	return vertexIndices;
+}
+
 cv::Mat PcaModel::getNormalizedPcaBasis() const
 {
 	return normalizedPcaBasis.clone();
 }
 
+const cv::Mat& PcaModel::getNormalizedPcaBasisView() const
+{
+	return normalizedPcaBasis;
+}
+
 cv::Mat PcaModel::getNormalizedPcaBasis(std::string landmarkIdentifier) const
 {
 	//int vertexId = landmarkVertexMap.at(landmarkIdentifier); // Todo: Hacky
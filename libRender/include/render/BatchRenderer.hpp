@@ -0,0 +1,147 @@
+/*
+ * BatchRenderer.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+#pragma once
+
+#ifndef BATCHRENDERER_HPP_
+#define BATCHRENDERER_HPP_
+
+#include "render/SoftwareRenderer.hpp"
+#include "render/WorkerPool.hpp"
+#include "render/Mesh.hpp"
+#include "render/MeshInstance.hpp"
+#include "render/Texture.hpp"
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+#include <utility>
+#include <memory>
+
+namespace render {
+
+/**
+ * Renders many views in one call, e.g. many samples of a Morphable
+ * Model, each from several viewpoints. The meshes are only read and
+ * never copied. The views are rendered concurrently, each into its own
+ * framebuffer that is allocated once and re-used by later calls.
+ *
+ * The render state (backface culling, texturing and the current
+ * texture) is the same for all views and is set like on a
+ * SoftwareRenderer. The views are already rendered in parallel, so
+ * each of them is rasterized with the scalar (non-tiled) rasterizer.
+ */
+class BatchRenderer
+{
+public:
+	/**
+	 * Constructs a batch renderer for the given viewport.
+	 *
+	 * @param[in] viewportWidth Width of the viewport of every view.
+	 * @param[in] viewportHeight Height of the viewport of every view.
+	 * @param[in] numThreads Number of threads to render with. 0 means std::thread::hardware_concurrency().
+	 */
+	BatchRenderer(unsigned int viewportWidth, unsigned int viewportHeight, unsigned int numThreads = 0);
+
+	bool doBackfaceCulling = false; ///< If true, only draw triangles with vertices ordered CCW in screen-space
+	bool doTexturing = false; ///< If true, shade with the current texture instead of the vertex colours.
+
+	void enableTexturing(bool doTexturing) {
+		this->doTexturing = doTexturing;
+	};
+
+	void setCurrentTexture(std::shared_ptr<Texture> texture) {
+		currentTexture = texture;
+	};
+
+	/**
+	 * Renders the mesh once for every given mvp matrix.
+	 * Note: As with SoftwareRenderer::render(...), the returned Mats
+	 * refer to the framebuffers, not to clones. They get overwritten by
+	 * the next call to render(...).
+	 *
+	 * @param[in] mesh The mesh to render.
+	 * @param[in] mvps A 4x4 CV_32FC1 model-view-projection matrix per view.
+	 * @return A pair of colour- and depth-buffer per view.
+	 */
+	std::vector<std::pair<cv::Mat, cv::Mat>> render(const Mesh& mesh, const std::vector<cv::Mat>& mvps);
+
+	/**
+	 * Renders view i with mvps[i] and the vertex positions
+	 * vertexPositions[i] instead of the positions in the mesh.
+	 * Each vertexPositions[i] is a (3 * numVertices) x 1 CV_32FC1
+	 * vector (xyzxyz...), e.g. from PcaModel::drawSample(...).
+	 * If vertexPositions is empty, the mesh's positions are used.
+	 *
+	 * @param[in] mesh The mesh providing the topology, colours and texture coordinates.
+	 * @param[in] mvps A 4x4 CV_32FC1 model-view-projection matrix per view.
+	 * @param[in] vertexPositions Vertex positions per view, or empty.
+	 * @return A pair of colour- and depth-buffer per view.
+	 */
+	std::vector<std::pair<cv::Mat, cv::Mat>> render(const Mesh& mesh, const std::vector<cv::Mat>& mvps, const std::vector<cv::Mat>& vertexPositions);
+
+	/**
+	 * Renders every mesh with each of its mvp matrices, i.e. mesh i
+	 * once for every matrix in mvps[i]. All views of all meshes are
+	 * rendered in one batch.
+	 *
+	 * @param[in] meshes The meshes to render.
+	 * @param[in] mvps The 4x4 CV_32FC1 model-view-projection matrices of the views of each mesh.
+	 * @return For each mesh, a pair of colour- and depth-buffer per view.
+	 */
+	std::vector<std::vector<std::pair<cv::Mat, cv::Mat>>> render(const std::vector<Mesh>& meshes, const std::vector<std::vector<cv::Mat>>& mvps);
+
+	/**
+	 * Renders every mesh instance with each of its mvp matrices, like
+	 * render(const std::vector<Mesh>&, ...). The instances can be re-used
+	 * for the next batch, e.g. with MorphableModel::drawSample(MeshInstance&, ...),
+	 * so that neither the samples nor the framebuffers are allocated again.
+	 *
+	 * @param[in] meshes The mesh instances to render.
+	 * @param[in] mvps The 4x4 CV_32FC1 model-view-projection matrices of the views of each mesh.
+	 * @return For each mesh, a pair of colour- and depth-buffer per view.
+	 */
+	std::vector<std::vector<std::pair<cv::Mat, cv::Mat>>> render(const std::vector<MeshInstance>& meshes, const std::vector<std::vector<cv::Mat>>& mvps);
+
+private:
+	/**
+	 * One view of a batch: A mesh or a mesh instance, the matrix to
+	 * render it with and optionally the vertex positions to use instead
+	 * of the ones of the mesh (not for mesh instances).
+	 */
+	struct View
+	{
+		const Mesh* mesh = nullptr; ///< The mesh, or nullptr if meshInstance is set.
+		const MeshInstance* meshInstance = nullptr; ///< The mesh instance, or nullptr if mesh is set.
+		cv::Mat mvp;
+		cv::Mat vertexPositions;
+
+		void setMesh(const Mesh& mesh) {
+			this->mesh = &mesh;
+		};
+
+		void setMesh(const MeshInstance& meshInstance) {
+			this->meshInstance = &meshInstance;
+		};
+	};
+
+	// Renders all views of all meshes in one batch and groups the framebuffers by mesh.
+	template<class MeshType>
+	std::vector<std::vector<std::pair<cv::Mat, cv::Mat>>> renderMeshes(const std::vector<MeshType>& meshes, const std::vector<std::vector<cv::Mat>>& mvps);
+
+	// Renders the views in parallel and returns their framebuffers.
+	std::vector<std::pair<cv::Mat, cv::Mat>> renderViews(const std::vector<View>& views);
+
+	unsigned int viewportWidth;
+	unsigned int viewportHeight;
+	std::shared_ptr<Texture> currentTexture; ///< The texture used if doTexturing is true.
+	std::shared_ptr<WorkerPool> workerPool; ///< Threads that render the views.
+	std::vector<SoftwareRenderer> renderers; ///< One renderer (and thus one set of framebuffers) per view. Grows to the largest batch seen.
+};
+
+} /* namespace render */
+
+#endif /* BATCHRENDERER_HPP_ */
@@ -49,9 +49,10 @@ public:
 
 	std::shared_ptr<render::Texture> texture; // optimally, we'd use a TextureManager, or maybe a smart pointer, to not load/store a texture twice if two models use the same texture.
 
-	// TODO Doc
 	// obj with vertex-coloring (not officially supported but works eg in meshlab)
-	static void writeObj(Mesh mesh, std::string filename);
+	// See render::utils::writeObj(...) in MeshExport.hpp, which this calls,
+	// for exporting the texture as well and for binary PLY output.
+	static void writeObj(const Mesh& mesh, std::string filename);
 
 };
 
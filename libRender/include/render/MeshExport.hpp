@@ -0,0 +1,82 @@
+/*
+ * MeshExport.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+#pragma once
+
+#ifndef MESHEXPORT_HPP_
+#define MESHEXPORT_HPP_
+
+#include "render/Mesh.hpp"
+
+#include "opencv2/core/core.hpp"
+
+#include <string>
+
+namespace render {
+
+	namespace utils {
+
+		/**
+		 * File formats a mesh can be exported to.
+		 */
+		enum class MeshFileFormat {
+			Obj,		///< Wavefront OBJ (text) with vertex colours, and a .mtl file if a texture is given.
+			PlyBinary	///< Binary little-endian PLY with vertex colours (as bytes).
+		};
+
+		/**
+		 * Writes the mesh to an OBJ file, with the vertex colours appended
+		 * to the vertex positions (not officially supported but works e.g.
+		 * in MeshLab). The whole file is formatted into one buffer and
+		 * written at once.
+		 * If a texture filename is given and the mesh has texture
+		 * coordinates, they are written too, together with a .mtl file next
+		 * to the OBJ file that references the texture. The texture filename
+		 * is written as given, so it should be relative to the OBJ file.
+		 *
+		 * @param[in] mesh The mesh to write.
+		 * @param[in] filename The file to write to. It will be overwritten.
+		 * @param[in] textureFilename The texture the material should reference, or empty.
+		 * @throws std::runtime_error if the file can't be written.
+		 */
+		void writeObj(const Mesh& mesh, const std::string& filename, const std::string& textureFilename = std::string());
+
+		/**
+		 * Writes the mesh to a binary little-endian PLY file. The vertex
+		 * colours are converted to bytes. If the mesh has texture
+		 * coordinates, they are written as texture_u and texture_v, and
+		 * a given texture filename is written as a "TextureFile" comment,
+		 * which is what MeshLab reads.
+		 *
+		 * @param[in] mesh The mesh to write.
+		 * @param[in] filename The file to write to. It will be overwritten.
+		 * @param[in] textureFilename The texture to reference, or empty.
+		 * @throws std::runtime_error if the file can't be written.
+		 */
+		void writePlyBinary(const Mesh& mesh, const std::string& filename, const std::string& textureFilename = std::string());
+
+		/**
+		 * Writes a mesh and its texture (e.g. an isomap from extractTexture())
+		 * in one call. The texture is PNG-encoded on a second thread while
+		 * the mesh is formatted, and both files are then written with a single
+		 * write each. The mesh references the texture by its filename, so
+		 * both should be written to the same directory.
+		 *
+		 * @param[in] mesh The mesh to write.
+		 * @param[in] meshFilename The file to write the mesh to.
+		 * @param[in] texture The texture to write, a CV_8UC3 or CV_8UC4 image.
+		 * @param[in] textureFilename The file to write the texture to, should end with ".png".
+		 * @param[in] format The file format of the mesh.
+		 * @param[in] pngCompression The PNG compression level (0-9). Lower is faster and results in larger files.
+		 * @throws std::runtime_error if one of the files can't be written.
+		 */
+		void writeMeshAndTexture(const Mesh& mesh, const std::string& meshFilename, cv::Mat texture, const std::string& textureFilename, MeshFileFormat format = MeshFileFormat::Obj, int pngCompression = 1);
+
+	} /* namespace utils */
+
+} /* namespace render */
+
+#endif /* MESHEXPORT_HPP_ */
@@ -0,0 +1,103 @@
+/*
+ * MeshInstance.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+#pragma once
+
+#ifndef MESHINSTANCE_HPP_
+#define MESHINSTANCE_HPP_
+
+#include "render/Mesh.hpp"
+
+#include "opencv2/core/core.hpp"
+
+#include <vector>
+#include <array>
+#include <memory>
+
+namespace render {
+
+/**
+ * The connectivity of a mesh, i.e. everything that is the same for
+ * all instances of e.g. a Morphable Model: The triangle lists and
+ * the texture coordinates. It is created once and then only shared
+ * (as shared_ptr<const MeshTopology>) by the instances, which never
+ * copy it.
+ */
+struct MeshTopology
+{
+	unsigned int numVertices = 0; ///< The number of vertices of every instance.
+	std::vector<std::array<int, 3>> tvi; ///< Triangle vertex indices.
+	std::vector<std::array<int, 3>> tci; ///< Triangle color indices.
+	std::vector<cv::Vec2f> texcrd; ///< Texture coordinates, one per vertex, or empty if there are none.
+};
+
+/**
+ * A mesh that consists of a shared, immutable topology and its own
+ * vertex data. Contrary to Mesh, which stores one Vertex struct per
+ * vertex, the vertex data is stored as one buffer per attribute, in
+ * the layout of the PCA models (xyzxyz... resp. rgbrgb...), so it can
+ * be written in place by e.g. MorphableModel::drawSample(MeshInstance&, ...)
+ * and read directly by SoftwareRenderer::render(const MeshInstance&, ...).
+ *
+ * Like cv::Mat, copying an instance shares the vertex buffers. Use
+ * clone() to get an independent copy.
+ */
+class MeshInstance
+{
+public:
+	MeshInstance() = default;
+
+	/**
+	 * Creates an instance of the given topology with uninitialised
+	 * vertex buffers.
+	 *
+	 * @param[in] topology The topology of the mesh.
+	 */
+	explicit MeshInstance(std::shared_ptr<const MeshTopology> topology);
+
+	/**
+	 * Sets the topology and (re-)allocates the vertex buffers for its
+	 * number of vertices. Nothing is allocated if the buffers already
+	 * have the right size, so an instance can be re-used for many
+	 * samples without allocating.
+	 *
+	 * @param[in] topology The topology of the mesh.
+	 */
+	void setTopology(std::shared_ptr<const MeshTopology> topology);
+
+	/**
+	 * Returns a copy with its own vertex buffers. The topology is shared.
+	 *
+	 * @return A deep copy of the vertex data.
+	 */
+	MeshInstance clone() const;
+
+	/**
+	 * Converts the instance to a Mesh, e.g. to write it to a file.
+	 * This copies the topology.
+	 *
+	 * @return The mesh.
+	 */
+	Mesh toMesh() const;
+
+	/**
+	 * Creates an instance from a mesh, with a new topology taken from
+	 * the mesh. The positions are converted from homogeneous coordinates
+	 * by dropping w, which is assumed to be 1.
+	 *
+	 * @param[in] mesh The mesh.
+	 * @return An instance with the vertices of the mesh.
+	 */
+	static MeshInstance fromMesh(const Mesh& mesh);
+
+	std::shared_ptr<const MeshTopology> topology; ///< The shared topology.
+	cv::Mat positions; ///< The vertex positions, a (3 * numVertices) x 1 CV_32FC1 vector (xyzxyz...).
+	cv::Mat colors; ///< The vertex colours, a (3 * numVertices) x 1 CV_32FC1 vector (rgbrgb...).
+};
+
+} /* namespace render */
+
+#endif /* MESHINSTANCE_HPP_ */
@@ -10,10 +10,15 @@
 #define MESHUTILS_HPP_
 
 #include "render/Mesh.hpp"
+#include "render/MeshInstance.hpp"
+#include "render/SoftwareRenderer.hpp"
+#include "render/WorkerPool.hpp"
 
 #include "opencv2/core/core.hpp"
 
 #include <memory>
+#include <vector>
+#include <array>
 
 // Todo: Class with static methods? Or just functions? I don't know which method is better.
 // ==> go for free functions in the namespace!
@@ -35,7 +40,92 @@ namespace render {
 			static bool isPointInTriangle(cv::Point2f point, cv::Point2f triV0, cv::Point2f triV1, cv::Point2f triV2);
 		};
 
-		cv::Mat extractTexture(render::Mesh mesh, cv::Mat mvpMatrix, int viewportWidth, int viewportHeight, cv::Mat image, cv::Mat depthBuffer);
+		/**
+		 * Interpolation method used to sample the image when extracting a texture.
+		 */
+		enum class TextureInterpolation {
+			Bilinear,
+			Bicubic
+		};
+
+		/**
+		 * Extracts the texture of a mesh from an image, see extractTexture(...).
+		 * Keeps its visibility renderer and its threads alive between calls, so
+		 * use one instance when extracting the textures of many images, e.g. of
+		 * all frames of a video.
+		 */
+		class TextureExtractor
+		{
+		public:
+			/**
+			 * Starts the threads that remap the texels.
+			 *
+			 * @param[in] numThreads Number of threads to use. 0 means std::thread::hardware_concurrency().
+			 */
+			explicit TextureExtractor(unsigned int numThreads = 0);
+
+			/**
+			 * Extracts the texture of the mesh from the image and returns it as
+			 * an isomap (a CV_8UC3 texture map in the mesh's texture coordinates).
+			 *
+			 * Only triangles that are completely visible are extracted. The
+			 * visibility is computed with one rendering pass into a triangle-ID
+			 * buffer (see SoftwareRenderer::renderTriangleIds(...)), and a triangle
+			 * is completely visible if it is the front-most one in all the pixels
+			 * it covers. Triangles that share an edge don't compete for its pixels,
+			 * so they aren't hidden by each other. The texels are sampled directly
+			 * from the image in parallel over the rows of the texture map.
+			 *
+			 * @param[in] mesh The mesh, with texture coordinates.
+			 * @param[in] mvpMatrix The 4x4 CV_32FC1 matrix the mesh was rendered with.
+			 * @param[in] viewportWidth Width of the viewport the mesh was rendered to.
+			 * @param[in] viewportHeight Height of the viewport the mesh was rendered to.
+			 * @param[in] image The CV_8UC3 image to extract the texture from.
+			 * @param[in] isomapResolution Width and height of the resulting texture map.
+			 * @param[in] interpolation How to sample the image.
+			 * @return The extracted texture map.
+			 */
+			cv::Mat extract(const render::Mesh& mesh, cv::Mat mvpMatrix, int viewportWidth, int viewportHeight, cv::Mat image, int isomapResolution = 512, TextureInterpolation interpolation = TextureInterpolation::Bicubic);
+
+			/**
+			 * Extracts the texture of a mesh instance, e.g. a sample of a Morphable
+			 * Model drawn with MorphableModel::drawSample(MeshInstance&, ...), without
+			 * converting it to a Mesh. See extract(const render::Mesh&, ...).
+			 *
+			 * @throws std::runtime_error if the topology of the instance has no texture coordinates.
+			 */
+			cv::Mat extract(const render::MeshInstance& mesh, cv::Mat mvpMatrix, int viewportWidth, int viewportHeight, cv::Mat image, int isomapResolution = 512, TextureInterpolation interpolation = TextureInterpolation::Bicubic);
+
+		private:
+			// Returns the visibility renderer, re-created if the viewport changed.
+			SoftwareRenderer& getVisibilityRenderer(int viewportWidth, int viewportHeight);
+
+			// Extracts the completely visible triangles, given the screen position and texture coordinates of every vertex and the result of the visibility pass.
+			cv::Mat extractVisibleTriangles(const std::vector<std::array<int, 3>>& tvi, const std::vector<cv::Vec2f>& texcrd, const std::vector<cv::Point2f>& screenPoints, const cv::Mat& triangleIds, const std::vector<int>& numCoveredPixels, cv::Mat image, int isomapResolution, TextureInterpolation interpolation);
+
+			std::shared_ptr<WorkerPool> workerPool; ///< Threads that remap the texels.
+			std::unique_ptr<SoftwareRenderer> visibilityRenderer; ///< Renders the triangle-IDs. Re-created only if the viewport changes.
+			int viewportWidth = 0; ///< Width of the viewport of the visibility renderer.
+			int viewportHeight = 0; ///< Height of the viewport of the visibility renderer.
+		};
+
+		/**
+		 * Extracts the texture of the mesh from the image and returns it as
+		 * an isomap (a CV_8UC3 texture map in the mesh's texture coordinates),
+		 * see TextureExtractor::extract(...).
+		 * This creates a renderer and threads on every call. To extract the
+		 * textures of many images, use one TextureExtractor instead.
+		 *
+		 * @param[in] mesh The mesh, with texture coordinates.
+		 * @param[in] mvpMatrix The 4x4 CV_32FC1 matrix the mesh was rendered with.
+		 * @param[in] viewportWidth Width of the viewport the mesh was rendered to.
+		 * @param[in] viewportHeight Height of the viewport the mesh was rendered to.
+		 * @param[in] image The CV_8UC3 image to extract the texture from.
+		 * @param[in] isomapResolution Width and height of the resulting texture map.
+		 * @param[in] interpolation How to sample the image.
+		 * @return The extracted texture map.
+		 */
+		cv::Mat extractTexture(const render::Mesh& mesh, cv::Mat mvpMatrix, int viewportWidth, int viewportHeight, cv::Mat image, int isomapResolution = 512, TextureInterpolation interpolation = TextureInterpolation::Bicubic);
 
 	} /* namespace utils */
 
@@ -10,10 +10,14 @@
 #define SOFTWARERENDERER_HPP_
 
 #include "render/Mesh.hpp"
+#include "render/MeshInstance.hpp"
 #include "render/MatrixUtils.hpp"
+#include "render/WorkerPool.hpp"
 
 #include "opencv2/core/core.hpp"
 #include "boost/optional/optional.hpp"
+
+#include <memory>
 #ifdef WITH_RENDER_QOPENGL
 	#include <QMatrix4x4>
 #endif
@@ -36,15 +40,44 @@ public:
 
 	bool doBackfaceCulling = false; ///< If true, only draw triangles with vertices ordered CCW in screen-space
 	bool doTexturing = false; ///< Desc.
+	bool doTiledRasterization = false; ///< If true, bin the triangles into screen tiles and rasterize the tiles in parallel.
+	unsigned int numRasterizerThreads = 0; ///< Number of threads used for tiled rasterization. 0 means std::thread::hardware_concurrency(). Only read when the worker pool is created, i.e. on the first tiled render without a pool set by setWorkerPool(...).
 
 #ifdef WITH_RENDER_QOPENGL
-	std::pair<cv::Mat, cv::Mat> render(Mesh mesh, QMatrix4x4 mvp);
+	std::pair<cv::Mat, cv::Mat> render(const Mesh& mesh, QMatrix4x4 mvp);
 #endif
 	// Note: returns a reference (Mat) to the framebuffer, not
 	// a clone! I.e. if you don't want your image to get
 	// overwritten by a second call to render(...), you have to
-	// clone.
-	std::pair<cv::Mat, cv::Mat> render(Mesh mesh, cv::Mat mvp);
+	// clone. The colour- and depth-buffer are allocated once and
+	// then cleared in place on every call.
+	// The mvp matrix has to be a 4x4 CV_32FC1 matrix.
+	std::pair<cv::Mat, cv::Mat> render(const Mesh& mesh, cv::Mat mvp);
+
+	// Renders the mesh with its vertex positions replaced by the given
+	// ones. The topology, colours and texture coordinates are taken from
+	// the mesh. vertexPositions is a (3 * numVertices) x 1 CV_32FC1 vector
+	// (xyzxyz...), as returned by e.g. PcaModel::drawSample(...).
+	std::pair<cv::Mat, cv::Mat> render(const Mesh& mesh, cv::Mat mvp, cv::Mat vertexPositions);
+
+	// Renders a mesh instance. The vertex buffers of the instance are read
+	// directly, no Mesh is assembled, so this is the fastest way to render
+	// many samples of a Morphable Model (see MorphableModel::drawSample(MeshInstance&, ...)).
+	std::pair<cv::Mat, cv::Mat> render(const MeshInstance& mesh, cv::Mat mvp);
+
+	// Visibility pass: Rasterizes the mesh without shading and returns
+	// a CV_32SC1 image that contains, for every pixel, the index (into
+	// mesh.tvi) of the visible triangle, or -1 if no triangle covers it.
+	// Pixel centres on an edge shared by two triangles are only covered
+	// by one of them (a top-left fill rule), contrary to render(...).
+	// If numCoveredPixels is given, it is filled with the number of
+	// pixels each triangle covers before the depth-test, or -1 if the
+	// triangle was culled or clipped away.
+	// As with render(...), the returned Mat refers to an internal buffer.
+	cv::Mat renderTriangleIds(const Mesh& mesh, cv::Mat mvp, std::vector<int>* numCoveredPixels = nullptr);
+
+	// Visibility pass for a mesh instance, see renderTriangleIds(const Mesh&, ...).
+	cv::Mat renderTriangleIds(const MeshInstance& mesh, cv::Mat mvp, std::vector<int>* numCoveredPixels = nullptr);
 
 	cv::Vec3f projectVertex(cv::Vec4f vertex, cv::Mat mvp);
 	
@@ -56,16 +89,59 @@ public:
 		currentTexture = texture;
 	};
 
+	// Sets the threads used for tiled rasterization. The pool can be
+	// shared by several renderers (calls to it are serialised), but it
+	// must not be the pool that the renderer itself is called from.
+	// Copies of a renderer share its pool.
+	void setWorkerPool(std::shared_ptr<WorkerPool> workerPool) {
+		this->workerPool = workerPool;
+	};
+
 private:
 	cv::Mat colorBuffer;
 	cv::Mat depthBuffer;
+	cv::Mat triangleIdBuffer;
 	unsigned int viewportWidth = 640;
 	unsigned int viewportHeight = 480;
 	float aspect;
 
 	// Texturing:
 	std::shared_ptr<Texture> currentTexture;
-	float dudx, dudy, dvdx, dvdy; // partial derivatives of U/V coordinates with respect to X/Y pixel's screen coordinates
+
+	std::shared_ptr<WorkerPool> workerPool; ///< Threads for the tiled rasterization. Created on the first tiled render, then re-used.
+
+	static const int tileSize = 32; ///< Width and height of a screen tile in pixels, used for the tiled rasterization
+
+	// Buffers that are re-used by every call to render(...), so
+	// that rendering a mesh doesn't allocate once they are warm:
+	std::vector<Vertex> clipSpaceVertices;
+	std::vector<TriangleToRasterize> trisToRaster;
+
+	// (Re-)allocates the colour- and depth-buffer if the viewport or the
+	// rasterizer changed, and clears them in place otherwise.
+	void clearRenderTargets();
+
+	// Vertex shader: Transforms all vertices with the mvp matrix into clip
+	// space, writing to clipSpaceVertices. Colour and texture coordinates
+	// are copied. If vertexPositions is not empty, the positions are taken
+	// from there (xyzxyz...) instead of from the vertices.
+	void transformVertices(const std::vector<Vertex>& vertices, const cv::Mat& mvp, const cv::Mat& vertexPositions = cv::Mat());
+
+	// Vertex shader for a mesh instance: Like above, but the positions,
+	// colours and texture coordinates are read from its vertex buffers.
+	void transformVertices(const MeshInstance& mesh, const cv::Mat& mvp);
+
+	// Rasterizes trisToRaster into the colour- and depth-buffer.
+	void rasterTriangles();
+
+	// Clears the depth- and triangle-ID buffer and rasterizes trisToRaster
+	// into them, see renderTriangleIds(...).
+	void rasterTriangleIds(std::size_t numTriangles, std::vector<int>* numCoveredPixels);
+
+	// Clips the triangles (given by indices into clipSpaceVertices) against
+	// the frustum, does the w-division and viewport transform and writes the
+	// result to trisToRaster.
+	void processTriangles(const std::vector<std::array<int, 3>>& triangleVertexIndices);
 
 	// Todo: Split this function into the general (core-part) and the texturing part.
 	// Then, utils::extractTexture can re-use the core-part.
@@ -73,17 +149,37 @@ private:
 
 	void rasterTriangle(TriangleToRasterize triangle);
 
+	// Rasterizes the triangle into the depth- and triangle-ID buffer.
+	// Returns the number of pixels it covers before the depth-test.
+	int rasterTriangleId(const TriangleToRasterize& t);
+
+	// Bins the triangles into tiles of tileSize x tileSize pixels and
+	// rasterizes the tiles in parallel on the worker pool. Each tile keeps
+	// the submission order of its triangles, so the result is the same as
+	// rasterizing them one after another.
+	void rasterTrianglesTiled(std::vector<TriangleToRasterize>& triangles);
+
+	// Rasterizes the part of the triangle that overlaps the given (inclusive)
+	// pixel rectangle of a tile. Processes the pixels in quads of 4, with
+	// the edge functions stepped from the start of each row.
+	void rasterTriangleInTile(const TriangleToRasterize& t, int tileMinX, int tileMaxX, int tileMinY, int tileMaxY);
+
+	// Pixel shader: Returns the RGB colour of a fragment with the given
+	// perspective-correct barycentric weights at pixel-center (x, y).
+	cv::Vec3f shadePixel(const TriangleToRasterize& t, double alpha, double beta, double gamma, float x, float y) const;
+
 	std::vector<Vertex> clipPolygonToPlaneIn4D(const std::vector<Vertex>& vertices, const cv::Vec4f& planeNormal);
 
-	cv::Vec3f tex2D(const cv::Vec2f& texCoord);
+	// dudx, dudy, dvdx, dvdy: partial derivatives of U/V coordinates with respect to X/Y pixel's screen coordinates
+	cv::Vec3f tex2D(const cv::Vec2f& texCoord, float dudx, float dudy, float dvdx, float dvdy) const;
 
-	cv::Vec3f tex2D_linear_mipmap_linear(const cv::Vec2f& texCoord);
+	cv::Vec3f tex2D_linear_mipmap_linear(const cv::Vec2f& texCoord, float dudx, float dudy, float dvdx, float dvdy) const;
 
-	cv::Vec2f texCoord_wrap(const cv::Vec2f& texCoord);
+	cv::Vec2f texCoord_wrap(const cv::Vec2f& texCoord) const;
 
-	cv::Vec3f tex2D_linear(const cv::Vec2f& imageTexCoord, unsigned char mipmapIndex);
+	cv::Vec3f tex2D_linear(const cv::Vec2f& imageTexCoord, unsigned char mipmapIndex) const;
 
-	float clamp(float x, float a, float b); // Todo: Document! x, a, b?
+	float clamp(float x, float a, float b) const; // Todo: Document! x, a, b?
 };
 
  } /* namespace render */
@@ -22,6 +22,11 @@ public:
 
 	void createFromFile(const std::string& fileName, unsigned int mipmapsNum = 0);
 
+	// Creates the texture from an image that is already in memory (e.g. an
+	// extracted isomap), so it doesn't have to be written and read back.
+	// The image is BGR (CV_8UC3) or BGRA (CV_8UC4).
+	void createFromImage(cv::Mat image, unsigned int mipmapsNum = 0);
+
 	std::vector<cv::Mat> mipmaps;	// make Texture a friend class of renderer, then move this to private?
 	unsigned char widthLog, heightLog; // log2 of width and height of the base mip-level
 
@@ -132,7 +132,7 @@ struct TriangleToRasterize
 	int tileMaxX;
 	int tileMinY;
 	int tileMaxY;
-	int padding[1];
+	int triangleIndex; ///< Index into Mesh::tvi of the triangle this one was created from (it might have been split by the clipping)
 
 	bool coversTile(int tileX, int tileY)
 	{
@@ -0,0 +1,87 @@
+/*
+ * WorkerPool.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+#pragma once
+
+#ifndef WORKERPOOL_HPP_
+#define WORKERPOOL_HPP_
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace render {
+
+/**
+ * A fixed set of threads that is started once and then re-used to
+ * process batches of independent tasks, so that e.g. rendering a frame
+ * doesn't have to create and join threads. The thread calling run(...)
+ * works on the batch as well.
+ *
+ * Calls to run(...) from different threads are processed one after
+ * another. run(...) must not be called from within a task of the same
+ * pool.
+ */
+class WorkerPool
+{
+public:
+	/**
+	 * Starts the worker threads.
+	 *
+	 * @param[in] numThreads Number of threads that process a batch, including the one calling run(...). 0 means std::thread::hardware_concurrency().
+	 */
+	explicit WorkerPool(unsigned int numThreads = 0);
+
+	/**
+	 * Stops and joins the worker threads.
+	 */
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool& other) = delete;
+	WorkerPool& operator=(const WorkerPool& other) = delete;
+
+	/**
+	 * @return The number of threads that process a batch, including the one calling run(...).
+	 */
+	unsigned int getNumThreads() const;
+
+	/**
+	 * Calls task(i) for every i in [0, numTasks) and returns once all of
+	 * them have finished. The tasks are distributed dynamically across the
+	 * threads, so they may run in any order and concurrently. If a task
+	 * throws, the remaining tasks are still processed and the first
+	 * exception is re-thrown afterwards.
+	 *
+	 * @param[in] numTasks The number of tasks.
+	 * @param[in] task The function to call with the index of each task.
+	 */
+	void run(int numTasks, const std::function<void(int)>& task);
+
+private:
+	void work(); ///< Main loop of a worker thread.
+	void processTasks(); ///< Processes tasks of the current batch until there are none left.
+
+	std::vector<std::thread> threads; ///< The worker threads, not including the thread calling run(...).
+	std::mutex runMutex; ///< Serialises calls to run(...).
+	std::mutex batchMutex; ///< Guards the state of the current batch.
+	std::condition_variable batchStarted; ///< Notified when a batch starts or the pool stops.
+	std::condition_variable batchFinished; ///< Notified when the last worker finished its part of a batch.
+	const std::function<void(int)>* task = nullptr; ///< The task of the current batch.
+	int numTasks = 0; ///< Number of tasks of the current batch.
+	std::atomic<int> nextTask; ///< Index of the next task of the current batch that is not yet taken.
+	unsigned long batch = 0; ///< Incremented with every batch, so that the workers process each one once.
+	unsigned int numBusyThreads = 0; ///< Number of worker threads still working on the current batch.
+	bool stopping = false; ///< Whether the worker threads should terminate.
+	std::exception_ptr error; ///< The first exception thrown by a task of the current batch.
+};
+
+} /* namespace render */
+
+#endif /* WORKERPOOL_HPP_ */
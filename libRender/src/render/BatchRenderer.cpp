@@ -0,0 +1,100 @@
+/*
+ * BatchRenderer.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "render/BatchRenderer.hpp"
+
+#include <stdexcept>
+
+using cv::Mat;
+using std::pair;
+using std::vector;
+
+namespace render {
+
+BatchRenderer::BatchRenderer(unsigned int viewportWidth, unsigned int viewportHeight, unsigned int numThreads) : viewportWidth(viewportWidth), viewportHeight(viewportHeight), workerPool(std::make_shared<WorkerPool>(numThreads))
+{
+}
+
+vector<pair<Mat, Mat>> BatchRenderer::render(const Mesh& mesh, const vector<Mat>& mvps)
+{
+	return render(mesh, mvps, vector<Mat>());
+}
+
+vector<pair<Mat, Mat>> BatchRenderer::render(const Mesh& mesh, const vector<Mat>& mvps, const vector<Mat>& vertexPositions)
+{
+	if (!vertexPositions.empty() && vertexPositions.size() != mvps.size()) {
+		throw std::runtime_error("BatchRenderer: The number of vertex positions has to be zero or equal to the number of mvp matrices.");
+	}
+	vector<View> views(mvps.size());
+	for (size_t i = 0; i < mvps.size(); ++i) {
+		views[i].mesh = &mesh;
+		views[i].mvp = mvps[i];
+		if (!vertexPositions.empty()) {
+			views[i].vertexPositions = vertexPositions[i];
+		}
+	}
+	return renderViews(views);
+}
+
+vector<vector<pair<Mat, Mat>>> BatchRenderer::render(const vector<Mesh>& meshes, const vector<vector<Mat>>& mvps)
+{
+	return renderMeshes(meshes, mvps);
+}
+
+vector<vector<pair<Mat, Mat>>> BatchRenderer::render(const vector<MeshInstance>& meshes, const vector<vector<Mat>>& mvps)
+{
+	return renderMeshes(meshes, mvps);
+}
+
+template<class MeshType>
+vector<vector<pair<Mat, Mat>>> BatchRenderer::renderMeshes(const vector<MeshType>& meshes, const vector<vector<Mat>>& mvps)
+{
+	if (meshes.size() != mvps.size()) {
+		throw std::runtime_error("BatchRenderer: The number of meshes has to be equal to the number of lists of mvp matrices.");
+	}
+	vector<View> views;
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		for (const auto& mvp : mvps[i]) {
+			View view;
+			view.setMesh(meshes[i]);
+			view.mvp = mvp;
+			views.push_back(view);
+		}
+	}
+	vector<pair<Mat, Mat>> framebuffers = renderViews(views);
+
+	vector<vector<pair<Mat, Mat>>> framebuffersPerMesh(meshes.size());
+	auto framebuffer = framebuffers.begin();
+	for (size_t i = 0; i < meshes.size(); ++i) {
+		framebuffersPerMesh[i].assign(framebuffer, framebuffer + mvps[i].size());
+		framebuffer += mvps[i].size();
+	}
+	return framebuffersPerMesh;
+}
+
+vector<pair<Mat, Mat>> BatchRenderer::renderViews(const vector<View>& views)
+{
+	while (renderers.size() < views.size()) {
+		renderers.emplace_back(viewportWidth, viewportHeight);
+	}
+	vector<pair<Mat, Mat>> framebuffers(views.size());
+	workerPool->run(static_cast<int>(views.size()), [&](int index) {
+		const View& view = views[index];
+		SoftwareRenderer& renderer = renderers[index];
+		renderer.doBackfaceCulling = doBackfaceCulling;
+		renderer.enableTexturing(doTexturing);
+		renderer.setCurrentTexture(currentTexture);
+		if (view.meshInstance) {
+			framebuffers[index] = renderer.render(*view.meshInstance, view.mvp);
+		} else {
+			framebuffers[index] = renderer.render(*view.mesh, view.mvp, view.vertexPositions);
+		}
+	});
+	return framebuffers;
+}
+
+} /* namespace render */
@@ -0,0 +1,207 @@
+/*
+ * MeshExport.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "render/MeshExport.hpp"
+
+#include "opencv2/highgui/highgui.hpp"
+
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+using cv::Mat;
+using std::string;
+using std::vector;
+using std::min;
+using std::max;
+
+namespace render {
+	namespace utils {
+
+namespace {
+
+// Returns the part of the path after the last (back-)slash.
+string getFilename(const string& path)
+{
+	string::size_type separator = path.find_last_of("/\\");
+	return separator == string::npos ? path : path.substr(separator + 1);
+}
+
+// Replaces the extension of the filename (if any) with the given one (including the dot).
+string replaceExtension(const string& path, const string& extension)
+{
+	string::size_type dot = path.find_last_of('.');
+	string::size_type separator = path.find_last_of("/\\");
+	if (dot == string::npos || (separator != string::npos && dot < separator)) {
+		return path + extension;
+	}
+	return path.substr(0, dot) + extension;
+}
+
+// Writes the whole buffer to the file with a single write.
+void writeFile(const string& filename, const char* data, size_t size)
+{
+	std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+	if (!file.is_open()) {
+		throw std::runtime_error("MeshExport: Could not open " + filename + " for writing.");
+	}
+	file.write(data, size);
+	if (!file) {
+		throw std::runtime_error("MeshExport: Error while writing " + filename + ".");
+	}
+}
+
+// Appends the printf-formatted text to the buffer, without going through a stream.
+template<typename... Args>
+void append(string& buffer, const char* format, Args... args)
+{
+	char line[256];
+	int length = std::snprintf(line, sizeof(line), format, args...);
+	buffer.append(line, min(static_cast<size_t>(max(length, 0)), sizeof(line) - 1));
+}
+
+// Appends the value in little-endian byte order, independent of the platform.
+void appendLittleEndian(string& buffer, std::uint32_t value)
+{
+	char bytes[4] = { static_cast<char>(value & 0xff), static_cast<char>((value >> 8) & 0xff), static_cast<char>((value >> 16) & 0xff), static_cast<char>((value >> 24) & 0xff) };
+	buffer.append(bytes, 4);
+}
+
+void appendLittleEndian(string& buffer, float value)
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	appendLittleEndian(buffer, bits);
+}
+
+unsigned char toByte(float color)
+{
+	return static_cast<unsigned char>(255.0f * min(max(color, 0.0f), 1.0f) + 0.5f);
+}
+
+// Formats the OBJ file (and the .mtl file if there's a texture) into the buffers.
+void formatObj(const Mesh& mesh, const string& mtlFilename, const string& textureFilename, string& obj, string& mtl)
+{
+	const bool writeTexture = mesh.hasTexture && !textureFilename.empty();
+	obj.clear();
+	obj.reserve(mesh.vertex.size() * (writeTexture ? 96 : 72) + mesh.tvi.size() * (writeTexture ? 48 : 24));
+	if (writeTexture) {
+		append(obj, "mtllib %s\n", getFilename(mtlFilename).c_str());
+	}
+	for (const auto& v : mesh.vertex) {
+		append(obj, "v %g %g %g %g %g %g \n", v.position[0], v.position[1], v.position[2], v.color[0], v.color[1], v.color[2]);
+	}
+	if (writeTexture) {
+		for (const auto& v : mesh.vertex) {
+			append(obj, "vt %g %g\n", v.texcrd[0], 1.0f - v.texcrd[1]); // The texture coordinates are in image coordinates, OBJ's origin is bottom-left
+		}
+		obj.append("usemtl FaceTexture\n");
+	}
+	// obj starts counting triangles at 1
+	for (const auto& t : mesh.tvi) {
+		if (writeTexture) {
+			append(obj, "f %d/%d %d/%d %d/%d\n", t[0] + 1, t[0] + 1, t[1] + 1, t[1] + 1, t[2] + 1, t[2] + 1);
+		}
+		else {
+			append(obj, "f %d %d %d\n", t[0] + 1, t[1] + 1, t[2] + 1);
+		}
+	}
+	mtl.clear();
+	if (writeTexture) {
+		mtl = "newmtl FaceTexture\nmap_Kd " + textureFilename + "\n";
+	}
+}
+
+// Formats the binary PLY file into the buffer.
+void formatPlyBinary(const Mesh& mesh, const string& textureFilename, string& ply)
+{
+	const bool writeTexcrd = mesh.hasTexture;
+	ply.clear();
+	ply.reserve(512 + mesh.vertex.size() * (writeTexcrd ? 23 : 15) + mesh.tvi.size() * 13);
+	ply.append("ply\nformat binary_little_endian 1.0\n");
+	if (writeTexcrd && !textureFilename.empty()) {
+		ply.append("comment TextureFile " + textureFilename + "\n");
+	}
+	append(ply, "element vertex %u\n", static_cast<unsigned int>(mesh.vertex.size()));
+	ply.append("property float x\nproperty float y\nproperty float z\n");
+	ply.append("property uchar red\nproperty uchar green\nproperty uchar blue\n");
+	if (writeTexcrd) {
+		ply.append("property float texture_u\nproperty float texture_v\n");
+	}
+	append(ply, "element face %u\n", static_cast<unsigned int>(mesh.tvi.size()));
+	ply.append("property list uchar int vertex_indices\nend_header\n");
+	for (const auto& v : mesh.vertex) {
+		appendLittleEndian(ply, v.position[0]);
+		appendLittleEndian(ply, v.position[1]);
+		appendLittleEndian(ply, v.position[2]);
+		ply.push_back(static_cast<char>(toByte(v.color[0])));
+		ply.push_back(static_cast<char>(toByte(v.color[1])));
+		ply.push_back(static_cast<char>(toByte(v.color[2])));
+		if (writeTexcrd) {
+			appendLittleEndian(ply, v.texcrd[0]);
+			appendLittleEndian(ply, 1.0f - v.texcrd[1]);
+		}
+	}
+	for (const auto& t : mesh.tvi) {
+		ply.push_back(3);
+		appendLittleEndian(ply, static_cast<std::uint32_t>(t[0]));
+		appendLittleEndian(ply, static_cast<std::uint32_t>(t[1]));
+		appendLittleEndian(ply, static_cast<std::uint32_t>(t[2]));
+	}
+}
+
+// Writes the formatted mesh, with the given texture filename written into the file as given.
+void writeMesh(const Mesh& mesh, const string& filename, const string& textureFilename, MeshFileFormat format)
+{
+	string buffer;
+	if (format == MeshFileFormat::PlyBinary) {
+		formatPlyBinary(mesh, textureFilename, buffer);
+		writeFile(filename, buffer.data(), buffer.size());
+	}
+	else {
+		string mtlFilename = replaceExtension(filename, ".mtl");
+		string mtl;
+		formatObj(mesh, mtlFilename, textureFilename, buffer, mtl);
+		writeFile(filename, buffer.data(), buffer.size());
+		if (!mtl.empty()) {
+			writeFile(mtlFilename, mtl.data(), mtl.size());
+		}
+	}
+}
+
+} /* unnamed namespace */
+
+void writeObj(const Mesh& mesh, const string& filename, const string& textureFilename)
+{
+	writeMesh(mesh, filename, textureFilename, MeshFileFormat::Obj);
+}
+
+void writePlyBinary(const Mesh& mesh, const string& filename, const string& textureFilename)
+{
+	writeMesh(mesh, filename, textureFilename, MeshFileFormat::PlyBinary);
+}
+
+void writeMeshAndTexture(const Mesh& mesh, const string& meshFilename, Mat texture, const string& textureFilename, MeshFileFormat format, int pngCompression)
+{
+	// Encoding the texture is the expensive part, so we do it while the mesh is formatted and written:
+	std::future<vector<uchar>> encodedTexture = std::async(std::launch::async, [texture, pngCompression]() {
+		vector<uchar> encoded;
+		vector<int> params{ cv::IMWRITE_PNG_COMPRESSION, pngCompression };
+		cv::imencode(".png", texture, encoded, params);
+		return encoded;
+	});
+	writeMesh(mesh, meshFilename, getFilename(textureFilename), format);
+	vector<uchar> encoded = encodedTexture.get();
+	writeFile(textureFilename, reinterpret_cast<const char*>(encoded.data()), encoded.size());
+}
+
+	} /* namespace utils */
+} /* namespace render */
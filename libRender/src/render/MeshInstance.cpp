@@ -0,0 +1,88 @@
+/*
+ * MeshInstance.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "render/MeshInstance.hpp"
+
+using cv::Mat;
+using cv::Vec2f;
+using cv::Vec3f;
+using cv::Vec4f;
+using std::shared_ptr;
+using std::make_shared;
+
+namespace render {
+
+MeshInstance::MeshInstance(shared_ptr<const MeshTopology> topology)
+{
+	setTopology(topology);
+}
+
+void MeshInstance::setTopology(shared_ptr<const MeshTopology> topology)
+{
+	this->topology = topology;
+	const int numValues = topology ? 3 * static_cast<int>(topology->numVertices) : 0;
+	// Mat::create() is a no-op if the size and type match:
+	positions.create(numValues, 1, CV_32FC1);
+	colors.create(numValues, 1, CV_32FC1);
+}
+
+MeshInstance MeshInstance::clone() const
+{
+	MeshInstance instance;
+	instance.topology = topology;
+	instance.positions = positions.clone();
+	instance.colors = colors.clone();
+	return instance;
+}
+
+Mesh MeshInstance::toMesh() const
+{
+	Mesh mesh;
+	if (!topology) {
+		return mesh;
+	}
+	mesh.tvi = topology->tvi;
+	mesh.tci = topology->tci;
+	const float* position = positions.ptr<float>();
+	const float* color = colors.ptr<float>();
+	mesh.vertex.resize(topology->numVertices);
+	for (unsigned int i = 0; i < topology->numVertices; ++i) {
+		mesh.vertex[i].position = Vec4f(position[3 * i + 0], position[3 * i + 1], position[3 * i + 2], 1.0f);
+		mesh.vertex[i].color = Vec3f(color[3 * i + 0], color[3 * i + 1], color[3 * i + 2]);
+		if (!topology->texcrd.empty()) {
+			mesh.vertex[i].texcrd = topology->texcrd[i];
+		}
+	}
+	mesh.hasTexture = !topology->texcrd.empty(); // Like MorphableModel::drawSample(...): It only has texture coordinates.
+	return mesh;
+}
+
+MeshInstance MeshInstance::fromMesh(const Mesh& mesh)
+{
+	shared_ptr<MeshTopology> topology = make_shared<MeshTopology>();
+	topology->numVertices = static_cast<unsigned int>(mesh.vertex.size());
+	topology->tvi = mesh.tvi;
+	topology->tci = mesh.tci;
+	if (mesh.hasTexture) {
+		topology->texcrd.reserve(mesh.vertex.size());
+		for (const auto& v : mesh.vertex) {
+			topology->texcrd.push_back(v.texcrd);
+		}
+	}
+	MeshInstance instance(topology);
+	float* position = instance.positions.ptr<float>();
+	float* color = instance.colors.ptr<float>();
+	for (size_t i = 0; i < mesh.vertex.size(); ++i) {
+		for (int k = 0; k < 3; ++k) {
+			position[3 * i + k] = mesh.vertex[i].position[k];
+			color[3 * i + k] = mesh.vertex[i].color[k];
+		}
+	}
+	return instance;
+}
+
+} /* namespace render */
@@ -6,12 +6,14 @@
  */
 
 #include "render/MeshUtils.hpp"
+#include "render/SoftwareRenderer.hpp"
 #include "render/utils.hpp"
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
 
 #include <array>
+#include <stdexcept>
 #include <iostream>
 #include <fstream>
 
@@ -19,6 +21,7 @@ using cv::Mat;
 using cv::Point2f;
 using cv::Vec2f;
 using cv::Scalar;
+using std::vector;
 
 namespace render {
 	namespace utils {
@@ -271,175 +274,215 @@ bool MeshUtils::isPointInTriangle(cv::Point2f point, cv::Point2f triV0, cv::Poin
 	return (u >= 0) && (v >= 0) && (u + v < 1);
 }
 
+// Samples the image at the (sub-pixel) position (x, y) with bilinear interpolation.
+// Positions outside the image are clamped to the border.
+static cv::Vec3b sampleBilinear(const Mat& image, float x, float y)
+{
+	const int x0 = cvFloor(x);
+	const int y0 = cvFloor(y);
+	const float ax = x - x0;
+	const float ay = y - y0;
+	const cv::Vec3b* row0 = image.ptr<cv::Vec3b>(std::min(std::max(y0, 0), image.rows - 1));
+	const cv::Vec3b* row1 = image.ptr<cv::Vec3b>(std::min(std::max(y0 + 1, 0), image.rows - 1));
+	const int c0 = std::min(std::max(x0, 0), image.cols - 1);
+	const int c1 = std::min(std::max(x0 + 1, 0), image.cols - 1);
+	cv::Vec3b result;
+	for (int c = 0; c < 3; ++c) {
+		float top = (1.0f - ax) * row0[c0][c] + ax * row0[c1][c];
+		float bottom = (1.0f - ax) * row1[c0][c] + ax * row1[c1][c];
+		result[c] = cv::saturate_cast<uchar>((1.0f - ay) * top + ay * bottom);
+	}
+	return result;
+}
+
+// Cubic convolution weights for the 4 taps around a sample with fractional part t.
+// Uses a = -0.75, the same kernel as OpenCV's INTER_CUBIC.
+static void cubicWeights(float t, float weights[4])
+{
+	const float a = -0.75f;
+	weights[0] = ((a*(t + 1) - 5*a)*(t + 1) + 8*a)*(t + 1) - 4*a;
+	weights[1] = ((a + 2)*t - (a + 3))*t*t + 1;
+	weights[2] = ((a + 2)*(1 - t) - (a + 3))*(1 - t)*(1 - t) + 1;
+	weights[3] = 1.0f - weights[0] - weights[1] - weights[2];
+}
+
+// Samples the image at the (sub-pixel) position (x, y) with bicubic interpolation.
+// Positions outside the image are clamped to the border.
+static cv::Vec3b sampleBicubic(const Mat& image, float x, float y)
+{
+	const int x0 = cvFloor(x);
+	const int y0 = cvFloor(y);
+	float wx[4], wy[4];
+	cubicWeights(x - x0, wx);
+	cubicWeights(y - y0, wy);
+	int cols[4];
+	for (int i = 0; i < 4; ++i) {
+		cols[i] = std::min(std::max(x0 - 1 + i, 0), image.cols - 1);
+	}
+	float sum[3] = { 0.0f, 0.0f, 0.0f };
+	for (int j = 0; j < 4; ++j) {
+		const cv::Vec3b* row = image.ptr<cv::Vec3b>(std::min(std::max(y0 - 1 + j, 0), image.rows - 1));
+		for (int i = 0; i < 4; ++i) {
+			const float w = wx[i] * wy[j];
+			sum[0] += w * row[cols[i]][0];
+			sum[1] += w * row[cols[i]][1];
+			sum[2] += w * row[cols[i]][2];
+		}
+	}
+	return cv::Vec3b(cv::saturate_cast<uchar>(sum[0]), cv::saturate_cast<uchar>(sum[1]), cv::saturate_cast<uchar>(sum[2]));
+}
+
 // image: where to extract the texture from
 // note: framebuffer should have size of the image (ok not necessarily. What about mobile?) (well it should, to get optimal quality (and everywhere the same quality)?)
 // note: mvpMatrix: Atm working with a 4x4 (full) affine. But anything would work, just take care with the w-division.
-// Regarding the depth-buffer: We could also pass an instance of a Renderer here. Depending on how "stateful" the renderer is, this might make more sense.
-Mat extractTexture(Mesh mesh, Mat mvpMatrix, int viewportWidth, int viewportHeight, Mat image, Mat depthBuffer) {
-	// optional param Mat textureMap = Mat(512, 512, CV_8UC3) ?
+Mat extractTexture(const Mesh& mesh, Mat mvpMatrix, int viewportWidth, int viewportHeight, Mat image, int isomapResolution/*=512*/, TextureInterpolation interpolation/*=TextureInterpolation::Bicubic*/) {
+	TextureExtractor extractor;
+	return extractor.extract(mesh, mvpMatrix, viewportWidth, viewportHeight, image, isomapResolution, interpolation);
+}
+
+TextureExtractor::TextureExtractor(unsigned int numThreads) : workerPool(std::make_shared<WorkerPool>(numThreads))
+{
+}
+
+Mat TextureExtractor::extract(const Mesh& mesh, Mat mvpMatrix, int viewportWidth, int viewportHeight, Mat image, int isomapResolution/*=512*/, TextureInterpolation interpolation/*=TextureInterpolation::Bicubic*/) {
+	vector<int> numCoveredPixels;
+	Mat triangleIds = getVisibilityRenderer(viewportWidth, viewportHeight).renderTriangleIds(mesh, mvpMatrix, &numCoveredPixels);
+
+	// Transform every vertex to screen space once:
+	const cv::Matx44f mvp(mvpMatrix);
+	vector<Point2f> screenPoints(mesh.vertex.size());
+	vector<Vec2f> texcrd(mesh.vertex.size());
+	for (size_t i = 0; i < mesh.vertex.size(); ++i) {
+		const cv::Vec4f& p = mesh.vertex[i].position;
+		cv::Vec4f res = mvp * cv::Vec4f(p[0], p[1], p[2], 1.0f);
+		res /= res[3];
+		screenPoints[i] = clipToScreenSpace(Vec2f(res[0], res[1]), viewportWidth, viewportHeight);
+		texcrd[i] = mesh.vertex[i].texcrd;
+	}
+	return extractVisibleTriangles(mesh.tvi, texcrd, screenPoints, triangleIds, numCoveredPixels, image, isomapResolution, interpolation);
+}
+
+Mat TextureExtractor::extract(const MeshInstance& mesh, Mat mvpMatrix, int viewportWidth, int viewportHeight, Mat image, int isomapResolution/*=512*/, TextureInterpolation interpolation/*=TextureInterpolation::Bicubic*/) {
+	// renderTriangleIds() checks the topology and the size of the vertex buffers:
+	vector<int> numCoveredPixels;
+	Mat triangleIds = getVisibilityRenderer(viewportWidth, viewportHeight).renderTriangleIds(mesh, mvpMatrix, &numCoveredPixels);
+	const MeshTopology& topology = *mesh.topology;
+	if (topology.texcrd.size() != topology.numVertices) {
+		throw std::runtime_error("TextureExtractor: The mesh instance has no texture coordinates.");
+	}
+
+	// Transform every vertex to screen space once:
+	const cv::Matx44f mvp(mvpMatrix);
+	const Mat positionData = mesh.positions.isContinuous() ? mesh.positions : mesh.positions.clone();
+	const float* positions = positionData.ptr<float>();
+	vector<Point2f> screenPoints(topology.numVertices);
+	for (size_t i = 0; i < topology.numVertices; ++i) {
+		const float* p = positions + 3 * i;
+		cv::Vec4f res = mvp * cv::Vec4f(p[0], p[1], p[2], 1.0f);
+		res /= res[3];
+		screenPoints[i] = clipToScreenSpace(Vec2f(res[0], res[1]), viewportWidth, viewportHeight);
+	}
+	return extractVisibleTriangles(topology.tvi, topology.texcrd, screenPoints, triangleIds, numCoveredPixels, image, isomapResolution, interpolation);
+}
+
+SoftwareRenderer& TextureExtractor::getVisibilityRenderer(int viewportWidth, int viewportHeight) {
+	if (!visibilityRenderer || viewportWidth != this->viewportWidth || viewportHeight != this->viewportHeight) {
+		visibilityRenderer.reset(new SoftwareRenderer(viewportWidth, viewportHeight));
+		visibilityRenderer->doBackfaceCulling = true;
+		this->viewportWidth = viewportWidth;
+		this->viewportHeight = viewportHeight;
+	}
+	return *visibilityRenderer;
+}
+
+Mat TextureExtractor::extractVisibleTriangles(const vector<std::array<int, 3>>& tvi, const vector<Vec2f>& texcrd, const vector<Point2f>& screenPoints, const Mat& triangleIds, const vector<int>& numCoveredPixels, Mat image, int isomapResolution, TextureInterpolation interpolation) {
 	//Mat textureMap(512, 512, inputImage.type());
-	Mat textureMap = Mat::zeros(512, 512, CV_8UC3); // We don't want an alpha channel. We might want to handle grayscale input images though.
-	Mat visibilityMask = Mat::zeros(512, 512, CV_8UC3);
-
-	for (const auto& triangleIndices : mesh.tvi) {
-
-		// Find out if the current triangle is visible:
-		// We do a second rendering-pass here. We use the depth-buffer of the final image, and then, here,
-		// check if each pixel in a triangle is visible. If the whole triangle is visible, we use it to extract
-		// the texture.
-		// Possible improvement: - If only part of the triangle is visible, split it
-		// - Share more code with the renderer?
-		Vertex v0_3d = mesh.vertex[triangleIndices[0]];
-		Vertex v1_3d = mesh.vertex[triangleIndices[1]];
-		Vertex v2_3d = mesh.vertex[triangleIndices[2]];
-
-		Vertex v0, v1, v2; // we don't copy the color and texcoords, we only do the visibility check here.
-		// This could be optimized in 2 ways though:
-		// - Use render(), or as in render(...), transfer the vertices once, not in a loop over all triangles (vertices are getting transformed multiple times)
-		// - We transform them later (below) a second time. Only do it once.
-		v0.position = Mat(mvpMatrix * Mat(v0_3d.position));
-		v1.position = Mat(mvpMatrix * Mat(v1_3d.position));
-		v2.position = Mat(mvpMatrix * Mat(v2_3d.position));
-
-		// Well, in in principle, we'd have to do the whole stuff as in render(), like
-		// clipping against the frustums etc.
-		// But as long as our model is fully on the screen, we're fine.
-
-		// divide by w
-		// if ortho, we can do the divide as well, it will just be a / 1.0f.
-		v0.position = v0.position / v0.position[3];
-		v1.position = v1.position / v1.position[3];
-		v2.position = v2.position / v2.position[3];
-
-		// Todo: This is all very similar to processProspectiveTri(...), except the other function does texturing stuff as well. Remove code duplication!
-		Vec2f v0_clip = clipToScreenSpace(Vec2f(v0.position[0], v0.position[1]), viewportWidth, viewportHeight);
-		Vec2f v1_clip = clipToScreenSpace(Vec2f(v1.position[0], v1.position[1]), viewportWidth, viewportHeight);
-		Vec2f v2_clip = clipToScreenSpace(Vec2f(v2.position[0], v2.position[1]), viewportWidth, viewportHeight);
-		v0.position[0] = v0_clip[0]; v0.position[1] = v0_clip[1];
-		v1.position[0] = v1_clip[0]; v1.position[1] = v1_clip[1];
-		v2.position[0] = v2_clip[0]; v2.position[1] = v2_clip[1];
-		
-		//if (doBackfaceCulling) {
-			if (!areVerticesCCWInScreenSpace(v0, v1, v2))
-				continue;
-		//}
-
-		cv::Rect bbox = calculateBoundingBox(v0, v1, v2, viewportWidth, viewportHeight);
-		int minX = bbox.x;
-		int maxX = bbox.x + bbox.width;
-		int minY = bbox.y;
-		int maxY = bbox.y + bbox.height;
-
-		//if (t.maxX <= t.minX || t.maxY <= t.minY) 	// Note: Can the width/height of the bbox be negative? Maybe we only need to check for equality here?
-		//	continue;
-
-		bool wholeTriangleIsVisible = true;
-		for (int yi = minY; yi <= maxY; yi++)
-		{
-			for (int xi = minX; xi <= maxX; xi++)
-			{
-				// we want centers of pixels to be used in computations. TODO: Do we?
-				float x = (float)xi + 0.5f;
-				float y = (float)yi + 0.5f;
-				// these will be used for barycentric weights computation
-				double one_over_v0ToLine12 = 1.0 / utils::implicitLine(v0.position[0], v0.position[1], v1.position, v2.position);
-				double one_over_v1ToLine20 = 1.0 / utils::implicitLine(v1.position[0], v1.position[1], v2.position, v0.position);
-				double one_over_v2ToLine01 = 1.0 / utils::implicitLine(v2.position[0], v2.position[1], v0.position, v1.position);
-				// affine barycentric weights
-				double alpha = utils::implicitLine(x, y, v1.position, v2.position) * one_over_v0ToLine12;
-				double beta = utils::implicitLine(x, y, v2.position, v0.position) * one_over_v1ToLine20;
-				double gamma = utils::implicitLine(x, y, v0.position, v1.position) * one_over_v2ToLine01;
-				// if pixel (x, y) is inside the triangle or on one of its edges
-				if (alpha >= 0 && beta >= 0 && gamma >= 0)
-				{
-					double z_affine = alpha*(double)v0.position[2] + beta*(double)v1.position[2] + gamma*(double)v2.position[2];
-					// The '<= 1.0' clips against the far-plane in NDC. We clip against the near-plane earlier.
-					if (z_affine < depthBuffer.at<double>(yi, xi)/* && z_affine <= 1.0*/) {
-						wholeTriangleIsVisible = false;
-						break;
-					}
-					else {
-						
-					}
-				}
-			}
-			if (!wholeTriangleIsVisible) {
-				break;
+	Mat textureMap = Mat::zeros(isomapResolution, isomapResolution, CV_8UC3); // We don't want an alpha channel. We might want to handle grayscale input images though.
+
+	// Find out which triangles are visible:
+	// We did one visibility pass that stores the index of the front-most triangle in every pixel.
+	// A triangle is completely visible if it still owns all the pixels it covers. Thanks to the
+	// fill rule of the visibility pass, neighbouring triangles don't cover the same pixels.
+	// Possible improvement: - If only part of the triangle is visible, split it
+	vector<int> numVisiblePixels(tvi.size(), 0);
+	for (int y = 0; y < triangleIds.rows; ++y) {
+		const int* idRow = triangleIds.ptr<int>(y);
+		for (int x = 0; x < triangleIds.cols; ++x) {
+			if (idRow[x] >= 0) {
+				++numVisiblePixels[idRow[x]];
 			}
 		}
+	}
 
-		if (!wholeTriangleIsVisible) {
+	// For every visible triangle, we store the triangle in the texture map and
+	// the affine transform from the texture map back to the source image:
+	struct TriangleToExtract {
+		cv::Point2f dstTri[3];
+		cv::Matx<double, 2, 3> dstToSrc;
+	};
+	vector<TriangleToExtract> trianglesToExtract;
+	for (size_t triangleIndex = 0; triangleIndex < tvi.size(); ++triangleIndex) {
+		if (numCoveredPixels[triangleIndex] < 0 || numVisiblePixels[triangleIndex] != numCoveredPixels[triangleIndex]) {
 			continue;
 		}
+		const auto& triangleIndices = tvi[triangleIndex];
 
 		cv::Point2f srcTri[3];
-		cv::Point2f dstTri[3];
-		cv::Vec4f vec(mesh.vertex[triangleIndices[0]].position[0], mesh.vertex[triangleIndices[0]].position[1], mesh.vertex[triangleIndices[0]].position[2], 1.0f);
-		cv::Vec4f res = Mat(mvpMatrix * Mat(vec));
-		res /= res[3];
-		Vec2f screenSpace = utils::clipToScreenSpace(Vec2f(res[0], res[1]), viewportWidth, viewportHeight);
-		srcTri[0] = screenSpace;
-
-		vec = cv::Vec4f(mesh.vertex[triangleIndices[1]].position[0], mesh.vertex[triangleIndices[1]].position[1], mesh.vertex[triangleIndices[1]].position[2], 1.0f);
-		res = Mat(mvpMatrix * Mat(vec));
-		res /= res[3];
-		screenSpace = utils::clipToScreenSpace(Vec2f(res[0], res[1]), viewportWidth, viewportHeight);
-		srcTri[1] = screenSpace;
-
-		vec = cv::Vec4f(mesh.vertex[triangleIndices[2]].position[0], mesh.vertex[triangleIndices[2]].position[1], mesh.vertex[triangleIndices[2]].position[2], 1.0f);
-		res = Mat(mvpMatrix * Mat(vec));
-		res /= res[3];
-		screenSpace = utils::clipToScreenSpace(Vec2f(res[0], res[1]), viewportWidth, viewportHeight);
-		srcTri[2] = screenSpace;
+		TriangleToExtract t;
+		for (int k = 0; k < 3; ++k) {
+			srcTri[k] = screenPoints[triangleIndices[k]];
+			t.dstTri[k] = cv::Point2f(textureMap.cols*texcrd[triangleIndices[k]][0], textureMap.rows*texcrd[triangleIndices[k]][1] - 1.0f);
+		}
 
-		// ROI in the source image:
-		// Todo: Check if the triangle is on screen. If it's outside, we crash here.
-		float src_tri_min_x = std::min(srcTri[0].x, std::min(srcTri[1].x, srcTri[2].x)); // note: might be better to round later (i.e. use the float points for getAffineTransform for a more accurate warping)
+		// Todo: Check if the triangle is on screen. If it's outside, we skip it.
+		float src_tri_min_x = std::min(srcTri[0].x, std::min(srcTri[1].x, srcTri[2].x));
 		float src_tri_max_x = std::max(srcTri[0].x, std::max(srcTri[1].x, srcTri[2].x));
 		float src_tri_min_y = std::min(srcTri[0].y, std::min(srcTri[1].y, srcTri[2].y));
 		float src_tri_max_y = std::max(srcTri[0].y, std::max(srcTri[1].y, srcTri[2].y));
-		// Fix out of range crash when a triangle is (partially?) outside the image borders:
-		//Mat roiImg; // Not finished yet!
 		if (src_tri_min_x < 0 || src_tri_min_y < 0 || src_tri_max_x >= image.cols || src_tri_max_y >= image.rows) {
 			continue;
-		/*	// The feature extraction location is too far near a border. We extend the image (add a black canvas)
-			// and then extract from this larger image.
-			int borderLeft = (x - patchWidthHalf) < 0 ? std::abs(x - patchWidthHalf) : 0; // Our x and y are center.
-			int borderTop = (y - patchWidthHalf) < 0 ? std::abs(y - patchWidthHalf) : 0;
-			int borderRight = (x + patchWidthHalf) >= image.cols ? std::abs(image.cols - (x + patchWidthHalf)) : 0;
-			int borderBottom = (y + patchWidthHalf) >= image.rows ? std::abs(image.rows - (y + patchWidthHalf)) : 0;
-			Mat extendedImage = image.clone();
-			cv::copyMakeBorder(extendedImage, extendedImage, borderTop, borderBottom, borderLeft, borderRight, cv::BORDER_CONSTANT, cv::Scalar(0));
-			cv::Rect roi((x - patchWidthHalf) + borderLeft, (y - patchWidthHalf) + borderTop, patchWidthHalf * 2, patchWidthHalf * 2); // Rect: x y w h. x and y are top-left corner.
-			roiImg = extendedImage(roi).clone(); // clone because we need a continuous memory block
-		*/
+		}
+		// Skip triangles that are degenerate in the texture map, there's no affine transform for them:
+		const cv::Point2f e1 = t.dstTri[1] - t.dstTri[0];
+		const cv::Point2f e2 = t.dstTri[2] - t.dstTri[0];
+		if (std::abs(e1.x * e2.y - e1.y * e2.x) < 1e-6f) {
+			continue;
 		}
 
-		Mat inputImageRoi = image.rowRange(cvFloor(src_tri_min_y), cvCeil(src_tri_max_y)).colRange(cvFloor(src_tri_min_x), cvCeil(src_tri_max_x)); // We round down and up. ROI is possibly larger. But wrong pixels get thrown away later when we check if the point is inside the triangle? Correct?
-		srcTri[0] -= Point2f(src_tri_min_x, src_tri_min_y);
-		srcTri[1] -= Point2f(src_tri_min_x, src_tri_min_y);
-		srcTri[2] -= Point2f(src_tri_min_x, src_tri_min_y); // shift all the points to correspond to the roi
-
-		dstTri[0] = cv::Point2f(textureMap.cols*mesh.vertex[triangleIndices[0]].texcrd[0], textureMap.rows*mesh.vertex[triangleIndices[0]].texcrd[1] - 1.0f);
-		dstTri[1] = cv::Point2f(textureMap.cols*mesh.vertex[triangleIndices[1]].texcrd[0], textureMap.rows*mesh.vertex[triangleIndices[1]].texcrd[1] - 1.0f);
-		dstTri[2] = cv::Point2f(textureMap.cols*mesh.vertex[triangleIndices[2]].texcrd[0], textureMap.rows*mesh.vertex[triangleIndices[2]].texcrd[1] - 1.0f);
-
-		/// Get the Affine Transform
-		Mat warp_mat = getAffineTransform(srcTri, dstTri);
-
-		/// Apply the Affine Transform just found to the src image
-		Mat tmpDstBuffer = Mat::zeros(textureMap.rows, textureMap.cols, image.type()); // I think using the source-size here is not correct. The dst might be larger. We should warp the endpoints and set to max-w/h. No, I think it would be even better to directly warp to the final textureMap size. (so that the last step is only a 1:1 copy)
-		warpAffine(inputImageRoi, tmpDstBuffer, warp_mat, tmpDstBuffer.size(), cv::INTER_CUBIC, cv::BORDER_TRANSPARENT); // last row/col is zeros, depends on interpolation method. Maybe because of rounding or interpolation? So it cuts a little. Maybe try to implement by myself?
+		/// Get the Affine Transform from the texture map to the image. We sample the source image directly
+		/// with it, instead of warpAffine-ing into a temporary buffer of the size of the texture map.
+		t.dstToSrc = getAffineTransform(t.dstTri, srcTri);
+		trianglesToExtract.push_back(t);
+	}
 
-		// only copy to final img if point is inside the triangle (or on the border)
-		for (int x = std::min(dstTri[0].x, std::min(dstTri[1].x, dstTri[2].x)); x < std::max(dstTri[0].x, std::max(dstTri[1].x, dstTri[2].x)); ++x) {
-			for (int y = std::min(dstTri[0].y, std::min(dstTri[1].y, dstTri[2].y)); y < std::max(dstTri[0].y, std::max(dstTri[1].y, dstTri[2].y)); ++y) {
-				if (MeshUtils::isPointInTriangle(cv::Point2f(x, y), dstTri[0], dstTri[1], dstTri[2])) {
-					textureMap.at<cv::Vec3b>(y, x) = tmpDstBuffer.at<cv::Vec3b>(y, x);
+	// Remap the texels. We split the texture map into bands of rows, and each thread
+	// remaps all the triangles in its bands. Texels on shared edges are written by the
+	// triangles in the same order as in a sequential loop, so the result is deterministic.
+	const int bandHeight = 16;
+	const int numBands = (textureMap.rows + bandHeight - 1) / bandHeight;
+	workerPool->run(numBands, [&](int band) {
+		const int bandMinY = band * bandHeight;
+		const int bandMaxY = std::min(bandMinY + bandHeight, textureMap.rows); // exclusive
+		for (const auto& t : trianglesToExtract) {
+			const cv::Point2f* dstTri = t.dstTri;
+			// only copy to final img if point is inside the triangle (or on the border)
+			const int minX = std::max(static_cast<int>(std::min(dstTri[0].x, std::min(dstTri[1].x, dstTri[2].x))), 0);
+			const float maxX = std::min(std::max(dstTri[0].x, std::max(dstTri[1].x, dstTri[2].x)), static_cast<float>(textureMap.cols));
+			const int minY = std::max(static_cast<int>(std::min(dstTri[0].y, std::min(dstTri[1].y, dstTri[2].y))), bandMinY);
+			const float maxY = std::min(std::max(dstTri[0].y, std::max(dstTri[1].y, dstTri[2].y)), static_cast<float>(bandMaxY));
+			for (int y = minY; y < maxY; ++y) {
+				cv::Vec3b* textureRow = textureMap.ptr<cv::Vec3b>(y);
+				for (int x = minX; x < maxX; ++x) {
+					if (MeshUtils::isPointInTriangle(cv::Point2f(x, y), dstTri[0], dstTri[1], dstTri[2])) {
+						const float srcX = static_cast<float>(t.dstToSrc(0, 0) * x + t.dstToSrc(0, 1) * y + t.dstToSrc(0, 2));
+						const float srcY = static_cast<float>(t.dstToSrc(1, 0) * x + t.dstToSrc(1, 1) * y + t.dstToSrc(1, 2));
+						textureRow[x] = (interpolation == TextureInterpolation::Bilinear) ? sampleBilinear(image, srcX, srcY) : sampleBicubic(image, srcX, srcY);
+					}
 				}
 			}
 		}
-	}
+	});
+
 	return textureMap;
 }
 
@@ -9,6 +9,8 @@
 
 #include "render/utils.hpp"
 
+#include <stdexcept>
+
 using cv::Mat;
 using cv::Vec4b;
 using cv::Vec2f;
@@ -29,7 +31,7 @@ SoftwareRenderer::SoftwareRenderer(unsigned int viewportWidth, unsigned int view
 }
 
 #ifdef WITH_RENDER_QOPENGL
-pair<Mat, Mat> SoftwareRenderer::render(Mesh mesh, QMatrix4x4 mvp)
+pair<Mat, Mat> SoftwareRenderer::render(const Mesh& mesh, QMatrix4x4 mvp)
 {
 	// We assign the values one-by-one since if we used
 	// mvp.data() or something, we'd have to transpose
@@ -43,27 +45,99 @@ pair<Mat, Mat> SoftwareRenderer::render(Mesh mesh, QMatrix4x4 mvp)
 }
 #endif
 
-pair<Mat, Mat> SoftwareRenderer::render(Mesh mesh, Mat mvp)
+pair<Mat, Mat> SoftwareRenderer::render(const Mesh& mesh, Mat mvp)
 {
-	colorBuffer = Mat::zeros(viewportHeight, viewportWidth, CV_8UC4);
-	depthBuffer = Mat::ones(viewportHeight, viewportWidth, CV_64FC1) * 1000000;
-	//depthBuffer = Mat::ones(viewportHeight, viewportWidth, CV_64FC1) * -0.88;
+	return render(mesh, mvp, Mat());
+}
 
-	vector<TriangleToRasterize> trisToRaster;
+pair<Mat, Mat> SoftwareRenderer::render(const Mesh& mesh, Mat mvp, Mat vertexPositions)
+{
+	clearRenderTargets();
 
 	// Vertex shader:
 	//processedVertex = shade(Vertex); // processedVertex : pos, col, tex, texweight
-	vector<Vertex> clipSpaceVertices;
-	for (const auto& v : mesh.vertex) {
-		Mat mpnew = mvp * Mat(v.position);
-		clipSpaceVertices.push_back(Vertex(mpnew, v.color, v.texcrd));
-	}
+	transformVertices(mesh.vertex, mvp, vertexPositions);
 
 	// We're in clip-space now
 	// PREPARE rasterizer:
+	processTriangles(mesh.tvi);
+
+	rasterTriangles();
+	return make_pair(colorBuffer, depthBuffer);
+}
+
+pair<Mat, Mat> SoftwareRenderer::render(const MeshInstance& mesh, Mat mvp)
+{
+	if (!mesh.topology) {
+		throw std::runtime_error("SoftwareRenderer: The mesh instance has no topology.");
+	}
+	clearRenderTargets();
+	transformVertices(mesh, mvp);
+	processTriangles(mesh.topology->tvi);
+	rasterTriangles();
+	return make_pair(colorBuffer, depthBuffer);
+}
+
+void SoftwareRenderer::rasterTriangles()
+{
+	// runPixelProcessor:
+	// Fragment shader: Color the pixel values
+	// for every tri:
+	if (doTiledRasterization) {
+		rasterTrianglesTiled(trisToRaster);
+	}
+	else {
+		for (const auto& tri : trisToRaster) {
+			rasterTriangle(tri);
+		}
+	}
+}
+
+Mat SoftwareRenderer::renderTriangleIds(const Mesh& mesh, Mat mvp, vector<int>* numCoveredPixels)
+{
+	transformVertices(mesh.vertex, mvp);
+	processTriangles(mesh.tvi);
+	rasterTriangleIds(mesh.tvi.size(), numCoveredPixels);
+	return triangleIdBuffer;
+}
+
+Mat SoftwareRenderer::renderTriangleIds(const MeshInstance& mesh, Mat mvp, vector<int>* numCoveredPixels)
+{
+	if (!mesh.topology) {
+		throw std::runtime_error("SoftwareRenderer: The mesh instance has no topology.");
+	}
+	transformVertices(mesh, mvp);
+	processTriangles(mesh.topology->tvi);
+	rasterTriangleIds(mesh.topology->tvi.size(), numCoveredPixels);
+	return triangleIdBuffer;
+}
+
+void SoftwareRenderer::rasterTriangleIds(std::size_t numTriangles, vector<int>* numCoveredPixels)
+{
+	depthBuffer.create(viewportHeight, viewportWidth, CV_64FC1);
+	depthBuffer.setTo(cv::Scalar::all(1000000));
+	triangleIdBuffer.create(viewportHeight, viewportWidth, CV_32SC1);
+	triangleIdBuffer.setTo(cv::Scalar::all(-1));
+
+	if (numCoveredPixels) {
+		numCoveredPixels->assign(numTriangles, -1);
+	}
+	for (const auto& tri : trisToRaster) {
+		int numCovered = rasterTriangleId(tri);
+		if (numCoveredPixels) {
+			int& count = (*numCoveredPixels)[tri.triangleIndex];
+			count = max(count, 0) + numCovered;
+		}
+	}
+}
+
+void SoftwareRenderer::processTriangles(const vector<std::array<int, 3>>& triangleVertexIndices)
+{
+	trisToRaster.clear();
 	// processProspectiveTriangleToRasterize:
 	// for every vertex/tri:
-	for (const auto& triIndices : mesh.tvi) {
+	for (int triangleIndex = 0; triangleIndex < static_cast<int>(triangleVertexIndices.size()); ++triangleIndex) {
+		const auto& triIndices = triangleVertexIndices[triangleIndex];
 		// Todo: Split this whole stuff up. Make a "clip" function, ... rename "processProspective..".. what is "process"... get rid of "continue;"-stuff by moving stuff inside process...
 		// classify vertices visibility with respect to the planes of the view frustum
 		// we're in clip-coords (NDC), so just check if outside [-1, 1] x ...
@@ -100,6 +174,7 @@ pair<Mat, Mat> SoftwareRenderer::render(Mesh mesh, Mat mvp)
 		{
 			boost::optional<TriangleToRasterize> t = processProspectiveTri(clipSpaceVertices[triIndices[0]], clipSpaceVertices[triIndices[1]], clipSpaceVertices[triIndices[2]]);
 			if (t) {
+				t->triangleIndex = triangleIndex;
 				trisToRaster.push_back(*t);
 			}
 			continue;
@@ -131,19 +206,75 @@ pair<Mat, Mat> SoftwareRenderer::render(Mesh mesh, Mat mvp)
 			{
 				boost::optional<TriangleToRasterize> t = processProspectiveTri(vertices[0], vertices[1 + k], vertices[2 + k]);
 				if (t) {
+					t->triangleIndex = triangleIndex;
 					trisToRaster.push_back(*t);
 				}
 			}
 		}
 	}
+}
 
-	// runPixelProcessor:
-	// Fragment shader: Color the pixel values
-	// for every tri:
-	for (const auto& tri : trisToRaster) {
-		rasterTriangle(tri);
+void SoftwareRenderer::clearRenderTargets()
+{
+	// Mat::create() is a no-op if the size and type match, so
+	// we only allocate on the first call or if something changed:
+	colorBuffer.create(viewportHeight, viewportWidth, CV_8UC4);
+	colorBuffer.setTo(cv::Scalar::all(0));
+	depthBuffer.create(viewportHeight, viewportWidth, CV_64FC1);
+	depthBuffer.setTo(cv::Scalar::all(1000000));
+	//depthBuffer.setTo(cv::Scalar::all(-0.88));
+}
+
+void SoftwareRenderer::transformVertices(const vector<Vertex>& vertices, const Mat& mvp, const Mat& vertexPositions)
+{
+	const bool usePositions = !vertexPositions.empty();
+	if (usePositions && vertexPositions.total() != 3 * vertices.size()) {
+		throw std::runtime_error("SoftwareRenderer: The number of vertex positions given does not match the number of vertices of the mesh.");
+	}
+	// A column of a larger matrix is not continuous, so we copy it in that case:
+	const Mat continuousPositions = (usePositions && !vertexPositions.isContinuous()) ? vertexPositions.clone() : vertexPositions;
+	const float* positions = usePositions ? continuousPositions.ptr<float>() : nullptr;
+	// Instead of one (heap-allocating) 4x4 * 4x1 Mat product per vertex, we
+	// keep the matrix in a Matx and do the multiplication in a tight loop.
+	// Like cv::gemm for float matrices, we accumulate in double.
+	const cv::Matx44d m = cv::Matx44f(mvp);
+	clipSpaceVertices.resize(vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		const Vec4f p = usePositions ? Vec4f(positions[3 * i + 0], positions[3 * i + 1], positions[3 * i + 2], 1.0f) : vertices[i].position;
+		Vertex& clipSpaceVertex = clipSpaceVertices[i];
+		for (int row = 0; row < 4; ++row) {
+			clipSpaceVertex.position[row] = static_cast<float>(m(row, 0) * p[0] + m(row, 1) * p[1] + m(row, 2) * p[2] + m(row, 3) * p[3]);
+		}
+		clipSpaceVertex.color = vertices[i].color;
+		clipSpaceVertex.texcrd = vertices[i].texcrd;
+	}
+}
+
+void SoftwareRenderer::transformVertices(const MeshInstance& mesh, const Mat& mvp)
+{
+	const MeshTopology& topology = *mesh.topology;
+	if (mesh.positions.total() != 3 * topology.numVertices || mesh.colors.total() != 3 * topology.numVertices) {
+		throw std::runtime_error("SoftwareRenderer: The vertex buffers of the mesh instance do not match the number of vertices of its topology.");
+	}
+	const bool hasTexcrd = !topology.texcrd.empty();
+	if (hasTexcrd && topology.texcrd.size() != topology.numVertices) {
+		throw std::runtime_error("SoftwareRenderer: The number of texture coordinates does not match the number of vertices.");
+	}
+	const Mat positionData = mesh.positions.isContinuous() ? mesh.positions : mesh.positions.clone();
+	const Mat colorData = mesh.colors.isContinuous() ? mesh.colors : mesh.colors.clone();
+	const float* positions = positionData.ptr<float>();
+	const float* colors = colorData.ptr<float>();
+	const cv::Matx44d m = cv::Matx44f(mvp);
+	clipSpaceVertices.resize(topology.numVertices);
+	for (size_t i = 0; i < topology.numVertices; ++i) {
+		const float* p = positions + 3 * i;
+		Vertex& clipSpaceVertex = clipSpaceVertices[i];
+		for (int row = 0; row < 4; ++row) {
+			clipSpaceVertex.position[row] = static_cast<float>(m(row, 0) * p[0] + m(row, 1) * p[1] + m(row, 2) * p[2] + m(row, 3));
+		}
+		clipSpaceVertex.color = Vec3f(colors[3 * i + 0], colors[3 * i + 1], colors[3 * i + 2]);
+		clipSpaceVertex.texcrd = hasTexcrd ? topology.texcrd[i] : Vec2f();
 	}
-	return make_pair(colorBuffer, depthBuffer);
 }
 
 boost::optional<TriangleToRasterize> SoftwareRenderer::processProspectiveTri(Vertex v0, Vertex v1, Vertex v2)
@@ -263,40 +394,7 @@ void SoftwareRenderer::rasterTriangle(TriangleToRasterize triangle)
 					beta *= d*t.one_over_z1;
 					gamma *= d*t.one_over_z2;
 
-					// attributes interpolation
-					Vec3f color_persp = alpha*t.v0.color + beta*t.v1.color + gamma*t.v2.color;
-					Vec2f texCoord_persp = alpha*t.v0.texcrd + beta*t.v1.texcrd + gamma*t.v2.texcrd;
-
-					Vec3f pixelColor;
-					// Pixel Shader:
-					if (doTexturing) {	// We use texturing
-						// check if texture != NULL?
-						// partial derivatives (for mip-mapping)
-						float u_over_z = -(t.alphaPlane.a*x + t.alphaPlane.b*y + t.alphaPlane.d) * t.one_over_alpha_c;
-						float v_over_z = -(t.betaPlane.a*x + t.betaPlane.b*y + t.betaPlane.d) * t.one_over_beta_c;
-						float one_over_z = -(t.gammaPlane.a*x + t.gammaPlane.b*y + t.gammaPlane.d) * t.one_over_gamma_c;
-						float one_over_squared_one_over_z = 1.0f / pow(one_over_z, 2);
-
-						dudx = one_over_squared_one_over_z * (t.alpha_ffx * one_over_z - u_over_z * t.gamma_ffx);
-						dudy = one_over_squared_one_over_z * (t.beta_ffx * one_over_z - v_over_z * t.gamma_ffx);
-						dvdx = one_over_squared_one_over_z * (t.alpha_ffy * one_over_z - u_over_z * t.gamma_ffy);
-						dvdy = one_over_squared_one_over_z * (t.beta_ffy * one_over_z - v_over_z * t.gamma_ffy);
-
-						dudx *= currentTexture->mipmaps[0].cols;
-						dudy *= currentTexture->mipmaps[0].cols;
-						dvdx *= currentTexture->mipmaps[0].rows;
-						dvdy *= currentTexture->mipmaps[0].rows;
-
-						// The Texture is in BGR, thus tex2D returns BGR
-						Vec3f textureColor = tex2D(texCoord_persp); // uses the current texture
-						pixelColor = Vec3f(textureColor[2], textureColor[1], textureColor[0]);
-						// other: color.mul(tex2D(texture, texCoord));
-						// Old note: for texturing, we load the texture as BGRA, so the colors get the wrong way in the next few lines...
-					}
-					else {	// We use vertex-coloring
-						// color_persp is in RGB
-						pixelColor = color_persp;
-					}
+					Vec3f pixelColor = shadePixel(t, alpha, beta, gamma, x, y);
 
 					// clamp bytes to 255
 					unsigned char red = (unsigned char)(255.0f * min(pixelColor[0], 1.0f)); // Todo: Proper casting (rounding?)
@@ -315,6 +413,228 @@ void SoftwareRenderer::rasterTriangle(TriangleToRasterize triangle)
 	}
 }
 
+int SoftwareRenderer::rasterTriangleId(const TriangleToRasterize& t)
+{
+	// Same depth-test as rasterTriangle(...), but we only write the depth and the triangle index.
+	// Contrary to rasterTriangle(...), the coverage-test uses a fill rule: A pixel centre that lies
+	// exactly on an edge is only covered by the triangle on the left of the edge (or the one below
+	// it, if the edge is horizontal). Thus two triangles that share an edge never both cover a pixel,
+	// and every pixel of a closed surface belongs to exactly one of its triangles.
+	// For this to work, the triangles on both sides of an edge have to compute exactly the same (or
+	// exactly negated) edge values. implicitLine(x, y, a, b) is exactly -implicitLine(x, y, b, a), and
+	// we evaluate the edges at every pixel as e(x = 0.5) + xi * step, independent of the bounding box.
+	const double one_over_v0ToLine12 = 1.0 / utils::implicitLine(t.v0.position[0], t.v0.position[1], t.v1.position, t.v2.position);
+	const double one_over_v1ToLine20 = 1.0 / utils::implicitLine(t.v1.position[0], t.v1.position[1], t.v2.position, t.v0.position);
+	const double one_over_v2ToLine01 = 1.0 / utils::implicitLine(t.v2.position[0], t.v2.position[1], t.v0.position, t.v1.position);
+	// Increments of the edge functions in x- and y-direction:
+	const double step12 = (double)t.v1.position[1] - (double)t.v2.position[1];
+	const double step20 = (double)t.v2.position[1] - (double)t.v0.position[1];
+	const double step01 = (double)t.v0.position[1] - (double)t.v1.position[1];
+	const double stepY12 = (double)t.v2.position[0] - (double)t.v1.position[0];
+	const double stepY20 = (double)t.v0.position[0] - (double)t.v2.position[0];
+	const double stepY01 = (double)t.v1.position[0] - (double)t.v0.position[0];
+	// A triangle owns the pixels on one of its edges if its barycentric weight for that edge
+	// grows to the right (or downwards, if the edge is horizontal):
+	auto ownsEdge = [](double stepX, double stepY, double one_over_vToLine) {
+		const double gradientX = stepX * one_over_vToLine;
+		const double gradientY = stepY * one_over_vToLine;
+		return gradientX > 0 || (gradientX == 0 && gradientY > 0);
+	};
+	const bool owns12 = ownsEdge(step12, stepY12, one_over_v0ToLine12);
+	const bool owns20 = ownsEdge(step20, stepY20, one_over_v1ToLine20);
+	const bool owns01 = ownsEdge(step01, stepY01, one_over_v2ToLine01);
+	auto isCovered = [](double weight, bool ownsEdge) {
+		return weight > 0 || (weight == 0 && ownsEdge);
+	};
+
+	int numCovered = 0;
+	for (int yi = t.minY; yi <= t.maxY; ++yi)
+	{
+		const float y = (float)yi + 0.5f;
+		const double e12 = utils::implicitLine(0.5f, y, t.v1.position, t.v2.position);
+		const double e20 = utils::implicitLine(0.5f, y, t.v2.position, t.v0.position);
+		const double e01 = utils::implicitLine(0.5f, y, t.v0.position, t.v1.position);
+		double* depthRow = depthBuffer.ptr<double>(yi);
+		int* idRow = triangleIdBuffer.ptr<int>(yi);
+		for (int xi = t.minX; xi <= t.maxX; ++xi)
+		{
+			const double alpha = (e12 + xi * step12) * one_over_v0ToLine12;
+			const double beta = (e20 + xi * step20) * one_over_v1ToLine20;
+			const double gamma = (e01 + xi * step01) * one_over_v2ToLine01;
+			if (isCovered(alpha, owns12) && isCovered(beta, owns20) && isCovered(gamma, owns01))
+			{
+				++numCovered;
+				const double z_affine = alpha*(double)t.v0.position[2] + beta*(double)t.v1.position[2] + gamma*(double)t.v2.position[2];
+				if (z_affine < depthRow[xi])
+				{
+					depthRow[xi] = z_affine;
+					idRow[xi] = t.triangleIndex;
+				}
+			}
+		}
+	}
+	return numCovered;
+}
+
+void SoftwareRenderer::rasterTrianglesTiled(vector<TriangleToRasterize>& triangles)
+{
+	const int numTilesX = (viewportWidth + tileSize - 1) / tileSize;
+	const int numTilesY = (viewportHeight + tileSize - 1) / tileSize;
+	const int numTiles = numTilesX * numTilesY;
+
+	// Binning: Store the indices of the triangles overlapping each tile, in submission order:
+	vector<vector<int>> tileBins(numTiles);
+	for (int i = 0; i < static_cast<int>(triangles.size()); ++i) {
+		TriangleToRasterize& t = triangles[i];
+		t.tileMinX = t.minX / tileSize;
+		t.tileMaxX = t.maxX / tileSize;
+		t.tileMinY = t.minY / tileSize;
+		t.tileMaxY = t.maxY / tileSize;
+		for (int tileY = t.tileMinY; tileY <= t.tileMaxY; ++tileY) {
+			for (int tileX = t.tileMinX; tileX <= t.tileMaxX; ++tileX) {
+				tileBins[tileY * numTilesX + tileX].push_back(i);
+			}
+		}
+	}
+
+	// Each tile writes to its own region of the buffers only, so the workers
+	// don't need any synchronisation:
+	if (!workerPool) {
+		workerPool = std::make_shared<WorkerPool>(numRasterizerThreads);
+	}
+	workerPool->run(numTiles, [&](int tile) {
+		const int tileMinX = (tile % numTilesX) * tileSize;
+		const int tileMinY = (tile / numTilesX) * tileSize;
+		const int tileMaxX = min(tileMinX + tileSize, static_cast<int>(viewportWidth)) - 1;
+		const int tileMaxY = min(tileMinY + tileSize, static_cast<int>(viewportHeight)) - 1;
+		for (const auto& triangleIndex : tileBins[tile]) {
+			rasterTriangleInTile(triangles[triangleIndex], tileMinX, tileMaxX, tileMinY, tileMaxY);
+		}
+	});
+}
+
+void SoftwareRenderer::rasterTriangleInTile(const TriangleToRasterize& t, int tileMinX, int tileMaxX, int tileMinY, int tileMaxY)
+{
+	const int minX = max(t.minX, tileMinX);
+	const int maxX = min(t.maxX, tileMaxX);
+	const int minY = max(t.minY, tileMinY);
+	const int maxY = min(t.maxY, tileMaxY);
+	if (maxX < minX || maxY < minY) {
+		return;
+	}
+
+	// these will be used for barycentric weights computation
+	const double one_over_v0ToLine12 = 1.0 / utils::implicitLine(t.v0.position[0], t.v0.position[1], t.v1.position, t.v2.position);
+	const double one_over_v1ToLine20 = 1.0 / utils::implicitLine(t.v1.position[0], t.v1.position[1], t.v2.position, t.v0.position);
+	const double one_over_v2ToLine01 = 1.0 / utils::implicitLine(t.v2.position[0], t.v2.position[1], t.v0.position, t.v1.position);
+	// Increments of the edge functions (see utils::implicitLine) when stepping one pixel in x-direction.
+	// The edge functions are evaluated with implicitLine at the start of every row and then stepped
+	// with e + dx * step, so the rounding errors don't accumulate along a row. The values can still
+	// differ from implicitLine in the last bits, which only matters for pixel centres that lie
+	// (almost) exactly on an edge.
+	const double step12 = (double)t.v1.position[1] - (double)t.v2.position[1];
+	const double step20 = (double)t.v2.position[1] - (double)t.v0.position[1];
+	const double step01 = (double)t.v0.position[1] - (double)t.v1.position[1];
+
+	for (int yi = minY; yi <= maxY; ++yi)
+	{
+		// we want centers of pixels to be used in computations. TODO: Do we?
+		const float y = (float)yi + 0.5f;
+		const double e12 = utils::implicitLine((float)minX + 0.5f, y, t.v1.position, t.v2.position);
+		const double e20 = utils::implicitLine((float)minX + 0.5f, y, t.v2.position, t.v0.position);
+		const double e01 = utils::implicitLine((float)minX + 0.5f, y, t.v0.position, t.v1.position);
+		Vec4b* colorRow = colorBuffer.ptr<Vec4b>(yi);
+		double* depthRow = depthBuffer.ptr<double>(yi);
+
+		// Process the row in quads of 4 pixels. The fixed-size inner loops are independent
+		// per lane, so the compiler can vectorise them.
+		for (int xi = minX; xi <= maxX; xi += 4)
+		{
+			double alpha[4], beta[4], gamma[4];
+			bool inside[4];
+			bool anyInside = false;
+			for (int k = 0; k < 4; ++k) {
+				const double dx = xi - minX + k;
+				// affine barycentric weights
+				alpha[k] = (e12 + dx * step12) * one_over_v0ToLine12;
+				beta[k] = (e20 + dx * step20) * one_over_v1ToLine20;
+				gamma[k] = (e01 + dx * step01) * one_over_v2ToLine01;
+				// if pixel (x, y) is inside the triangle or on one of its edges
+				inside[k] = (alpha[k] >= 0 && beta[k] >= 0 && gamma[k] >= 0 && xi + k <= maxX);
+				anyInside |= inside[k];
+			}
+			if (!anyInside) {
+				continue;
+			}
+
+			for (int k = 0; k < 4; ++k) {
+				if (!inside[k]) {
+					continue;
+				}
+				const int pixelIndexCol = xi + k;
+				const double z_affine = alpha[k]*(double)t.v0.position[2] + beta[k]*(double)t.v1.position[2] + gamma[k]*(double)t.v2.position[2];
+				if (z_affine < depthRow[pixelIndexCol])
+				{
+					// perspective-correct barycentric weights
+					double d = alpha[k]*t.one_over_z0 + beta[k]*t.one_over_z1 + gamma[k]*t.one_over_z2;
+					d = 1.0 / d;
+					const double alpha_persp = alpha[k] * (d*t.one_over_z0);
+					const double beta_persp = beta[k] * (d*t.one_over_z1);
+					const double gamma_persp = gamma[k] * (d*t.one_over_z2);
+
+					Vec3f pixelColor = shadePixel(t, alpha_persp, beta_persp, gamma_persp, (float)pixelIndexCol + 0.5f, y);
+
+					// clamp bytes to 255
+					colorRow[pixelIndexCol][0] = (unsigned char)(255.0f * min(pixelColor[2], 1.0f)); // blue
+					colorRow[pixelIndexCol][1] = (unsigned char)(255.0f * min(pixelColor[1], 1.0f)); // green
+					colorRow[pixelIndexCol][2] = (unsigned char)(255.0f * min(pixelColor[0], 1.0f)); // red
+					colorRow[pixelIndexCol][3] = 255; // alpha, or 1.0f?
+					depthRow[pixelIndexCol] = z_affine;
+				}
+			}
+		}
+	}
+}
+
+Vec3f SoftwareRenderer::shadePixel(const TriangleToRasterize& t, double alpha, double beta, double gamma, float x, float y) const
+{
+	// attributes interpolation
+	Vec3f color_persp = alpha*t.v0.color + beta*t.v1.color + gamma*t.v2.color;
+	Vec2f texCoord_persp = alpha*t.v0.texcrd + beta*t.v1.texcrd + gamma*t.v2.texcrd;
+
+	Vec3f pixelColor;
+	// Pixel Shader:
+	if (doTexturing) {	// We use texturing
+		// check if texture != NULL?
+		// partial derivatives (for mip-mapping)
+		float u_over_z = -(t.alphaPlane.a*x + t.alphaPlane.b*y + t.alphaPlane.d) * t.one_over_alpha_c;
+		float v_over_z = -(t.betaPlane.a*x + t.betaPlane.b*y + t.betaPlane.d) * t.one_over_beta_c;
+		float one_over_z = -(t.gammaPlane.a*x + t.gammaPlane.b*y + t.gammaPlane.d) * t.one_over_gamma_c;
+		float one_over_squared_one_over_z = 1.0f / pow(one_over_z, 2);
+
+		float dudx = one_over_squared_one_over_z * (t.alpha_ffx * one_over_z - u_over_z * t.gamma_ffx);
+		float dudy = one_over_squared_one_over_z * (t.beta_ffx * one_over_z - v_over_z * t.gamma_ffx);
+		float dvdx = one_over_squared_one_over_z * (t.alpha_ffy * one_over_z - u_over_z * t.gamma_ffy);
+		float dvdy = one_over_squared_one_over_z * (t.beta_ffy * one_over_z - v_over_z * t.gamma_ffy);
+
+		dudx *= currentTexture->mipmaps[0].cols;
+		dudy *= currentTexture->mipmaps[0].cols;
+		dvdx *= currentTexture->mipmaps[0].rows;
+		dvdy *= currentTexture->mipmaps[0].rows;
+
+		// The Texture is in BGR, thus tex2D returns BGR
+		Vec3f textureColor = tex2D(texCoord_persp, dudx, dudy, dvdx, dvdy); // uses the current texture
+		pixelColor = Vec3f(textureColor[2], textureColor[1], textureColor[0]);
+		// other: color.mul(tex2D(texture, texCoord));
+		// Old note: for texturing, we load the texture as BGRA, so the colors get the wrong way in the next few lines...
+	}
+	else {	// We use vertex-coloring
+		// color_persp is in RGB
+		pixelColor = color_persp;
+	}
+	return pixelColor;
+}
+
 std::vector<Vertex> SoftwareRenderer::clipPolygonToPlaneIn4D(const std::vector<Vertex>& vertices, const Vec4f& planeNormal)
 {
 	std::vector<Vertex> clippedVertices;
@@ -359,12 +679,12 @@ std::vector<Vertex> SoftwareRenderer::clipPolygonToPlaneIn4D(const std::vector<V
 	return clippedVertices;
 }
 
-Vec3f SoftwareRenderer::tex2D(const Vec2f& texCoord)
+Vec3f SoftwareRenderer::tex2D(const Vec2f& texCoord, float dudx, float dudy, float dvdx, float dvdy) const
 {
-	return (1.0f / 255.0f) * tex2D_linear_mipmap_linear(texCoord);
+	return (1.0f / 255.0f) * tex2D_linear_mipmap_linear(texCoord, dudx, dudy, dvdx, dvdy);
 }
 
-Vec3f SoftwareRenderer::tex2D_linear_mipmap_linear(const Vec2f& texCoord)
+Vec3f SoftwareRenderer::tex2D_linear_mipmap_linear(const Vec2f& texCoord, float dudx, float dudy, float dvdx, float dvdy) const
 {
 	float px = std::sqrt(std::pow(dudx, 2) + std::pow(dvdx, 2));
 	float py = std::sqrt(std::pow(dudy, 2) + std::pow(dvdy, 2));
@@ -390,12 +710,12 @@ Vec3f SoftwareRenderer::tex2D_linear_mipmap_linear(const Vec2f& texCoord)
 	return color;
 }
 
-Vec2f SoftwareRenderer::texCoord_wrap(const Vec2f& texCoord)
+Vec2f SoftwareRenderer::texCoord_wrap(const Vec2f& texCoord) const
 {
 	return Vec2f(texCoord[0] - (int)texCoord[0], texCoord[1] - (int)texCoord[1]);
 }
 
-Vec3f SoftwareRenderer::tex2D_linear(const Vec2f& imageTexCoord, unsigned char mipmapIndex)
+Vec3f SoftwareRenderer::tex2D_linear(const Vec2f& imageTexCoord, unsigned char mipmapIndex) const
 {
 	int x = (int)imageTexCoord[0];
 	int y = (int)imageTexCoord[1];
@@ -443,7 +763,7 @@ Vec3f SoftwareRenderer::tex2D_linear(const Vec2f& imageTexCoord, unsigned char m
 	return color;
 }
 
-float SoftwareRenderer::clamp(float x, float a, float b)
+float SoftwareRenderer::clamp(float x, float a, float b) const
 {
 	return max(min(x, b), a);
 }
@@ -30,6 +30,14 @@ void Texture::createFromFile(const std::string& fileName, unsigned int mipmapsNu
 		exit(EXIT_FAILURE);
 	}
 
+	createFromImage(image, mipmapsNum);
+	this->fileName = fileName;
+}
+
+void Texture::createFromImage(cv::Mat image, unsigned int mipmapsNum)
+{
+	this->fileName.clear();
+	mipmaps.clear();
 	this->mipmapsNum = (mipmapsNum == 0 ? render::utils::getMaxPossibleMipmapsNum(image.cols, image.rows) : mipmapsNum);
 	/*if (mipmapsNum == 0)
 	{
@@ -44,12 +52,16 @@ void Texture::createFromFile(const std::string& fileName, unsigned int mipmapsNu
 	{
 		if (!isPowerOfTwo(image.cols) || !isPowerOfTwo(image.rows))
 		{
-			std::cout << "Error: Couldn't generate mipmaps for image: " << fileName << std::endl;
+			std::cout << "Error: Couldn't generate mipmaps for an image of size " << image.cols << "x" << image.rows << ", it's not a power of two." << std::endl;
 			exit(EXIT_FAILURE);
 		}
 	}
-	image.convertTo(image, CV_8UC4);	// Most often, the input img is CV_8UC3. Img is BGR. Add an alpha channel
-	cv::cvtColor(image, image, CV_BGR2BGRA);
+	if (image.channels() == 3) {
+		cv::cvtColor(image, image, CV_BGR2BGRA); // Most often, the input img is CV_8UC3. Img is BGR. Add an alpha channel
+	}
+	else {
+		image = image.clone(); // Don't share the data with the caller
+	}
 
 	int currWidth = image.cols;
 	int currHeight = image.rows;
@@ -68,7 +80,6 @@ void Texture::createFromFile(const std::string& fileName, unsigned int mipmapsNu
 		if (currHeight > 1)
 			currHeight >>= 1;
 	}
-	this->fileName = fileName;
 	this->widthLog = (uchar)(std::log(mipmaps[0].cols)/CV_LOG2 + 0.0001f); // std::epsilon or something? or why 0.0001f here?
 	this->heightLog = (uchar)(std::log(mipmaps[0].rows)/CV_LOG2 + 0.0001f); // Changed std::logf to std::log because it doesnt compile in linux (gcc 4.8). CHECK THAT
 }
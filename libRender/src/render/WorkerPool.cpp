@@ -0,0 +1,108 @@
+/*
+ * WorkerPool.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "render/WorkerPool.hpp"
+
+#include <algorithm>
+
+using std::mutex;
+using std::unique_lock;
+using std::lock_guard;
+
+namespace render {
+
+WorkerPool::WorkerPool(unsigned int numThreads) : nextTask(0)
+{
+	if (numThreads == 0) {
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+	// The thread calling run(...) is one of them:
+	for (unsigned int i = 1; i < numThreads; ++i) {
+		threads.emplace_back(&WorkerPool::work, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(batchMutex);
+		stopping = true;
+	}
+	batchStarted.notify_all();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+unsigned int WorkerPool::getNumThreads() const
+{
+	return static_cast<unsigned int>(threads.size()) + 1;
+}
+
+void WorkerPool::run(int numTasks, const std::function<void(int)>& task)
+{
+	lock_guard<mutex> runLock(runMutex);
+	{
+		lock_guard<mutex> lock(batchMutex);
+		this->task = &task;
+		this->numTasks = numTasks;
+		nextTask = 0;
+		error = nullptr;
+		numBusyThreads = static_cast<unsigned int>(threads.size());
+		++batch;
+	}
+	batchStarted.notify_all();
+	processTasks();
+
+	unique_lock<mutex> lock(batchMutex);
+	batchFinished.wait(lock, [this] { return numBusyThreads == 0; });
+	this->task = nullptr;
+	if (error) {
+		std::exception_ptr batchError = error;
+		error = nullptr;
+		std::rethrow_exception(batchError);
+	}
+}
+
+void WorkerPool::work()
+{
+	unsigned long processedBatch = 0;
+	while (true) {
+		{
+			unique_lock<mutex> lock(batchMutex);
+			batchStarted.wait(lock, [&] { return stopping || batch != processedBatch; });
+			if (stopping) {
+				return;
+			}
+			processedBatch = batch;
+		}
+		processTasks();
+		{
+			lock_guard<mutex> lock(batchMutex);
+			if (--numBusyThreads == 0) {
+				batchFinished.notify_one();
+			}
+		}
+	}
+}
+
+void WorkerPool::processTasks()
+{
+	int index;
+	while ((index = nextTask++) < numTasks) {
+		try {
+			(*task)(index);
+		} catch (...) {
+			lock_guard<mutex> lock(batchMutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	}
+}
+
+} /* namespace render */
@@ -13,6 +13,7 @@
 #include "superviseddescent/DescriptorExtractor.hpp"
 #include "superviseddescent/utils.hpp"
 #include "imageio/LandmarkCollection.hpp"
+#include "logging/Instrumentation.hpp"
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
@@ -280,7 +281,8 @@ public:
 	// calculates shape updates (deltaShape) for one or more iter/scales and returns...
 	// assume we get a col-vec.
 	cv::Mat optimize(cv::Mat modelShape, cv::Mat image) {
-
+		INSTRUMENT_SCOPE("SdmLandmarkModelFitting::optimize");
+		INSTRUMENT_COUNT("SdmLandmarkModelFitting.cascadeSteps", model.getNumCascadeSteps());
 		for (int cascadeStep = 0; cascadeStep < model.getNumCascadeSteps(); ++cascadeStep) {
 			//feature_current = obtain_features(double(TestImg), New_Shape, 'HOG', hogScale);
 
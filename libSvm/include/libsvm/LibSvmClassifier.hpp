@@ -45,7 +45,8 @@ public:
 			std::shared_ptr<classification::Kernel> kernel, double cnu = 1, bool oneClass = false);
 
 	/**
-	 * Loads static negative training examples from a file.
+	 * Loads static negative training examples from a file. The file is either a text file with one example per line
+	 * or a binary model file (see classification::writeStaticNegatives()).
 	 *
 	 * @param[in] negativesFilename The name of the file containing the static negative training examples.
 	 * @param[in] maxNegatives The amount of static negative training examples to use.
@@ -10,6 +10,7 @@
 #include "classification/ExampleManagement.hpp"
 #include "classification/UnlimitedExampleManagement.hpp"
 #include "classification/EmptyExampleManagement.hpp"
+#include "classification/BinaryModelFile.hpp"
 #include "svm.h"
 #include <fstream>
 #include <stdexcept>
@@ -19,6 +20,7 @@ using classification::SvmClassifier;
 using classification::ExampleManagement;
 using classification::UnlimitedExampleManagement;
 using classification::EmptyExampleManagement;
+using classification::BinaryModelReader;
 using cv::Mat;
 using std::move;
 using std::string;
@@ -73,6 +75,20 @@ void LibSvmClassifier::createParameters(const shared_ptr<Kernel> kernel, double
 
 void LibSvmClassifier::loadStaticNegatives(const string& negativesFilename, int maxNegatives, double scale) {
 	staticNegativeExamples.reserve(maxNegatives);
+	if (BinaryModelReader::isBinaryModelFile(negativesFilename)) {
+		Mat negatives = classification::readStaticNegatives(negativesFilename, maxNegatives);
+		for (int row = 0; row < negatives.rows; ++row) {
+			const double* values = negatives.ptr<double>(row);
+			unique_ptr<struct svm_node[], NodeDeleter> data(new struct svm_node[negatives.cols + 1], utils.getNodeDeleter());
+			for (int i = 0; i < negatives.cols; ++i) {
+				data[i].index = i;
+				data[i].value = scale * values[i];
+			}
+			data[negatives.cols].index = -1;
+			staticNegativeExamples.push_back(move(data));
+		}
+		return;
+	}
 	int negatives = 0;
 	vector<double> values;
 	double value;
@@ -108,8 +124,11 @@ bool LibSvmClassifier::retrain(const vector<Mat>& newPositiveExamples, const vec
 		return usable;
 	positiveExamples->add(newPositiveExamples);
 	negativeExamples->add(newNegativeExamples);
-	if (positiveExamples->hasRequiredSize() && negativeExamples->hasRequiredSize())
+	if (positiveExamples->hasRequiredSize() && negativeExamples->hasRequiredSize()) {
 		usable = train();
+		positiveExamples->classifierChanged();
+		negativeExamples->classifierChanged();
+	}
 	return usable;
 }
 
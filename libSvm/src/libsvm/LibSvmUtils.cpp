@@ -72,8 +72,10 @@ Mat LibSvmUtils::getVector(const struct svm_node *node) const {
 			fillMat<double>(vector, node, dimensions);
 		else
 			throw invalid_argument("LibSvmUtils: vectors have to be of depth CV_8U, CV_32F, or CV_64F");
+		return vector;
 	}
-	return vector;
+	// the training example may refer to data of an example management that is overwritten later on
+	return vector.clone();
 }
 
 template<class T>
@@ -0,0 +1,119 @@
+/*
+ * Microbenchmark.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#include "Microbenchmark.hpp"
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+using std::chrono::steady_clock;
+using std::chrono::duration;
+using std::function;
+using std::string;
+using std::vector;
+using std::ostream;
+using std::make_pair;
+
+Microbenchmark::Microbenchmark(size_t warmupRepetitions, size_t repetitions, double minRepetitionTime) :
+		warmupRepetitions(warmupRepetitions), repetitions(std::max(repetitions, static_cast<size_t>(1))),
+		minRepetitionTime(minRepetitionTime), kernels(), results() {}
+
+void Microbenchmark::add(const string& name, function<void()> kernel) {
+	kernels.push_back(make_pair(name, kernel));
+}
+
+const vector<MicrobenchmarkResult>& Microbenchmark::run(const string& filter, ostream& progressOut) {
+	results.clear();
+	for (const auto& kernel : kernels) {
+		if (!filter.empty() && kernel.first.find(filter) == string::npos)
+			continue;
+		results.push_back(measure(kernel.first, kernel.second));
+		const MicrobenchmarkResult& result = results.back();
+		progressOut << std::left << std::setw(48) << result.name << std::right << std::fixed << std::setprecision(1)
+				<< " median " << std::setw(12) << result.median << " ns"
+				<< "  mean " << std::setw(12) << result.mean << " ns"
+				<< "  stddev " << std::setw(10) << result.stddev << " ns" << std::endl;
+	}
+	return results;
+}
+
+MicrobenchmarkResult Microbenchmark::measure(const string& name, const function<void()>& kernel) const {
+	for (size_t i = 0; i < warmupRepetitions; ++i)
+		kernel();
+
+	// double the iterations until one repetition takes long enough
+	size_t iterations = 1;
+	while (true) {
+		steady_clock::time_point start = steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i)
+			kernel();
+		double seconds = duration<double>(steady_clock::now() - start).count();
+		if (seconds >= minRepetitionTime || iterations >= (static_cast<size_t>(1) << 30))
+			break;
+		iterations *= 2;
+	}
+
+	vector<double> times;
+	times.reserve(repetitions);
+	for (size_t repetition = 0; repetition < repetitions; ++repetition) {
+		steady_clock::time_point start = steady_clock::now();
+		for (size_t i = 0; i < iterations; ++i)
+			kernel();
+		double nanoseconds = duration<double, std::nano>(steady_clock::now() - start).count();
+		times.push_back(nanoseconds / iterations);
+	}
+
+	MicrobenchmarkResult result;
+	result.name = name;
+	result.repetitions = repetitions;
+	result.iterations = iterations;
+	std::sort(times.begin(), times.end());
+	result.min = times.front();
+	result.max = times.back();
+	size_t middle = times.size() / 2;
+	result.median = times.size() % 2 == 1 ? times[middle] : 0.5 * (times[middle - 1] + times[middle]);
+	double sum = 0;
+	for (double time : times)
+		sum += time;
+	result.mean = sum / times.size();
+	double squaredSum = 0;
+	for (double time : times)
+		squaredSum += (time - result.mean) * (time - result.mean);
+	result.stddev = times.size() > 1 ? std::sqrt(squaredSum / (times.size() - 1)) : 0;
+	return result;
+}
+
+void Microbenchmark::writeJson(ostream& out) const {
+	out << std::setprecision(3) << std::fixed;
+	out << "{\n";
+	out << "  \"unit\": \"ns\",\n";
+	out << "  \"benchmarks\": [";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const MicrobenchmarkResult& result = results[i];
+		out << (i == 0 ? "\n" : ",\n");
+		out << "    {\"name\": \"" << result.name << "\""
+				<< ", \"repetitions\": " << result.repetitions
+				<< ", \"iterations\": " << result.iterations
+				<< ", \"min\": " << result.min
+				<< ", \"max\": " << result.max
+				<< ", \"mean\": " << result.mean
+				<< ", \"median\": " << result.median
+				<< ", \"stddev\": " << result.stddev << "}";
+	}
+	out << "\n  ]\n";
+	out << "}\n";
+}
+
+void Microbenchmark::writeCsv(ostream& out) const {
+	out << std::setprecision(3) << std::fixed;
+	out << "name,repetitions,iterations,min_ns,max_ns,mean_ns,median_ns,stddev_ns\n";
+	for (const MicrobenchmarkResult& result : results) {
+		out << result.name << ',' << result.repetitions << ',' << result.iterations << ','
+				<< result.min << ',' << result.max << ',' << result.mean << ',' << result.median << ',' << result.stddev << '\n';
+	}
+}
@@ -0,0 +1,98 @@
+/*
+ * Microbenchmark.hpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifndef MICROBENCHMARK_HPP_
+#define MICROBENCHMARK_HPP_
+
+#include <functional>
+#include <string>
+#include <vector>
+#include <ostream>
+
+/**
+ * Timing statistics of one microbenchmark. All times are in nanoseconds per call of the benchmarked kernel.
+ */
+struct MicrobenchmarkResult {
+	std::string name; ///< Name of the benchmark.
+	size_t repetitions; ///< Number of timed repetitions.
+	size_t iterations; ///< Number of kernel calls per repetition.
+	double min; ///< Minimum time.
+	double max; ///< Maximum time.
+	double mean; ///< Mean time.
+	double median; ///< Median time.
+	double stddev; ///< Standard deviation of the time.
+};
+
+/**
+ * Runs small kernels repeatedly and collects timing statistics. Each benchmark is first run for some warm-up
+ * repetitions that are not measured. Then the number of kernel calls per repetition is chosen such that one
+ * repetition takes at least a minimum amount of time, which keeps the timer resolution out of the results of
+ * very fast kernels. Finally, the repetitions are timed and summarized.
+ */
+class Microbenchmark {
+public:
+
+	/**
+	 * Constructs a new microbenchmark.
+	 *
+	 * @param[in] warmupRepetitions The number of repetitions that are run before measuring.
+	 * @param[in] repetitions The number of measured repetitions.
+	 * @param[in] minRepetitionTime The minimum duration of one repetition in seconds.
+	 */
+	Microbenchmark(size_t warmupRepetitions, size_t repetitions, double minRepetitionTime);
+
+	/**
+	 * Adds a kernel for benchmarking. The kernel should store its result somewhere that is visible outside
+	 * (e.g. in a captured variable), so the compiler cannot optimize it away.
+	 *
+	 * @param[in] name Name of the benchmark.
+	 * @param[in] kernel The function that is measured.
+	 */
+	void add(const std::string& name, std::function<void()> kernel);
+
+	/**
+	 * Runs the benchmarks in the order they were added.
+	 *
+	 * @param[in] filter Only benchmarks whose name contains this string are run (all if empty).
+	 * @param[in] progressOut Stream that receives a line per finished benchmark.
+	 * @return The results of the benchmarks that were run.
+	 */
+	const std::vector<MicrobenchmarkResult>& run(const std::string& filter, std::ostream& progressOut);
+
+	/**
+	 * Writes the results of the last run as JSON.
+	 *
+	 * @param[in] out The output stream.
+	 */
+	void writeJson(std::ostream& out) const;
+
+	/**
+	 * Writes the results of the last run as CSV with a header line.
+	 *
+	 * @param[in] out The output stream.
+	 */
+	void writeCsv(std::ostream& out) const;
+
+private:
+
+	/**
+	 * Measures a single kernel.
+	 *
+	 * @param[in] name Name of the benchmark.
+	 * @param[in] kernel The function that is measured.
+	 * @return The timing statistics.
+	 */
+	MicrobenchmarkResult measure(const std::string& name, const std::function<void()>& kernel) const;
+
+	size_t warmupRepetitions; ///< The number of repetitions that are run before measuring.
+	size_t repetitions; ///< The number of measured repetitions.
+	double minRepetitionTime; ///< The minimum duration of one repetition in seconds.
+	std::vector<std::pair<std::string, std::function<void()>>> kernels; ///< The named kernels.
+	std::vector<MicrobenchmarkResult> results; ///< The results of the last run.
+};
+
+#endif /* MICROBENCHMARK_HPP_ */
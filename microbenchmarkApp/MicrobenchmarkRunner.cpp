@@ -0,0 +1,357 @@
+/*
+ * MicrobenchmarkRunner.cpp
+ *
+ *  Created on: 18.10.2026
+ *      Author: agent
+ */
+
+#ifdef WIN32
+	#include <SDKDDKVer.h>
+#endif
+
+#include "Microbenchmark.hpp"
+
+#include "imageprocessing/GradientFilter.hpp"
+#include "imageprocessing/GradientBinningFilter.hpp"
+#include "imageprocessing/ExtendedHogFilter.hpp"
+#include "imageprocessing/HistEq64Filter.hpp"
+#include "imageprocessing/WhiteningFilter.hpp"
+#include "classification/RbfKernel.hpp"
+#include "classification/WvmClassifier.hpp"
+#include "render/SoftwareRenderer.hpp"
+#include "render/MatrixUtils.hpp"
+#include "render/Mesh.hpp"
+#include "render/MeshInstance.hpp"
+#include "superviseddescent/DescriptorExtractor.hpp"
+#include "logging/LoggerFactory.hpp"
+
+#include "opencv2/core/core.hpp"
+
+#ifdef WIN32
+	#define BOOST_ALL_DYN_LINK	// Link against the dynamic boost lib. Seems to be necessary because we use /MD, i.e. link to the dynamic CRT.
+	#define BOOST_ALL_NO_LIB	// Don't use the automatic library linking by boost with VS2010 (#pragma ...). Instead, we specify everything in cmake.
+#endif
+#include "boost/program_options.hpp"
+#include "boost/algorithm/string.hpp"
+#include "boost/filesystem.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <exception>
+#include <cmath>
+
+namespace po = boost::program_options;
+using logging::Logger;
+using logging::LoggerFactory;
+using logging::LogLevel;
+using boost::filesystem::path;
+using imageprocessing::GradientFilter;
+using imageprocessing::GradientBinningFilter;
+using imageprocessing::ExtendedHogFilter;
+using imageprocessing::HistEq64Filter;
+using imageprocessing::WhiteningFilter;
+using classification::RbfKernel;
+using classification::WvmClassifier;
+using render::SoftwareRenderer;
+using render::Mesh;
+using render::MeshInstance;
+using render::Vertex;
+using render::utils::MatrixUtils;
+using superviseddescent::VlHogDescriptorExtractor;
+using cv::Mat;
+using cv::Size;
+using cv::Rect;
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+using std::vector;
+using std::shared_ptr;
+using std::make_shared;
+
+/**
+ * Creates a deterministic random image.
+ *
+ * @param[in] size The size of the image.
+ * @param[in] type The type of the image.
+ * @param[in] seed The seed of the random number generator.
+ * @return The image with uniformly distributed values (0 to 255).
+ */
+Mat createRandomImage(Size size, int type, unsigned int seed) {
+	cv::RNG rng(seed);
+	Mat image(size, type);
+	rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+	return image;
+}
+
+/**
+ * Creates a deterministic image that looks a bit more natural than noise (smooth gradients plus some noise), so
+ * the gradient and histogram based filters see a realistic distribution of values.
+ *
+ * @param[in] size The size of the image.
+ * @param[in] seed The seed of the random number generator.
+ * @return The image of type CV_8UC1.
+ */
+Mat createSyntheticImage(Size size, unsigned int seed) {
+	Mat noise = createRandomImage(size, CV_8UC1, seed);
+	Mat image(size, CV_8UC1);
+	for (int y = 0; y < size.height; ++y) {
+		for (int x = 0; x < size.width; ++x) {
+			double value = 128 + 60 * std::sin(0.05 * x) * std::cos(0.07 * y) + 0.25 * (noise.at<uchar>(y, x) - 128);
+			image.at<uchar>(y, x) = cv::saturate_cast<uchar>(value);
+		}
+	}
+	return image;
+}
+
+/**
+ * Creates a mesh of a bumpy regular grid in the x-y-plane from -1 to 1 with two triangles per grid cell.
+ *
+ * @param[in] cells The number of grid cells per row and column.
+ * @return The mesh.
+ */
+Mesh createGridMesh(int cells) {
+	Mesh mesh;
+	for (int y = 0; y <= cells; ++y) {
+		for (int x = 0; x <= cells; ++x) {
+			float u = static_cast<float>(x) / cells;
+			float v = static_cast<float>(y) / cells;
+			float z = 0.2f * std::sin(6 * u) * std::cos(6 * v);
+			mesh.vertex.push_back(Vertex(cv::Vec4f(2 * u - 1, 2 * v - 1, z, 1), cv::Vec3f(u, v, 0.5f), cv::Vec2f(u, v)));
+		}
+	}
+	for (int y = 0; y < cells; ++y) {
+		for (int x = 0; x < cells; ++x) {
+			int topLeft = y * (cells + 1) + x;
+			int bottomLeft = topLeft + cells + 1;
+			mesh.tvi.push_back({ { topLeft, bottomLeft, topLeft + 1 } });
+			mesh.tvi.push_back({ { topLeft + 1, bottomLeft, bottomLeft + 1 } });
+		}
+	}
+	mesh.tci = mesh.tvi;
+	return mesh;
+}
+
+/**
+ * Runs microbenchmarks of single hot kernels (filters, classifiers and the renderer) on synthetic deterministic
+ * inputs and writes the timing statistics as JSON or CSV.
+ */
+int main(int argc, char *argv[])
+{
+	string verboseLevelConsole;
+	size_t warmupRepetitions, repetitions;
+	double minRepetitionTime;
+	string filter, format;
+	path outputFilename, wvmFilename;
+	unsigned int seed;
+
+	try {
+		po::options_description desc("Allowed options");
+		desc.add_options()
+			("help,h",
+				"produce help message")
+			("verbose,v", po::value<string>(&verboseLevelConsole)->implicit_value("DEBUG")->default_value("INFO", "show messages with INFO loglevel or below."),
+				"specify the verbosity of the console output: PANIC, ERROR, WARN, INFO, DEBUG or TRACE")
+			("warmup", po::value<size_t>(&warmupRepetitions)->default_value(3),
+				"the number of repetitions before measuring")
+			("repetitions,r", po::value<size_t>(&repetitions)->default_value(25),
+				"the number of measured repetitions")
+			("min-time", po::value<double>(&minRepetitionTime)->default_value(0.01),
+				"the minimum duration of one repetition in seconds, fast kernels are called several times per repetition")
+			("filter,f", po::value<string>(&filter)->default_value(""),
+				"only run the benchmarks whose name contains this string")
+			("format", po::value<string>(&format)->default_value("json"),
+				"the format of the results: json or csv")
+			("output,o", po::value<path>(&outputFilename)->default_value(""),
+				"the file to write the results to (standard output if not given)")
+			("wvm", po::value<path>(&wvmFilename)->default_value(""),
+				"a WVM classifier in the binary model format (see convert-classifier), the WVM benchmark is skipped if not given")
+			("seed", po::value<unsigned int>(&seed)->default_value(42),
+				"the seed of the synthetic inputs")
+			;
+
+		po::variables_map vm;
+		po::store(po::command_line_parser(argc, argv).options(desc).run(), vm);
+		if (vm.count("help")) {
+			cout << "Usage: microbenchmarkApp [options]\n";
+			cout << desc;
+			return EXIT_SUCCESS;
+		}
+		po::notify(vm);
+
+	}
+	catch (po::error& e) {
+		cerr << "Error while parsing command-line arguments: " << e.what() << endl;
+		cerr << "Use --help to display a list of options." << endl;
+		return EXIT_FAILURE;
+	}
+
+	LogLevel logLevel;
+	if (boost::iequals(verboseLevelConsole, "PANIC")) logLevel = LogLevel::Panic;
+	else if (boost::iequals(verboseLevelConsole, "ERROR")) logLevel = LogLevel::Error;
+	else if (boost::iequals(verboseLevelConsole, "WARN")) logLevel = LogLevel::Warn;
+	else if (boost::iequals(verboseLevelConsole, "INFO")) logLevel = LogLevel::Info;
+	else if (boost::iequals(verboseLevelConsole, "DEBUG")) logLevel = LogLevel::Debug;
+	else if (boost::iequals(verboseLevelConsole, "TRACE")) logLevel = LogLevel::Trace;
+	else {
+		cerr << "Error: Invalid LogLevel." << endl;
+		return EXIT_FAILURE;
+	}
+	if (!boost::iequals(format, "json") && !boost::iequals(format, "csv")) {
+		cerr << "Error: Invalid format, expected json or csv." << endl;
+		return EXIT_FAILURE;
+	}
+
+	// The results may be written to the standard output, so we log to the standard error:
+	Loggers->getLogger("classification").addAppender(make_shared<logging::ConsoleAppender>(logLevel, std::cerr));
+	Loggers->getLogger("microbenchmarkApp").addAppender(make_shared<logging::ConsoleAppender>(logLevel, std::cerr));
+	Logger appLogger = Loggers->getLogger("microbenchmarkApp");
+
+	Microbenchmark benchmark(warmupRepetitions, repetitions, minRepetitionTime);
+	double sink = 0; // the kernels accumulate a value of their results here, so they cannot be optimized away
+
+	// image filters on a VGA image
+	Mat image = createSyntheticImage(Size(640, 480), seed);
+	shared_ptr<GradientFilter> gradientFilter = make_shared<GradientFilter>(1);
+	Mat gradients = gradientFilter->applyTo(image);
+	shared_ptr<GradientBinningFilter> binningFilter = make_shared<GradientBinningFilter>(8, false, false);
+	shared_ptr<GradientBinningFilter> interpolatingBinningFilter = make_shared<GradientBinningFilter>(18, true, true);
+	Mat bins = interpolatingBinningFilter->applyTo(gradients);
+	shared_ptr<ExtendedHogFilter> hogFilter = make_shared<ExtendedHogFilter>(18, 5, true, true);
+	shared_ptr<Mat> filtered = make_shared<Mat>();
+
+	benchmark.add("GradientFilter/640x480", [=, &sink]() {
+		sink += gradientFilter->applyTo(image, *filtered).data[0];
+	});
+	benchmark.add("GradientBinningFilter/8bins/640x480", [=, &sink]() {
+		sink += binningFilter->applyTo(gradients, *filtered).data[0];
+	});
+	benchmark.add("GradientBinningFilter/18bins-signed-interpolated/640x480", [=, &sink]() {
+		sink += interpolatingBinningFilter->applyTo(gradients, *filtered).data[0];
+	});
+	benchmark.add("ExtendedHogFilter/18bins-cell5/640x480", [=, &sink]() {
+		sink += hogFilter->applyTo(bins, *filtered).data[0];
+	});
+
+	// histogram equalization of single patches and of all windows of an image
+	shared_ptr<HistEq64Filter> histEqFilter = make_shared<HistEq64Filter>();
+	Mat patch = createSyntheticImage(Size(20, 20), seed + 1);
+	Mat smallImage = createSyntheticImage(Size(160, 120), seed + 2);
+	benchmark.add("HistEq64Filter/applyTo/20x20", [=, &sink]() {
+		sink += histEqFilter->applyTo(patch, *filtered).data[0];
+	});
+	benchmark.add("HistEq64Filter/computeWindowLuts/160x120-20x20", [=, &sink]() {
+		Mat luts = histEqFilter->computeWindowLuts(smallImage, Size(20, 20), Rect(0, 0, 140, 100), 1, 1);
+		sink += luts.data[0];
+	});
+
+	// whitening of a set of patches (one by one and batched) and of an image with an unfavourable transform size
+	shared_ptr<WhiteningFilter> whiteningFilter = make_shared<WhiteningFilter>();
+	shared_ptr<WhiteningFilter> paddingWhiteningFilter = make_shared<WhiteningFilter>(1, 0.390625f, true);
+	shared_ptr<WhiteningFilter::Workspace> whiteningWorkspace = make_shared<WhiteningFilter::Workspace>();
+	vector<Mat> whiteningPatches;
+	for (int i = 0; i < 256; ++i)
+		whiteningPatches.push_back(createSyntheticImage(Size(20, 20), seed + 200 + i));
+	shared_ptr<vector<Mat>> whitenedPatches = make_shared<vector<Mat>>();
+	Mat oddImage = createSyntheticImage(Size(631, 467), seed + 7);
+	benchmark.add("WhiteningFilter/single/256x20x20", [=, &sink]() {
+		whitenedPatches->resize(whiteningPatches.size());
+		for (size_t i = 0; i < whiteningPatches.size(); ++i)
+			whiteningFilter->applyTo(whiteningPatches[i], (*whitenedPatches)[i], *whiteningWorkspace);
+		sink += whitenedPatches->back().data[0];
+	});
+	benchmark.add("WhiteningFilter/batch/256x20x20", [=, &sink]() {
+		whiteningFilter->applyTo(whiteningPatches, *whitenedPatches, *whiteningWorkspace);
+		sink += whitenedPatches->back().data[0];
+	});
+	benchmark.add("WhiteningFilter/unpadded/631x467", [=, &sink]() {
+		sink += whiteningFilter->applyTo(oddImage, *filtered, *whiteningWorkspace).data[0];
+	});
+	benchmark.add("WhiteningFilter/padded/631x467", [=, &sink]() {
+		sink += paddingWhiteningFilter->applyTo(oddImage, *filtered, *whiteningWorkspace).data[0];
+	});
+
+	// kernel functions
+	RbfKernel rbfKernel(0.05);
+	Mat vectorUchar1 = createRandomImage(Size(20, 20), CV_8UC1, seed + 3);
+	Mat vectorUchar2 = createRandomImage(Size(20, 20), CV_8UC1, seed + 4);
+	Mat vectorFloat1, vectorFloat2;
+	createRandomImage(Size(1, 1024), CV_32FC1, seed + 5).convertTo(vectorFloat1, CV_32F, 1.0 / 255);
+	createRandomImage(Size(1, 1024), CV_32FC1, seed + 6).convertTo(vectorFloat2, CV_32F, 1.0 / 255);
+	benchmark.add("RbfKernel/uchar-400", [=, &sink]() {
+		sink += rbfKernel.compute(vectorUchar1, vectorUchar2);
+	});
+	benchmark.add("RbfKernel/float-1024", [=, &sink]() {
+		sink += rbfKernel.compute(vectorFloat1, vectorFloat2);
+	});
+
+	// WVM (there is no synthetic WVM, as its filters are only meaningful when trained)
+	if (!wvmFilename.empty()) {
+		try {
+			shared_ptr<WvmClassifier> wvm = WvmClassifier::loadFromBinary(wvmFilename.string());
+			vector<Mat> patches;
+			for (int i = 0; i < 64; ++i)
+				patches.push_back(createSyntheticImage(wvm->getFilterSize(), seed + 100 + i));
+			shared_ptr<size_t> index = make_shared<size_t>(0);
+			benchmark.add("WvmClassifier/computeHyperplaneDistance", [=, &sink]() {
+				sink += wvm->computeHyperplaneDistance(patches[*index]).second;
+				*index = (*index + 1) % patches.size();
+			});
+		} catch (std::exception& e) {
+			appLogger.error("Could not load the WVM, skipping its benchmark: " + string(e.what()));
+		}
+	} else {
+		appLogger.info("No WVM given, skipping the WVM benchmark.");
+	}
+
+	// software renderer
+	Mesh mesh = createGridMesh(100);
+	Mat mvp = MatrixUtils::createOrthogonalProjectionMatrix(-1.2f, 1.2f, -1.2f, 1.2f, 0.1f, 100.0f) * MatrixUtils::createTranslationMatrix(0.0f, 0.0f, -2.0f);
+	shared_ptr<SoftwareRenderer> renderer = make_shared<SoftwareRenderer>(640, 480);
+	shared_ptr<SoftwareRenderer> tiledRenderer = make_shared<SoftwareRenderer>(640, 480);
+	tiledRenderer->doTiledRasterization = true;
+	benchmark.add("SoftwareRenderer/render/20000tris-640x480", [=, &sink]() {
+		sink += renderer->render(mesh, mvp).first.data[0];
+	});
+	benchmark.add("SoftwareRenderer/render-tiled/20000tris-640x480", [=, &sink]() {
+		sink += tiledRenderer->render(mesh, mvp).first.data[0];
+	});
+	MeshInstance meshInstance = MeshInstance::fromMesh(mesh);
+	benchmark.add("SoftwareRenderer/render-instance/20000tris-640x480", [=, &sink]() {
+		sink += renderer->render(meshInstance, mvp).first.data[0];
+	});
+
+	// HOG descriptors around 68 landmarks
+	vector<cv::Point2f> locations;
+	cv::RNG rng(seed + 7);
+	for (int i = 0; i < 68; ++i)
+		locations.push_back(cv::Point2f(rng.uniform(200.0f, 440.0f), rng.uniform(140.0f, 340.0f)));
+	shared_ptr<VlHogDescriptorExtractor> hogExtractor = make_shared<VlHogDescriptorExtractor>(VlHogDescriptorExtractor::VlHogType::DalalTriggs, 3, 10, 9);
+	benchmark.add("VlHogDescriptorExtractor/DalalTriggs/68landmarks", [=, &sink]() {
+		sink += hogExtractor->getDescriptors(image, locations, 0).at<float>(0, 0);
+	});
+
+	benchmark.run(filter, std::cerr);
+	appLogger.debug("Checksum of the results: " + std::to_string(sink));
+
+	if (outputFilename.empty()) {
+		if (boost::iequals(format, "json"))
+			benchmark.writeJson(cout);
+		else
+			benchmark.writeCsv(cout);
+	} else {
+		std::ofstream out(outputFilename.string().c_str());
+		if (!out.is_open()) {
+			appLogger.error("Could not open the output file " + outputFilename.string());
+			return EXIT_FAILURE;
+		}
+		if (boost::iequals(format, "json"))
+			benchmark.writeJson(out);
+		else
+			benchmark.writeCsv(out);
+	}
+	return EXIT_SUCCESS;
+}
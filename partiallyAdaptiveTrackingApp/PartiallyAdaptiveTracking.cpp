@@ -9,11 +9,15 @@
 #include "logging/LoggerFactory.hpp"
 #include "logging/Logger.hpp"
 #include "logging/ConsoleAppender.hpp"
+#include "logging/Instrumentation.hpp"
 #include "imageio/CameraImageSource.hpp"
 #include "imageio/VideoImageSource.hpp"
 #include "imageio/KinectImageSource.hpp"
 #include "imageio/DirectoryImageSource.hpp"
 #include "imageio/VideoImageSink.hpp"
+#include "imageio/SingleLandmarkSink.hpp"
+#include "imageio/LandmarkCollection.hpp"
+#include "imageio/RectLandmark.hpp"
 #include "imageprocessing/ImagePyramid.hpp"
 #include "imageprocessing/FeatureExtractor.hpp"
 #include "imageprocessing/DirectPyramidFeatureExtractor.hpp"
@@ -35,6 +39,7 @@
 #include "libsvm/LibSvmClassifier.hpp"
 #include "condensation/ResamplingSampler.hpp"
 #include "condensation/GridSampler.hpp"
+#include "condensation/HierarchicalGridSampler.hpp"
 #include "condensation/LowVarianceSampling.hpp"
 #include "condensation/SimpleTransitionModel.hpp"
 #include "condensation/WvmSvmModel.hpp"
@@ -50,6 +55,7 @@
 #include <iostream>
 #include <chrono>
 #include <sstream>
+#include <thread>
 
 using namespace logging;
 using namespace imageprocessing;
@@ -69,13 +75,18 @@ namespace po = boost::program_options;
 const string PartiallyAdaptiveTracking::videoWindowName = "Image";
 const string PartiallyAdaptiveTracking::controlWindowName = "Controls";
 
-PartiallyAdaptiveTracking::PartiallyAdaptiveTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink, ptree config) :
-		imageSource(move(imageSource)), imageSink(move(imageSink)) {
+PartiallyAdaptiveTracking::PartiallyAdaptiveTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink,
+		unique_ptr<OrderedLandmarkSink> resultSink, ptree config, bool headless) :
+				imageSource(move(imageSource)), imageSink(move(imageSink)), resultSink(move(resultSink)), headless(headless) {
 	initTracking(config);
-	initGui();
+	drawSamples = !headless;
+	if (!headless) // all windows and trackbars are created on the display thread, which also runs their callbacks
+		display.reset(new WindowImageSink(videoWindowName, 5, [this]() { initGui(); }));
 }
 
-PartiallyAdaptiveTracking::~PartiallyAdaptiveTracking() {}
+PartiallyAdaptiveTracking::~PartiallyAdaptiveTracking() {
+	display.reset(); // the GUI callbacks must not run while the tracker is destructed
+}
 
 shared_ptr<Kernel> PartiallyAdaptiveTracking::createKernel(ptree config) {
 	if (config.get_value<string>() == "rbf") {
@@ -192,8 +203,8 @@ void PartiallyAdaptiveTracking::initTracking(ptree config) {
 	resamplingSampler = make_shared<ResamplingSampler>(
 			config.get<unsigned int>("resampling.particleCount"), config.get<double>("resampling.randomRate"), make_shared<LowVarianceSampling>(),
 			transitionModel, config.get<double>("resampling.minSize"), config.get<double>("resampling.maxSize"));
-	gridSampler = make_shared<GridSampler>(config.get<int>("pyramid.patch.minWidth"), config.get<int>("pyramid.patch.maxWidth"),
-			1 / patchExtractor->getPyramid()->getIncrementalScaleFactor(), 0.1);
+	gridSampler = HierarchicalGridSampler::createGridSampler(config, staticMeasurementModel,
+			config.get<int>("pyramid.patch.minWidth"), config.get<int>("pyramid.patch.maxWidth"), 1 / patchExtractor->getPyramid()->getIncrementalScaleFactor());
 	tracker = unique_ptr<PartiallyAdaptiveCondensationTracker>(new PartiallyAdaptiveCondensationTracker(
 			resamplingSampler, staticMeasurementModel, adaptiveMeasurementModel,
 			make_shared<FilteringStateExtractor>(make_shared<WeightedMeanStateExtractor>())));
@@ -201,8 +212,6 @@ void PartiallyAdaptiveTracking::initTracking(ptree config) {
 }
 
 void PartiallyAdaptiveTracking::initGui() {
-	drawSamples = true;
-
 	cvNamedWindow(videoWindowName.c_str(), CV_WINDOW_AUTOSIZE);
 	cvMoveWindow(videoWindowName.c_str(), 50, 50);
 
@@ -233,11 +242,13 @@ void PartiallyAdaptiveTracking::initGui() {
 
 void PartiallyAdaptiveTracking::adaptiveChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->tracker->setUseAdaptiveModel(state == 1);
 }
 
 void PartiallyAdaptiveTracking::samplerChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	if (state == 0)
 		tracking->tracker->setSampler(tracking->gridSampler);
 	else
@@ -246,42 +257,106 @@ void PartiallyAdaptiveTracking::samplerChanged(int state, void* userdata) {
 
 void PartiallyAdaptiveTracking::sampleCountChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->resamplingSampler->setCount(state);
 }
 
 void PartiallyAdaptiveTracking::randomRateChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->resamplingSampler->setRandomRate(0.01 * state);
 }
 
 void PartiallyAdaptiveTracking::positionDeviationChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->transitionModel->setPositionDeviation(0.1 * state);
 }
 
 void PartiallyAdaptiveTracking::sizeDeviationChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->transitionModel->setSizeDeviation(0.01 * state);
 }
 
 void PartiallyAdaptiveTracking::drawSamplesChanged(int state, void* userdata) {
 	PartiallyAdaptiveTracking *tracking = (PartiallyAdaptiveTracking*)userdata;
+	std::lock_guard<std::mutex> lock(tracking->trackingMutex);
 	tracking->drawSamples = (state == 1);
 }
 
-void PartiallyAdaptiveTracking::drawDebug(cv::Mat& image) {
+bool PartiallyAdaptiveTracking::needsVisualization() const {
+	// frames that the display thread would drop anyway are not prepared at all
+	return imageSink || (display && display->isReady());
+}
+
+PartiallyAdaptiveTracking::Visualization PartiallyAdaptiveTracking::createVisualization(const Mat& frame, optional<Rect> target) {
+	Visualization visualization;
+	visualization.image = frame;
+	if (drawSamples) {
+		const std::vector<shared_ptr<Sample>>& samples = tracker->getSamples();
+		visualization.samples.reserve(samples.size());
+		for (const shared_ptr<Sample>& sample : samples)
+			visualization.samples.push_back(*sample);
+	}
+	visualization.target = target;
+	visualization.usedAdaptive = tracker->wasUsingAdaptiveModel();
+	return visualization;
+}
+
+void PartiallyAdaptiveTracking::show(const Visualization& visualization) {
+	if (display && display->isReady()) {
+		display->add(visualization.image, [visualization](Mat& image) {
+			draw(image, visualization);
+		});
+	}
+	if (imageSink) {
+		Mat image;
+		visualization.image.copyTo(image);
+		draw(image, visualization);
+		imageSink->add(image);
+	}
+}
+
+void PartiallyAdaptiveTracking::addResult(optional<Rect> target) {
+	if (resultSink) {
+		LandmarkCollection collection;
+		if (target)
+			collection.insert(make_shared<RectLandmark>("target", *target));
+		else
+			collection.insert(make_shared<RectLandmark>("target"));
+		resultSink->add(collection);
+	}
+}
+
+void PartiallyAdaptiveTracking::handleKey(int key) {
+	char c = (char)key;
+	if (c == 'p')
+		paused = !paused;
+	else if (c == 'q')
+		stop();
+}
+
+void PartiallyAdaptiveTracking::waitForQuit(const string& message) {
+	if (display) {
+		std::cerr << message << " - press 'q' to quit program" << std::endl;
+		while ('q' != (char)display->getKey())
+			std::this_thread::sleep_for(milliseconds(10));
+	}
+}
+
+void PartiallyAdaptiveTracking::draw(Mat& image, const Visualization& visualization) {
 	cv::Scalar black(0, 0, 0); // blue, green, red
 	cv::Scalar red(0, 0, 255); // blue, green, red
 	cv::Scalar green(0, 255, 0); // blue, green, red
-	if (drawSamples) {
-		const std::vector<shared_ptr<Sample>> samples = tracker->getSamples();
-		for (const shared_ptr<Sample>& sample : samples) {
-			const cv::Scalar& color = sample->isTarget() ? cv::Scalar(0, 0, sample->getWeight() * 255) : black;
-			cv::circle(image, cv::Point(sample->getX(), sample->getY()), 3, color);
-		}
+	for (const Sample& sample : visualization.samples) {
+		const cv::Scalar& color = sample.isTarget() ? cv::Scalar(0, 0, sample.getWeight() * 255) : black;
+		cv::circle(image, cv::Point(sample.getX(), sample.getY()), 3, color);
 	}
-	cv::Scalar& svmIndicatorColor = tracker->wasUsingAdaptiveModel() ? green : red;
-	cv::circle(image, cv::Point(10, 10), 5, svmIndicatorColor, -1);
+	cv::Scalar& color = visualization.usedAdaptive ? green : red;
+	cv::circle(image, cv::Point(10, 10), 5, color, -1);
+	if (visualization.target)
+		cv::rectangle(image, *visualization.target, color);
 }
 
 void PartiallyAdaptiveTracking::run() {
@@ -289,44 +364,37 @@ void PartiallyAdaptiveTracking::run() {
 	running = true;
 	paused = false;
 
-	bool first = true;
-	cv::Mat frame, image;
-	cv::Scalar green(0, 255, 0); // blue, green, red
-	cv::Scalar red(0, 0, 255); // blue, green, red
+	cv::Mat frame;
 
 	duration<double> allIterationTime;
 	duration<double> allCondensationTime;
 	int frames = 0;
 
 	while (running) {
-		frames++;
 		steady_clock::time_point frameStart = steady_clock::now();
 		frame = imageSource->get();
 
 		if (frame.empty()) {
-			std::cerr << "Could not capture frame - press 'q' to quit program" << std::endl;
 			stop();
-			while ('q' != (char)cv::waitKey(10));
+			waitForQuit("Could not capture frame");
 		} else {
-			if (first) {
-				first = false;
-				image.create(frame.rows, frame.cols, frame.type());
-			}
+			frames++;
 			steady_clock::time_point condensationStart = steady_clock::now();
-			boost::optional<Rect> face = tracker->process(frame);
-			steady_clock::time_point condensationEnd = steady_clock::now();
-			image = frame;
-			drawDebug(image);
-			cv::Scalar& color = tracker->wasUsingAdaptiveModel() ? green : red;
-			if (face)
-				cv::rectangle(image, *face, color);
-			imshow(videoWindowName, image);
-			if (imageSink.get() != 0)
-				imageSink->add(image);
+			optional<Rect> face;
+			milliseconds condensationTime;
+			{
+				std::lock_guard<std::mutex> lock(trackingMutex);
+				face = tracker->process(frame);
+				steady_clock::time_point condensationEnd = steady_clock::now();
+				condensationTime = duration_cast<milliseconds>(condensationEnd - condensationStart);
+				addResult(face);
+				if (needsVisualization())
+					show(createVisualization(frame, face));
+			}
 			steady_clock::time_point frameEnd = steady_clock::now();
+			INSTRUMENT_END_FRAME();
 
 			milliseconds iterationTime = duration_cast<milliseconds>(frameEnd - frameStart);
-			milliseconds condensationTime = duration_cast<milliseconds>(condensationEnd - condensationStart);
 			allIterationTime += iterationTime;
 			allCondensationTime += condensationTime;
 			float iterationFps = frames / allIterationTime.count();
@@ -338,14 +406,25 @@ void PartiallyAdaptiveTracking::run() {
 					<< " condensation: " << condensationTime.count() << " ms (" << condensationFps << " fps)";
 			log.info(text.str());
 
-			int delay = paused ? 0 : 5;
-			char c = (char)cv::waitKey(delay);
-			if (c == 'p')
-				paused = !paused;
-			else if (c == 'q')
-				stop();
+			if (display)
+				handleKey(display->getKey());
+			while (running && paused) {
+				std::this_thread::sleep_for(milliseconds(10));
+				handleKey(display->getKey());
+			}
 		}
 	}
+
+	if (frames > 0) {
+		ostringstream text;
+		text.precision(3);
+		text << "Tracked " << frames << " frames with " << (frames / allIterationTime.count()) << " fps"
+				<< " (condensation: " << (frames / allCondensationTime.count()) << " fps)";
+		if (display)
+			text << ", " << display->getDroppedCount() << " frames were not displayed";
+		log.info(text.str());
+	}
+	display.reset();
 }
 
 void PartiallyAdaptiveTracking::stop() {
@@ -361,6 +440,9 @@ int main(int argc, char *argv[]) {
 	string configFile;
 	string outputFile;
 	int outputFps = -1;
+	string resultFile;
+	bool headless = false;
+	string instrumentationFile;
 
 	try {
 		po::options_description desc("Allowed options");
@@ -375,6 +457,9 @@ int main(int argc, char *argv[]) {
 			("config,c", po::value< string >(&configFile)->default_value("default.cfg","default.cfg"), "The filename to the config file.")
 			("output,o", po::value< string >(&outputFile)->default_value("","none"), "Filename to a video file for storing the image data.")
 			("output-fps,r", po::value<int>(&outputFps)->default_value(-1), "The framerate of the output video.")
+			("result,R", po::value< string >(&resultFile)->default_value("","none"), "Filename to a text file for storing the estimated target position of each frame.")
+			("headless", "Run the tracking without any window, e.g. for measuring the throughput.")
+			("instrumentation", po::value< string >(&instrumentationFile)->default_value("","none"), "Filename to a JSON file for storing the per-frame stage timings and counters (needs WITH_INSTRUMENTATION).")
 			;
 
 		po::variables_map vm;
@@ -394,6 +479,8 @@ int main(int argc, char *argv[]) {
 			useCamera = true;
 		if (vm.count("kinect"))
 			useKinect = true;
+		if (vm.count("headless"))
+			headless = true;
 	}
 	catch (std::exception& e) {
 		std::cout << e.what() << std::endl;
@@ -435,9 +522,15 @@ int main(int argc, char *argv[]) {
 		imageSink.reset(new VideoImageSink(outputFile, outputFps));
 	}
 
+	unique_ptr<OrderedLandmarkSink> resultSink;
+	if (resultFile != "")
+		resultSink.reset(new SingleLandmarkSink(resultFile));
+
 	ptree config;
 	read_info(configFile, config);
-	unique_ptr<PartiallyAdaptiveTracking> tracker(new PartiallyAdaptiveTracking(move(imageSource), move(imageSink), config.get_child("tracking")));
+	unique_ptr<PartiallyAdaptiveTracking> tracker(new PartiallyAdaptiveTracking(move(imageSource), move(imageSink), move(resultSink), config.get_child("tracking"), headless));
 	tracker->run();
+	if (instrumentationFile != "")
+		Instrumentation::Instance()->writeJson(instrumentationFile);
 	return 0;
 }
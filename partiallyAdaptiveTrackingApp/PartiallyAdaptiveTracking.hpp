@@ -10,6 +10,8 @@
 
 #include "imageio/ImageSource.hpp"
 #include "imageio/ImageSink.hpp"
+#include "imageio/WindowImageSink.hpp"
+#include "imageio/OrderedLandmarkSink.hpp"
 #include "classification/Kernel.hpp"
 #include "classification/TrainableSvmClassifier.hpp"
 #include "classification/TrainableProbabilisticClassifier.hpp"
@@ -18,19 +20,24 @@
 #include "condensation/MeasurementModel.hpp"
 #include "condensation/SimpleTransitionModel.hpp"
 #include "condensation/ResamplingSampler.hpp"
-#include "condensation/GridSampler.hpp"
+#include "condensation/Sampler.hpp"
+#include "condensation/Sample.hpp"
 #include "opencv2/highgui/highgui.hpp"
 #include "boost/property_tree/ptree.hpp"
+#include "boost/optional.hpp"
 #include <memory>
 #include <string>
-#include <memory>
-#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
 
 using namespace imageio;
 using namespace condensation;
 using namespace classification;
 using cv::Mat;
+using cv::Rect;
 using boost::property_tree::ptree;
+using boost::optional;
 using std::string;
 using std::unique_ptr;
 using std::shared_ptr;
@@ -39,7 +46,17 @@ using std::make_shared;
 class PartiallyAdaptiveTracking {
 public:
 
-	PartiallyAdaptiveTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink, ptree config);
+	/**
+	 * Constructs a new partially adaptive tracking.
+	 *
+	 * @param[in] imageSource Source of the images.
+	 * @param[in] imageSink Sink for the visualized images (may be null). Is written to on the tracking thread.
+	 * @param[in] resultSink Sink for the estimated target positions, one per frame (may be null).
+	 * @param[in] config The configuration of the tracking.
+	 * @param[in] headless Flag that indicates whether to run without any window.
+	 */
+	PartiallyAdaptiveTracking(unique_ptr<ImageSource> imageSource, unique_ptr<ImageSink> imageSink,
+			unique_ptr<OrderedLandmarkSink> resultSink, ptree config, bool headless);
 	virtual ~PartiallyAdaptiveTracking();
 
 	void run();
@@ -47,6 +64,17 @@ public:
 
 private:
 
+	/**
+	 * Copy of everything that is drawn onto a frame, so the drawing can happen on the display thread
+	 * while the tracker already processes the next frame.
+	 */
+	struct Visualization {
+		Mat image; ///< The frame.
+		std::vector<Sample> samples; ///< Copies of the samples, empty if they should not be drawn.
+		optional<Rect> target; ///< The estimated position of the target.
+		bool usedAdaptive; ///< Flag that indicates whether the adaptive measurement model was used.
+	};
+
 	static void adaptiveChanged(int state, void* userdata);
 	static void samplerChanged(int state, void* userdata);
 	static void sampleCountChanged(int state, void* userdata);
@@ -60,16 +88,26 @@ private:
 	shared_ptr<TrainableProbabilisticClassifier> createClassifier(shared_ptr<TrainableSvmClassifier> trainableSvm, ptree config);
 	void initTracking(ptree config);
 	void initGui();
-	void drawDebug(Mat& image);
+	bool needsVisualization() const;
+	Visualization createVisualization(const Mat& frame, optional<Rect> target);
+	void show(const Visualization& visualization);
+	void addResult(optional<Rect> target);
+	void handleKey(int key);
+	void waitForQuit(const string& message);
+	static void draw(Mat& image, const Visualization& visualization);
 
 	static const string videoWindowName;
 	static const string controlWindowName;
 
 	unique_ptr<ImageSource> imageSource;
 	unique_ptr<ImageSink> imageSink;
+	unique_ptr<OrderedLandmarkSink> resultSink;
+	unique_ptr<WindowImageSink> display; ///< Shows the images and runs the GUI callbacks on a thread of its own, null if headless.
+	std::mutex trackingMutex; ///< Guards the tracker against changes by the GUI callbacks, which run on the display thread.
 
-	bool running;
+	std::atomic<bool> running;
 	bool paused;
+	bool headless;
 	bool drawSamples;
 
 	unique_ptr<PartiallyAdaptiveCondensationTracker> tracker;
@@ -77,7 +115,7 @@ private:
 	shared_ptr<AdaptiveMeasurementModel> adaptiveMeasurementModel;
 	shared_ptr<SimpleTransitionModel> transitionModel;
 	shared_ptr<ResamplingSampler> resamplingSampler;
-	shared_ptr<GridSampler> gridSampler;
+	shared_ptr<Sampler> gridSampler;
 };
 
 #endif /* PARTIALLYADAPTIVETRACKING_HPP_ */
@@ -33,6 +33,11 @@
 #include <chrono>
 #include <memory>
 #include <unordered_map>
+#include <thread>
+#include <future>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 
 #include "opencv2/core/core.hpp"
 #include "opencv2/imgproc/imgproc.hpp"
@@ -62,6 +67,8 @@
 #include "imageprocessing/UnitNormFilter.hpp"
 #include "imageprocessing/WhiteningFilter.hpp"
 
+#include "classification/BinaryModelFile.hpp"
+
 #include "logging/LoggerFactory.hpp"
 
 namespace po = boost::program_options;
@@ -69,7 +76,11 @@ using namespace std;
 using namespace imageprocessing;
 using logging::Logger;
 using logging::LoggerFactory;
-using logging::loglevel;
+using logging::LogLevel;
+using classification::BinaryModelReader;
+using classification::BinaryPatchSetReader;
+using classification::BinaryPatchSetWriter;
+using cv::Mat;
 using boost::filesystem::path;
 using boost::lexical_cast;
 
@@ -81,6 +92,140 @@ ostream& operator<<(ostream& os, const vector<T>& v)
 	return os;
 }
 
+/**
+ * Reads patches chunk by chunk, either from a text file (one patch per line, whitespace-separated
+ * values in [0, 1]) or from a binary patch set. The patches are returned as CV_8U in [0, 255].
+ */
+class PatchReader
+{
+public:
+	PatchReader(const path& filename, int patchWidth, int patchHeight) : patchWidth(patchWidth), patchHeight(patchHeight)
+	{
+		if (BinaryModelReader::isBinaryModelFile(filename.string())) {
+			binaryReader = make_shared<BinaryPatchSetReader>(filename.string());
+			if (binaryReader->getWidth() != patchWidth || binaryReader->getHeight() != patchHeight || CV_MAT_CN(binaryReader->getType()) != 1) {
+				throw runtime_error("The patches of " + filename.string() + " are not " + lexical_cast<string>(patchWidth) + "x" + lexical_cast<string>(patchHeight) + " single-channel patches.");
+			}
+		}
+		else {
+			textFile.open(filename.string());
+			if (!textFile.is_open()) {
+				throw runtime_error("Error opening input file " + filename.string());
+			}
+		}
+	}
+
+	/**
+	 * Reads the next patches, at most maxCount. Returns an empty vector at the end of the file.
+	 */
+	vector<Mat> read(size_t maxCount)
+	{
+		vector<Mat> patches;
+		if (binaryReader) {
+			binaryReader->read(patches, maxCount);
+			for (auto& patch : patches) {
+				if (patch.depth() != CV_8U) {
+					patch.convertTo(patch, CV_8U, 255.0); // float patches are in [0, 1], like the text files
+				}
+			}
+			return patches;
+		}
+		patches.reserve(maxCount);
+		const int dimensions = patchWidth * patchHeight;
+		while (patches.size() < maxCount && std::getline(textFile, line)) {
+			if (line.empty()) {
+				continue;
+			}
+			Mat patch(patchHeight, patchWidth, CV_8U);
+			uchar* values = patch.ptr<uchar>(0);
+			const char* position = line.c_str();
+			for (int j = 0; j < dimensions; ++j) {
+				char* end;
+				float val = std::strtof(position, &end);
+				if (end == position) {
+					throw runtime_error("Invalid patches file: A line has less than " + lexical_cast<string>(dimensions) + " values.");
+				}
+				values[j] = static_cast<uchar>(val*255.0f);
+				position = end;
+			}
+			patches.push_back(patch);
+		}
+		return patches;
+	}
+
+private:
+	int patchWidth, patchHeight;
+	shared_ptr<BinaryPatchSetReader> binaryReader; ///< Set if the input is a binary patch set.
+	std::ifstream textFile; ///< Open if the input is a text file.
+	string line; ///< Buffer for the current line of the text file.
+};
+
+/**
+ * Writes the converted patches chunk by chunk, either as text (one patch per line) or as
+ * binary patch set. The format is chosen by the extension of the file, .txt means text.
+ */
+class PatchWriter
+{
+public:
+	explicit PatchWriter(const path& filename) : filename(filename)
+	{
+		if (boost::iequals(filename.extension().string(), ".txt")) {
+			textFile.open(filename.string(), std::ios::binary);
+			if (!textFile.is_open()) {
+				throw runtime_error("Error creating output file " + filename.string());
+			}
+		}
+	}
+
+	void write(const vector<Mat>& patches)
+	{
+		if (patches.empty()) {
+			return;
+		}
+		if (!textFile.is_open()) {
+			if (!binaryWriter) { // the size and type of the converted patches is only known now
+				binaryWriter = make_shared<BinaryPatchSetWriter>(filename.string(), patches.front().rows, patches.front().cols, patches.front().type());
+			}
+			binaryWriter->write(patches);
+			return;
+		}
+		// Format the whole chunk into one buffer instead of streaming every value:
+		buffer.clear();
+		char value[32];
+		for (const auto& p : patches) {
+			const float* values = p.ptr<float>(0);
+			for (size_t j = 0; j < p.total(); ++j) {
+				int length = std::snprintf(value, sizeof(value), "%g ", values[j]);
+				buffer.append(value, length);
+			}
+			buffer.push_back('\n');
+		}
+		textFile.write(buffer.data(), buffer.size());
+		if (!textFile) {
+			throw runtime_error("Error writing output file " + filename.string());
+		}
+	}
+
+	void close()
+	{
+		if (binaryWriter) {
+			binaryWriter->close();
+		}
+		else if (!textFile.is_open()) { // no patches at all, write an empty patch set
+			BinaryPatchSetWriter(filename.string(), 0, 0, CV_32F).close();
+		}
+		else {
+			textFile.close();
+		}
+	}
+
+private:
+	path filename;
+	shared_ptr<BinaryPatchSetWriter> binaryWriter; ///< Created with the first patches if the output is binary.
+	std::ofstream textFile; ///< Open if the output is a text file.
+	string buffer; ///< Buffer for formatting the text of a chunk.
+};
+
 int main(int argc, char *argv[])
 {
 	#ifdef WIN32
@@ -100,6 +245,8 @@ int main(int argc, char *argv[])
 	ConversionMethod conversionMethod;
 	bool doResize;
 	int resizedWidth, resizedHeight;
+	size_t chunkSize;
+	unsigned int numThreads;
 
 	try {
 		po::options_description desc("Allowed options");
@@ -109,9 +256,9 @@ int main(int argc, char *argv[])
 			("verbose,v", po::value<string>(&verboseLevelConsole)->implicit_value("DEBUG")->default_value("INFO","show messages with INFO loglevel or below."),
 				  "specify the verbosity of the console output: PANIC, ERROR, WARN, INFO, DEBUG or TRACE")
 			("input,i", po::value<path>(&inputFilename)->required(),
-				"input file (.txt, containing patches)")
+				"input file (.txt, containing patches, or a binary patch set)")
 			("output,o", po::value<path>(&outputFilename)->required(),
-				"output file for the result patches")
+				"output file for the result patches (.txt for text, anything else for a binary patch set, e.g. .bcm)")
 			("patch-width,w", po::value<int>(&patchWidth)->required(),
 				"output file for the result patches")
 			("patch-height,h", po::value<int>(&patchHeight)->required(),
@@ -124,6 +271,10 @@ int main(int argc, char *argv[])
 				"todo")
 			("resized-height,t", po::value<int>(&resizedHeight),
 				"todo")
+			("chunk-size,c", po::value<size_t>(&chunkSize)->default_value(4096),
+				"number of patches that are read, converted and written at once")
+			("threads,j", po::value<unsigned int>(&numThreads)->default_value(0),
+				"number of threads that convert the patches, 0 uses one per hardware thread")
 		;
 
 		po::variables_map vm;
@@ -143,13 +294,13 @@ int main(int argc, char *argv[])
 		return EXIT_FAILURE;
 	}
 
-	loglevel logLevel;
-	if(boost::iequals(verboseLevelConsole, "PANIC")) logLevel = loglevel::PANIC;
-	else if(boost::iequals(verboseLevelConsole, "ERROR")) logLevel = loglevel::ERROR;
-	else if(boost::iequals(verboseLevelConsole, "WARN")) logLevel = loglevel::WARN;
-	else if(boost::iequals(verboseLevelConsole, "INFO")) logLevel = loglevel::INFO;
-	else if(boost::iequals(verboseLevelConsole, "DEBUG")) logLevel = loglevel::DEBUG;
-	else if(boost::iequals(verboseLevelConsole, "TRACE")) logLevel = loglevel::TRACE;
+	LogLevel logLevel;
+	if(boost::iequals(verboseLevelConsole, "PANIC")) logLevel = LogLevel::Panic;
+	else if(boost::iequals(verboseLevelConsole, "ERROR")) logLevel = LogLevel::Error;
+	else if(boost::iequals(verboseLevelConsole, "WARN")) logLevel = LogLevel::Warn;
+	else if(boost::iequals(verboseLevelConsole, "INFO")) logLevel = LogLevel::Info;
+	else if(boost::iequals(verboseLevelConsole, "DEBUG")) logLevel = LogLevel::Debug;
+	else if(boost::iequals(verboseLevelConsole, "TRACE")) logLevel = LogLevel::Trace;
 	else {
 		cout << "Invalid loglevel." << endl;
 		return EXIT_FAILURE;
@@ -159,7 +310,7 @@ int main(int argc, char *argv[])
 	Loggers->getLogger("patchConverter").addAppender(make_shared<logging::ConsoleAppender>(logLevel));
 	Logger appLogger = Loggers->getLogger("patchConverter");
 
-	appLogger.debug("Verbose level for console output: " + logging::loglevelToString(logLevel));
+	appLogger.debug("Verbose level for console output: " + logging::logLevelToString(logLevel));
 
 	if (conversionMethodNum == 0) {
 		conversionMethod = ConversionMethod::H;
@@ -170,6 +321,13 @@ int main(int argc, char *argv[])
 		appLogger.error("Unknown conversion method.");
 		return EXIT_FAILURE;
 	}
+	if (chunkSize == 0) {
+		appLogger.error("The chunk size must be greater than zero.");
+		return EXIT_FAILURE;
+	}
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
 	
 	// Read a txt patchset from Cog, do WHI, and write a new .txt.
 	// =================================================================
@@ -178,39 +336,16 @@ int main(int argc, char *argv[])
 	// -w 31 -h 31
 	// Example usage:
 	// -i C:\Users\Patrik\Documents\GitHub\tmp_regre_redMachines\data\posPatches.txt -o C:\Users\Patrik\Documents\GitHub\tmp_regre_redMachines\data\posPatches_out.txt -w 31 -h 31 -m 0 -r -s 19 -t 19
-	vector<cv::Mat> patches;
-	std::ifstream file(inputFilename.string());
-	if (!file.is_open()) {
-		appLogger.error("Error opening input file.");
-		return EXIT_FAILURE;
-	}
-	while (file.good()) {
-		string line;
-		if (!std::getline(file, line))
-			break;
-
-		int dimensions = patchWidth * patchHeight;
-		Mat patch(patchHeight, patchWidth, CV_8U);
-		std::istringstream lineStream(line);
-		if (!lineStream.good() || lineStream.fail()) {
-			std::cout << "Invalid patches file l2" << std::endl;
-			return 0;
-		}
-		uchar* values = patch.ptr<uchar>(0);
-		float val;
-		for (int j = 0; j < dimensions; ++j) {
-			lineStream >> val;
-			values[j] = static_cast<uchar>(val*255.0f);
-		}
-
-		patches.push_back(patch);
-	}
-	file.close();
+	// The patches are streamed through the filters in chunks of chunkSize, so the memory
+	// doesn't grow with the size of the file: While one chunk is converted by numThreads
+	// threads, the next one is read and the previous one is written.
 
+	shared_ptr<ImageFilter> resizingFilter;
+	shared_ptr<WhiteningFilter> whiteningFilter; // applied to all patches of a thread at once, after resizing and before the other filters
 	vector<shared_ptr<ImageFilter>> filters;
 
 	if (doResize) {
-		filters.push_back(make_shared<ResizingFilter>(cv::Size(resizedWidth, resizedHeight)));
+		resizingFilter = make_shared<ResizingFilter>(cv::Size(resizedWidth, resizedHeight));
 	}
 
 	if (conversionMethod == ConversionMethod::H) {
@@ -220,39 +355,77 @@ int main(int argc, char *argv[])
 		filters.push_back(make_shared<ReshapingFilter>(1));
 	} 
 	else if (conversionMethod == ConversionMethod::WHI) {
-		filters.push_back(make_shared<WhiteningFilter>());
+		whiteningFilter = make_shared<WhiteningFilter>();
 		filters.push_back(make_shared<HistogramEqualizationFilter>()); // min/max, stretch to [0, 255] 8U
 		filters.push_back(make_shared<ConversionFilter>(CV_32F, 1.0 / 127.5, -1.0)); // need to go back to [-1, 1] before UnitNormFilter
 		filters.push_back(make_shared<UnitNormFilter>(cv::NORM_L2));
 		filters.push_back(make_shared<ReshapingFilter>(1));
 	}
 
-	for (auto& p : patches) {
-		for (const auto& f : filters) {
-			f->applyInPlace(p);
+	// Converts the patches [begin, end) of a chunk. The filters are shared between the threads,
+	// only the whitening buffers are per thread.
+	vector<WhiteningFilter::Workspace> workspaces(numThreads);
+	auto convert = [&](vector<Mat>& patches, size_t begin, size_t end, WhiteningFilter::Workspace& workspace) {
+		if (resizingFilter) {
+			for (size_t i = begin; i < end; ++i) {
+				resizingFilter->applyInPlace(patches[i]);
+			}
 		}
-	}
+		if (whiteningFilter) {
+			vector<Mat> slice(patches.begin() + begin, patches.begin() + end);
+			whiteningFilter->applyTo(slice, slice, workspace);
+			std::copy(slice.begin(), slice.end(), patches.begin() + begin);
+		}
+		for (size_t i = begin; i < end; ++i) {
+			for (const auto& f : filters) {
+				f->applyInPlace(patches[i]);
+			}
+		}
+	};
 
-	if (doResize) {
-		patchWidth = resizedWidth;
-		patchHeight = resizedHeight;
+	size_t numPatches = 0;
+	auto start = std::chrono::system_clock::now();
+	try {
+		PatchReader reader(inputFilename, patchWidth, patchHeight);
+		PatchWriter writer(outputFilename);
+		vector<Mat> patches = reader.read(chunkSize);
+		vector<Mat> convertedPatches; // the previous chunk, while it is written
+		std::future<void> writing;
+		while (!patches.empty()) {
+			std::future<vector<Mat>> reading = std::async(std::launch::async, [&reader, chunkSize]() { return reader.read(chunkSize); });
+
+			size_t threadCount = std::min(static_cast<size_t>(numThreads), patches.size());
+			size_t sliceSize = (patches.size() + threadCount - 1) / threadCount;
+			vector<std::thread> threads;
+			for (size_t t = 1; t < threadCount; ++t) {
+				size_t begin = std::min(t * sliceSize, patches.size());
+				size_t end = std::min(begin + sliceSize, patches.size());
+				threads.emplace_back(convert, std::ref(patches), begin, end, std::ref(workspaces[t]));
+			}
+			convert(patches, 0, std::min(sliceSize, patches.size()), workspaces[0]);
+			for (auto& thread : threads) {
+				thread.join();
+			}
+			numPatches += patches.size();
+
+			if (writing.valid()) {
+				writing.get();
+			}
+			convertedPatches.swap(patches);
+			writing = std::async(std::launch::async, [&writer, &convertedPatches]() { writer.write(convertedPatches); });
+			patches = reading.get();
+		}
+		if (writing.valid()) {
+			writing.get();
+		}
+		writer.close();
 	}
-	
-	std::ofstream ofile(outputFilename.string());
-	if (!ofile.is_open()) {
-		appLogger.error("Error creating output file.");
+	catch (std::exception& e) {
+		appLogger.error(e.what());
 		return EXIT_FAILURE;
 	}
-	for (auto& p : patches) {
-		int dimensions = patchWidth * patchHeight;
-		float* values = p.ptr<float>(0);
-		for (int j = 0; j < dimensions; ++j) {
-			ofile << values[j] << " ";
-		}
-		ofile << "\n";
-	}
-	ofile.close();
+	auto end = std::chrono::system_clock::now();
+	appLogger.info("Converted " + lexical_cast<string>(numPatches) + " patches in " + lexical_cast<string>(std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()) + "ms.");
 	
 	return 0;
 }
-
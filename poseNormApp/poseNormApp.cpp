@@ -40,6 +40,7 @@
 
 #include "render/SoftwareRenderer.hpp"
 #include "render/MeshUtils.hpp"
+#include "render/MeshExport.hpp"
 #include "render/utils.hpp"
 
 #include "imageio/ImageSource.hpp"
@@ -270,6 +271,8 @@ int main(int argc, char *argv[])
 
     vector<imageio::ModelLandmark> landmarks;
     float lambda = config.get_child("fitting", ptree()).get<float>("lambda", 15.0f);
+	fitting::AffineCameraEstimator cameraEstimator(morphableModel); // re-uses its buffers between images. Note: No warmStart, the images are independent.
+	fitting::LinearShapeFitter shapeFitter(morphableModel); // caches the landmark subspace between images
 
 	SdmLandmarkModel lmModel = SdmLandmarkModel::load(sdmModelFile);
 	SdmLandmarkModelFitting modelFitter(lmModel);
@@ -290,6 +293,7 @@ int main(int argc, char *argv[])
 		landmarkMapper = LandmarkMapper(landmarkMappings);
 	} // Ideas for a better solution: A flag in LandmarkMapper, or polymorphism (IdentityLandmarkMapper), or in Mapper, if mapping empty, return input?, or...?
 	
+	render::utils::TextureExtractor textureExtractor; // keeps its renderer and threads for all images
 	while (imageSource->next()) {
 		start = std::chrono::system_clock::now();
 		appLogger.info("Starting to process " + imageSource->getName().string());
@@ -357,7 +361,7 @@ int main(int argc, char *argv[])
 			}
 		}
 		
-		Mat affineCam = fitting::estimateAffineCamera(landmarksClipSpace, morphableModel);
+		Mat affineCam = cameraEstimator.estimate(landmarksClipSpace);
 
 		// Render the mean-face landmarks projected using the estimated camera:
 		// Todo/Note: Here we render all landmarks. Shouldn't we only render the ones that exist in the model? (see above, landmarksClipSpace)
@@ -376,7 +380,7 @@ int main(int argc, char *argv[])
 		// Estimate the shape coefficients:
 		// Detector variances: Should not be in pixels. Should be normalised by the IED. Normalise by the image dimensions is not a good idea either, it has nothing to do with it. See comment in fitShapeToLandmarksLinear().
 		// Let's just use the hopefully reasonably set default value for now (around 3 pixels)
-		vector<float> fittedCoeffs = fitting::fitShapeToLandmarksLinear(morphableModel, affineCam, landmarksClipSpace, lambda);
+		vector<float> fittedCoeffs = shapeFitter.fit(affineCam, landmarksClipSpace, lambda);
 
 		// Obtain the full mesh and render it using the estimated camera:
 		Mesh mesh = morphableModel.drawSample(fittedCoeffs, vector<float>()); // takes standard-normal (not-normalised) coefficients
@@ -391,19 +395,26 @@ int main(int argc, char *argv[])
 
 		// Extract the texture
 		// Todo: check for if hasTexture, we can't do it if the model doesn't have texture coordinates
-		Mat textureMap = render::utils::extractTexture(mesh, fullAffineCam, img.cols, img.rows, img, framebuffer.second);
+		Mat textureMap = textureExtractor.extract(mesh, fullAffineCam, img.cols, img.rows, img);
 
-		// Save the extracted texture map (isomap):
+		// Save the extracted texture map (isomap), together with the mesh if requested:
         path isomapFilename = outputPath / imageSource->getName().stem();
 		isomapFilename += "_isomap.png";
-		cv::imwrite(isomapFilename.string(), textureMap);
+		if (config.get_child("output", ptree()).get<bool>("writeObj", false)) {
+			path outMesh = outputPath / imageSource->getName().stem();
+			outMesh.replace_extension("obj");
+			render::utils::writeMeshAndTexture(mesh, outMesh.string(), textureMap, isomapFilename.string());
+		}
+		else {
+			cv::imwrite(isomapFilename.string(), textureMap);
+		}
 
 		// Render the shape-model with the extracted texture from a frontal viewpoint:
 		float aspect = static_cast<float>(img.cols) / static_cast<float>(img.rows);
 		Mat frontalCam = render::utils::MatrixUtils::createOrthogonalProjectionMatrix(-1.0f * aspect, 1.0f * aspect, -1.0f, 1.0f, 0.1f, 100.0f) * render::utils::MatrixUtils::createScalingMatrix(1.0f / 120.0f, 1.0f / 120.0f, 1.0f / 120.0f);
 		softwareRenderer.enableTexturing(true);
 		auto texture = make_shared<render::Texture>();
-		texture->createFromFile(isomapFilename.string());
+		texture->createFromImage(textureMap);
 		softwareRenderer.setCurrentTexture(texture);
 		auto frFrontal = softwareRenderer.render(mesh, frontalCam);
 
@@ -442,11 +453,6 @@ int main(int argc, char *argv[])
 			outLandmarksImage += "_landmarks.png";
 			cv::imwrite(outLandmarksImage.string(), affineCamLandmarksProjectionImage);
 		}
-		if (config.get_child("output", ptree()).get<bool>("writeObj", false)) {
-            path outMesh = outputPath / imageSource->getName().stem();
-			outMesh.replace_extension("obj");
-			Mesh::writeObj(mesh, outMesh.string());
-		}
 		if (config.get_child("output", ptree()).get<bool>("renderResult", false)) {
             path outRenderResult = outputPath / imageSource->getName().stem();
 			outRenderResult += "_render.png";